@@ -1,4 +1,6 @@
 #include "audio_decoder.h"
+#include "decode_trace.h"
+#include "wav_file_writer.h"
 #include <hilog/log.h>
 #include <chrono>
 #include <algorithm>
@@ -11,14 +13,18 @@
 #define LOG_TAG "AudioDecoder"
 #define LOG_DOMAIN 0x3200
 
-AudioDecoder::AudioDecoder()
-    : audioDecoder_(nullptr), signal_(nullptr), format_(nullptr), isRunning_(false), currentMimeType_(""),
+AudioDecoder::AudioDecoder(media::Backend& backend)
+    : backend_(backend), audioDecoder_(nullptr), signal_(nullptr), configureAttempted_(false), isRunning_(false),
+      currentMimeType_(""),
       avSource_(nullptr), avDemuxer_(nullptr), audioTrackIndex_(-1), currentInputPathOrUri_(""),
       durationMs_(0), detectedSampleRate_(0), detectedChannelCount_(0), detectedSampleFormat_(0),
-      lastProgressPercent_(-1), lastProgressPtsMs_(-1), cancelFlag_(nullptr) {
+      lastProgressPercent_(-1), lastProgressPtsMs_(-1), cancelFlag_(nullptr), inputInterrupt_(false),
+      readLatencyPeakUs_(0), stats_(nullptr),
+      wakeup_(&ownWakeup_), codecConfigured_(false) {
 }
 
 AudioDecoder::~AudioDecoder() {
+    ReleaseCodec();
     Destroy();
 }
 
@@ -41,27 +47,27 @@ std::string AudioDecoder::GetMimeTypeFromFile(const std::string& filePath) {
 
     // 根据扩展名返回对应的 MIME 类型
     if (extension == "mp3") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_MPEG (MP3)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_MPEG;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/mpeg (MP3)");
+        return "audio/mpeg";
     } else if (extension == "flac") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_FLAC (FLAC)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_FLAC;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/flac (FLAC)");
+        return "audio/flac";
     } else if (extension == "wav") {
         OH_LOG_INFO(LOG_APP, "Using MIME type: audio/wav (WAV)");
         // WAV 通常不需要解码，但如果需要可以使用 PCM 解码器
         return "audio/wav";
     } else if (extension == "aac") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_AAC (AAC)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_AAC;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/mp4a-latm (AAC)");
+        return "audio/mp4a-latm";
     } else if (extension == "m4a") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_AAC (M4A/AAC)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_AAC;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/mp4a-latm (M4A/AAC)");
+        return "audio/mp4a-latm";
     } else if (extension == "ogg" || extension == "oga") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_VORBIS (OGG/Vorbis)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_VORBIS;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/vorbis (OGG/Vorbis)");
+        return "audio/vorbis";
     } else if (extension == "opus") {
-        OH_LOG_INFO(LOG_APP, "Using MIME type: OH_AVCODEC_MIMETYPE_AUDIO_OPUS (Opus)");
-        return OH_AVCODEC_MIMETYPE_AUDIO_OPUS;
+        OH_LOG_INFO(LOG_APP, "Using MIME type: audio/opus (Opus)");
+        return "audio/opus";
     } else {
         OH_LOG_ERROR(LOG_APP, "Unsupported audio format: %{public}s", extension.c_str());
         return "";
@@ -74,12 +80,6 @@ bool AudioDecoder::Initialize(const std::string& mimeType) {
         return false;
     }
 
-    // 如果已有解码器且 MIME 类型相同，无需重新创建
-    if (audioDecoder_ && currentMimeType_ == mimeType) {
-        OH_LOG_INFO(LOG_APP, "Decoder already initialized with same MIME type: %{public}s", mimeType.c_str());
-        return true;
-    }
-
     // 销毁旧的解码器
     if (audioDecoder_) {
         OH_LOG_INFO(LOG_APP, "Destroying old decoder before creating new one");
@@ -94,12 +94,14 @@ bool AudioDecoder::Initialize(const std::string& mimeType) {
             return false;
         }
     }
+    signal_->wakeup_.store(wakeup_, std::memory_order_release);
 
-    // 通过 MIME 类型创建解码器
-    bool isEncoder = false;
-    audioDecoder_ = OH_AudioCodec_CreateByMime(mimeType.c_str(), isEncoder);
+    // 通过 MIME 类型创建解码器（创建与注册回调的耗时计入实例池统计）
+    const auto createStart = std::chrono::steady_clock::now();
+    audioDecoder_ = backend_.CreateAudioDecoder(mimeType).release();
     if (!audioDecoder_) {
         OH_LOG_ERROR(LOG_APP, "Failed to create audio decoder for MIME type: %{public}s", mimeType.c_str());
+        CodecPool::Shared().RecordCreate(0, false);
         delete signal_;
         signal_ = nullptr;
         return false;
@@ -108,42 +110,174 @@ bool AudioDecoder::Initialize(const std::string& mimeType) {
     currentMimeType_ = mimeType;
 
     // 注册回调函数
-    OH_AVCodecCallback callback = {
+    media::CodecCallbacks callbacks = {
         &OnError,
         &OnOutputFormatChanged,
         &OnInputBufferAvailable,
         &OnOutputBufferAvailable
     };
 
-    int32_t ret = OH_AudioCodec_RegisterCallback(audioDecoder_, callback, signal_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->RegisterCallbacks(callbacks, signal_);
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to register callback, error: %{public}d", ret);
+        CodecPool::Shared().RecordCreate(0, false);
+        Destroy();
         return false;
     }
 
-    OH_LOG_INFO(LOG_APP, "Audio decoder initialized successfully with MIME type: %{public}s", mimeType.c_str());
+    const int64_t createUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - createStart).count();
+    CodecPool::Shared().RecordCreate(createUs, true);
+    OH_LOG_INFO(LOG_APP, "Audio decoder initialized successfully with MIME type: %{public}s (%{public}lld us)",
+                mimeType.c_str(), (long long)createUs);
     return true;
 }
 
-bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t bitrate, int32_t sampleFormat) {
+bool AudioDecoder::SetupCodec(const std::string& mimeType, int32_t sampleRate, int32_t channelCount,
+                              int32_t bitrate, int32_t sampleFormat, std::string* failedStage)
+{
+    const auto setupStart = std::chrono::steady_clock::now();
+
+    // 上一次解码的 codec 先归还，同配置时马上又能取回
+    ReleaseCodec();
+
+    CodecPool::Config config;
+    config.sampleRate = sampleRate;
+    config.channelCount = channelCount;
+    config.bitrate = bitrate;
+    config.sampleFormat = sampleFormat;
+    config.codecConfigHash = CodecPool::HashCodecConfig(detectedCodecConfig_);
+
+    CodecPool::Entry entry;
+    CodecPool::Reuse reuse = CodecPool::Shared().Acquire(&backend_, mimeType, config, &entry);
+    if (reuse != CodecPool::Reuse::Miss) {
+        audioDecoder_ = entry.codec;
+        signal_ = entry.signal;
+        signal_->wakeup_.store(wakeup_, std::memory_order_release);
+        signal_->failed_.store(false);
+        currentMimeType_ = mimeType;
+        ClearSignalQueues();
+    }
+
+    // 同配置：停止状态下直接 Start，跳过 Configure/Prepare
+    if (reuse == CodecPool::Reuse::Warm) {
+        const int32_t ret = audioDecoder_->Start();
+        if (ret == media::kOk) {
+            isRunning_ = true;
+            codecConfigured_ = true;
+            codecConfig_ = config;
+        } else {
+            OH_LOG_ERROR(LOG_APP, "Failed to restart pooled decoder, error: %{public}d", ret);
+            reuse = CodecPool::Reuse::Reset;
+            entry.configured = true;
+        }
+    }
+
+    // 同 MIME 不同配置：Reset 回到初始化状态后重新 Configure（回调保持注册）
+    if (reuse == CodecPool::Reuse::Reset && entry.configured && !Reset()) {
+        OH_LOG_ERROR(LOG_APP, "Failed to reset pooled decoder, recreating");
+        CodecPool::Entry failed;
+        failed.backend = &backend_;
+        failed.codec = audioDecoder_;
+        failed.signal = signal_;
+        audioDecoder_ = nullptr;
+        signal_ = nullptr;
+        CodecPool::Shared().Discard(std::move(failed));
+        reuse = CodecPool::Reuse::Miss;
+    }
+
+    if (reuse != CodecPool::Reuse::Warm) {
+        if (reuse == CodecPool::Reuse::Miss && !Initialize(mimeType)) {
+            *failedStage = "init_decoder";
+            return false;
+        }
+        if (!Configure(sampleRate, channelCount, bitrate, sampleFormat)) {
+            *failedStage = "configure";
+            return false;
+        }
+        if (!Start()) {
+            *failedStage = "start";
+            return false;
+        }
+        codecConfigured_ = true;
+        codecConfig_ = config;
+    }
+
+    static const char* const kReuseNames[] = {"miss", "reset", "warm"};
+    const int64_t setupUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - setupStart).count();
+    OH_LOG_INFO(LOG_APP, "Codec ready for %{public}s: %{public}s, %{public}lld us", mimeType.c_str(),
+                kReuseNames[static_cast<int>(reuse)], (long long)setupUs);
+    return true;
+}
+
+void AudioDecoder::ReleaseCodec()
+{
     if (!audioDecoder_) {
-        OH_LOG_ERROR(LOG_APP, "Audio decoder not initialized");
-        return false;
+        return;
+    }
+
+    CodecPool::Entry entry;
+    entry.backend = &backend_;
+    entry.mimeType = currentMimeType_;
+    entry.config = codecConfig_;
+    entry.configured = codecConfigured_;
+
+    // 出过错的 codec 不再复用；运行中的先 Stop（保持已配置状态），Stop 失败则 Reset
+    // 配置未完成的 codec 同样 Reset，下次只需重新 Configure
+    bool reusable = signal_ && !signal_->failed_.load();
+    if (reusable && isRunning_ && !Stop()) {
+        entry.configured = false;
+        reusable = Reset();
+    } else if (reusable && !codecConfigured_ && configureAttempted_) {
+        reusable = Reset();
+    }
+    ClearSignalQueues();
+
+    entry.codec = audioDecoder_;
+    entry.signal = signal_;
+    audioDecoder_ = nullptr;
+    signal_ = nullptr;
+    isRunning_ = false;
+    codecConfigured_ = false;
+    configureAttempted_ = false;
+
+    if (reusable) {
+        (void)CodecPool::Shared().Release(std::move(entry));
+    } else {
+        OH_LOG_INFO(LOG_APP, "Discarding decoder of MIME %{public}s after an error", entry.mimeType.c_str());
+        CodecPool::Shared().Discard(std::move(entry));
     }
+}
 
-    // 创建格式配置
-    if (format_) {
-        OH_AVFormat_Destroy(format_);
+size_t AudioDecoder::PrewarmCodecs(const std::string& mimeType, size_t count, media::Backend& backend)
+{
+    size_t created = 0;
+    for (size_t i = 0; i < count; i++) {
+        AudioDecoder decoder(backend);
+        if (!decoder.Initialize(mimeType)) {
+            break;
+        }
+        decoder.ReleaseCodec();
+        created++;
     }
-    format_ = OH_AVFormat_Create();
-    if (!format_) {
-        OH_LOG_ERROR(LOG_APP, "Failed to create format");
+    OH_LOG_INFO(LOG_APP, "Prewarmed %{public}llu codec(s) for %{public}s", (unsigned long long)created,
+                mimeType.c_str());
+    return created;
+}
+
+bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t bitrate, int32_t sampleFormat) {
+    if (!audioDecoder_) {
+        OH_LOG_ERROR(LOG_APP, "Audio decoder not initialized");
         return false;
     }
 
+    configureAttempted_ = true;
+    media::CodecFormat format;
+
     // 采样率（必须参数）- 如果未指定则使用默认值
     int32_t finalSampleRate = sampleRate > 0 ? sampleRate : 44100;
-    OH_AVFormat_SetIntValue(format_, OH_MD_KEY_AUD_SAMPLE_RATE, finalSampleRate);
+    format.sampleRate = finalSampleRate;
     if (sampleRate > 0) {
         OH_LOG_INFO(LOG_APP, "Set sample rate: %{public}d Hz (user specified)", finalSampleRate);
     } else {
@@ -152,7 +286,7 @@ bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t b
 
     // 声道数（必须参数）- 如果未指定则使用默认值
     int32_t finalChannelCount = channelCount > 0 ? channelCount : 2;
-    OH_AVFormat_SetIntValue(format_, OH_MD_KEY_AUD_CHANNEL_COUNT, finalChannelCount);
+    format.channelCount = finalChannelCount;
     if (channelCount > 0) {
         OH_LOG_INFO(LOG_APP, "Set channel count: %{public}d (user specified)", finalChannelCount);
     } else {
@@ -161,7 +295,7 @@ bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t b
 
     // 比特率（可选参数）- 只有明确指定时才设置
     if (bitrate > 0) {
-        OH_AVFormat_SetIntValue(format_, OH_MD_KEY_BITRATE, bitrate);
+        format.bitrate = bitrate;
         OH_LOG_INFO(LOG_APP, "Set bitrate: %{public}d bps (optional)", bitrate);
     } else {
         OH_LOG_INFO(LOG_APP, "Bitrate not set (optional parameter skipped)");
@@ -198,7 +332,7 @@ bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t b
         OH_LOG_INFO(LOG_APP, "Mapping planar format %{public}d to interleaved F32LE", sampleFormat);
     }
     
-    OH_AVFormat_SetIntValue(format_, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, finalSampleFormat);
+    format.sampleFormat = finalSampleFormat;
     if (finalSampleFormat == 4) {
         OH_LOG_INFO(LOG_APP, "Set output sample format: F32LE");
     } else if (finalSampleFormat == 3) {
@@ -209,8 +343,7 @@ bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t b
 
     // 设置Codec Specific Data (extradata/csd) - 某些解码器（如ALAC、Vorbis）需要
     if (!detectedCodecConfig_.empty()) {
-        OH_AVFormat_SetBuffer(format_, OH_MD_KEY_CODEC_CONFIG,
-            detectedCodecConfig_.data(), detectedCodecConfig_.size());
+        format.codecConfig = detectedCodecConfig_;
         OH_LOG_INFO(LOG_APP,
             "Attached codec config for MIME %{public}s, extradata size: %{public}zu",
             currentMimeType_.c_str(), detectedCodecConfig_.size());
@@ -219,8 +352,8 @@ bool AudioDecoder::Configure(int32_t sampleRate, int32_t channelCount, int32_t b
     }
 
     // 配置解码器
-    int32_t ret = OH_AudioCodec_Configure(audioDecoder_, format_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->Configure(format);
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to configure decoder, error: %{public}d", ret);
         return false;
     }
@@ -236,15 +369,15 @@ bool AudioDecoder::Start() {
     }
     
     // 准备解码器
-    int32_t ret = OH_AudioCodec_Prepare(audioDecoder_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->Prepare();
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to prepare decoder, error: %{public}d", ret);
         return false;
     }
     
     // 启动解码器
-    ret = OH_AudioCodec_Start(audioDecoder_);
-    if (ret != AV_ERR_OK) {
+    ret = audioDecoder_->Start();
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to start decoder, error: %{public}d", ret);
         return false;
     }
@@ -267,8 +400,16 @@ bool AudioDecoder::DecodeFile(const std::string& inputPath, const std::string& o
 
 bool AudioDecoder::DecodeFileWithProgress(const std::string& inputPathOrUri, const std::string& outputPath,
                                          int32_t sampleRate, int32_t channelCount, int32_t bitrate,
-                                         const ProgressCallback& progressCb)
+                                         const ProgressCallback& progressCb,
+                                         CancelFlag* cancelFlag)
 {
+    struct CancelGuard {
+        AudioDecoder* self;
+        ~CancelGuard() { self->cancelFlag_ = nullptr; }
+    } guard { this };
+
+    cancelFlag_ = cancelFlag;
+
     OH_LOG_INFO(LOG_APP, "=== Starting audio decode process ===");
     OH_LOG_INFO(LOG_APP, "Input: %{public}s", inputPathOrUri.c_str());
     OH_LOG_INFO(LOG_APP, "Output: %{public}s", outputPath.c_str());
@@ -337,14 +478,14 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
     int32_t fd = -1;
     int64_t fileSize = -1;
-    OH_AVSource* source = nullptr;
-    OH_AVDemuxer* demuxer = nullptr;
+    std::unique_ptr<media::Source> source;
+    std::unique_ptr<media::Demuxer> demuxer;
 
     // 保存输入路径用于 Seek
     currentInputPathOrUri_ = inputPathOrUri;
 
     if (isRemoteUri) {
-        source = OH_AVSource_CreateWithURI(const_cast<char*>(inputPathOrUri.c_str()));
+        source = backend_.CreateSourceWithUri(inputPathOrUri);
         if (!source) {
             reportError("create_source", -1, "Failed to create AVSource with URI");
             return false;
@@ -361,7 +502,7 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         lseek(fd, 0, SEEK_SET);
         OH_LOG_INFO(LOG_APP, "Input file size: %{public}lld bytes", (long long)fileSize);
 
-        source = OH_AVSource_CreateWithFD(fd, 0, fileSize);
+        source = backend_.CreateSourceWithFd(fd, 0, fileSize);
         if (!source) {
             reportError("create_source", -1, "Failed to create AVSource with FD");
             close(fd);
@@ -371,14 +512,8 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
     // 资源清理辅助函数
     auto cleanup = [&]() {
-        if (demuxer) {
-            OH_AVDemuxer_Destroy(demuxer);
-            demuxer = nullptr;
-        }
-        if (source) {
-            OH_AVSource_Destroy(source);
-            source = nullptr;
-        }
+        demuxer.reset();
+        source.reset();
         if (fd >= 0) {
             close(fd);
             fd = -1;
@@ -393,32 +528,18 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
     // 获取源文件格式信息，包括轨道数和总时长
     int32_t trackCount = 0;
     {
-        OH_AVFormat* sourceFormat = OH_AVSource_GetSourceFormat(source);
-        if (!sourceFormat) {
-            reportError("source_format", -1, "Failed to get source format");
-            cleanup();
-            return false;
-        }
-
-        if (!OH_AVFormat_GetIntValue(sourceFormat, OH_MD_KEY_TRACK_COUNT, &trackCount)) {
-            reportError("source_format", -1, "Failed to get track count");
-            OH_AVFormat_Destroy(sourceFormat);
+        media::SourceInfo sourceInfo;
+        if (!source->GetInfo(&sourceInfo)) {
+            reportError("source_format", -1, "Failed to get source format or track count");
             cleanup();
             return false;
         }
-
-        // OH_MD_KEY_DURATION is typically in microseconds.
-        int64_t durationUs = 0;
-        if (OH_AVFormat_GetLongValue(sourceFormat, OH_MD_KEY_DURATION, &durationUs) && durationUs > 0) {
-            durationMs_ = durationUs / 1000;
-        } else {
-            durationMs_ = 0;
-        }
-        OH_AVFormat_Destroy(sourceFormat);
+        trackCount = sourceInfo.trackCount;
+        durationMs_ = sourceInfo.durationUs / 1000;
     }
 
     // 创建解封装器
-    demuxer = OH_AVDemuxer_CreateWithSource(source);
+    demuxer = backend_.CreateDemuxer(*source);
     if (!demuxer) {
         reportError("create_demuxer", -1, "Failed to create demuxer");
         cleanup();
@@ -426,8 +547,8 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
     }
 
     // Save handles for potential internal seek operations.
-    avSource_ = source;
-    avDemuxer_ = demuxer;
+    avSource_ = source.get();
+    avDemuxer_ = demuxer.get();
 
     // 遍历轨道查找音频流并解析参数
     uint32_t audioTrackIndex = 0;
@@ -435,43 +556,33 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
     std::string audioCodecMime;
 
     for (uint32_t i = 0; i < static_cast<uint32_t>(trackCount); i++) {
-        OH_AVFormat* trackFormat = OH_AVSource_GetTrackFormat(source, i);
-        if (!trackFormat) {
+        media::TrackInfo track;
+        if (!source->GetTrackInfo(i, &track)) {
             continue;
         }
 
-        const char* codecMime = nullptr;
-        OH_AVFormat_GetStringValue(trackFormat, OH_MD_KEY_CODEC_MIME, &codecMime);
-        if (codecMime && strstr(codecMime, "audio")) {
+        const char* codecMime = track.mimeType.c_str();
+        if (strstr(codecMime, "audio")) {
             audioTrackIndex = i;
             foundAudioTrack = true;
             audioCodecMime = codecMime;
 
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUD_SAMPLE_RATE, &detectedSampleRate_);
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUD_CHANNEL_COUNT, &detectedChannelCount_);
+            detectedSampleRate_ = track.sampleRate;
+            detectedChannelCount_ = track.channelCount;
             // For audio/raw (WAV passthrough), this usually tells the PCM sample width.
             // 1=S16LE, 3=S32LE.
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, &detectedSampleFormat_);
-            
-            // Extract codec config (extradata/csd) for decoder initialization
+            detectedSampleFormat_ = track.sampleFormat;
+
+            // Codec config (extradata/csd) for decoder initialization
             // Required for ALAC, Vorbis, AAC, etc.
-            uint8_t* codecConfig = nullptr;
-            size_t codecConfigSize = 0;
-            if (OH_AVFormat_GetBuffer(trackFormat, OH_MD_KEY_CODEC_CONFIG, &codecConfig, &codecConfigSize) &&
-                codecConfig != nullptr && codecConfigSize > 0) {
-                detectedCodecConfig_.assign(codecConfig, codecConfig + codecConfigSize);
+            detectedCodecConfig_ = std::move(track.codecConfig);
+            if (!detectedCodecConfig_.empty()) {
                 OH_LOG_INFO(LOG_APP,
                     "Detected codec config from track %{public}u, MIME: %{public}s, extradata size: %{public}zu",
-                    i, codecMime, codecConfigSize);
+                    i, codecMime, detectedCodecConfig_.size());
             } else {
-                detectedCodecConfig_.clear();
                 OH_LOG_INFO(LOG_APP, "Track %{public}u MIME %{public}s has no codec config", i, codecMime);
             }
-        }  // end of if (codecMime && strstr(codecMime, "audio"))
-
-        OH_AVFormat_Destroy(trackFormat);
-
-        if (foundAudioTrack) {
             break;
         }
     }
@@ -485,7 +596,7 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
     // Track index is needed for both decoding and seek.
     audioTrackIndex_ = static_cast<int32_t>(audioTrackIndex);
 
-    // Seek/drop state (pts in microseconds per OH_AVCodecBufferAttr docs)
+    // Seek/drop state (pts in microseconds, see media::BufferAttr)
     int64_t dropUntilPtsUs = -1;
 
     auto clearSignalQueues = [&]() {
@@ -522,12 +633,17 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         if (targetMs < 0) {
             targetMs = 0;
         }
+        DecodeTrace::Scope trace("applySeek", "targetMs", targetMs);
 
         // For codec path, stop first to avoid dropping outstanding buffer indices.
         if (codecRunning && audioDecoder_) {
-            const int32_t sret = OH_AudioCodec_Stop(audioDecoder_);
-            if (sret != AV_ERR_OK) {
-                reportError("seek_stop", sret, "OH_AudioCodec_Stop failed");
+            int32_t sret;
+            {
+                DecodeTrace::Scope stopTrace("codecStop");
+                sret = audioDecoder_->Stop();
+            }
+            if (sret != media::kOk) {
+                reportError("seek_stop", sret, "Codec Stop failed");
                 if (seekAppliedCb) {
                     seekAppliedCb(seq, false, targetMs);
                 }
@@ -538,9 +654,13 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         }
  
         // Seek demuxer to target position.
-        const OH_AVErrCode sret = OH_AVDemuxer_SeekToTime(demuxer, targetMs, SEEK_MODE_CLOSEST_SYNC);
-        if (sret != AV_ERR_OK) {
-            reportError("seek", static_cast<int32_t>(sret), "OH_AVDemuxer_SeekToTime failed");
+        int32_t sret;
+        {
+            DecodeTrace::Scope demuxTrace("demuxerSeek");
+            sret = demuxer->SeekToTime(targetMs);
+        }
+        if (sret != media::kOk) {
+            reportError("seek", sret, "Demuxer SeekToTime failed");
             if (seekAppliedCb) {
                 seekAppliedCb(seq, false, targetMs);
             }
@@ -549,11 +669,12 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
         if (codecRunning && audioDecoder_) {
             // Flush codec buffers after seek (best effort), then restart.
-            (void)OH_AudioCodec_Flush(audioDecoder_);
+            DecodeTrace::Scope restartTrace("codecFlushStart");
+            (void)audioDecoder_->Flush();
 
-            const int32_t pret = OH_AudioCodec_Start(audioDecoder_);
-            if (pret != AV_ERR_OK) {
-                reportError("seek_start", pret, "OH_AudioCodec_Start failed");
+            const int32_t pret = audioDecoder_->Start();
+            if (pret != media::kOk) {
+                reportError("seek_start", pret, "Codec Start failed");
                 if (seekAppliedCb) {
                     seekAppliedCb(seq, false, targetMs);
                 }
@@ -571,12 +692,14 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
     constexpr auto kTailSeekWindow = std::chrono::milliseconds(2500);
     auto waitForTailSeekWindow = [&](bool codecRunning) {
-        if (eosCb) {
-            eosCb();
+        if (eosCb && !eosCb()) {
+            return true;
         }
 
+        // 不轮询：seek 请求与取消都会 Notify() 唤醒
         const auto deadline = std::chrono::steady_clock::now() + kTailSeekWindow;
         while (true) {
+            const uint64_t gen = wakeup_->Generation();
             if (cancelFlag_ && cancelFlag_->load()) {
                 OH_LOG_INFO(LOG_APP, "Decode canceled during EOS tail window");
                 return true;
@@ -591,11 +714,9 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
                 }
             }
 
-            if (std::chrono::steady_clock::now() >= deadline) {
+            if (!wakeup_->WaitChangedUntil(gen, deadline, [this]() { return IsCanceled(); })) {
                 return true;
             }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
         }
     };
 
@@ -605,7 +726,7 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
         // 创建用于读取原始数据的缓冲区
         int32_t bufferSize = 8192; 
-        OH_AVBuffer* buffer = OH_AVBuffer_Create(bufferSize);
+        std::unique_ptr<media::Buffer> buffer = backend_.CreateBuffer(bufferSize);
         if (!buffer) {
             reportError("create_buffer", -1, "Failed to create buffer for raw read");
             cleanup();
@@ -643,9 +764,9 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
             infoCb(finalSR, finalCh, finalSF, durationMs_);
         }
 
-        if (OH_AVDemuxer_SelectTrackByID(demuxer, audioTrackIndex) != AV_ERR_OK) {
+        if (demuxer->SelectTrack(audioTrackIndex) != media::kOk) {
             reportError("select_track", -1, "Failed to select audio track");
-            OH_AVBuffer_Destroy(buffer);
+            buffer.reset();
             cleanup();
             return false;
         }
@@ -672,8 +793,8 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
                 }
             }
 
-            int32_t ret = OH_AVDemuxer_ReadSampleBuffer(demuxer, audioTrackIndex, buffer);
-            if (ret != AV_ERR_OK) {
+            int32_t ret = ReadSample(demuxer.get(), audioTrackIndex, buffer.get());
+            if (ret != media::kOk) {
                 OH_LOG_INFO(LOG_APP, "Raw read finished: %{public}d", ret);
                 if (waitForTailSeekWindow(/*codecRunning*/ false)) {
                     break;
@@ -682,8 +803,8 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
                 continue;
             }
 
-            OH_AVCodecBufferAttr attr;
-            if (OH_AVBuffer_GetBufferAttr(buffer, &attr) != AV_ERR_OK) {
+            media::BufferAttr attr;
+            if (!buffer->GetAttr(&attr)) {
                 OH_LOG_ERROR(LOG_APP, "Failed to get raw buffer attr");
                 ok = false;
                 break;
@@ -715,7 +836,7 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
 
             // 数据回调
             if (attr.size > 0 && pcmCb) {
-                uint8_t* addr = OH_AVBuffer_GetAddr(buffer);
+                uint8_t* addr = buffer->Addr();
                 if (addr) {
                     // If a seek just happened, drop old PCM before target.
                     if (dropUntilPtsUs >= 0 && attr.pts >= 0 && attr.pts < dropUntilPtsUs) {
@@ -731,7 +852,7 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
                 }
             }
 
-            if (attr.flags & AVCODEC_BUFFER_FLAGS_EOS) {
+            if (attr.flags & media::kBufferFlagEos) {
                 OH_LOG_INFO(LOG_APP, "Raw read EOS");
                 ok = true;
                 if (waitForTailSeekWindow(/*codecRunning*/ false)) {
@@ -742,18 +863,11 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
             }
         }
 
-        OH_AVBuffer_Destroy(buffer);
+        buffer.reset();
         cleanup();
         return ok;
     }
 
-    // 初始化硬件解码器
-    if (!Initialize(audioCodecMime)) {
-        reportError("init_decoder", -1, "Failed to initialize decoder");
-        cleanup();
-        return false;
-    }
-
     const int32_t finalSampleRate = (sampleRate > 0) ? sampleRate : ((detectedSampleRate_ > 0) ? detectedSampleRate_ : 44100);
     const int32_t finalChannelCount = (channelCount > 0) ? channelCount : ((detectedChannelCount_ > 0) ? detectedChannelCount_ : 2);
 
@@ -771,16 +885,16 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         OH_LOG_INFO(LOG_APP, "Using default sampleFormat: 1 (S16LE)");
     }
 
-    // 配置解码参数
-    if (!Configure(finalSampleRate, finalChannelCount, bitrate, finalSampleFormat)) {
-        reportError("configure", -1, "Failed to configure decoder");
-        cleanup();
-        return false;
-    }
-
-    // 启动解码器
-    if (!Start()) {
-        reportError("start", -1, "Failed to start decoder");
+    // 取得并启动解码器（优先复用实例池中的 codec）
+    std::string setupStage;
+    if (!SetupCodec(audioCodecMime, finalSampleRate, finalChannelCount, bitrate, finalSampleFormat, &setupStage)) {
+        if (setupStage == "init_decoder") {
+            reportError(setupStage, -1, "Failed to initialize decoder");
+        } else if (setupStage == "configure") {
+            reportError(setupStage, -1, "Failed to configure decoder");
+        } else {
+            reportError(setupStage, -1, "Failed to start decoder");
+        }
         cleanup();
         return false;
     }
@@ -791,17 +905,101 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
     }
 
     // 选择音频轨道
-    if (OH_AVDemuxer_SelectTrackByID(demuxer, audioTrackIndex) != AV_ERR_OK) {
+    if (demuxer->SelectTrack(audioTrackIndex) != media::kOk) {
         reportError("select_track", -1, "Failed to select audio track");
         cleanup();
         return false;
     }
 
+    // 流水线解码：独立的 feeder 线程负责解封装并填满 codec 输入缓冲，
+    // 当前线程只负责取输出、回调 PCM 以及处理 seek/EOS/取消。
+    // 这样一次慢速的 ReadSampleBuffer（尤其是 HTTP）不会阻塞输出消费，反之亦然。
+    // 需要操作 codec/demuxer 的 seek 先让 feeder 停靠（ParkFeeder），完成后再放行。
+    struct FeederState {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool hold = false;      // 输出线程要求 feeder 停靠
+        bool parked = false;    // feeder 已停靠，不再访问 demuxer/codec 输入
+        bool inputEos = false;  // 已向 codec 送出 EOS
+        bool failed = false;
+        bool stop = false;
+    } feeder;
+
+    inputInterrupt_.store(false);
+
+    std::thread feederThread([&]() {
+        DecodeTrace::SetThreadName("pcm-feeder");
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(feeder.mutex);
+                if (feeder.hold || feeder.inputEos || feeder.failed) {
+                    feeder.parked = true;
+                    feeder.cond.notify_all();
+                    feeder.cond.wait(lock, [&feeder]() {
+                        return feeder.stop || (!feeder.hold && !feeder.inputEos && !feeder.failed);
+                    });
+                    feeder.parked = false;
+                }
+                if (feeder.stop) {
+                    feeder.parked = true;
+                    feeder.cond.notify_all();
+                    return;
+                }
+            }
+
+            wakeup_->Wait([this]() { return IsCanceled() || inputInterrupt_.load() || HasInputBuffer(); });
+
+            const StepResult inRes = PushInputData(demuxer.get(), audioTrackIndex, progressCb);
+            if (inRes == StepResult::Continue) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(feeder.mutex);
+                if (inRes == StepResult::Eos) {
+                    feeder.inputEos = true;
+                } else {
+                    feeder.failed = true;
+                }
+            }
+            if (inRes == StepResult::Error) {
+                wakeup_->Notify();
+            }
+        }
+    });
+
+    // 让 feeder 停在两次 PushInputData 之间（等待输入缓冲时会被立即唤醒）
+    auto parkFeeder = [&]() {
+        std::unique_lock<std::mutex> lock(feeder.mutex);
+        feeder.hold = true;
+        inputInterrupt_.store(true);
+        wakeup_->NotifyState();
+        feeder.cond.wait(lock, [&feeder]() { return feeder.parked; });
+    };
+
+    auto releaseFeeder = [&](bool restartInput) {
+        {
+            std::lock_guard<std::mutex> lock(feeder.mutex);
+            inputInterrupt_.store(false);
+            feeder.hold = false;
+            if (restartInput) {
+                feeder.inputEos = false;
+            }
+        }
+        feeder.cond.notify_all();
+    };
+
+    auto pipelinedSeek = [&](int64_t targetMs, uint64_t seq) {
+        parkFeeder();
+        applySeek(targetMs, seq, /*codecRunning*/ true);
+        releaseFeeder(/*restartInput*/ true);
+    };
+
     bool ok = false;
-    bool inputEos = false;
-    
+
     // 循环解码流程
     while (true) {
+        // 先取代数再检查状态，期间到达的 seek/取消不会丢失唤醒
+        const uint64_t gen = wakeup_->Generation();
         if (cancelFlag_ && cancelFlag_->load()) {
             OH_LOG_INFO(LOG_APP, "Decode canceled");
             ok = true;
@@ -813,23 +1011,39 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
             int64_t targetMs = 0;
             uint64_t seq = 0;
             if (seekPollCb(targetMs, seq)) {
-                inputEos = false;
-                applySeek(targetMs, seq, /*codecRunning*/ true);
+                pipelinedSeek(targetMs, seq);
+                continue;
             }
         }
 
-        // 推送输入数据到解码器
-        if (!inputEos) {
-            StepResult inRes = PushInputData(demuxer, audioTrackIndex, progressCb);
-            if (inRes == StepResult::Eos) {
-                inputEos = true;
-            } else if (inRes == StepResult::Error) {
-                reportError("push_input", -1, "Failed to push input data");
-                ok = false;
+        {
+            std::lock_guard<std::mutex> lock(feeder.mutex);
+            if (feeder.failed) {
+                // feeder 在取消时也会以失败退出等待
+                ok = cancelFlag_ && cancelFlag_->load();
+                if (!ok) {
+                    reportError("push_input", -1, "Failed to push input data");
+                }
                 break;
             }
         }
 
+        // 等待输出缓冲或外部事件（seek/取消/feeder 失败）
+        {
+            DecodeStats::Timer waitTimer(stats_, DecodeStats::Stage::CodecWait);
+            DecodeTrace::Scope trace("codecWait");
+            wakeup_->WaitChanged(gen, [this]() {
+                return IsCanceled() || signal_->failed_.load() || HasOutputBuffer();
+            });
+        }
+
+        // codec 报错（OnError）后不会再有输出
+        if (signal_->failed_.load() && !IsCanceled()) {
+            reportError("codec", signal_->errorCode_.load(), "Decoder reported an error");
+            ok = false;
+            break;
+        }
+
         // 获取解码后的输出数据
         StepResult outRes = PopOutputData([&](const uint8_t* data, size_t size, int64_t ptsUs) {
             if (dropUntilPtsUs >= 0) {
@@ -846,10 +1060,13 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         });
         if (outRes == StepResult::Eos) {
             ok = true;
-            if (waitForTailSeekWindow(/*codecRunning*/ true)) {
+            // 尾部等待期间 feeder 已因 inputEos 停靠；若有 seek，则停靠后执行并重新送入输入
+            parkFeeder();
+            const bool finished = waitForTailSeekWindow(/*codecRunning*/ true);
+            releaseFeeder(/*restartInput*/ !finished);
+            if (finished) {
                 break;
             }
-            inputEos = false;
             continue;
         }
         if (outRes == StepResult::Error) {
@@ -864,6 +1081,17 @@ bool AudioDecoder::DecodeToPcmStream(const std::string& inputPathOrUri,
         }
     }
 
+    // 先停止 feeder，再释放 demuxer/source
+    {
+        std::lock_guard<std::mutex> lock(feeder.mutex);
+        feeder.stop = true;
+        inputInterrupt_.store(true);
+    }
+    feeder.cond.notify_all();
+    wakeup_->NotifyState();
+    feederThread.join();
+    inputInterrupt_.store(false);
+
     cleanup();
     return ok;
 }
@@ -884,9 +1112,19 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
         progressCb(0.0, 0, 0);
     }
 
-    // 1. 打开输出文件
-    std::ofstream outputFile(outputPath, std::ios::out | std::ios::binary);
-    if (!outputFile.is_open()) {
+    if (cancelFlag_ && cancelFlag_->load()) {
+        OH_LOG_INFO(LOG_APP, "Decode canceled before start");
+        return false;
+    }
+
+    // 1. 打开输出文件（异步块写入，磁盘延迟不阻塞解码循环）
+    std::unique_ptr<PcmFileWriter> outputFile;
+    if (fileOutputOptions_.container == OutputContainer::Wav) {
+        outputFile = std::make_unique<WavFileWriter>();
+    } else {
+        outputFile = std::make_unique<PcmFileWriter>();
+    }
+    if (!outputFile->Open(outputPath, fileOutputOptions_.writer)) {
         OH_LOG_ERROR(LOG_APP, "Failed to open output file: %{public}s", outputPath.c_str());
         return false;
     }
@@ -896,17 +1134,17 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
 
     int32_t fd = -1;
     int64_t fileSize = -1;
-    OH_AVSource* source = nullptr;
-    OH_AVDemuxer* demuxer = nullptr;
+    std::unique_ptr<media::Source> source;
+    std::unique_ptr<media::Demuxer> demuxer;
 
     // 保存输入路径用于 Seek
     currentInputPathOrUri_ = inputPathOrUri;
 
     if (isRemoteUri) {
-        source = OH_AVSource_CreateWithURI(const_cast<char*>(inputPathOrUri.c_str()));
+        source = backend_.CreateSourceWithUri(inputPathOrUri);
         if (!source) {
             OH_LOG_ERROR(LOG_APP, "Failed to create AVSource with URI");
-            outputFile.close();
+            outputFile->Close();
             return false;
         }
         OH_LOG_INFO(LOG_APP, "AVSource created with URI");
@@ -914,7 +1152,7 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
         fd = open(inputPathOrUri.c_str(), O_RDONLY);
         if (fd < 0) {
             OH_LOG_ERROR(LOG_APP, "Failed to open input file: %{public}s", inputPathOrUri.c_str());
-            outputFile.close();
+            outputFile->Close();
             return false;
         }
 
@@ -922,11 +1160,11 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
         lseek(fd, 0, SEEK_SET);
         OH_LOG_INFO(LOG_APP, "Input file size: %{public}lld bytes", (long long)fileSize);
 
-        source = OH_AVSource_CreateWithFD(fd, 0, fileSize);
+        source = backend_.CreateSourceWithFd(fd, 0, fileSize);
         if (!source) {
             OH_LOG_ERROR(LOG_APP, "Failed to create AVSource with FD");
             close(fd);
-            outputFile.close();
+            outputFile->Close();
             return false;
         }
     }
@@ -934,60 +1172,43 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
     // 3. 获取 source 信息（轨道数、时长）
     int32_t trackCount = 0;
     {
-        OH_AVFormat* sourceFormat = OH_AVSource_GetSourceFormat(source);
-        if (!sourceFormat) {
-            OH_LOG_ERROR(LOG_APP, "Failed to get source format");
-            OH_AVSource_Destroy(source);
-            source = nullptr;
+        media::SourceInfo sourceInfo;
+        if (!source->GetInfo(&sourceInfo)) {
+            OH_LOG_ERROR(LOG_APP, "Failed to get source format or track count");
+            source.reset();
             if (fd >= 0) {
                 close(fd);
             }
-            outputFile.close();
+            outputFile->Close();
             return false;
         }
+        trackCount = sourceInfo.trackCount;
 
-        if (!OH_AVFormat_GetIntValue(sourceFormat, OH_MD_KEY_TRACK_COUNT, &trackCount)) {
-            OH_LOG_ERROR(LOG_APP, "Failed to get track count");
-            OH_AVFormat_Destroy(sourceFormat);
-            OH_AVSource_Destroy(source);
-            source = nullptr;
-            if (fd >= 0) {
-                close(fd);
-            }
-            outputFile.close();
-            return false;
-        }
-
-        int64_t durationUs = 0;
-        if (OH_AVFormat_GetLongValue(sourceFormat, OH_MD_KEY_DURATION, &durationUs) && durationUs > 0) {
-            durationMs_ = durationUs / 1000;
+        durationMs_ = sourceInfo.durationUs / 1000;
+        if (durationMs_ > 0) {
             OH_LOG_INFO(LOG_APP, "Duration: %{public}lld ms", (long long)durationMs_);
         } else {
-            durationMs_ = 0;
             OH_LOG_INFO(LOG_APP, "Duration: unknown");
         }
-
-        OH_AVFormat_Destroy(sourceFormat);
     }
 
     OH_LOG_INFO(LOG_APP, "Track count: %{public}d", trackCount);
 
     // 4. 创建解封装器
-    demuxer = OH_AVDemuxer_CreateWithSource(source);
+    demuxer = backend_.CreateDemuxer(*source);
     if (!demuxer) {
         OH_LOG_ERROR(LOG_APP, "Failed to create demuxer");
-        OH_AVSource_Destroy(source);
-        source = nullptr;
+        source.reset();
         if (fd >= 0) {
             close(fd);
         }
-        outputFile.close();
+        outputFile->Close();
         return false;
     }
 
     // 保存 AVSource 和 AVDemuxer 句柄用于 Seek
-    avSource_ = source;
-    avDemuxer_ = demuxer;
+    avSource_ = source.get();
+    avDemuxer_ = demuxer.get();
 
     // 5. 查找音频轨道 & 获取音频参数
     uint32_t audioTrackIndex = 0;
@@ -995,109 +1216,97 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
     std::string audioCodecMime;
 
     for (uint32_t i = 0; i < static_cast<uint32_t>(trackCount); i++) {
-        OH_AVFormat* trackFormat = OH_AVSource_GetTrackFormat(source, i);
-        if (!trackFormat) {
+        media::TrackInfo track;
+        if (!source->GetTrackInfo(i, &track)) {
             continue;
         }
 
-        const char* codecMime = nullptr;
-        OH_AVFormat_GetStringValue(trackFormat, OH_MD_KEY_CODEC_MIME, &codecMime);
-        if (codecMime && strstr(codecMime, "audio")) {
+        const char* codecMime = track.mimeType.c_str();
+        if (strstr(codecMime, "audio")) {
             audioTrackIndex = i;
             foundAudioTrack = true;
             audioCodecMime = codecMime;
 
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUD_SAMPLE_RATE, &detectedSampleRate_);
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUD_CHANNEL_COUNT, &detectedChannelCount_);
-            OH_AVFormat_GetIntValue(trackFormat, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, &detectedSampleFormat_);
+            detectedSampleRate_ = track.sampleRate;
+            detectedChannelCount_ = track.channelCount;
+            detectedSampleFormat_ = track.sampleFormat;
 
-            // Extract codec config (extradata/csd) for decoder initialization
-            uint8_t* codecConfig = nullptr;
-            size_t codecConfigSize = 0;
-            if (OH_AVFormat_GetBuffer(trackFormat, OH_MD_KEY_CODEC_CONFIG, &codecConfig, &codecConfigSize) &&
-                codecConfig != nullptr && codecConfigSize > 0) {
-                detectedCodecConfig_.assign(codecConfig, codecConfig + codecConfigSize);
+            // Codec config (extradata/csd) for decoder initialization
+            detectedCodecConfig_ = std::move(track.codecConfig);
+            if (!detectedCodecConfig_.empty()) {
                 OH_LOG_INFO(LOG_APP,
                     "Detected codec config from track %{public}u, MIME: %{public}s, extradata size: %{public}zu",
-                    i, codecMime, codecConfigSize);
+                    i, codecMime, detectedCodecConfig_.size());
             } else {
-                detectedCodecConfig_.clear();
                 OH_LOG_INFO(LOG_APP, "Track %{public}u MIME %{public}s has no codec config", i, codecMime);
             }
 
             OH_LOG_INFO(LOG_APP, "Found audio track %{public}d, MIME: %{public}s", i, codecMime);
             OH_LOG_INFO(LOG_APP, "Detected audio params: %{public}d Hz, %{public}d channels",
                         detectedSampleRate_, detectedChannelCount_);
-        }  // end of if (codecMime && strstr(codecMime, "audio"))
-
-        OH_AVFormat_Destroy(trackFormat);
-
-        if (foundAudioTrack) {
             break;
         }
     }
 
     if (!foundAudioTrack || audioCodecMime.empty()) {
         OH_LOG_ERROR(LOG_APP, "No audio track found");
-        OH_AVDemuxer_Destroy(demuxer);
-        demuxer = nullptr;
-        OH_AVSource_Destroy(source);
-        source = nullptr;
+        demuxer.reset();
+        source.reset();
         if (fd >= 0) {
             close(fd);
         }
-        outputFile.close();
+        outputFile->Close();
         return false;
     }
 
     audioTrackIndex_ = static_cast<int32_t>(audioTrackIndex);
 
-    // 6. 初始化/配置/启动解码器
-    if (!Initialize(audioCodecMime)) {
-        OH_LOG_ERROR(LOG_APP, "Failed to initialize decoder");
-        OH_AVDemuxer_Destroy(demuxer);
-        OH_AVSource_Destroy(source);
-        if (fd >= 0) {
-            close(fd);
-        }
-        outputFile.close();
-        return false;
-    }
-
+    // 6. 取得/配置/启动解码器（优先复用实例池中的 codec）
     const int32_t finalSampleRate = (sampleRate > 0) ? sampleRate : ((detectedSampleRate_ > 0) ? detectedSampleRate_ : 44100);
     const int32_t finalChannelCount = (channelCount > 0) ? channelCount : ((detectedChannelCount_ > 0) ? detectedChannelCount_ : 2);
 
-    if (!Configure(finalSampleRate, finalChannelCount, bitrate)) {
-        OH_LOG_ERROR(LOG_APP, "Failed to configure decoder");
-        OH_AVDemuxer_Destroy(demuxer);
-        OH_AVSource_Destroy(source);
+    std::string setupStage;
+    if (!SetupCodec(audioCodecMime, finalSampleRate, finalChannelCount, bitrate, 1, &setupStage)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to set up decoder (%{public}s)", setupStage.c_str());
+        demuxer.reset();
+        source.reset();
         if (fd >= 0) {
             close(fd);
         }
-        outputFile.close();
+        outputFile->Close();
         return false;
     }
 
-    if (!Start()) {
-        OH_LOG_ERROR(LOG_APP, "Failed to start decoder");
-        OH_AVDemuxer_Destroy(demuxer);
-        OH_AVSource_Destroy(source);
+    // 输出为解码器默认的 S16LE
+    PcmFileFormat outputFormat;
+    outputFormat.sampleRate = finalSampleRate;
+    outputFormat.channelCount = finalChannelCount;
+    outputFormat.bitsPerSample = 16;
+    if (!outputFile->SetFormat(outputFormat)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to write output header");
+        demuxer.reset();
+        source.reset();
         if (fd >= 0) {
             close(fd);
         }
-        outputFile.close();
+        outputFile->Close();
         return false;
     }
 
+    if (fileOutputOptions_.preallocate && durationMs_ > 0) {
+        const int64_t bytesPerSec = static_cast<int64_t>(finalSampleRate) * finalChannelCount * 2;
+        (void)outputFile->Preallocate(durationMs_ * bytesPerSec / 1000);
+    }
+
     // 7. 选择音频轨道
-    if (OH_AVDemuxer_SelectTrackByID(demuxer, audioTrackIndex) != AV_ERR_OK) {
+    if (demuxer->SelectTrack(audioTrackIndex) != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to select audio track");
-        OH_AVDemuxer_Destroy(demuxer);
-        OH_AVSource_Destroy(source);
+        demuxer.reset();
+        source.reset();
         if (fd >= 0) {
             close(fd);
         }
-        outputFile.close();
+        outputFile->Close();
         return false;
     }
 
@@ -1110,8 +1319,26 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
     while (true) {
         loopCount++;
 
+        if (cancelFlag_ && cancelFlag_->load()) {
+            OH_LOG_INFO(LOG_APP, "Decode canceled");
+            ok = false;
+            break;
+        }
+
+        // 无定时轮询：等待任一 codec 缓冲可用或被取消
+        // 每轮至少送入或取出一个缓冲，不设迭代上限（长文件的包数可远超 10 万）
+        wakeup_->Wait([this, inputEos]() {
+            return IsCanceled() || signal_->failed_.load() || (!inputEos && HasInputBuffer()) || HasOutputBuffer();
+        });
+
+        if (signal_->failed_.load() && !IsCanceled()) {
+            OH_LOG_ERROR(LOG_APP, "Decoder reported error %{public}d", signal_->errorCode_.load());
+            ok = false;
+            break;
+        }
+
         if (!inputEos) {
-            StepResult inRes = PushInputData(demuxer, audioTrackIndex, progressCb);
+            StepResult inRes = PushInputData(demuxer.get(), audioTrackIndex, progressCb);
             if (inRes == StepResult::Eos) {
                 inputEos = true;
                 OH_LOG_INFO(LOG_APP, "Input reached EOS after %{public}d loops", loopCount);
@@ -1121,7 +1348,7 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
             }
         }
 
-        StepResult outRes = PopOutputData(outputFile);
+        StepResult outRes = PopOutputData(*outputFile);
         if (outRes == StepResult::Eos) {
             ok = true;
             break;
@@ -1130,26 +1357,21 @@ bool AudioDecoder::DecodeFileInternal(const std::string& inputPathOrUri, const s
             ok = false;
             break;
         }
-
-        if (loopCount > 100000) {
-            OH_LOG_ERROR(LOG_APP, "Decode loop exceeded maximum iterations");
-            ok = false;
-            break;
-        }
     }
 
     // 8. 清理资源
-    OH_AVDemuxer_Destroy(demuxer);
-    demuxer = nullptr;
-    OH_AVSource_Destroy(source);
-    source = nullptr;
+    demuxer.reset();
+    source.reset();
     avSource_ = nullptr;
     avDemuxer_ = nullptr;
     audioTrackIndex_ = -1;
     if (fd >= 0) {
         close(fd);
     }
-    outputFile.close();
+    if (!outputFile->Close()) {
+        OH_LOG_ERROR(LOG_APP, "Failed to flush output file: %{public}s", outputPath.c_str());
+        ok = false;
+    }
 
     if (progressCb) {
         if (durationMs_ > 0) {
@@ -1183,8 +1405,8 @@ bool AudioDecoder::Stop() {
         return false;
     }
 
-    int32_t ret = OH_AudioCodec_Stop(audioDecoder_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->Stop();
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to stop decoder, error: %{public}d", ret);
         return false;
     }
@@ -1199,8 +1421,8 @@ bool AudioDecoder::Flush() {
         return false;
     }
 
-    int32_t ret = OH_AudioCodec_Flush(audioDecoder_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->Flush();
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to flush decoder, error: %{public}d", ret);
         return false;
     }
@@ -1214,8 +1436,8 @@ bool AudioDecoder::Reset() {
         return false;
     }
 
-    int32_t ret = OH_AudioCodec_Reset(audioDecoder_);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->Reset();
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to reset decoder, error: %{public}d", ret);
         return false;
     }
@@ -1239,43 +1461,32 @@ bool AudioDecoder::SeekTo(int64_t timeMs)
     OH_LOG_INFO(LOG_APP, "Seeking to %{public}lld ms", timeMs);
 
     // Stop first so the codec can reclaim any outstanding buffers.
-    const int32_t stopRet = OH_AudioCodec_Stop(audioDecoder_);
-    if (stopRet != AV_ERR_OK) {
+    const int32_t stopRet = audioDecoder_->Stop();
+    if (stopRet != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to stop codec before seek: %{public}d", stopRet);
         return false;
     }
 
     // 1. Seek demuxer
-    const OH_AVErrCode seekRet = OH_AVDemuxer_SeekToTime(avDemuxer_, timeMs, SEEK_MODE_CLOSEST_SYNC);
-    if (seekRet != AV_ERR_OK) {
-        OH_LOG_ERROR(LOG_APP, "Failed to seek demuxer: %{public}d", static_cast<int32_t>(seekRet));
+    const int32_t seekRet = avDemuxer_->SeekToTime(timeMs);
+    if (seekRet != media::kOk) {
+        OH_LOG_ERROR(LOG_APP, "Failed to seek demuxer: %{public}d", seekRet);
         return false;
     }
 
     // 2. Flush codec buffers to discard pre-seek frames
-    const int32_t fret = OH_AudioCodec_Flush(audioDecoder_);
-    if (fret != AV_ERR_OK) {
+    const int32_t fret = audioDecoder_->Flush();
+    if (fret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to flush codec after seek: %{public}d", fret);
         return false;
     }
 
     // 3. Clear callback queues (safe after Stop)
-    if (signal_) {
-        {
-            std::lock_guard<std::mutex> lock(signal_->inMutex_);
-            while (!signal_->inQueue_.empty()) signal_->inQueue_.pop();
-            while (!signal_->inBufferQueue_.empty()) signal_->inBufferQueue_.pop();
-        }
-        {
-            std::lock_guard<std::mutex> lock(signal_->outMutex_);
-            while (!signal_->outQueue_.empty()) signal_->outQueue_.pop();
-            while (!signal_->outBufferQueue_.empty()) signal_->outBufferQueue_.pop();
-        }
-    }
+    ClearSignalQueues();
 
     // 4. Restart
-    const int32_t pret = OH_AudioCodec_Start(audioDecoder_);
-    if (pret != AV_ERR_OK) {
+    const int32_t pret = audioDecoder_->Start();
+    if (pret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to start codec after seek: %{public}d", pret);
         return false;
     }
@@ -1284,16 +1495,52 @@ bool AudioDecoder::SeekTo(int64_t timeMs)
     return true;
 }
 
-void AudioDecoder::Destroy() {
-    if (audioDecoder_) {
-        OH_AudioCodec_Destroy(audioDecoder_);
-        audioDecoder_ = nullptr;
+void AudioDecoder::ClearSignalQueues()
+{
+    if (!signal_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(signal_->inMutex_);
+        while (!signal_->inQueue_.empty()) signal_->inQueue_.pop();
+        while (!signal_->inBufferQueue_.empty()) signal_->inBufferQueue_.pop();
+    }
+    {
+        std::lock_guard<std::mutex> lock(signal_->outMutex_);
+        while (!signal_->outQueue_.empty()) signal_->outQueue_.pop();
+        while (!signal_->outBufferQueue_.empty()) signal_->outBufferQueue_.pop();
     }
+}
 
-    if (format_) {
-        OH_AVFormat_Destroy(format_);
-        format_ = nullptr;
+void AudioDecoder::SetWakeup(DecodeWakeup* wakeup)
+{
+    wakeup_ = (wakeup != nullptr) ? wakeup : &ownWakeup_;
+    if (signal_) {
+        signal_->wakeup_.store(wakeup_, std::memory_order_release);
     }
+}
+
+bool AudioDecoder::IsCanceled() const
+{
+    return cancelFlag_ && cancelFlag_->load();
+}
+
+bool AudioDecoder::HasInputBuffer()
+{
+    std::lock_guard<std::mutex> lock(signal_->inMutex_);
+    return !signal_->inQueue_.empty();
+}
+
+bool AudioDecoder::HasOutputBuffer()
+{
+    std::lock_guard<std::mutex> lock(signal_->outMutex_);
+    return !signal_->outQueue_.empty();
+}
+
+void AudioDecoder::Destroy() {
+    delete audioDecoder_;
+    audioDecoder_ = nullptr;
+    configureAttempted_ = false;
 
     if (signal_) {
         delete signal_;
@@ -1303,84 +1550,102 @@ void AudioDecoder::Destroy() {
     detectedCodecConfig_.clear();
 
     isRunning_ = false;
+    codecConfigured_ = false;
     OH_LOG_INFO(LOG_APP, "Audio decoder destroyed");
 }
 
 // 回调函数实现
-void AudioDecoder::OnError(OH_AVCodec *codec, int32_t errorCode, void *userData) {
-    (void)codec;
-    (void)userData;
+void AudioDecoder::OnError(int32_t errorCode, void *userData) {
+    AudioDecoderSignal *signal = static_cast<AudioDecoderSignal *>(userData);
+    if (signal) {
+        signal->errorCode_.store(errorCode);
+        signal->failed_.store(true);
+        // 解码循环的等待无超时，须唤醒其检查 failed_
+        signal->wakeup_.load(std::memory_order_acquire)->Notify();
+    }
     OH_LOG_ERROR(LOG_APP, "Decoder error occurred: %{public}d", errorCode);
 }
 
-void AudioDecoder::OnOutputFormatChanged(OH_AVCodec *codec, OH_AVFormat *format, void *userData) {
-    (void)codec;
+void AudioDecoder::OnOutputFormatChanged(const media::CodecFormat& format, void *userData) {
     (void)userData;
 
-    int32_t sampleRate = 0;
-    int32_t channelCount = 0;
-    int32_t sampleFormat = 0;
-
-    if (OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_SAMPLE_RATE, &sampleRate)) {
-        OH_LOG_INFO(LOG_APP, "Sample rate changed to: %{public}d", sampleRate);
+    if (format.sampleRate > 0) {
+        OH_LOG_INFO(LOG_APP, "Sample rate changed to: %{public}d", format.sampleRate);
     }
 
-    if (OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_CHANNEL_COUNT, &channelCount)) {
-        OH_LOG_INFO(LOG_APP, "Channel count changed to: %{public}d", channelCount);
+    if (format.channelCount > 0) {
+        OH_LOG_INFO(LOG_APP, "Channel count changed to: %{public}d", format.channelCount);
     }
 
-    if (OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, &sampleFormat)) {
-        OH_LOG_INFO(LOG_APP, "Sample format changed to: %{public}d", sampleFormat);
+    if (format.sampleFormat > 0) {
+        OH_LOG_INFO(LOG_APP, "Sample format changed to: %{public}d", format.sampleFormat);
     }
 }
 
-void AudioDecoder::OnInputBufferAvailable(OH_AVCodec *codec, uint32_t index, OH_AVBuffer *data, void *userData) {
-    (void)codec;
+void AudioDecoder::OnInputBufferAvailable(uint32_t index, media::Buffer *data, void *userData) {
     AudioDecoderSignal *signal = static_cast<AudioDecoderSignal *>(userData);
-    std::unique_lock<std::mutex> lock(signal->inMutex_);
-    signal->inQueue_.push(index);
-    signal->inBufferQueue_.push(data);
-    signal->inCond_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(signal->inMutex_);
+        signal->inQueue_.push(index);
+        signal->inBufferQueue_.push(data);
+    }
+    signal->wakeup_.load(std::memory_order_acquire)->NotifyState();
 }
 
-void AudioDecoder::OnOutputBufferAvailable(OH_AVCodec *codec, uint32_t index, OH_AVBuffer *data, void *userData) {
-    (void)codec;
+void AudioDecoder::OnOutputBufferAvailable(uint32_t index, media::Buffer *data, void *userData) {
     AudioDecoderSignal *signal = static_cast<AudioDecoderSignal *>(userData);
-    std::unique_lock<std::mutex> lock(signal->outMutex_);
-    signal->outQueue_.push(index);
-    signal->outBufferQueue_.push(data);
-    signal->outCond_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(signal->outMutex_);
+        signal->outQueue_.push(index);
+        signal->outBufferQueue_.push(data);
+    }
+    signal->wakeup_.load(std::memory_order_acquire)->NotifyState();
+}
+
+int32_t AudioDecoder::ReadSample(media::Demuxer* demuxer, uint32_t trackIndex, media::Buffer* buffer)
+{
+    DecodeTrace::Scope trace("demuxRead");
+    const auto start = std::chrono::steady_clock::now();
+    const int32_t ret = demuxer->ReadSample(trackIndex, buffer);
+    const int64_t ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (DecodeStats::kEnabled && stats_) {
+        stats_->Record(DecodeStats::Stage::Read, ns);
+    }
+    const int64_t us = ns / 1000;
+    int64_t peak = readLatencyPeakUs_.load(std::memory_order_relaxed);
+    while (us > peak && !readLatencyPeakUs_.compare_exchange_weak(peak, us, std::memory_order_relaxed)) {
+    }
+    return ret;
 }
 
 // 输入数据处理（从解封装器读取）
-AudioDecoder::StepResult AudioDecoder::PushInputData(OH_AVDemuxer* demuxer, uint32_t trackIndex,
+AudioDecoder::StepResult AudioDecoder::PushInputData(media::Demuxer* demuxer, uint32_t trackIndex,
                                                      const ProgressCallback& progressCb)
 {
     if (!signal_ || !demuxer) {
         return StepResult::Error;
     }
 
-    std::unique_lock<std::mutex> lock(signal_->inMutex_);
-    if (!signal_->inCond_.wait_for(lock, std::chrono::milliseconds(200),
-                                   [this]() {
-                                       if (cancelFlag_ && cancelFlag_->load()) {
-                                           return true;
-                                       }
-                                       return !signal_->inQueue_.empty();
-                                   })) {
-        return StepResult::Continue;
-    }
-
     if (cancelFlag_ && cancelFlag_->load()) {
         OH_LOG_INFO(LOG_APP, "Decode canceled while waiting input buffer");
         return StepResult::Error;
     }
 
+    // 非阻塞：调用方通过 wakeup_ 等待输入缓冲。
+    // 流水线模式下输出线程要求让出（seek/退出）时不取用输入缓冲。
+    std::unique_lock<std::mutex> lock(signal_->inMutex_);
+    if (inputInterrupt_.load() || signal_->inQueue_.empty()) {
+        return StepResult::Continue;
+    }
+
     uint32_t index = signal_->inQueue_.front();
     signal_->inQueue_.pop();
 
-    OH_AVBuffer* buffer = signal_->inBufferQueue_.front();
+    media::Buffer* buffer = signal_->inBufferQueue_.front();
     signal_->inBufferQueue_.pop();
+    // 读取解封装数据（可能很慢）时不阻塞 codec 的回调线程
+    lock.unlock();
 
     if (!buffer) {
         OH_LOG_ERROR(LOG_APP, "Buffer is null");
@@ -1388,19 +1653,19 @@ AudioDecoder::StepResult AudioDecoder::PushInputData(OH_AVDemuxer* demuxer, uint
     }
 
     // 从解封装器读取一帧数据
-    int32_t ret = OH_AVDemuxer_ReadSampleBuffer(demuxer, trackIndex, buffer);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = ReadSample(demuxer, trackIndex, buffer);
+    if (ret != media::kOk) {
         // 读取失败：通常意味着 EOS
         OH_LOG_INFO(LOG_APP, "ReadSampleBuffer returned: %{public}d, sending EOS", ret);
 
-        OH_AVCodecBufferAttr eosAttr = {0};
+        media::BufferAttr eosAttr;
         eosAttr.size = 0;
-        eosAttr.flags = AVCODEC_BUFFER_FLAGS_EOS;
+        eosAttr.flags = media::kBufferFlagEos;
         eosAttr.pts = 0;
-        OH_AVBuffer_SetBufferAttr(buffer, &eosAttr);
+        buffer->SetAttr(eosAttr);
 
-        ret = OH_AudioCodec_PushInputBuffer(audioDecoder_, index);
-        if (ret != AV_ERR_OK) {
+        ret = audioDecoder_->PushInputBuffer(index);
+        if (ret != media::kOk) {
             OH_LOG_ERROR(LOG_APP, "Failed to push EOS buffer, error: %{public}d", ret);
             return StepResult::Error;
         }
@@ -1408,13 +1673,13 @@ AudioDecoder::StepResult AudioDecoder::PushInputData(OH_AVDemuxer* demuxer, uint
         return StepResult::Eos;
     }
 
-    OH_AVCodecBufferAttr attr = {0};
-    if (OH_AVBuffer_GetBufferAttr(buffer, &attr) != AV_ERR_OK) {
+    media::BufferAttr attr;
+    if (!buffer->GetAttr(&attr)) {
         OH_LOG_ERROR(LOG_APP, "Failed to get input buffer attr");
         return StepResult::Error;
     }
 
-    // OH_AVCodecBufferAttr::pts is in microseconds.
+    // BufferAttr::pts is in microseconds.
     const int64_t ptsMs = (attr.pts >= 0) ? (attr.pts / 1000) : attr.pts;
 
     // 进度上报（节流）
@@ -1438,13 +1703,13 @@ AudioDecoder::StepResult AudioDecoder::PushInputData(OH_AVDemuxer* demuxer, uint
         }
     }
 
-    ret = OH_AudioCodec_PushInputBuffer(audioDecoder_, index);
-    if (ret != AV_ERR_OK) {
+    ret = audioDecoder_->PushInputBuffer(index);
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to push input buffer, error: %{public}d", ret);
         return StepResult::Error;
     }
 
-    if (attr.flags & AVCODEC_BUFFER_FLAGS_EOS) {
+    if (attr.flags & media::kBufferFlagEos) {
         OH_LOG_INFO(LOG_APP, "Reached end of stream (EOS flag in input buffer)");
         return StepResult::Eos;
     }
@@ -1453,33 +1718,30 @@ AudioDecoder::StepResult AudioDecoder::PushInputData(OH_AVDemuxer* demuxer, uint
 }
 
 // 输出数据处理
-AudioDecoder::StepResult AudioDecoder::PopOutputData(std::ofstream& outputFile)
+AudioDecoder::StepResult AudioDecoder::PopOutputData(PcmOutputSink& sink)
 {
     if (!signal_) {
         return StepResult::Error;
     }
 
-    std::unique_lock<std::mutex> lock(signal_->outMutex_);
-    if (!signal_->outCond_.wait_for(lock, std::chrono::milliseconds(200),
-                                    [this]() {
-                                        if (cancelFlag_ && cancelFlag_->load()) {
-                                            return true;
-                                        }
-                                        return !signal_->outQueue_.empty();
-                                    })) {
-        return StepResult::Continue;
-    }
-
     if (cancelFlag_ && cancelFlag_->load()) {
         OH_LOG_INFO(LOG_APP, "Decode canceled while waiting output buffer");
         return StepResult::Error;
     }
 
+    // 非阻塞：调用方通过 wakeup_ 等待输出缓冲
+    std::unique_lock<std::mutex> lock(signal_->outMutex_);
+    if (signal_->outQueue_.empty()) {
+        return StepResult::Continue;
+    }
+
     uint32_t index = signal_->outQueue_.front();
     signal_->outQueue_.pop();
 
-    OH_AVBuffer* data = signal_->outBufferQueue_.front();
+    media::Buffer* data = signal_->outBufferQueue_.front();
     signal_->outBufferQueue_.pop();
+    // 写出/回调（可能因暂停或环形缓冲满而阻塞）时不阻塞 codec 的回调线程
+    lock.unlock();
 
     if (!data) {
         OH_LOG_ERROR(LOG_APP, "Output buffer is null");
@@ -1487,26 +1749,27 @@ AudioDecoder::StepResult AudioDecoder::PopOutputData(std::ofstream& outputFile)
     }
 
     // 获取缓冲区属性
-    OH_AVCodecBufferAttr attr = {0};
-    int32_t ret = OH_AVBuffer_GetBufferAttr(data, &attr);
-    if (ret != AV_ERR_OK) {
-        OH_LOG_ERROR(LOG_APP, "Failed to get output buffer attr, error: %{public}d", ret);
+    media::BufferAttr attr;
+    if (!data->GetAttr(&attr)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to get output buffer attr");
         return StepResult::Error;
     }
 
     // 写入解码后的 PCM 数据
-    if (attr.size > 0) {
-        outputFile.write(reinterpret_cast<char*>(OH_AVBuffer_GetAddr(data)), attr.size);
+    if (attr.size > 0 && !sink.Write(data->Addr(), static_cast<size_t>(attr.size))) {
+        OH_LOG_ERROR(LOG_APP, "Failed to write decoded PCM");
+        audioDecoder_->FreeOutputBuffer(index);
+        return StepResult::Error;
     }
 
     // 释放输出缓冲区
-    ret = OH_AudioCodec_FreeOutputBuffer(audioDecoder_, index);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->FreeOutputBuffer(index);
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to free output buffer, error: %{public}d", ret);
         return StepResult::Error;
     }
 
-    if (attr.flags == AVCODEC_BUFFER_FLAGS_EOS) {
+    if (attr.flags == media::kBufferFlagEos) {
         OH_LOG_INFO(LOG_APP, "Reached end of stream (output EOS)");
         return StepResult::Eos;
     }
@@ -1521,37 +1784,33 @@ AudioDecoder::StepResult AudioDecoder::PopOutputData(const PcmDataCallback& pcmC
         return StepResult::Error;
     }
 
-    std::unique_lock<std::mutex> lock(signal_->outMutex_);
-    if (!signal_->outCond_.wait_for(lock, std::chrono::milliseconds(200),
-                                    [this]() {
-                                        if (cancelFlag_ && cancelFlag_->load()) {
-                                            return true;
-                                        }
-                                        return !signal_->outQueue_.empty();
-                                    })) {
-        return StepResult::Continue;
-    }
-
     if (cancelFlag_ && cancelFlag_->load()) {
         OH_LOG_INFO(LOG_APP, "Decode canceled while waiting output buffer");
         return StepResult::Error;
     }
 
+    // 非阻塞：调用方通过 wakeup_ 等待输出缓冲
+    std::unique_lock<std::mutex> lock(signal_->outMutex_);
+    if (signal_->outQueue_.empty()) {
+        return StepResult::Continue;
+    }
+
     uint32_t index = signal_->outQueue_.front();
     signal_->outQueue_.pop();
 
-    OH_AVBuffer* data = signal_->outBufferQueue_.front();
+    media::Buffer* data = signal_->outBufferQueue_.front();
     signal_->outBufferQueue_.pop();
+    // 写出/回调（可能因暂停或环形缓冲满而阻塞）时不阻塞 codec 的回调线程
+    lock.unlock();
 
     if (!data) {
         OH_LOG_ERROR(LOG_APP, "Output buffer is null");
         return StepResult::Error;
     }
 
-    OH_AVCodecBufferAttr attr = {0};
-    int32_t ret = OH_AVBuffer_GetBufferAttr(data, &attr);
-    if (ret != AV_ERR_OK) {
-        OH_LOG_ERROR(LOG_APP, "Failed to get output buffer attr, error: %{public}d", ret);
+    media::BufferAttr attr;
+    if (!data->GetAttr(&attr)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to get output buffer attr");
         return StepResult::Error;
     }
 
@@ -1561,7 +1820,7 @@ AudioDecoder::StepResult AudioDecoder::PopOutputData(const PcmDataCallback& pcmC
             return StepResult::Error;
         }
 
-        const uint8_t* addr = OH_AVBuffer_GetAddr(data);
+        const uint8_t* addr = data->Addr();
         if (!addr) {
             OH_LOG_ERROR(LOG_APP, "Output addr is null");
             return StepResult::Error;
@@ -1574,13 +1833,13 @@ AudioDecoder::StepResult AudioDecoder::PopOutputData(const PcmDataCallback& pcmC
         }
     }
 
-    ret = OH_AudioCodec_FreeOutputBuffer(audioDecoder_, index);
-    if (ret != AV_ERR_OK) {
+    int32_t ret = audioDecoder_->FreeOutputBuffer(index);
+    if (ret != media::kOk) {
         OH_LOG_ERROR(LOG_APP, "Failed to free output buffer, error: %{public}d", ret);
         return StepResult::Error;
     }
 
-    if (attr.flags == AVCODEC_BUFFER_FLAGS_EOS) {
+    if (attr.flags == media::kBufferFlagEos) {
         OH_LOG_INFO(LOG_APP, "Reached end of stream (output EOS)");
         return StepResult::Eos;
     }
@@ -1,14 +1,6 @@
 #ifndef AUDIO_DECODER_H
 #define AUDIO_DECODER_H
 
-#include <multimedia/player_framework/native_avcodec_audiocodec.h>
-#include <multimedia/native_audio_channel_layout.h>
-#include <multimedia/player_framework/native_avcapability.h>
-#include <multimedia/player_framework/native_avcodec_base.h>
-#include <multimedia/player_framework/native_avformat.h>
-#include <multimedia/player_framework/native_avbuffer.h>
-#include <multimedia/player_framework/native_avdemuxer.h>
-#include <multimedia/player_framework/native_avsource.h>
 #include <fcntl.h>
 #include <stdint.h>
 #include <atomic>
@@ -16,24 +8,34 @@
 #include <mutex>
 #include <queue>
 #include <condition_variable>
-#include <fstream>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "codec_pool.h"
+#include "decode_stats.h"
+#include "decode_wakeup.h"
+#include "media/media_backend.h"
+#include "pcm_file_writer.h"
+
 // 音频解码器缓冲区信号类
+// 缓冲入队后通过 wakeup_ 唤醒解码线程（与 seek/暂停/取消共用同一等待原语）
 class AudioDecoderSignal {
 public:
     std::mutex inMutex_;
     std::mutex outMutex_;
     std::mutex startMutex_;
-    std::condition_variable inCond_;
-    std::condition_variable outCond_;
     std::condition_variable startCond_;
     std::queue<uint32_t> inQueue_;
     std::queue<uint32_t> outQueue_;
-    std::queue<OH_AVBuffer *> inBufferQueue_;
-    std::queue<OH_AVBuffer *> outBufferQueue_;
+    std::queue<media::Buffer *> inBufferQueue_;
+    std::queue<media::Buffer *> outBufferQueue_;
+    // codec 回调线程无锁读取；Release / SetupCodec / SetWakeup 在其他线程改写
+    std::atomic<DecodeWakeup*> wakeup_{nullptr};
+    // OnError 置位：该 codec 不再归还实例池，解码循环以 "codec" 错误结束
+    std::atomic<bool> failed_{false};
+    std::atomic<int32_t> errorCode_{0};
 };
 
 // 音频解码器类
@@ -50,11 +52,37 @@ public:
     // - appliedCb: called after the seek attempt is applied (success or failure).
     using SeekPollCallback = std::function<bool(int64_t& targetMs, uint64_t& seq)>;
     using SeekAppliedCallback = std::function<void(uint64_t seq, bool success, int64_t targetMs)>;
-    using EosCallback = std::function<void()>;
+    // - eosCb: called when the stream ends; return false to finish right away instead of
+    //   keeping a short tail window open for seeks (e.g. another track follows).
+    using EosCallback = std::function<bool()>;
+
+    // 文件解码的输出容器
+    enum class OutputContainer {
+        Raw = 0,    // 无头 PCM
+        Wav = 1,    // WAV，超过 4GB 时自动写为 RF64
+    };
 
-    AudioDecoder();
+    // 文件解码的输出策略（DecodeFile* 使用）
+    struct FileOutputOptions {
+        OutputContainer container = OutputContainer::Raw;
+        PcmFileWriter::Options writer;
+        // 按 时长 × 采样率 × 声道 × 2 字节 预分配磁盘空间（时长未知时跳过）
+        bool preallocate = false;
+    };
+
+    // backend：解封装与 codec 的平台实现（设备上为 OH 媒体框架，主机上为基准测试用的替身）
+    explicit AudioDecoder(media::Backend& backend = media::Backend::Default());
     ~AudioDecoder();
 
+    void SetFileOutputOptions(const FileOutputOptions& options) { fileOutputOptions_ = options; }
+
+    // 指定解码线程的等待原语（须在解码开始前调用，nullptr 恢复内部实例）。
+    // 解码线程不再定时轮询：调用方在置位 cancelFlag、发起 seek 等之后必须调用 wakeup->Notify()。
+    void SetWakeup(DecodeWakeup* wakeup);
+
+    // 指定阶段耗时统计（解封装读取、等待 codec 输出），nullptr 关闭；须在解码开始前调用
+    void SetStats(DecodeStats* stats) { stats_ = stats; }
+
     // 解码文件（自动检测格式，使用默认参数：44100Hz, 2声道）
     bool DecodeFile(const std::string& inputPath, const std::string& outputPath);
 
@@ -64,14 +92,18 @@ public:
                    int32_t sampleRate, int32_t channelCount, int32_t bitrate);
 
     // 解码文件（带进度回调；progress=0~1，durationMs 可能为 0 表示未知）
+    // cancelFlag：可选，置 true 时尽快停止并返回 false
+    // 同一实例可连续解码多个文件（codec 经实例池复用）
     bool DecodeFileWithProgress(const std::string& inputPathOrUri, const std::string& outputPath,
                                 int32_t sampleRate, int32_t channelCount, int32_t bitrate,
-                                const ProgressCallback& progressCb);
+                                const ProgressCallback& progressCb,
+                                CancelFlag* cancelFlag = nullptr);
 
     // 流式解码：输出 PCM 数据给回调（用于 AudioRenderer/writeData 拉取式播放）
     // 说明：
     // - infoCb：在解析出音频参数并启动解码器后调用一次
     // - pcmCb：持续回调输出 PCM；返回 false 将中止解码
+    // - codec 路径为流水线模式：解封装/送输入在独立线程，progressCb 也从该线程回调
     // - cancelFlag：可选，置 true 时尽快停止
     // - sampleFormat: 输出采样格式，1=S16LE, 3=S32LE，默认 1
     bool DecodeToPcmStream(const std::string& inputPathOrUri,
@@ -86,6 +118,10 @@ public:
                            const SeekAppliedCallback& seekAppliedCb = SeekAppliedCallback(),
                            const EosCallback& eosCb = EosCallback());
 
+    // 上次调用以来最慢一次解封装读取（Demuxer::ReadSample）的耗时（微秒），并清零。
+    // 可在任意线程调用，用于按源数据读取延迟调整缓冲。
+    int64_t TakeReadLatencyPeakUs() { return readLatencyPeakUs_.exchange(0); }
+
     // 停止解码
     bool Stop();
 
@@ -105,6 +141,14 @@ public:
     // 销毁解码器
     void Destroy();
 
+    // 把 codec 归还进程级实例池（CodecPool），供下一次同 MIME 的解码复用；析构时自动调用。
+    // 解码结束后可提前调用，让后续解码（如播放队列的预解码）尽早取到空闲 codec。
+    void ReleaseCodec();
+
+    // 预先创建 count 个 mimeType 的 codec 放入实例池（未配置，取用时只需 Configure），返回成功个数
+    static size_t PrewarmCodecs(const std::string& mimeType, size_t count,
+                                media::Backend& backend = media::Backend::Default());
+
 private:
     enum class StepResult {
         Continue = 0,
@@ -112,15 +156,20 @@ private:
         Error = 2,
     };
 
-    OH_AVCodec* audioDecoder_;
+    // 读取一帧并记录耗时峰值
+    int32_t ReadSample(media::Demuxer* demuxer, uint32_t trackIndex, media::Buffer* buffer);
+
+    media::Backend& backend_;
+    media::Codec* audioDecoder_;
     AudioDecoderSignal* signal_;
-    OH_AVFormat* format_;
+    // 已调用过 Configure（无论成败），归还实例池前需要 Reset
+    bool configureAttempted_;
     bool isRunning_;
     std::string currentMimeType_;
 
     // 用于 Seek 功能
-    OH_AVSource* avSource_;
-    OH_AVDemuxer* avDemuxer_;
+    media::Source* avSource_;
+    media::Demuxer* avDemuxer_;
     int32_t audioTrackIndex_;
     std::string currentInputPathOrUri_;
 
@@ -138,9 +187,30 @@ private:
 
     CancelFlag* cancelFlag_;
 
-    // 初始化解码器（使用指定的 MIME 类型）
+    // 流水线解码时由输出线程置位，让等待输入缓冲的 feeder 线程立即返回
+    std::atomic<bool> inputInterrupt_;
+
+    std::atomic<int64_t> readLatencyPeakUs_;
+    DecodeStats* stats_;
+
+    DecodeWakeup ownWakeup_;
+    DecodeWakeup* wakeup_;
+
+    FileOutputOptions fileOutputOptions_;
+
+    // 当前 codec 的配置（已配置时用于归还实例池）
+    bool codecConfigured_;
+    CodecPool::Config codecConfig_;
+
+    // 创建新的解码器（使用指定的 MIME 类型）
     bool Initialize(const std::string& mimeType);
 
+    // 取得已启动的解码器：优先从实例池取同 MIME 的空闲 codec（同配置直接 Start，
+    // 否则 Reset 后重新 Configure），没有时 Initialize + Configure + Start。
+    // 失败时 failedStage 为 "init_decoder" / "configure" / "start"
+    bool SetupCodec(const std::string& mimeType, int32_t sampleRate, int32_t channelCount, int32_t bitrate,
+                    int32_t sampleFormat, std::string* failedStage);
+
     // 配置解码器参数
     // sampleRate: 采样率（必须），<= 0 时使用默认值 44100
     // channelCount: 声道数（必须），<= 0 时使用默认值 2
@@ -151,22 +221,29 @@ private:
     // 开始解码
     bool Start();
 
+    // 清空回调队列中残留的缓冲区索引（codec 已 Stop/Reset 时调用）
+    void ClearSignalQueues();
+
+    bool IsCanceled() const;
+    bool HasInputBuffer();
+    bool HasOutputBuffer();
+
     // 从文件路径获取 MIME 类型
     std::string GetMimeTypeFromFile(const std::string& filePath);
 
     // 回调函数
-    static void OnError(OH_AVCodec *codec, int32_t errorCode, void *userData);
-    static void OnOutputFormatChanged(OH_AVCodec *codec, OH_AVFormat *format, void *userData);
-    static void OnInputBufferAvailable(OH_AVCodec *codec, uint32_t index, OH_AVBuffer *data, void *userData);
-    static void OnOutputBufferAvailable(OH_AVCodec *codec, uint32_t index, OH_AVBuffer *data, void *userData);
+    static void OnError(int32_t errorCode, void *userData);
+    static void OnOutputFormatChanged(const media::CodecFormat& format, void *userData);
+    static void OnInputBufferAvailable(uint32_t index, media::Buffer *data, void *userData);
+    static void OnOutputBufferAvailable(uint32_t index, media::Buffer *data, void *userData);
 
-    // 输入数据处理（从解封装器读取）
-    StepResult PushInputData(OH_AVDemuxer* demuxer, uint32_t trackIndex, const ProgressCallback& progressCb);
+    // 输入数据处理（从解封装器读取；无可用输入缓冲时立即返回 Continue）
+    StepResult PushInputData(media::Demuxer* demuxer, uint32_t trackIndex, const ProgressCallback& progressCb);
 
-    // 输出数据处理
-    StepResult PopOutputData(std::ofstream& outputFile);
+    // 输出数据处理（写入输出 sink；无可用输出缓冲时立即返回 Continue）
+    StepResult PopOutputData(PcmOutputSink& sink);
 
-    // 输出数据处理（PCM 回调）
+    // 输出数据处理（PCM 回调；无可用输出缓冲时立即返回 Continue）
     StepResult PopOutputData(const PcmDataCallback& pcmCb);
 
     // 内部解码实现（使用解封装器）
@@ -0,0 +1,61 @@
+#ifndef BENCH_SIGNAL_H
+#define BENCH_SIGNAL_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+constexpr int32_t kSampleRate = 48000;
+
+// Frame counts of one decoder output / render callback (5.3 ms .. 85 ms at 48 kHz).
+constexpr int64_t kMinFrames = 256;
+constexpr int64_t kMaxFrames = 4096;
+
+// Sample rates of the rate-dependent DSP benchmarks.
+constexpr int32_t kSampleRates[] = {44100, 48000, 96000};
+
+// Music-like interleaved test signal: two partials per channel plus a little
+// deterministic noise, peaking around -3 dBFS so the DRC and limiter engage.
+inline std::vector<float> MakeSignal(size_t frames, size_t channels, int32_t sampleRate = kSampleRate)
+{
+    std::vector<float> out(frames * channels);
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < frames; i++) {
+        const float t = static_cast<float>(i) / static_cast<float>(sampleRate);
+        for (size_t c = 0; c < channels; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            const float noise = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+            const float f = 220.0f * static_cast<float>(c + 1);
+            out[i * channels + c] = 0.45f * std::sin(6.2831853f * f * t) +
+                                    0.2f * std::sin(6.2831853f * f * 3.01f * t) + 0.05f * noise;
+        }
+    }
+    return out;
+}
+
+inline std::vector<int16_t> MakeSignalS16(size_t frames, size_t channels, int32_t sampleRate = kSampleRate)
+{
+    const std::vector<float> f = MakeSignal(frames, channels, sampleRate);
+    std::vector<int16_t> out(f.size());
+    for (size_t i = 0; i < f.size(); i++) {
+        out[i] = static_cast<int16_t>(std::lrint(f[i] * 32767.0f));
+    }
+    return out;
+}
+
+inline std::vector<int32_t> MakeSignalS32(size_t frames, size_t channels, int32_t sampleRate = kSampleRate)
+{
+    const std::vector<float> f = MakeSignal(frames, channels, sampleRate);
+    std::vector<int32_t> out(f.size());
+    for (size_t i = 0; i < f.size(); i++) {
+        out[i] = static_cast<int32_t>(std::lrint(static_cast<double>(f[i]) * 2147483647.0));
+    }
+    return out;
+}
+
+} // namespace bench
+
+#endif
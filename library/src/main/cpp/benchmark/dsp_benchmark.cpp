@@ -0,0 +1,480 @@
+// DSP stage benchmarks. Every benchmark processes one buffer of `frames`
+// interleaved frames per iteration, the way the stream decoder feeds a decoded
+// codec buffer through the chain. The input is copied into the work buffer
+// each iteration (in-place stages would otherwise feed on their own output);
+// the copy is part of the measurement, as the scratch load is in the decoder.
+//
+// Arguments: {frames, channels}, plus the sample rate for the EQ, DRC,
+// limiter, pitch and chain benchmarks (filter coefficients, lookahead and
+// detector lengths depend on it). items_per_second counts frames.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "bench_signal.h"
+#include "decode_stats.h"
+#include "drc_processor.h"
+#include "dsp_chain.h"
+#include "pcm_convert.h"
+#include "pcm_crossfade.h"
+#include "pcm_equalizer.h"
+#include "pcm_pitch_shifter.h"
+#include "triple_buffer.h"
+#include "true_peak_limiter.h"
+
+namespace {
+
+// Frames x channels: mono, stereo, 5.1 and 7.1 at render / codec buffer sizes.
+void FramesAndChannels(benchmark::internal::Benchmark* b)
+{
+    for (int64_t ch : {1, 2, 6, 8}) {
+        for (int64_t frames = bench::kMinFrames; frames <= bench::kMaxFrames; frames *= 4) {
+            b->Args({frames, ch});
+        }
+    }
+}
+
+void StereoOnly(benchmark::internal::Benchmark* b)
+{
+    for (int64_t frames = bench::kMinFrames; frames <= bench::kMaxFrames; frames *= 4) {
+        b->Args({frames, 2});
+    }
+}
+
+// {frames, channels, sampleRate}: every layout at 48 kHz, stereo also at 44.1
+// and 96 kHz.
+void FramesChannelsAndRate(benchmark::internal::Benchmark* b)
+{
+    for (int64_t ch : {1, 2, 6, 8}) {
+        for (int64_t rate : bench::kSampleRates) {
+            if (ch != 2 && rate != bench::kSampleRate) {
+                continue;
+            }
+            for (int64_t frames = bench::kMinFrames; frames <= bench::kMaxFrames; frames *= 4) {
+                b->Args({frames, ch, rate});
+            }
+        }
+    }
+}
+
+void StereoAndRate(benchmark::internal::Benchmark* b)
+{
+    for (int64_t rate : bench::kSampleRates) {
+        for (int64_t frames = bench::kMinFrames; frames <= bench::kMaxFrames; frames *= 4) {
+            b->Args({frames, 2, rate});
+        }
+    }
+}
+
+constexpr std::array<float, PcmEqualizer::kBandCount> kEqGainsDb = {4.0f, 3.0f, 1.5f, 0.0f, -1.0f,
+                                                                    -2.0f, 0.5f, 2.0f, 3.5f, 5.0f};
+
+void InitEq(PcmEqualizer& eq, int32_t channels, int32_t sampleRate)
+{
+    eq.Init(sampleRate, channels);
+    eq.SetGainsDb(kEqGainsDb);
+    eq.SetEnabled(true);
+}
+
+void InitDrc(DrcProcessor& drc, int32_t channels, int32_t sampleRate)
+{
+    drc.Init(sampleRate, channels);
+    drc.SetParams(-18.0f, 4.0f, 10.0f, 120.0f, 6.0f);
+    drc.SetEnabled(true);
+}
+
+void InitLimiter(TruePeakLimiter& limiter, int32_t channels, int32_t sampleRate)
+{
+    limiter.Init(sampleRate, channels);
+    limiter.SetParams(-1.0f, 5.0f, 1.0f, 80.0f);
+    limiter.SetEnabled(true);
+}
+
+void InitPitch(PcmPitchShifter& pitch, int32_t channels, int32_t sampleRate)
+{
+    pitch.Init(sampleRate, channels);
+    pitch.SetSemitones(5);
+    pitch.SetEnabled(true);
+}
+
+void SetFrames(benchmark::State& state, size_t frames)
+{
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(frames));
+}
+
+// ----------------------------------------------------------------------------
+// Equalizer
+// ----------------------------------------------------------------------------
+
+void BM_EqualizerFloat(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<float> in = bench::MakeSignal(frames, static_cast<size_t>(ch), rate);
+    std::vector<float> work(in.size());
+    PcmEqualizer eq;
+    InitEq(eq, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        eq.ProcessFloat(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_EqualizerFloat)->Apply(FramesChannelsAndRate);
+
+void BM_EqualizerS16(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<int16_t> in = bench::MakeSignalS16(frames, static_cast<size_t>(ch), rate);
+    std::vector<int16_t> work(in.size());
+    PcmEqualizer eq;
+    InitEq(eq, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        eq.Process(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_EqualizerS16)->Apply(StereoAndRate);
+
+void BM_EqualizerS32(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<int32_t> in = bench::MakeSignalS32(frames, static_cast<size_t>(ch), rate);
+    std::vector<int32_t> work(in.size());
+    PcmEqualizer eq;
+    InitEq(eq, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        eq.Process(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_EqualizerS32)->Apply(StereoAndRate);
+
+// ----------------------------------------------------------------------------
+// DRC
+// ----------------------------------------------------------------------------
+
+void BM_DrcFloat(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<float> in = bench::MakeSignal(frames, static_cast<size_t>(ch), rate);
+    std::vector<float> work(in.size());
+    DrcProcessor drc;
+    InitDrc(drc, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        drc.ProcessFloat(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_DrcFloat)->Apply(FramesChannelsAndRate);
+
+void BM_DrcS16(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<int16_t> in = bench::MakeSignalS16(frames, static_cast<size_t>(ch), rate);
+    std::vector<int16_t> work(in.size());
+    DrcProcessor drc;
+    InitDrc(drc, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        drc.Process(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_DrcS16)->Apply(StereoAndRate);
+
+// ----------------------------------------------------------------------------
+// True-peak limiter
+// ----------------------------------------------------------------------------
+
+void BM_TruePeakLimiter(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    std::vector<float> in = bench::MakeSignal(frames, static_cast<size_t>(ch), rate);
+    // +6 dB so the ceiling is exceeded and the gain path is exercised.
+    for (float& s : in) {
+        s *= 2.0f;
+    }
+    std::vector<float> work(in.size());
+    TruePeakLimiter limiter;
+    InitLimiter(limiter, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        limiter.ProcessFloat(work.data(), frames);
+        benchmark::DoNotOptimize(work.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_TruePeakLimiter)->Apply(FramesChannelsAndRate);
+
+// ----------------------------------------------------------------------------
+// Pitch shifter
+// ----------------------------------------------------------------------------
+
+void BM_PitchShifter(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const std::vector<float> in = bench::MakeSignal(frames, static_cast<size_t>(ch), rate);
+    std::vector<float> work(in.size());
+    PcmPitchShifter pitch;
+    InitPitch(pitch, ch, rate);
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), work.begin());
+        benchmark::DoNotOptimize(pitch.ProcessFloat(work.data(), frames));
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_PitchShifter)->Apply(FramesChannelsAndRate);
+
+// ----------------------------------------------------------------------------
+// Full chain: S16 in -> EQ, pitch, channel volume, DRC, limiter -> S16 out
+// ----------------------------------------------------------------------------
+
+void RunChain(benchmark::State& state, uint32_t stages, DecodeStats* stats = nullptr)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const int32_t ch = static_cast<int32_t>(state.range(1));
+    const int32_t rate = static_cast<int32_t>(state.range(2));
+    const size_t chs = static_cast<size_t>(ch);
+    const std::vector<int16_t> in = bench::MakeSignalS16(frames, chs, rate);
+    std::vector<int16_t> out(in.size());
+
+    PcmEqualizer eq;
+    PcmPitchShifter pitch;
+    DrcProcessor drc;
+    TruePeakLimiter limiter;
+    InitEq(eq, ch, rate);
+    InitPitch(pitch, ch, rate);
+    InitDrc(drc, ch, rate);
+    InitLimiter(limiter, ch, rate);
+    DspChain chain(eq, pitch, drc, limiter);
+    chain.Configure(ch, stages, 0.9f, 0.8f);
+    chain.SetStats(stats);
+
+    const float norm = 1.0f / 32768.0f;
+    const float preamp = 0.5f;
+    auto source = [&in, chs, norm, preamp](float* f, size_t n) {
+        pcm_convert::S16ToFloat(in.data(), f, n * chs, norm, preamp);
+    };
+    auto sink = [&out, chs](const float* f, size_t n) {
+        pcm_convert::FloatToS16(f, out.data(), n * chs, 32768.0f);
+        return true;
+    };
+    for (auto _ : state) {
+        chain.Run(frames, source, sink);
+        benchmark::DoNotOptimize(out.data());
+    }
+    SetFrames(state, frames);
+}
+
+void BM_DspChainLimiterOnly(benchmark::State& state)
+{
+    RunChain(state, DspChain::kStageLimiter);
+}
+BENCHMARK(BM_DspChainLimiterOnly)->Apply(FramesChannelsAndRate);
+
+void BM_DspChainAllStages(benchmark::State& state)
+{
+    RunChain(state, DspChain::kStageEq | DspChain::kStagePitch | DspChain::kStageChannelVolume |
+                        DspChain::kStageDrc | DspChain::kStageLimiter);
+}
+BENCHMARK(BM_DspChainAllStages)->Apply(FramesChannelsAndRate);
+
+// Same chain with per-stage timing (getStats()): the difference to
+// BM_DspChainAllStages is the instrumentation overhead.
+void BM_DspChainAllStagesTimed(benchmark::State& state)
+{
+    DecodeStats stats;
+    RunChain(state, DspChain::kStageEq | DspChain::kStagePitch | DspChain::kStageChannelVolume |
+                        DspChain::kStageDrc | DspChain::kStageLimiter, &stats);
+}
+BENCHMARK(BM_DspChainAllStagesTimed)->Apply(FramesChannelsAndRate);
+
+// Ten minutes of stereo 48 kHz S16 through EQ, channel volume, DRC and the
+// limiter, S16 out, in decoder callbacks of range(0) frames. Input cycles
+// through 10 s of signal so the source streams from memory like a codec
+// buffer; output goes to one callback-sized buffer like the ring. One
+// iteration is the whole track: compare real_time across builds.
+void BM_DspChainTenMinutes(benchmark::State& state)
+{
+    const size_t callbackFrames = static_cast<size_t>(state.range(0));
+    const int32_t ch = 2;
+    const size_t chs = static_cast<size_t>(ch);
+    const int32_t rate = bench::kSampleRate;
+    const size_t trackFrames = static_cast<size_t>(rate) * 600;
+    const size_t loopFrames = (static_cast<size_t>(rate) * 10 / callbackFrames) * callbackFrames;
+    const std::vector<int16_t> in = bench::MakeSignalS16(loopFrames, chs, rate);
+    std::vector<int16_t> out(callbackFrames * chs);
+
+    PcmEqualizer eq;
+    PcmPitchShifter pitch;
+    DrcProcessor drc;
+    TruePeakLimiter limiter;
+    InitEq(eq, ch, rate);
+    InitDrc(drc, ch, rate);
+    InitLimiter(limiter, ch, rate);
+    DspChain chain(eq, pitch, drc, limiter);
+    chain.Configure(ch, DspChain::kStageEq | DspChain::kStageChannelVolume | DspChain::kStageDrc |
+                            DspChain::kStageLimiter, 0.9f, 0.8f);
+
+    const float norm = 1.0f / 32768.0f;
+    const float preamp = 0.5f;
+    for (auto _ : state) {
+        for (size_t done = 0; done < trackFrames;) {
+            const size_t n = std::min(callbackFrames, trackFrames - done);
+            const int16_t* src = in.data() + (done % loopFrames) * chs;
+            auto source = [src, chs, norm, preamp](float* f, size_t k) {
+                pcm_convert::S16ToFloat(src, f, k * chs, norm, preamp);
+            };
+            auto sink = [&out, chs](const float* f, size_t k) {
+                pcm_convert::FloatToS16(f, out.data(), k * chs, 32768.0f);
+                benchmark::DoNotOptimize(out.data());
+                return true;
+            };
+            chain.Run(n, source, sink);
+            done += n;
+        }
+    }
+    SetFrames(state, trackFrames);
+}
+BENCHMARK(BM_DspChainTenMinutes)->Arg(1024)->Arg(4096)->Arg(16384)->Iterations(1)->Repetitions(3)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// ----------------------------------------------------------------------------
+// Crossfade mix and sample format conversion
+// ----------------------------------------------------------------------------
+
+void BM_CrossfadeMixTile(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const size_t chs = static_cast<size_t>(state.range(1));
+    const std::vector<float> outgoing = bench::MakeSignal(frames, chs);
+    const std::vector<float> incoming = bench::MakeSignal(frames, chs);
+    std::vector<float> work(outgoing.size());
+    const size_t window = static_cast<size_t>(bench::kSampleRate) * 3;  // 3 s crossfade
+    size_t pos = 0;
+    for (auto _ : state) {
+        std::copy(outgoing.begin(), outgoing.end(), work.begin());
+        PcmCrossfade::MixTile(work.data(), incoming.data(), frames, chs, pos, window);
+        benchmark::DoNotOptimize(work.data());
+        pos = (pos + frames) % window;
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_CrossfadeMixTile)->Apply(FramesAndChannels);
+
+void BM_ConvertS16ToFloat(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const size_t chs = static_cast<size_t>(state.range(1));
+    const std::vector<int16_t> in = bench::MakeSignalS16(frames, chs);
+    std::vector<float> out(in.size());
+    for (auto _ : state) {
+        pcm_convert::S16ToFloat(in.data(), out.data(), in.size(), 1.0f / 32768.0f, 0.5f);
+        benchmark::DoNotOptimize(out.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_ConvertS16ToFloat)->Apply(StereoOnly);
+
+void BM_ConvertS24ToFloat(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const size_t chs = static_cast<size_t>(state.range(1));
+    const std::vector<int32_t> s32 = bench::MakeSignalS32(frames, chs);
+    std::vector<uint8_t> in(s32.size() * pcm_convert::kS24Bytes);
+    for (size_t i = 0; i < s32.size(); i++) {
+        const uint32_t v = static_cast<uint32_t>(s32[i]) >> 8;
+        in[i * 3] = static_cast<uint8_t>(v);
+        in[i * 3 + 1] = static_cast<uint8_t>(v >> 8);
+        in[i * 3 + 2] = static_cast<uint8_t>(v >> 16);
+    }
+    std::vector<float> out(s32.size());
+    for (auto _ : state) {
+        pcm_convert::S24ToFloat(in.data(), out.data(), out.size(), 1.0f / 8388608.0f, 0.5f);
+        benchmark::DoNotOptimize(out.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_ConvertS24ToFloat)->Apply(StereoOnly);
+
+void BM_ConvertFloatToS16(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const size_t chs = static_cast<size_t>(state.range(1));
+    const std::vector<float> in = bench::MakeSignal(frames, chs);
+    std::vector<int16_t> out(in.size());
+    for (auto _ : state) {
+        pcm_convert::FloatToS16(in.data(), out.data(), in.size(), 32768.0f);
+        benchmark::DoNotOptimize(out.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_ConvertFloatToS16)->Apply(StereoOnly);
+
+void BM_ConvertFloatToS32(benchmark::State& state)
+{
+    const size_t frames = static_cast<size_t>(state.range(0));
+    const size_t chs = static_cast<size_t>(state.range(1));
+    const std::vector<float> in = bench::MakeSignal(frames, chs);
+    std::vector<int32_t> out(in.size());
+    for (auto _ : state) {
+        pcm_convert::FloatToS32(in.data(), out.data(), in.size(), 2147483648.0f);
+        benchmark::DoNotOptimize(out.data());
+    }
+    SetFrames(state, frames);
+}
+BENCHMARK(BM_ConvertFloatToS32)->Apply(StereoOnly);
+
+
+// Per-buffer parameter pick-up on the decode thread: an EQ-sized snapshot
+// (10 bands x 2 channels). Arg 0: nothing published since the last buffer;
+// arg 1: a new snapshot per buffer (publish + exchange, single thread).
+void BM_ParamSnapshotAcquire(benchmark::State& state)
+{
+    struct Params {
+        bool enabled = true;
+        std::array<std::array<float, PcmEqualizer::kBandCount>, 2> gainsDb{};
+        float preamp = 1.0f;
+    };
+    const bool publish = state.range(0) != 0;
+    TripleBuffer<Params> params;
+    Params next;
+    float sum = 0.0f;
+    for (auto _ : state) {
+        if (publish) {
+            next.gainsDb[0][0] += 0.01f;
+            params.Publish(next);
+        }
+        params.Acquire();
+        sum += params.Current().gainsDb[0][0];
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_ParamSnapshotAcquire)->Arg(0)->Arg(1);
+} // namespace
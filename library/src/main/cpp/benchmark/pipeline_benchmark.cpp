@@ -0,0 +1,490 @@
+// End-to-end stream decode benchmarks: AudioDecoder::DecodeToPcmStream on the
+// host media backend (media/host_media_backend.h), feeding the float DSP chain
+// and the PCM ring the way the stream decoder does. Source I/O and codec costs
+// are simulated per demuxed packet (1024 frames, 21.3 ms at 48 kHz), so these
+// measure the pipeline around them: threads, wakeups, buffer hand-offs.
+//
+// Input: a generated 48 kHz stereo S16 WAV of kFileSeconds.
+//
+// FREE_PCM_TRACE=<path> records a DecodeTrace timeline of the whole run and
+// writes it to <path> at exit (Chrome trace-event JSON).
+
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "bench_signal.h"
+#include "codec_pool.h"
+#include "decode_trace.h"
+#include "drc_processor.h"
+#include "dsp_chain.h"
+#include "media/host_media_backend.h"
+#include "pcm_convert.h"
+#include "pcm_equalizer.h"
+#include "pcm_pitch_shifter.h"
+#include "ring_buffer.h"
+#include "true_peak_limiter.h"
+
+namespace {
+
+constexpr int32_t kChannels = 2;
+constexpr size_t kFrameBytes = kChannels * sizeof(int16_t);
+constexpr int64_t kFileSeconds = 20;
+constexpr int64_t kPacketFrames = 1024;
+
+using Clock = std::chrono::steady_clock;
+
+class TraceFile {
+public:
+    TraceFile()
+    {
+        const char* path = getenv("FREE_PCM_TRACE");
+        if (path != nullptr && path[0] != '\0') {
+            path_ = path;
+            DecodeTrace::Start(DecodeTrace::kMaxEventsPerThread);
+        }
+    }
+    ~TraceFile()
+    {
+        if (path_.empty()) {
+            return;
+        }
+        DecodeTrace::Stop();
+        const std::string json = DecodeTrace::Dump();
+        FILE* f = fopen(path_.c_str(), "w");
+        if (f != nullptr) {
+            fwrite(json.data(), 1, json.size(), f);
+            fclose(f);
+        }
+    }
+
+private:
+    std::string path_;
+};
+
+TraceFile g_traceFile;
+
+void PutLe(std::string* out, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+// Test WAV in the temp directory, created on first use and removed at exit.
+class TestWav {
+public:
+    static const std::string& Path()
+    {
+        static TestWav wav;
+        return wav.path_;
+    }
+
+    ~TestWav()
+    {
+        if (!path_.empty()) {
+            unlink(path_.c_str());
+        }
+    }
+
+private:
+    TestWav()
+    {
+        const char* dir = std::getenv("TMPDIR");
+        std::string pattern = std::string(dir != nullptr ? dir : "/tmp") + "/free_pcm_bench_XXXXXX";
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        const int fd = mkstemp(name.data());
+        if (fd < 0) {
+            return;
+        }
+        const size_t frames = static_cast<size_t>(kFileSeconds * bench::kSampleRate);
+        const std::vector<int16_t> pcm = bench::MakeSignalS16(frames, kChannels);
+        const uint32_t dataBytes = static_cast<uint32_t>(pcm.size() * sizeof(int16_t));
+
+        std::string header = "RIFF";
+        PutLe(&header, 36 + dataBytes, 4);
+        header += "WAVEfmt ";
+        PutLe(&header, 16, 4);
+        PutLe(&header, 1, 2);  // PCM
+        PutLe(&header, kChannels, 2);
+        PutLe(&header, bench::kSampleRate, 4);
+        PutLe(&header, bench::kSampleRate * kFrameBytes, 4);
+        PutLe(&header, kFrameBytes, 2);
+        PutLe(&header, 16, 2);
+        header += "data";
+        PutLe(&header, dataBytes, 4);
+
+        const bool ok = write(fd, header.data(), header.size()) == static_cast<ssize_t>(header.size()) &&
+                        write(fd, pcm.data(), dataBytes) == static_cast<ssize_t>(dataBytes);
+        close(fd);
+        path_ = name.data();
+        if (!ok) {
+            unlink(path_.c_str());
+            path_.clear();
+        }
+    }
+
+    std::string path_;
+};
+
+// S16 decoder output -> float DSP chain (EQ, DRC, limiter) -> S16 -> ring,
+// as the stream decoder's PCM callback does.
+class DspToRing {
+public:
+    explicit DspToRing(size_t ringBytes)
+        : chain_(eq_, pitch_, drc_, limiter_), ring_(ringBytes, bench::kSampleRate, kChannels, sizeof(int16_t))
+    {
+        eq_.Init(bench::kSampleRate, kChannels);
+        eq_.SetGainsDb({4.0f, 3.0f, 1.5f, 0.0f, -1.0f, -2.0f, 0.5f, 2.0f, 3.5f, 5.0f});
+        eq_.SetEnabled(true);
+        pitch_.Init(bench::kSampleRate, kChannels);
+        drc_.Init(bench::kSampleRate, kChannels);
+        drc_.SetParams(-18.0f, 4.0f, 10.0f, 120.0f, 6.0f);
+        drc_.SetEnabled(true);
+        limiter_.Init(bench::kSampleRate, kChannels);
+        limiter_.SetParams(-1.0f, 5.0f, 1.0f, 80.0f);
+        limiter_.SetEnabled(true);
+        chain_.Configure(kChannels, DspChain::kStageEq | DspChain::kStageDrc | DspChain::kStageLimiter, 1.0f, 1.0f);
+    }
+
+    bool Process(const uint8_t* data, size_t size, const std::atomic<bool>* cancel)
+    {
+        const size_t frames = size / kFrameBytes;
+        const size_t samples = frames * kChannels;
+        const int16_t* in = reinterpret_cast<const int16_t*>(data);
+        out_.resize(samples);
+        auto source = [in](float* f, size_t n) {
+            pcm_convert::S16ToFloat(in, f, n * kChannels, 1.0f / 32768.0f, 1.0f);
+        };
+        auto sink = [this](const float* f, size_t n) {
+            pcm_convert::FloatToS16(f, out_.data(), n * kChannels, 32768.0f);
+            return true;
+        };
+        chain_.Run(frames, source, sink);
+        return ring_.Push(reinterpret_cast<const uint8_t*>(out_.data()), samples * sizeof(int16_t), cancel);
+    }
+
+    audio::PcmRingBuffer& Ring() { return ring_; }
+
+private:
+    PcmEqualizer eq_;
+    PcmPitchShifter pitch_;
+    DrcProcessor drc_;
+    TruePeakLimiter limiter_;
+    DspChain chain_;
+    audio::PcmRingBuffer ring_;
+    std::vector<int16_t> out_;
+};
+
+media::HostMediaBackend::Options MakeOptions(int64_t readLatencyUs, int64_t readJitterUs, int64_t decodeLatencyUs)
+{
+    media::HostMediaBackend::Options options;
+    options.rawSampleRate = bench::kSampleRate;
+    options.rawChannelCount = kChannels;
+    options.packetFrames = static_cast<int32_t>(kPacketFrames);
+    options.readLatencyUs = readLatencyUs;
+    options.readJitterUs = readJitterUs;
+    options.decodeLatencyUs = decodeLatencyUs;
+    return options;
+}
+
+// Pooled codecs keep the delays of the backend that created them; drop them
+// before the backend goes away (another one may reuse its address).
+struct PoolReset {
+    ~PoolReset() { CodecPool::Shared().Clear(); }
+};
+
+// Decodes with no seek support and no EOS tail window.
+bool Decode(AudioDecoder& decoder, const AudioDecoder::PcmDataCallback& pcmCb, std::atomic<bool>* cancel,
+            const AudioDecoder::SeekPollCallback& seekPollCb = AudioDecoder::SeekPollCallback(),
+            const AudioDecoder::SeekAppliedCallback& seekAppliedCb = AudioDecoder::SeekAppliedCallback())
+{
+    return decoder.DecodeToPcmStream(TestWav::Path(), 0, 0, 0, nullptr, nullptr, pcmCb, nullptr, cancel, 1,
+                                     seekPollCb, seekAppliedCb, []() { return false; });
+}
+
+// ----------------------------------------------------------------------------
+// Throughput: the whole file per iteration, drained by a consumer that never
+// waits on the clock. Arguments: {readLatencyUs, decodeLatencyUs}.
+// realtimeX = seconds of audio per wall-clock second.
+// ----------------------------------------------------------------------------
+
+void BM_PipelineThroughput(benchmark::State& state)
+{
+    if (TestWav::Path().empty()) {
+        state.SkipWithError("cannot create test WAV");
+        return;
+    }
+    PoolReset poolReset;
+    media::HostMediaBackend backend(MakeOptions(state.range(0), 0, state.range(1)));
+    int64_t frames = 0;
+    for (auto _ : state) {
+        AudioDecoder decoder(backend);
+        DspToRing dsp(256 * 1024);
+        std::atomic<bool> cancel{false};
+        std::thread consumer([&dsp]() {
+            std::vector<uint8_t> period(bench::kMaxFrames * kFrameBytes);
+            while (!dsp.Ring().IsEos()) {
+                dsp.Ring().ReadBlocking(period.data(), period.size(), -1);
+            }
+        });
+        const bool ok = Decode(
+            decoder,
+            [&dsp, &cancel, &frames](const uint8_t* data, size_t size, int64_t) {
+                frames += static_cast<int64_t>(size / kFrameBytes);
+                return dsp.Process(data, size, &cancel);
+            },
+            &cancel);
+        dsp.Ring().MarkEos();
+        consumer.join();
+        if (!ok) {
+            state.SkipWithError("decode failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["realtimeX"] = benchmark::Counter(static_cast<double>(frames) / bench::kSampleRate,
+                                                     benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PipelineThroughput)
+    ->Args({0, 0})
+    ->Args({200, 0})
+    ->Args({0, 500})
+    ->Args({1000, 1000})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// ----------------------------------------------------------------------------
+// Seek latency: from posting a seek request to the first PCM at or after the
+// target, through stop/seek/flush/start of the codec and the refill of its
+// buffers. The consumer holds the pipeline full (a full ring) between seeks.
+// Arguments: {readLatencyUs, decodeLatencyUs}.
+// ----------------------------------------------------------------------------
+
+class SeekDriver {
+public:
+    // Posts a seek and waits for the first PCM at or after the target; false if
+    // the decode ended first.
+    bool SeekAndWait(int64_t targetMs, DecodeWakeup& wakeup)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pendingMs_ = targetMs;
+        pendingSeq_ = ++postedSeq_;
+        cond_.notify_all();
+        lock.unlock();
+        wakeup.Notify();
+        lock.lock();
+        cond_.wait(lock, [this]() { return reachedSeq_ == postedSeq_ || finished_; });
+        return reachedSeq_ == postedSeq_;
+    }
+
+    bool Poll(int64_t& targetMs, uint64_t& seq)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pendingSeq_ == 0) {
+            return false;
+        }
+        targetMs = pendingMs_;
+        seq = pendingSeq_;
+        pendingSeq_ = 0;
+        return true;
+    }
+
+    void Applied(uint64_t seq, bool success, int64_t targetMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (success) {
+            appliedSeq_ = seq;
+            appliedTargetUs_ = targetMs * 1000;
+        }
+    }
+
+    // PCM callback: once the current seek is reached, holds the decode thread
+    // until the next seek is posted.
+    bool OnPcm(int64_t ptsUs, const std::atomic<bool>& cancel)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (appliedSeq_ != postedSeq_ || ptsUs < appliedTargetUs_) {
+            return true;
+        }
+        reachedSeq_ = appliedSeq_;
+        cond_.notify_all();
+        cond_.wait(lock, [this, &cancel]() { return postedSeq_ != reachedSeq_ || cancel.load(); });
+        return !cancel.load();
+    }
+
+    void Finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        cond_.notify_all();
+    }
+
+    void Cancel(std::atomic<bool>& cancel)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel.store(true);
+        cond_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint64_t postedSeq_ = 0;
+    uint64_t pendingSeq_ = 0;
+    int64_t pendingMs_ = 0;
+    uint64_t appliedSeq_ = 0;
+    int64_t appliedTargetUs_ = 0;
+    uint64_t reachedSeq_ = 0;
+    bool finished_ = false;
+};
+
+void BM_PipelineSeekLatency(benchmark::State& state)
+{
+    if (TestWav::Path().empty()) {
+        state.SkipWithError("cannot create test WAV");
+        return;
+    }
+    PoolReset poolReset;
+    media::HostMediaBackend backend(MakeOptions(state.range(0), 0, state.range(1)));
+    DecodeWakeup wakeup;  // outlives the decoder and its codec callbacks
+    AudioDecoder decoder(backend);
+    decoder.SetWakeup(&wakeup);
+    SeekDriver driver;
+    std::atomic<bool> cancel{false};
+
+    std::thread decodeThread([&]() {
+        Decode(
+            decoder, [&driver, &cancel](const uint8_t*, size_t, int64_t ptsUs) { return driver.OnPcm(ptsUs, cancel); },
+            &cancel, [&driver](int64_t& targetMs, uint64_t& seq) { return driver.Poll(targetMs, seq); },
+            [&driver](uint64_t seq, bool success, int64_t targetMs) { driver.Applied(seq, success, targetMs); });
+        driver.Finish();
+    });
+
+    // Deterministic targets over the first kFileSeconds - 2 s.
+    uint32_t lcg = 12345;
+    for (auto _ : state) {
+        lcg = lcg * 1664525u + 1013904223u;
+        const int64_t targetMs = static_cast<int64_t>(lcg >> 8) % ((kFileSeconds - 2) * 1000);
+        const auto start = Clock::now();
+        if (!driver.SeekAndWait(targetMs, wakeup)) {
+            state.SkipWithError("decode ended before the seek completed");
+            break;
+        }
+        state.SetIterationTime(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    driver.Cancel(cancel);
+    wakeup.Notify();
+    decodeThread.join();
+}
+BENCHMARK(BM_PipelineSeekLatency)
+    ->Args({0, 0})
+    ->Args({200, 0})
+    ->Args({0, 500})
+    ->Args({1000, 1000})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
+
+// ----------------------------------------------------------------------------
+// Underruns: a renderer reading 10 ms periods on a real-time clock from a
+// 200 ms ring, while source reads take readLatencyUs + U(0, readJitterUs) per
+// 21.3 ms packet. One iteration plays kPlaySeconds after a full prebuffer.
+// Arguments: {readLatencyUs, readJitterUs}. underruns = short periods.
+// ----------------------------------------------------------------------------
+
+constexpr int64_t kPlaySeconds = 3;
+constexpr int64_t kPeriodMs = 10;
+constexpr size_t kUnderrunRingBytes = bench::kSampleRate / 5 * kFrameBytes;
+
+void BM_PipelineUnderrun(benchmark::State& state)
+{
+    if (TestWav::Path().empty()) {
+        state.SkipWithError("cannot create test WAV");
+        return;
+    }
+    PoolReset poolReset;
+    media::HostMediaBackend::Options options = MakeOptions(state.range(0), state.range(1), 0);
+    int64_t underruns = 0;
+    int64_t periods = 0;
+    for (auto _ : state) {
+        media::HostMediaBackend backend(options);
+        AudioDecoder decoder(backend);
+        DspToRing dsp(kUnderrunRingBytes);
+        std::atomic<bool> cancel{false};
+        std::thread decodeThread([&]() {
+            Decode(decoder, [&dsp, &cancel](const uint8_t* data, size_t size, int64_t) {
+                return dsp.Process(data, size, &cancel);
+            }, &cancel);
+            dsp.Ring().MarkEos();
+        });
+
+        // Prebuffer like the renderer start: wait for a full ring.
+        while (dsp.Ring().Available() + kPacketFrames * kFrameBytes <= dsp.Ring().Capacity() &&
+               !dsp.Ring().IsEosMarked()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::vector<uint8_t> period(static_cast<size_t>(bench::kSampleRate * kPeriodMs / 1000) * kFrameBytes);
+        auto next = Clock::now();
+        for (int64_t i = 0; i < kPlaySeconds * 1000 / kPeriodMs; i++) {
+            next += std::chrono::milliseconds(kPeriodMs);
+            std::this_thread::sleep_until(next);
+            if (dsp.Ring().Read(period.data(), period.size()) < period.size()) {
+                underruns++;
+            }
+            periods++;
+        }
+
+        cancel.store(true);
+        dsp.Ring().Cancel();
+        decodeThread.join();
+    }
+    state.counters["underruns"] = benchmark::Counter(static_cast<double>(underruns), benchmark::Counter::kAvgIterations);
+    state.counters["underrunRate"] =
+        benchmark::Counter(periods > 0 ? static_cast<double>(underruns) / static_cast<double>(periods) : 0.0);
+}
+BENCHMARK(BM_PipelineUnderrun)
+    ->Args({0, 0})
+    ->Args({5000, 10000})
+    ->Args({10000, 20000})
+    ->Args({2000, 60000})
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// ----------------------------------------------------------------------------
+// Trace points: cost of one DecodeTrace::Scope with tracing off and on.
+// Argument: 0 = off, 1 = on (recording into a wrapping per-thread ring).
+// ----------------------------------------------------------------------------
+
+void BM_TraceScope(benchmark::State& state)
+{
+    if (DecodeTrace::Enabled()) {
+        state.SkipWithError("tracing the run (FREE_PCM_TRACE)");
+        return;
+    }
+    if (state.range(0) != 0) {
+        DecodeTrace::Start();
+    }
+    for (auto _ : state) {
+        DecodeTrace::Scope scope("bench", "iteration", 1);
+        benchmark::ClobberMemory();
+    }
+    DecodeTrace::Stop();
+}
+BENCHMARK(BM_TraceScope)->Arg(0)->Arg(1);
+
+} // namespace
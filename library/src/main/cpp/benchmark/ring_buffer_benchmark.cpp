@@ -0,0 +1,121 @@
+// PcmRingBuffer benchmarks. Chunk sizes follow the two sides of the stream
+// decoder: the decode thread pushes codec-sized chunks, the renderer's
+// writeData callback reads render-period-sized chunks.
+//
+// Arguments: {chunkBytes}. bytes_per_second counts bytes through the ring.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bench_signal.h"
+#include "ring_buffer.h"
+
+namespace {
+
+constexpr int kChannels = 2;
+constexpr int kBytesPerSample = 2;
+constexpr size_t kFrameBytes = kChannels * kBytesPerSample;
+// ~1.4 s of S16 stereo, the decoder's default ring size ballpark.
+constexpr size_t kCapacity = 256 * 1024;
+
+void ChunkSizes(benchmark::internal::Benchmark* b)
+{
+    for (int64_t frames = bench::kMinFrames; frames <= bench::kMaxFrames; frames *= 4) {
+        b->Arg(frames * static_cast<int64_t>(kFrameBytes));
+    }
+}
+
+audio::PcmRingBuffer MakeRing(size_t historyBytes = 0)
+{
+    return audio::PcmRingBuffer(kCapacity, bench::kSampleRate, kChannels, kBytesPerSample, historyBytes);
+}
+
+// Push then Read on one thread: the uncontended fast path (no waiters, no locks).
+void BM_RingPushRead(benchmark::State& state)
+{
+    const size_t chunk = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> in(chunk, 0x5a);
+    std::vector<uint8_t> out(chunk);
+    std::atomic<bool> cancel{false};
+    auto ring = MakeRing();
+    for (auto _ : state) {
+        ring.Push(in.data(), chunk, &cancel);
+        benchmark::DoNotOptimize(ring.Read(out.data(), chunk));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(chunk));
+}
+BENCHMARK(BM_RingPushRead)->Apply(ChunkSizes);
+
+// Same with the playback history (seek-back window) enabled.
+void BM_RingPushReadHistory(benchmark::State& state)
+{
+    const size_t chunk = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> in(chunk, 0x5a);
+    std::vector<uint8_t> out(chunk);
+    std::atomic<bool> cancel{false};
+    auto ring = MakeRing(kCapacity);
+    for (auto _ : state) {
+        ring.Push(in.data(), chunk, &cancel);
+        benchmark::DoNotOptimize(ring.Read(out.data(), chunk));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(chunk));
+}
+BENCHMARK(BM_RingPushReadHistory)->Apply(ChunkSizes);
+
+// Zero-copy API: ReserveWrite/CommitWrite and PeekRegions/Commit.
+void BM_RingZeroCopy(benchmark::State& state)
+{
+    const size_t chunk = static_cast<size_t>(state.range(0));
+    std::atomic<bool> cancel{false};
+    auto ring = MakeRing();
+    for (auto _ : state) {
+        const audio::PcmRingBuffer::WriteRegions w = ring.ReserveWrite(chunk, &cancel);
+        std::memset(w.data[0], 0x5a, w.len[0]);
+        if (w.len[1] > 0) {
+            std::memset(w.data[1], 0x5a, w.len[1]);
+        }
+        ring.CommitWrite(w.Total());
+
+        const audio::PcmRingBuffer::ReadRegions r = ring.PeekRegions(chunk);
+        benchmark::DoNotOptimize(r.data[0]);
+        ring.Commit(r.Total());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(chunk));
+}
+BENCHMARK(BM_RingZeroCopy)->Apply(ChunkSizes);
+
+// Decode thread pushing 4096-frame chunks while the measured thread reads
+// chunk-sized render periods with ReadBlocking: includes the producer/consumer
+// wakeups of a full ring.
+void BM_RingProducerConsumer(benchmark::State& state)
+{
+    const size_t chunk = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> out(chunk);
+    std::atomic<bool> cancel{false};
+    auto ring = MakeRing();
+
+    std::thread producer([&ring, &cancel]() {
+        std::vector<uint8_t> in(static_cast<size_t>(bench::kMaxFrames) * kFrameBytes, 0x5a);
+        while (ring.Push(in.data(), in.size(), &cancel)) {
+        }
+    });
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ring.ReadBlocking(out.data(), chunk, -1));
+    }
+
+    cancel.store(true);
+    ring.Cancel();
+    producer.join();
+
+    const audio::PcmRingBuffer::WakeupStats wakeups = ring.GetWakeupStats();
+    state.counters["producerSleeps"] = benchmark::Counter(static_cast<double>(wakeups.producerSleeps));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(chunk));
+}
+BENCHMARK(BM_RingProducerConsumer)->Apply(ChunkSizes)->UseRealTime();
+
+} // namespace
@@ -1,57 +1,171 @@
 #include "ring_buffer.h"
 
+#include "../decode_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
 namespace audio {
 
-PcmRingBuffer::PcmRingBuffer(size_t capacity, int sampleRate, int channels, int bytesPerSample)
-    : buf_(capacity), head_(0), tail_(0), size_(0), eos_(false), canceled_(false),
-      totalBytesRead_(0), sampleRate_(sampleRate), channels_(channels), bytesPerSample_(bytesPerSample)
+PcmRingBuffer::PcmRingBuffer(size_t capacity, int sampleRate, int channels, int bytesPerSample, size_t historyBytes)
+    : owned_(std::make_unique<Storage>(capacity + historyBytes)), storage_(owned_.get()),
+      readerStorage_(owned_.get()), capacity_(capacity), historyCap_(historyBytes),
+      allocated_(capacity + historyBytes), tail_(0), head_(0), peekHead_(0),
+      readPin_(kNoPin), historyFloor_(0), headHigh_(0), eos_(false), canceled_(false), readWaiters_(0),
+      writeWaiters_(0),
+      writerResumeAt_(0), highPercent_(0), lowPercent_(0), producerSleeps_(0), producerWakeups_(0),
+      posOffset_(0), nextSegStart_(std::numeric_limits<uint64_t>::max()), segmentsPassed_(0),
+      sampleRate_(sampleRate), channels_(channels), bytesPerSample_(bytesPerSample)
 {
 }
 
-void PcmRingBuffer::Cancel()
+void PcmRingBuffer::WakeReaders()
 {
+    // Pairs with the fence in the waiter path: either the waiter observes the new
+    // state, or we observe the waiter count and take the slow path.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (readWaiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        canceled_ = true;
+        std::lock_guard<std::mutex> lock(waitMu_);
     }
     notEmpty_.notify_all();
-    notFull_.notify_all();
 }
 
-void PcmRingBuffer::MarkEos()
+void PcmRingBuffer::WakeWriters()
 {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writeWaiters_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    // In watermark mode the producer only cares once the fill level is down to the
+    // low watermark; waking it earlier would just put it back to sleep.
+    if (!canceled_.load(std::memory_order_acquire)) {
+        const uint64_t head = ProducerHead();
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        const uint64_t used = (tail > head) ? tail - head : 0;
+        if (used > writerResumeAt_.load(std::memory_order_seq_cst)) {
+            return;
+        }
+    }
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        eos_ = true;
+        std::lock_guard<std::mutex> lock(waitMu_);
     }
-    notEmpty_.notify_all();
+    notFull_.notify_all();
+}
+
+void PcmRingBuffer::Cancel()
+{
+    canceled_.store(true, std::memory_order_release);
+    WakeReaders();
+    WakeWriters();
+}
+
+void PcmRingBuffer::MarkEos()
+{
+    eos_.store(true, std::memory_order_release);
+    WakeReaders();
 }
 
 void PcmRingBuffer::ResetEos()
 {
-    {
-        std::lock_guard<std::mutex> lock(mu_);
-        eos_ = false;
-    }
-    notEmpty_.notify_all();
+    eos_.store(false, std::memory_order_release);
+    WakeReaders();
 }
 
 bool PcmRingBuffer::IsEos() const
 {
-    std::lock_guard<std::mutex> lock(mu_);
-    return eos_ && size_ == 0;
+    return eos_.load(std::memory_order_acquire) && Available() == 0;
 }
 
 bool PcmRingBuffer::IsEosMarked() const
 {
-    std::lock_guard<std::mutex> lock(mu_);
-    return eos_;
+    return eos_.load(std::memory_order_acquire);
 }
 
 size_t PcmRingBuffer::Available() const
 {
-    std::lock_guard<std::mutex> lock(mu_);
-    return size_;
+    // Load head first: tail only grows, so tail >= head holds for this snapshot.
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    return (tail > head) ? static_cast<size_t>(tail - head) : 0;
+}
+
+PcmRingBuffer::WriteRegions PcmRingBuffer::ReserveWrite(size_t maxLen, const std::atomic<bool>* cancelFlag)
+{
+    WriteRegions out;
+    // Unread data is limited to capacity_; the rest of the storage keeps played history.
+    // Only the producer resizes, so capacity and storage are stable here.
+    const size_t cap = capacity_.load(std::memory_order_relaxed);
+    std::vector<uint8_t>& buf = owned_->bytes;
+    const size_t size = buf.size();
+    if (maxLen == 0 || cap == 0) {
+        return out;
+    }
+
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = ProducerHead();
+    size_t limit = FillLimit(cap);
+    while (static_cast<size_t>(tail - head) >= limit) {
+        if ((cancelFlag && cancelFlag->load()) || canceled_.load(std::memory_order_acquire)) {
+            return out;
+        }
+
+        // Slow path: register as a waiter, then re-check under the lock.
+        writerResumeAt_.store(ResumeLevel(cap), std::memory_order_seq_cst);
+        writeWaiters_.fetch_add(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        producerSleeps_.fetch_add(1, std::memory_order_relaxed);
+        {
+            DecodeTrace::Scope trace("ringFull");
+            std::unique_lock<std::mutex> lock(waitMu_);
+            bool woken = false;
+            notFull_.wait(lock, [&]() {
+                if (woken) {
+                    producerWakeups_.fetch_add(1, std::memory_order_relaxed);
+                }
+                woken = true;
+                if (canceled_.load(std::memory_order_acquire)) {
+                    return true;
+                }
+                // Watermarks may have changed while sleeping.
+                const size_t resume = ResumeLevel(cap);
+                writerResumeAt_.store(resume, std::memory_order_seq_cst);
+                head = ProducerHead();
+                return static_cast<size_t>(tail - head) <= resume;
+            });
+        }
+        writeWaiters_.fetch_sub(1, std::memory_order_relaxed);
+        limit = FillLimit(cap);
+    }
+    if ((cancelFlag && cancelFlag->load()) || canceled_.load(std::memory_order_acquire)) {
+        return out;
+    }
+
+    const size_t n = std::min(limit - static_cast<size_t>(tail - head), maxLen);
+    const size_t pos = static_cast<size_t>(tail % size);
+    const size_t first = std::min(n, size - pos);
+    out.data[0] = &buf[pos];
+    out.len[0] = first;
+    if (n > first) {
+        out.data[1] = &buf[0];
+        out.len[1] = n - first;
+    }
+    return out;
+}
+
+void PcmRingBuffer::CommitWrite(size_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    // Publish the bytes to the consumer.
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    tail_.store(tail + n, std::memory_order_release);
+    WakeReaders();
 }
 
 bool PcmRingBuffer::Push(const uint8_t* data, size_t len, const std::atomic<bool>* cancelFlag)
@@ -62,40 +176,96 @@ bool PcmRingBuffer::Push(const uint8_t* data, size_t len, const std::atomic<bool
 
     size_t offset = 0;
     while (offset < len) {
-        if ((cancelFlag && cancelFlag->load()) || canceled_) {
+        const WriteRegions w = ReserveWrite(len - offset, cancelFlag);
+        const size_t n = w.Total();
+        if (n == 0) {
             return false;
         }
-
-        std::unique_lock<std::mutex> lock(mu_);
-        notFull_.wait(lock, [&]() {
-            if (canceled_) {
-                return true;
-            }
-            return size_ < buf_.size();
-        });
-
-        if (canceled_) {
-            return false;
+        memcpy(w.data[0], data + offset, w.len[0]);
+        if (w.len[1] > 0) {
+            memcpy(w.data[1], data + offset + w.len[0], w.len[1]);
         }
+        CommitWrite(n);
+        offset += n;
+    }
 
-        const size_t cap = buf_.size();
-        const size_t space = cap - size_;
-        if (space == 0) {
+    return true;
+}
+
+PcmRingBuffer::ReadRegions PcmRingBuffer::PeekRegions(size_t maxLen)
+{
+    ReadRegions out;
+    // Resize publishes the new storage before any tail that needs it, so a storage
+    // pointer that is unchanged after loading tail covers [head, tail).
+    Storage* storage = storage_.load(std::memory_order_acquire);
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    for (;;) {
+        // Pin the read cursor before copying from it. Re-checking head after the pin
+        // closes the window where a Clear moved head and the producer already sized its
+        // reservation without the pin (all seq_cst, see ProducerHead()).
+        head = head_.load(std::memory_order_seq_cst);
+        readPin_.store(head, std::memory_order_seq_cst);
+        if (head_.load(std::memory_order_seq_cst) != head) {
             continue;
         }
+        tail = tail_.load(std::memory_order_acquire);
+        Storage* current = storage_.load(std::memory_order_acquire);
+        if (current == storage) {
+            break;
+        }
+        storage = current;
+    }
+    if (readerStorage_.load(std::memory_order_relaxed) != storage) {
+        // Everything read from the previous storage is done; let the producer free it.
+        readerStorage_.store(storage, std::memory_order_release);
+    }
+    peekHead_ = head;
 
-        const size_t tailToEnd = cap - tail_;
-        const size_t n = std::min({space, len - offset, tailToEnd});
-        memcpy(&buf_[tail_], data + offset, n);
-        tail_ = (tail_ + n) % cap;
-        size_ += n;
-        offset += n;
+    std::vector<uint8_t>& buf = storage->bytes;
+    const size_t size = buf.size();
 
-        lock.unlock();
-        notEmpty_.notify_all();
+    const size_t avail = (tail > head) ? static_cast<size_t>(tail - head) : 0;
+    const size_t n = std::min({maxLen, avail, size});
+    if (n == 0) {
+        // Nothing to copy, and callers do not Commit an empty peek.
+        readPin_.store(kNoPin, std::memory_order_release);
+        return out;
     }
 
-    return true;
+    const size_t pos = static_cast<size_t>(head % size);
+    const size_t first = std::min(n, size - pos);
+    out.data[0] = &buf[pos];
+    out.len[0] = first;
+    if (n > first) {
+        out.data[1] = &buf[0];
+        out.len[1] = n - first;
+    }
+    return out;
+}
+
+size_t PcmRingBuffer::Commit(size_t n)
+{
+    // A concurrent Clear() may have moved head forward since PeekRegions(); in
+    // that case the peeked bytes are stale and must be dropped.
+    uint64_t expected = peekHead_;
+    const bool committed =
+        n > 0 && head_.compare_exchange_strong(expected, peekHead_ + n, std::memory_order_seq_cst);
+    // Done copying: the producer may reuse the peeked bytes.
+    readPin_.store(kNoPin, std::memory_order_release);
+    if (!committed) {
+        // The pin may have been all that kept the producer waiting.
+        WakeWriters();
+        return 0;
+    }
+    peekHead_ += n;
+    if (peekHead_ >= nextSegStart_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(segMu_);
+        PassSegmentsLocked(peekHead_);
+    }
+
+    WakeWriters();
+    return n;
 }
 
 size_t PcmRingBuffer::Read(uint8_t* dst, size_t len)
@@ -104,28 +274,16 @@ size_t PcmRingBuffer::Read(uint8_t* dst, size_t len)
         return 0;
     }
 
-    std::lock_guard<std::mutex> lock(mu_);
-    const size_t cap = buf_.size();
-    const size_t n = std::min(len, size_);
+    const ReadRegions r = PeekRegions(len);
+    const size_t n = r.Total();
     if (n == 0) {
         return 0;
     }
-
-    const size_t headToEnd = cap - head_;
-    const size_t first = std::min(n, headToEnd);
-    memcpy(dst, &buf_[head_], first);
-    const size_t second = n - first;
-    if (second > 0) {
-        memcpy(dst + first, &buf_[0], second);
+    memcpy(dst, r.data[0], r.len[0]);
+    if (r.len[1] > 0) {
+        memcpy(dst + r.len[0], r.data[1], r.len[1]);
     }
-    head_ = (head_ + n) % cap;
-    size_ -= n;
-
-    // 累加已读字节数（原子操作）
-    totalBytesRead_.fetch_add(n);
-
-    notFull_.notify_all();
-    return n;
+    return Commit(n);
 }
 
 size_t PcmRingBuffer::ReadBlocking(uint8_t* dst, size_t len, int timeoutMs)
@@ -134,96 +292,366 @@ size_t PcmRingBuffer::ReadBlocking(uint8_t* dst, size_t len, int timeoutMs)
         return 0;
     }
 
-    std::unique_lock<std::mutex> lock(mu_);
-    
-    // 如果数据已充足，直接读取
-    if (size_ >= len) {
-        const size_t cap = buf_.size();
-        const size_t headToEnd = cap - head_;
-        const size_t first = std::min(len, headToEnd);
-        memcpy(dst, &buf_[head_], first);
-        const size_t second = len - first;
-        if (second > 0) {
-            memcpy(dst + first, &buf_[0], second);
-        }
-        head_ = (head_ + len) % cap;
-        size_ -= len;
-        totalBytesRead_.fetch_add(len);
-        notFull_.notify_all();
-        return len;
-    }
-    
-    // 数据不足，等待条件满足
+    // 如果数据已充足，直接读取（无锁快路径）
+    if (Available() >= len) {
+        return Read(dst, len);
+    }
+
+    // 数据不足，注册为等待者后等待条件满足
     auto waitCondition = [&]() {
-        return canceled_ || eos_ || size_ >= len;
+        return canceled_.load(std::memory_order_acquire) || eos_.load(std::memory_order_acquire) ||
+               Available() >= len;
     };
-    
-    if (timeoutMs < 0) {
-        // 无限等待
-        notEmpty_.wait(lock, waitCondition);
-    } else {
-        // 带超时等待
-        if (!notEmpty_.wait_for(lock, std::chrono::milliseconds(timeoutMs), waitCondition)) {
-            // 超时，返回 0
-            return 0;
+
+    bool satisfied = true;
+    readWaiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(waitMu_);
+        if (timeoutMs < 0) {
+            // 无限等待
+            notEmpty_.wait(lock, waitCondition);
+        } else {
+            // 带超时等待
+            satisfied = notEmpty_.wait_for(lock, std::chrono::milliseconds(timeoutMs), waitCondition);
         }
     }
-    
+    readWaiters_.fetch_sub(1, std::memory_order_relaxed);
+
+    if (!satisfied) {
+        // 超时，返回 0
+        return 0;
+    }
+
     // 检查取消状态
-    if (canceled_) {
+    if (canceled_.load(std::memory_order_acquire)) {
         return 0;
     }
-    
-    // 检查 EOS 状态
-    if (eos_ && size_ < len) {
-        // EOS 已到达但数据不足，返回可用的数据
-        if (size_ == 0) {
+
+    const size_t avail = Available();
+
+    // 检查 EOS 状态：EOS 已到达但数据不足，返回可用的数据
+    if (avail < len) {
+        if (!eos_.load(std::memory_order_acquire) || avail == 0) {
             return 0;
         }
-        const size_t n = size_;
-        const size_t cap = buf_.size();
-        const size_t headToEnd = cap - head_;
-        const size_t first = std::min(n, headToEnd);
-        memcpy(dst, &buf_[head_], first);
-        const size_t second = n - first;
-        if (second > 0) {
-            memcpy(dst + first, &buf_[0], second);
-        }
-        head_ = (head_ + n) % cap;
-        size_ = 0;
-        totalBytesRead_.fetch_add(n);
-        notFull_.notify_all();
-        return n;
+        return Read(dst, avail);
     }
-    
+
     // 数据充足，执行读取
-    const size_t cap = buf_.size();
-    const size_t headToEnd = cap - head_;
-    const size_t first = std::min(len, headToEnd);
-    memcpy(dst, &buf_[head_], first);
-    const size_t second = len - first;
-    if (second > 0) {
-        memcpy(dst + first, &buf_[0], second);
-    }
-    head_ = (head_ + len) % cap;
-    size_ -= len;
-    totalBytesRead_.fetch_add(len);
-    notFull_.notify_all();
-    return len;
+    return Read(dst, len);
 }
 
 void PcmRingBuffer::Clear()
 {
-    std::lock_guard<std::mutex> lock(mu_);
-    head_ = 0;
-    tail_ = 0;
-    size_ = 0;
+    std::lock_guard<std::mutex> segLock(segMu_);
+    // Drop everything currently buffered by moving head up to the published tail.
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (head < tail &&
+           !head_.compare_exchange_weak(head, tail, std::memory_order_seq_cst)) {
+    }
+    ClearLocked(head, tail);
+}
+
+size_t PcmRingBuffer::ClearPendingSegments()
+{
+    std::lock_guard<std::mutex> segLock(segMu_);
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (head < tail &&
+           !head_.compare_exchange_weak(head, tail, std::memory_order_seq_cst)) {
+    }
+    // Starts beyond the old head were never reached: withdraw them before the clear crosses them.
+    size_t dropped = 0;
+    while (!segments_.empty() && segments_.back().start > head) {
+        segments_.pop_back();
+        dropped++;
+    }
+    nextSegStart_.store(segments_.empty() ? std::numeric_limits<uint64_t>::max() : segments_.front().start,
+                        std::memory_order_release);
+    ClearLocked(head, tail);
+    return dropped;
+}
+
+// head: the read cursor before it was moved up to tail.
+void PcmRingBuffer::ClearLocked(uint64_t head, uint64_t tail)
+{
+    // Keep the reported position where it was: the dropped bytes were never played.
+    // Crossing a segment start lands at the beginning of the last segment instead.
+    if (head < tail) {
+        if (nextSegStart_.load(std::memory_order_relaxed) <= tail) {
+            uint64_t start = 0;
+            uint64_t offset = 0;
+            while (!segments_.empty() && segments_.front().start <= tail) {
+                start = segments_.front().start;
+                offset = segments_.front().offset;
+                segments_.pop_front();
+                segmentsPassed_.fetch_add(1, std::memory_order_acq_rel);
+            }
+            posOffset_.store(offset - (tail - start), std::memory_order_release);
+            nextSegStart_.store(segments_.empty() ? std::numeric_limits<uint64_t>::max() : segments_.front().start,
+                                std::memory_order_release);
+        } else {
+            posOffset_.fetch_sub(tail - head, std::memory_order_acq_rel);
+        }
+    }
+    historyFloor_.store(tail, std::memory_order_release);
+    WakeWriters();
+}
+
+bool PcmRingBuffer::SeekWithinBuffer(uint64_t positionMs)
+{
+    if (sampleRate_ <= 0 || channels_ <= 0 || bytesPerSample_ <= 0) {
+        return false;
+    }
+
+    const uint64_t target = MsToBytes(positionMs);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (;;) {
+        // Stay inside the segment being played: the history floor is raised to its start
+        // once passed, and a pending start ends it.
+        uint64_t segStart = 0;
+        uint64_t segEnd = 0;
+        const uint64_t offset = OffsetAt(head, &segStart, &segEnd);
+        const uint64_t tail = std::min(tail_.load(std::memory_order_acquire), segEnd);
+        const uint64_t low = std::max(HistoryStart(head), segStart);
+        // Positions of the history start, the read cursor and the buffered end.
+        const uint64_t lowPos = low + offset;
+        const uint64_t headPos = head + offset;
+        if (target < lowPos || target - lowPos > tail - low) {
+            return false;
+        }
+        const uint64_t newHead = (target >= headPos) ? head + (target - headPos) : head - (headPos - target);
+        if (newHead < head && head > headHigh_.load(std::memory_order_relaxed)) {
+            headHigh_.store(head, std::memory_order_release);
+        }
+        // A failed CAS (a racing Read/Clear moved head) reloads head and re-checks the window.
+        if (head_.compare_exchange_weak(head, newHead, std::memory_order_seq_cst)) {
+            break;
+        }
+    }
+    WakeWriters();
+    return true;
+}
+
+uint64_t PcmRingBuffer::HistoryStart(uint64_t head) const
+{
+    // The producer reserves space relative to the highest head it may have seen, so
+    // it can overwrite anything older than that minus the history capacity. head
+    // only moves backwards through SeekWithinBuffer, which records headHigh_ first.
+    const uint64_t high = std::max(head, headHigh_.load(std::memory_order_acquire));
+    const uint64_t retained = (high > historyCap_) ? high - historyCap_ : 0;
+    return std::min(head, std::max(retained, historyFloor_.load(std::memory_order_acquire)));
+}
+
+PcmRingBuffer::MemoryStats PcmRingBuffer::GetMemoryStats() const
+{
+    MemoryStats stats;
+    stats.capacityBytes = capacity_.load(std::memory_order_acquire);
+    stats.historyCapacityBytes = historyCap_;
+    stats.allocatedBytes = allocated_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    stats.bufferedBytes = (tail > head) ? static_cast<size_t>(tail - head) : 0;
+    stats.historyBytes = static_cast<size_t>(head - HistoryStart(head));
+    return stats;
+}
+
+bool PcmRingBuffer::Resize(size_t capacity)
+{
+    if (capacity == 0) {
+        return false;
+    }
+    if (retired_) {
+        if (readerStorage_.load(std::memory_order_acquire) != owned_.get()) {
+            // The consumer may still be copying out of the previous storage.
+            return false;
+        }
+        retired_.reset();
+        allocated_.store(owned_->bytes.size(), std::memory_order_relaxed);
+    }
+    // Compare with the storage, not capacity_: a pending shrink already lowered that.
+    if (capacity + historyCap_ == owned_->bytes.size()) {
+        capacity_.store(capacity, std::memory_order_release);
+        return true;
+    }
+
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    if (tail - head > capacity) {
+        // Shrinking below the unread amount: stop filling past the new capacity now
+        // and swap storage on a later call, once the consumer has drained enough.
+        capacity_.store(capacity, std::memory_order_release);
+        return false;
+    }
+
+    // Everything a reader or SeekWithinBuffer may still reach lies in [low, tail);
+    // the history start never moves backwards, so copying it once is enough.
+    const uint64_t low = HistoryStart(head);
+    auto next = std::make_unique<Storage>(capacity + historyCap_);
+    const std::vector<uint8_t>& from = owned_->bytes;
+    std::vector<uint8_t>& to = next->bytes;
+    for (uint64_t i = low; i < tail;) {
+        const size_t src = static_cast<size_t>(i % from.size());
+        const size_t dst = static_cast<size_t>(i % to.size());
+        const size_t n = std::min({static_cast<size_t>(tail - i), from.size() - src, to.size() - dst});
+        memcpy(&to[dst], &from[src], n);
+        i += n;
+    }
+
+    retired_ = std::move(owned_);
+    owned_ = std::move(next);
+    allocated_.store(owned_->bytes.size() + retired_->bytes.size(), std::memory_order_relaxed);
+    capacity_.store(capacity, std::memory_order_release);
+    storage_.store(owned_.get(), std::memory_order_release);
+    return true;
+}
+
+size_t PcmRingBuffer::Capacity() const
+{
+    return capacity_.load(std::memory_order_acquire);
+}
+
+uint64_t PcmRingBuffer::ProducerHead() const
+{
+    // Clear and SeekWithinBuffer move head past bytes the consumer may still be
+    // copying; the pin keeps them from being overwritten until its Commit. head is
+    // loaded first: a pin published after this load is re-checked by PeekRegions
+    // against a head at least this new.
+    const uint64_t head = head_.load(std::memory_order_seq_cst);
+    return std::min(head, readPin_.load(std::memory_order_seq_cst));
+}
+
+size_t PcmRingBuffer::FillLimit(size_t cap) const
+{
+    const uint32_t high = highPercent_.load(std::memory_order_acquire);
+    if (high == 0) {
+        return cap;
+    }
+    return std::max<size_t>(1, static_cast<size_t>(static_cast<uint64_t>(cap) * high / 100));
+}
+
+size_t PcmRingBuffer::ResumeLevel(size_t cap) const
+{
+    const uint32_t high = highPercent_.load(std::memory_order_acquire);
+    if (high == 0) {
+        // Any free byte is enough.
+        return cap - 1;
+    }
+    return static_cast<size_t>(static_cast<uint64_t>(cap) * lowPercent_.load(std::memory_order_acquire) / 100);
+}
+
+void PcmRingBuffer::SetWatermarks(uint32_t highPercent, uint32_t lowPercent)
+{
+    const bool valid = highPercent > 0 && highPercent <= 100 && lowPercent < highPercent;
+    lowPercent_.store(valid ? lowPercent : 0, std::memory_order_release);
+    highPercent_.store(valid ? highPercent : 0, std::memory_order_release);
+    // Let a sleeping producer re-evaluate against the new levels.
+    {
+        std::lock_guard<std::mutex> lock(waitMu_);
+    }
     notFull_.notify_all();
 }
 
+PcmRingBuffer::WakeupStats PcmRingBuffer::GetWakeupStats() const
+{
+    WakeupStats stats;
+    stats.producerSleeps = producerSleeps_.load(std::memory_order_relaxed);
+    stats.producerWakeups = producerWakeups_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 uint64_t PcmRingBuffer::GetBytesRead() const
 {
-    return totalBytesRead_.load();
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t segStart = 0;
+    uint64_t segEnd = 0;
+    return head + OffsetAt(head, &segStart, &segEnd);
+}
+
+uint64_t PcmRingBuffer::OffsetAt(uint64_t head, uint64_t* segStart, uint64_t* segEnd) const
+{
+    // Fast path: no segment start at or before head. nextSegStart_ is published after
+    // posOffset_, so a reader that sees the new value also sees the folded offset.
+    const uint64_t next = nextSegStart_.load(std::memory_order_acquire);
+    if (head < next) {
+        *segStart = 0;
+        *segEnd = next;
+        return posOffset_.load(std::memory_order_acquire);
+    }
+    // head passed a start the consumer has not folded yet (or is folding right now).
+    std::lock_guard<std::mutex> lock(segMu_);
+    uint64_t offset = posOffset_.load(std::memory_order_acquire);
+    *segStart = 0;
+    *segEnd = std::numeric_limits<uint64_t>::max();
+    for (const Segment& seg : segments_) {
+        if (seg.start > head) {
+            *segEnd = seg.start;
+            break;
+        }
+        offset = seg.offset;
+        *segStart = seg.start;
+    }
+    return offset;
+}
+
+void PcmRingBuffer::PassSegmentsLocked(uint64_t head)
+{
+    while (!segments_.empty() && segments_.front().start <= head) {
+        const Segment seg = segments_.front();
+        segments_.pop_front();
+        posOffset_.store(seg.offset, std::memory_order_release);
+        // The previous segment is no longer reachable by SeekWithinBuffer.
+        if (historyFloor_.load(std::memory_order_relaxed) < seg.start) {
+            historyFloor_.store(seg.start, std::memory_order_release);
+        }
+        segmentsPassed_.fetch_add(1, std::memory_order_acq_rel);
+    }
+    nextSegStart_.store(segments_.empty() ? std::numeric_limits<uint64_t>::max() : segments_.front().start,
+                        std::memory_order_release);
+}
+
+void PcmRingBuffer::DropSegmentsLocked()
+{
+    segmentsPassed_.fetch_add(segments_.size(), std::memory_order_acq_rel);
+    segments_.clear();
+    nextSegStart_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+}
+
+void PcmRingBuffer::MarkSegmentStart()
+{
+    std::lock_guard<std::mutex> lock(segMu_);
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    // Position bytes = head - tail from the start on.
+    segments_.push_back({tail, 0 - tail});
+    if (segments_.size() == 1) {
+        nextSegStart_.store(tail, std::memory_order_release);
+    }
+}
+
+uint64_t PcmRingBuffer::GetSegmentCount() const
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    if (head < nextSegStart_.load(std::memory_order_acquire)) {
+        return segmentsPassed_.load(std::memory_order_acquire);
+    }
+    std::lock_guard<std::mutex> lock(segMu_);
+    uint64_t count = segmentsPassed_.load(std::memory_order_acquire);
+    for (const Segment& seg : segments_) {
+        if (seg.start > head) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool PcmRingBuffer::HasPendingSegment() const
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(segMu_);
+    return !segments_.empty() && segments_.back().start > head;
 }
 
 uint64_t PcmRingBuffer::GetPositionMs() const
@@ -232,7 +660,7 @@ uint64_t PcmRingBuffer::GetPositionMs() const
         return 0;
     }
 
-    const uint64_t bytesRead = totalBytesRead_.load();
+    const uint64_t bytesRead = GetBytesRead();
 
     // 计算总样本数：已读字节数 / (声道数 × 每样本字节数)
     const uint64_t totalSamples = bytesRead / (channels_ * bytesPerSample_);
@@ -243,16 +671,15 @@ uint64_t PcmRingBuffer::GetPositionMs() const
 
 void PcmRingBuffer::ResetCounters()
 {
-    totalBytesRead_.store(0);
+    std::lock_guard<std::mutex> lock(segMu_);
+    DropSegmentsLocked();
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    historyFloor_.store(head, std::memory_order_release);
+    posOffset_.store(0 - head, std::memory_order_release);
 }
 
-void PcmRingBuffer::SetPositionMs(uint64_t positionMs)
+uint64_t PcmRingBuffer::MsToBytes(uint64_t positionMs) const
 {
-    if (sampleRate_ <= 0 || channels_ <= 0 || bytesPerSample_ <= 0) {
-        totalBytesRead_.store(0);
-        return;
-    }
-
     // Convert ms -> samples -> bytes. Use wide intermediate to avoid overflow.
     const unsigned __int128 samples = (static_cast<unsigned __int128>(positionMs) *
                                        static_cast<unsigned __int128>(sampleRate_)) /
@@ -261,10 +688,20 @@ void PcmRingBuffer::SetPositionMs(uint64_t positionMs)
                                     static_cast<unsigned __int128>(channels_) *
                                     static_cast<unsigned __int128>(bytesPerSample_);
 
-    const uint64_t capped = (bytes > static_cast<unsigned __int128>(UINT64_MAX))
-                                ? UINT64_MAX
-                                : static_cast<uint64_t>(bytes);
-    totalBytesRead_.store(capped);
+    return (bytes > static_cast<unsigned __int128>(UINT64_MAX))
+               ? UINT64_MAX
+               : static_cast<uint64_t>(bytes);
+}
+
+void PcmRingBuffer::SetPositionMs(uint64_t positionMs)
+{
+    const uint64_t bytes = (sampleRate_ <= 0 || channels_ <= 0 || bytesPerSample_ <= 0) ? 0 : MsToBytes(positionMs);
+    // Data before head belongs to the previous timeline.
+    std::lock_guard<std::mutex> lock(segMu_);
+    DropSegmentsLocked();
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    historyFloor_.store(head, std::memory_order_release);
+    posOffset_.store(bytes - head, std::memory_order_release);
 }
 
 } // namespace audio
@@ -2,32 +2,100 @@
 #define RING_BUFFER_H
 
 #include <cstdint>
+#include <cstddef>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <vector>
 
 namespace audio {
 
 /**
- * @brief 线程安全的 PCM 环形缓冲区
+ * @brief 单生产者/单消费者（SPSC）无锁 PCM 环形缓冲区
  *
  * 用于音频流式解码的数据缓冲，支持：
- * - 线程安全的 Push/Read 操作
+ * - 无锁 Push/Read：head/tail 为单调递增的字节计数，使用 acquire/release 原子操作发布
  * - EOS（End of Stream）标记
  * - 取消操作
- * - 动态容量配置
+ * - 动态容量配置（运行期可由生产者线程调用 Resize 调整）
+ *
+ * 线程约定：
+ * - 生产者（解码线程）调用 Push / MarkSegmentStart
+ * - 消费者（writeData 回调线程）调用 Read / ReadBlocking
+ * - Clear / MarkEos / ResetEos / Cancel / SetPositionMs 可在任意线程调用
+ * - SeekWithinBuffer 可在任意线程调用，但同一时刻只能有一个调用方
+ *
+ * 位置追踪：缓冲区内每个字节都对应时间轴上的一个位置（position = 读指针 + 位置偏移），
+ * 因此读指针处的位置即播放位置，[读指针, 写指针) 即已缓冲的时间窗口。
+ *
+ * 回看区（history）：存储空间为 capacity + historyBytes，生产者最多只写入 capacity 字节的
+ * 未读数据，因此读指针之前最近 historyBytes 字节已播放的数据不会被覆盖，
+ * 可供 SeekWithinBuffer 向后定位。
+ *
+ * 水位模式（SetWatermarks）：生产者写到高水位后停止，直到消费者把数据读到低水位以下才被唤醒，
+ * 解码因此成批进行，两批之间解码线程保持休眠；消费者只在越过低水位时才唤醒生产者。
+ *
+ * 扩缩容：Resize 由生产者线程分配新存储并拷贝 [回看区起点, 写指针) 的数据后原子地发布；
+ * 消费者在下一次 PeekRegions 时切换到新存储，旧存储在消费者确认切换后才释放。
+ *
+ * 分段（MarkSegmentStart）：生产者可在写指针处标记新曲目的起点，读指针越过该点后位置从 0 重新计算，
+ * 之前的数据不再可回看；标记之后写入的数据与之前的数据首尾相接，不留空隙。
+ *
+ * 互斥锁与条件变量仅用于阻塞等待的慢路径：只有在对端确实存在等待者时才会加锁唤醒，
+ * 快路径（数据/空间充足）不会触碰互斥锁。
  */
 class PcmRingBuffer {
 public:
+    /**
+     * @brief 可读区间（最多两段连续内存，第二段为回绕部分）
+     */
+    struct ReadRegions {
+        const uint8_t* data[2] = {nullptr, nullptr};
+        size_t len[2] = {0, 0};
+
+        size_t Total() const { return len[0] + len[1]; }
+    };
+
+    /**
+     * @brief 可写区间（最多两段连续内存，第二段为回绕部分）
+     */
+    struct WriteRegions {
+        uint8_t* data[2] = {nullptr, nullptr};
+        size_t len[2] = {0, 0};
+
+        size_t Total() const { return len[0] + len[1]; }
+    };
+
+    /**
+     * @brief 内存占用统计
+     */
+    struct MemoryStats {
+        size_t capacityBytes = 0;         // 未读数据容量
+        size_t historyCapacityBytes = 0;  // 回看区容量
+        size_t allocatedBytes = 0;        // 实际分配的存储空间（含尚未释放的旧存储）
+        size_t bufferedBytes = 0;         // 当前未读数据量
+        size_t historyBytes = 0;          // 当前可回看的已播放数据量
+    };
+
+    /**
+     * @brief 生产者阻塞/唤醒统计
+     */
+    struct WakeupStats {
+        uint64_t producerSleeps = 0;   // 生产者因缓冲区满进入等待的次数（一次等待对应一批写入结束）
+        uint64_t producerWakeups = 0;  // 生产者等待期间被唤醒的次数（含条件尚未满足的唤醒）
+    };
+
     /**
      * @brief 构造环形缓冲区
-     * @param capacity 缓冲区容量（字节）
+     * @param capacity 缓冲区容量（字节，未读数据上限）
      * @param sampleRate 采样率（Hz），用于位置计算
      * @param channels 声道数，用于位置计算
      * @param bytesPerSample 每样本字节数（2=S16LE, 4=S32LE），用于位置计算
+     * @param historyBytes 回看区容量（字节），0 表示不保留已播放数据
      */
-    PcmRingBuffer(size_t capacity, int sampleRate, int channels, int bytesPerSample);
+    PcmRingBuffer(size_t capacity, int sampleRate, int channels, int bytesPerSample, size_t historyBytes = 0);
 
     /**
      * @brief 取消所有等待的操作
@@ -61,7 +129,7 @@ public:
     size_t Available() const;
 
     /**
-     * @brief 向缓冲区推送数据
+     * @brief 向缓冲区推送数据（仅生产者线程）
      * @param data 数据指针
      * @param len 数据长度
      * @param cancelFlag 取消标志指针
@@ -70,7 +138,37 @@ public:
     bool Push(const uint8_t* data, size_t len, const std::atomic<bool>* cancelFlag);
 
     /**
-     * @brief 从缓冲区读取数据（非阻塞）
+     * @brief 预留写入空间（仅生产者线程，零拷贝写入）
+     * @param maxLen 期望写入的最大字节数
+     * @param cancelFlag 取消标志指针
+     * @return 可直接写入的区间；空间不足时阻塞等待，被取消时返回空区间
+     *
+     * @remarks
+     * 返回的区间总长度可能小于 maxLen，调用方写入后需调用 CommitWrite 发布数据。
+     */
+    WriteRegions ReserveWrite(size_t maxLen, const std::atomic<bool>* cancelFlag);
+
+    /**
+     * @brief 发布最近一次 ReserveWrite 中已写入的 n 字节（仅生产者线程）
+     */
+    void CommitWrite(size_t n);
+
+    /**
+     * @brief 查看当前可读数据（仅消费者线程，零拷贝读取）
+     * @param maxLen 最多查看的字节数
+     * @return 可读区间，不会移动读指针；在随后的 Commit 之前，生产者不会覆盖这段数据
+     *         （即使 Clear / SeekWithinBuffer 已把读指针移过它），因此非空结果之后必须调用 Commit
+     */
+    ReadRegions PeekRegions(size_t maxLen);
+
+    /**
+     * @brief 消费最近一次 PeekRegions 返回区间中的前 n 字节（仅消费者线程）
+     * @return 实际消费的字节数；若期间被 Clear 抢占，返回 0 且已查看的数据应视为无效
+     */
+    size_t Commit(size_t n);
+
+    /**
+     * @brief 从缓冲区读取数据（非阻塞，仅消费者线程）
      * @param dst 目标缓冲区
      * @param len 要读取的长度
      * @return 实际读取的字节数
@@ -78,31 +176,34 @@ public:
     size_t Read(uint8_t* dst, size_t len);
 
     /**
-     * @brief 从缓冲区读取数据（带超时阻塞）
+     * @brief 从缓冲区读取数据（带超时阻塞，仅消费者线程）
      * @param dst 目标缓冲区
      * @param len 要读取的长度
      * @param timeoutMs 超时时间（毫秒），-1 表示无限等待
      * @return 实际读取的字节数，超时返回 0
-     * 
+     *
      * @remarks
      * 当缓冲区数据不足时，会阻塞等待直到：
      * 1. 数据充足
      * 2. 超时
      * 3. EOS 到达
      * 4. 被取消
-     * 
+     *
      * 推荐用于 AudioRenderer 的 writeData 回调，避免高频 INVALID 返回。
      */
     size_t ReadBlocking(uint8_t* dst, size_t len, int timeoutMs);
 
     /**
      * @brief 清空缓冲区
+     *
+     * 通过把读指针推进到当前写指针实现，可与 Push/Read 并发调用：
+     * 与之竞争的 Read 会检测到读指针被移动并放弃本次读取。回看区同时失效。
      */
     void Clear();
 
     /**
-     * @brief 获取累计读取的字节数
-     * @return 累计读取字节数
+     * @brief 获取读指针处的位置（字节）
+     * @return 位置字节数；未经 Seek 时等于累计读取字节数
      */
     uint64_t GetBytesRead() const;
 
@@ -120,24 +221,157 @@ public:
     /**
      * @brief 设置当前位置（毫秒）
      *
-     * 该方法会通过修改内部已读字节计数器来实现“位置基线”，
+     * 该方法会通过修改内部位置偏移来实现“位置基线”：当前读指针处即为 positionMs，
      * 便于 Seek 后让 GetPositionMs() 从目标时间点继续累加。
      */
     void SetPositionMs(uint64_t positionMs);
 
+    /**
+     * @brief 在已缓冲数据内定位
+     * @param positionMs 目标位置（毫秒）
+     * @return 目标位于 [回看区起点, 已缓冲末尾] 内时移动读指针并返回 true，否则不做任何修改并返回 false
+     *
+     * 读指针被移动到目标帧（向前跳过的数据成为回看区的一部分），生产者继续从原写指针追加，
+     * 不需要重新定位解码器。与之竞争的 Read 会像遇到 Clear 一样放弃本次读取。
+     */
+    bool SeekWithinBuffer(uint64_t positionMs);
+
+    /**
+     * @brief 在当前写指针处开始新的分段（仅生产者线程）
+     *
+     * 读指针到达该点时位置重置为 0（GetPositionMs 随之从 0 累加），回看区下界移到该点；
+     * 在此之前 SeekWithinBuffer 只能在当前分段内定位。
+     */
+    void MarkSegmentStart();
+
+    /**
+     * @brief 读指针已越过的分段起点个数（单调递增），可在任意线程调用
+     */
+    uint64_t GetSegmentCount() const;
+
+    /**
+     * @brief 是否有已写入但读指针尚未到达的分段起点
+     */
+    bool HasPendingSegment() const;
+
+    /**
+     * @brief 撤销读指针尚未到达的分段起点并清空缓冲区，可在任意线程调用
+     * @return 撤销的分段起点个数（按 MarkSegmentStart 顺序位于末尾的若干个）
+     *
+     * 撤销的起点不计入 GetSegmentCount，位置停留在当前分段内（同 Clear）；
+     * 用于定位回当前曲目时丢弃已拼接在其后的曲目。
+     */
+    size_t ClearPendingSegments();
+
+    /**
+     * @brief 获取内存占用与当前缓冲/回看数据量
+     */
+    MemoryStats GetMemoryStats() const;
+
+    /**
+     * @brief 调整未读数据容量（仅生产者线程）
+     * @param capacity 新容量（字节）
+     * @return 成功返回 true；上一次扩缩容的旧存储仍被消费者使用，或未读数据超过新容量时返回 false，
+     *         调用方应稍后重试（后一种情况下生产者已不再写入超过新容量的数据，等待消费者读走即可）
+     *
+     * 已缓冲数据、回看区与播放位置保持不变，可与 Read / SeekWithinBuffer 并发调用。
+     */
+    bool Resize(size_t capacity);
+
+    /**
+     * @brief 当前未读数据容量（字节）
+     */
+    size_t Capacity() const;
+
+    /**
+     * @brief 设置水位（容量百分比），可在任意线程调用
+     * @param highPercent 高水位：未读数据达到该比例后生产者停止写入
+     * @param lowPercent 低水位：未读数据降到该比例及以下时生产者恢复写入
+     *
+     * 需满足 0 <= lowPercent < highPercent <= 100，否则（包括 highPercent 为 0）关闭水位模式，
+     * 此时生产者只要有空闲空间就会写入。随 Resize 按新容量换算。
+     */
+    void SetWatermarks(uint32_t highPercent, uint32_t lowPercent);
+
+    /**
+     * @brief 获取生产者阻塞/唤醒统计
+     */
+    WakeupStats GetWakeupStats() const;
+
 private:
-    mutable std::mutex mu_;
+    static constexpr size_t kCacheLineSize = 64;
+
+    void WakeReaders();
+    void WakeWriters();
+    uint64_t MsToBytes(uint64_t positionMs) const;
+    uint64_t HistoryStart(uint64_t head) const;
+    uint64_t ProducerHead() const;
+    size_t FillLimit(size_t cap) const;
+    size_t ResumeLevel(size_t cap) const;
+    uint64_t OffsetAt(uint64_t head, uint64_t* segStart, uint64_t* segEnd) const;
+    void PassSegmentsLocked(uint64_t head);
+    void DropSegmentsLocked();
+    void ClearLocked(uint64_t head, uint64_t tail);
+
+    // 环形存储；Resize 时整体替换。
+    struct Storage {
+        explicit Storage(size_t size) : bytes(size) {}
+        std::vector<uint8_t> bytes;
+    };
+
+    // 生产者持有当前存储的所有权，storage_ 向消费者发布；retired_ 为等待消费者切换的旧存储。
+    std::unique_ptr<Storage> owned_;
+    std::unique_ptr<Storage> retired_;
+    std::atomic<Storage*> storage_;
+    // 消费者最近一次 PeekRegions 使用的存储（仅用于判断旧存储能否释放）。
+    std::atomic<Storage*> readerStorage_;
+    std::atomic<size_t> capacity_;  // 未读数据上限（存储大小 - historyCap_）
+    size_t historyCap_;             // 回看区容量
+    std::atomic<size_t> allocated_; // owned_ 与 retired_ 的存储大小之和（仅生产者写）
+
+    // 生产者独占的写指针（单调递增字节计数），与读指针分处不同缓存行避免伪共享。
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail_;
+    // 消费者持有的读指针；Clear 也会通过 CAS 推进它。
+    alignas(kCacheLineSize) std::atomic<uint64_t> head_;
+    // 最近一次 PeekRegions 时的读指针快照（仅消费者线程访问），Commit 以此检测 Clear 抢占。
+    uint64_t peekHead_;
+    // 消费者正在拷贝的区间起点（PeekRegions 到 Commit 之间，否则为 kNoPin）；
+    // 生产者按 min(读指针, readPin_) 预留空间，被 Clear 抢占的读取因此不会读到正在写入的字节。
+    std::atomic<uint64_t> readPin_;
+    static constexpr uint64_t kNoPin = UINT64_MAX;
+    // 回看区有效数据的下界（Clear / SetPositionMs 时失效）。
+    std::atomic<uint64_t> historyFloor_;
+    // 向后定位前读指针到达过的最高值；生产者的写入可能基于它预留了空间（仅 SeekWithinBuffer 写）。
+    std::atomic<uint64_t> headHigh_;
+
+    alignas(kCacheLineSize) std::atomic<bool> eos_;
+    std::atomic<bool> canceled_;
+
+    // 慢路径等待者计数：仅当计数非零时，对端才需要加锁唤醒。
+    std::atomic<uint32_t> readWaiters_;
+    std::atomic<uint32_t> writeWaiters_;
+    // 等待中的生产者在未读数据降到该值及以下时才需要被唤醒。
+    std::atomic<uint64_t> writerResumeAt_;
+    std::atomic<uint32_t> highPercent_;
+    std::atomic<uint32_t> lowPercent_;
+    std::atomic<uint64_t> producerSleeps_;
+    std::atomic<uint64_t> producerWakeups_;
+    std::mutex waitMu_;
     std::condition_variable notEmpty_;
     std::condition_variable notFull_;
-    std::vector<uint8_t> buf_;
-    size_t head_;
-    size_t tail_;
-    size_t size_;
-    bool eos_;
-    bool canceled_;
 
     // 位置追踪相关
-    std::atomic<uint64_t> totalBytesRead_;  // 累计读取字节数（原子变量）
+    std::atomic<uint64_t> posOffset_;       // 位置偏移：位置字节数 = 读指针 + posOffset_（按 2^64 取模）
+    // 尚未被读指针越过的分段起点（按 start 递增）；到达后 offset 成为新的 posOffset_。
+    struct Segment {
+        uint64_t start;
+        uint64_t offset;
+    };
+    // 保护 segments_，以及 Clear / SetPositionMs / ResetCounters 对 posOffset_ 与 historyFloor_ 的更新。
+    mutable std::mutex segMu_;
+    std::deque<Segment> segments_;
+    std::atomic<uint64_t> nextSegStart_;    // segments_ 首个起点，无分段时为 UINT64_MAX（读指针快路径只比较它）
+    std::atomic<uint64_t> segmentsPassed_;
     int sampleRate_;                        // 采样率（Hz）
     int channels_;                          // 声道数
     int bytesPerSample_;                    // 每样本字节数（2=S16LE, 4=S32LE）
@@ -0,0 +1,149 @@
+#ifndef RING_RESIZE_POLICY_H
+#define RING_RESIZE_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+
+/**
+ * @brief 环形缓冲区运行期扩缩容策略
+ *
+ * 由解码线程按固定间隔喂入测量值，返回是否需要调整容量：
+ * - 消费端欠载（fillForWriteData 返回 0）次数增加：立即扩容 1.5 倍
+ * - 容量不足以覆盖近期最慢一次源数据读取的 kLatencyHeadroom 倍：扩容到该值
+ * - 长时间无欠载、水位持续接近满、且缩容后仍能覆盖读取延迟：缩容到 0.75 倍
+ *
+ * 结果限制在 [minBytes, maxBytes] 内并按 alignBytes 对齐。不是线程安全的，仅解码线程使用。
+ */
+class RingResizePolicy {
+public:
+    enum class Reason {
+        None = 0,
+        Underrun,
+        Latency,
+        Idle,
+    };
+
+    struct Sample {
+        uint64_t nowMs = 0;
+        size_t capacityBytes = 0;
+        size_t bufferedBytes = 0;
+        uint64_t underruns = 0;     // 累计欠载次数
+        int64_t readLatencyUs = 0;  // 上次采样以来最慢一次源读取
+        uint64_t bytesPerSecond = 0;
+    };
+
+    struct Decision {
+        Reason reason = Reason::None;
+        size_t newBytes = 0;
+    };
+
+    static constexpr uint64_t kEvalIntervalMs = 1000;
+    static constexpr uint64_t kShrinkStableMs = 10 * 1000;
+    static constexpr double kLatencyHeadroom = 4.0;
+    static constexpr double kShrinkFillRatio = 0.9;
+
+    static const char* ReasonName(Reason reason)
+    {
+        switch (reason) {
+            case Reason::Underrun: return "underrun";
+            case Reason::Latency: return "latency";
+            case Reason::Idle: return "idle";
+            default: return "none";
+        }
+    }
+
+    void Reset(size_t minBytes, size_t maxBytes, size_t alignBytes, uint64_t nowMs)
+    {
+        minBytes_ = minBytes;
+        maxBytes_ = std::max(minBytes, maxBytes);
+        alignBytes_ = std::max<size_t>(alignBytes, 1);
+        lastEvalMs_ = nowMs;
+        lastChangeMs_ = nowMs;
+        lastUnderruns_ = 0;
+        latencyPeakUs_ = 0;
+        windowMinFill_ = 1.0;
+    }
+
+    /**
+     * @brief 每次产出 PCM 时调用；到达评估间隔时给出决策
+     */
+    Decision Update(const Sample& s)
+    {
+        Decision d;
+        if (s.capacityBytes == 0) {
+            return d;
+        }
+        const double fill = static_cast<double>(s.bufferedBytes) / static_cast<double>(s.capacityBytes);
+        windowMinFill_ = std::min(windowMinFill_, fill);
+        // Decaying peak so one slow read keeps the ring large for a while.
+        latencyPeakUs_ = std::max(latencyPeakUs_, s.readLatencyUs);
+
+        if (s.nowMs - lastEvalMs_ < kEvalIntervalMs) {
+            return d;
+        }
+        const double minFill = windowMinFill_;
+        windowMinFill_ = 1.0;
+        lastEvalMs_ = s.nowMs;
+
+        const bool underrun = s.underruns > lastUnderruns_;
+        lastUnderruns_ = s.underruns;
+
+        const size_t latencyBytes =
+            static_cast<size_t>(static_cast<double>(latencyPeakUs_) * kLatencyHeadroom *
+                                static_cast<double>(s.bytesPerSecond) / 1e6);
+        latencyPeakUs_ = latencyPeakUs_ * 7 / 8;
+
+        size_t target = s.capacityBytes;
+        if (underrun) {
+            d.reason = Reason::Underrun;
+            target = std::max(s.capacityBytes + s.capacityBytes / 2, latencyBytes);
+        } else if (latencyBytes > s.capacityBytes) {
+            d.reason = Reason::Latency;
+            target = latencyBytes;
+        } else if (s.nowMs - lastChangeMs_ >= kShrinkStableMs && minFill >= kShrinkFillRatio) {
+            d.reason = Reason::Idle;
+            target = std::max(s.capacityBytes - s.capacityBytes / 4, latencyBytes);
+        }
+        if (d.reason == Reason::None) {
+            return d;
+        }
+        if (underrun) {
+            // Shrinking is measured from the last underrun too.
+            lastChangeMs_ = s.nowMs;
+        }
+
+        target = ((target + alignBytes_ - 1) / alignBytes_) * alignBytes_;
+        target = std::min(std::max(target, minBytes_), maxBytes_);
+        if (target == s.capacityBytes) {
+            d.reason = Reason::None;
+            return d;
+        }
+        d.newBytes = target;
+        return d;
+    }
+
+    /**
+     * @brief 决策已生效（Resize 成功）后调用
+     */
+    void Applied(uint64_t nowMs)
+    {
+        lastChangeMs_ = nowMs;
+    }
+
+private:
+    size_t minBytes_ = 0;
+    size_t maxBytes_ = 0;
+    size_t alignBytes_ = 1;
+    uint64_t lastEvalMs_ = 0;
+    uint64_t lastChangeMs_ = 0;
+    uint64_t lastUnderruns_ = 0;
+    int64_t latencyPeakUs_ = 0;
+    double windowMinFill_ = 1.0;
+};
+
+} // namespace audio
+
+#endif // RING_RESIZE_POLICY_H
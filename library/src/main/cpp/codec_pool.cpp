@@ -0,0 +1,181 @@
+#include "codec_pool.h"
+
+#include <algorithm>
+#include <hilog/log.h>
+
+#include "audio_decoder.h"
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "CodecPool"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+// Callback user data of a parked codec points here rather than at the wakeup of
+// the decoder that returned it (which may be gone by the time a late callback fires).
+DecodeWakeup g_parkedWakeup;
+
+} // namespace
+
+CodecPool& CodecPool::Shared()
+{
+    static CodecPool pool;
+    return pool;
+}
+
+CodecPool::~CodecPool()
+{
+    Clear();
+}
+
+CodecPool::Reuse CodecPool::Acquire(const media::Backend* backend, const std::string& mimeType,
+                                    const Config& config, Entry* entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Most recently used first: a warm match, otherwise any codec of the MIME.
+    auto sameMime = idle_.rend();
+    for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+        if (it->backend != backend || it->mimeType != mimeType) {
+            continue;
+        }
+        if (it->configured && it->config == config) {
+            *entry = std::move(*it);
+            idle_.erase(std::next(it).base());
+            stats_.warmHits++;
+            return Reuse::Warm;
+        }
+        if (sameMime == idle_.rend()) {
+            sameMime = it;
+        }
+    }
+    if (sameMime != idle_.rend()) {
+        *entry = std::move(*sameMime);
+        idle_.erase(std::next(sameMime).base());
+        stats_.resetHits++;
+        return Reuse::Reset;
+    }
+    stats_.misses++;
+    return Reuse::Miss;
+}
+
+bool CodecPool::Release(Entry entry)
+{
+    if (entry.codec == nullptr) {
+        return false;
+    }
+    if (entry.signal != nullptr) {
+        entry.signal->wakeup_.store(&g_parkedWakeup, std::memory_order_release);
+    }
+    std::vector<Entry> evicted;
+    bool kept = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (maxIdle_ > 0) {
+            idle_.push_back(std::move(entry));
+            kept = true;
+            TrimLocked(&evicted);
+        }
+    }
+    if (!kept) {
+        DestroyEntry(entry);
+    }
+    for (Entry& e : evicted) {
+        DestroyEntry(e);
+    }
+    return kept;
+}
+
+void CodecPool::Discard(Entry entry)
+{
+    if (entry.codec == nullptr && entry.signal == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.discards++;
+    }
+    DestroyEntry(entry);
+}
+
+void CodecPool::RecordCreate(int64_t us, bool ok)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+        stats_.createFailures++;
+        return;
+    }
+    stats_.creates++;
+    stats_.createUsTotal += us;
+    stats_.createUsLast = us;
+    stats_.createUsMax = std::max(stats_.createUsMax, us);
+}
+
+void CodecPool::SetMaxIdle(size_t maxIdle)
+{
+    std::vector<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxIdle_ = std::min(maxIdle, kMaxIdleLimit);
+        TrimLocked(&evicted);
+    }
+    for (Entry& e : evicted) {
+        DestroyEntry(e);
+    }
+}
+
+CodecPool::Stats CodecPool::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.idle = idle_.size();
+    stats.maxIdle = maxIdle_;
+    return stats;
+}
+
+void CodecPool::Clear()
+{
+    std::deque<Entry> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle.swap(idle_);
+    }
+    for (Entry& e : idle) {
+        DestroyEntry(e);
+    }
+}
+
+uint64_t CodecPool::HashCodecConfig(const std::vector<uint8_t>& data)
+{
+    // FNV-1a; an empty config hashes to 0.
+    if (data.empty()) {
+        return 0;
+    }
+    uint64_t h = 1469598103934665603ULL;
+    for (uint8_t b : data) {
+        h ^= b;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void CodecPool::DestroyEntry(Entry& entry)
+{
+    delete entry.codec;
+    entry.codec = nullptr;
+    delete entry.signal;
+    entry.signal = nullptr;
+}
+
+void CodecPool::TrimLocked(std::vector<Entry>* evicted)
+{
+    while (idle_.size() > maxIdle_) {
+        evicted->push_back(std::move(idle_.front()));
+        idle_.pop_front();
+        stats_.evictions++;
+    }
+    if (!evicted->empty()) {
+        OH_LOG_INFO(LOG_APP, "Evicting %{public}llu idle codec(s), limit %{public}llu",
+                    (unsigned long long)evicted->size(), (unsigned long long)maxIdle_);
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef CODEC_POOL_H
+#define CODEC_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "media/media_backend.h"
+
+class AudioDecoderSignal;
+
+// Process-wide pool of idle audio codec instances.
+//
+// Creating a codec (Backend::CreateAudioDecoder + RegisterCallbacks) and taking
+// it through Configure/Prepare is a large part of the time to the first PCM.
+// A finished AudioDecoder therefore parks its codec here instead of destroying
+// it, and the next decode of the same MIME checks it out again:
+//   - Warm:  same MIME and configuration; the codec was stopped and only needs
+//            Codec::Start.
+//   - Reset: same MIME, other configuration; Codec::Reset brings it back
+//            to the initialized state (callbacks stay registered) for Configure.
+//   - Miss:  a new codec is created.
+// Each codec keeps its AudioDecoderSignal (the registered callback user data),
+// so the pair is pooled together. Codecs are only handed back to decoders using
+// the backend that created them. Idle codecs beyond the limit are destroyed in
+// least-recently-used order.
+class CodecPool {
+public:
+    static constexpr size_t kDefaultMaxIdle = 4;
+    static constexpr size_t kMaxIdleLimit = 32;
+
+    // Output configuration of a configured codec.
+    struct Config {
+        int32_t sampleRate = 0;
+        int32_t channelCount = 0;
+        int32_t bitrate = 0;
+        int32_t sampleFormat = 0;
+        uint64_t codecConfigHash = 0;  // extradata/csd
+
+        bool operator==(const Config& other) const
+        {
+            return sampleRate == other.sampleRate && channelCount == other.channelCount &&
+                   bitrate == other.bitrate && sampleFormat == other.sampleFormat &&
+                   codecConfigHash == other.codecConfigHash;
+        }
+    };
+
+    // A pooled codec and its callback user data.
+    struct Entry {
+        const media::Backend* backend = nullptr;
+        media::Codec* codec = nullptr;
+        AudioDecoderSignal* signal = nullptr;
+        std::string mimeType;
+        bool configured = false;  // stopped after Configure/Prepare: Start() resumes it
+        Config config;
+    };
+
+    enum class Reuse {
+        Miss = 0,
+        Reset = 1,
+        Warm = 2,
+    };
+
+    struct Stats {
+        uint64_t warmHits = 0;
+        uint64_t resetHits = 0;
+        uint64_t misses = 0;
+        uint64_t creates = 0;
+        uint64_t createFailures = 0;
+        uint64_t evictions = 0;
+        uint64_t discards = 0;  // failed codecs not taken back
+        int64_t createUsTotal = 0;
+        int64_t createUsLast = 0;
+        int64_t createUsMax = 0;
+        size_t idle = 0;
+        size_t maxIdle = 0;
+    };
+
+    static CodecPool& Shared();
+
+    CodecPool() = default;
+    ~CodecPool();
+
+    CodecPool(const CodecPool&) = delete;
+    CodecPool& operator=(const CodecPool&) = delete;
+
+    // Check out an idle codec of mimeType created by backend, preferring one
+    // configured with config. On Miss *entry is left empty and the caller creates the codec.
+    Reuse Acquire(const media::Backend* backend, const std::string& mimeType, const Config& config,
+                  Entry* entry);
+
+    // Take a codec back (stopped or reset). Returns false if it was destroyed
+    // right away because the pool is disabled.
+    bool Release(Entry entry);
+
+    // Destroy a codec that must not be reused (codec error, failed Stop/Reset).
+    void Discard(Entry entry);
+
+    // Timing of one Backend::CreateAudioDecoder + callback registration.
+    void RecordCreate(int64_t us, bool ok);
+
+    // 0 disables pooling; idle codecs beyond the new limit are destroyed.
+    void SetMaxIdle(size_t maxIdle);
+
+    Stats GetStats();
+
+    // Destroy all idle codecs.
+    void Clear();
+
+    static uint64_t HashCodecConfig(const std::vector<uint8_t>& data);
+
+private:
+    static void DestroyEntry(Entry& entry);
+    void TrimLocked(std::vector<Entry>* evicted);
+
+    std::mutex mutex_;
+    std::deque<Entry> idle_;  // front = least recently used
+    size_t maxIdle_ = kDefaultMaxIdle;
+    Stats stats_;
+};
+
+#endif
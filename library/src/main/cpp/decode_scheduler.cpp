@@ -0,0 +1,208 @@
+#include "decode_scheduler.h"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "DecodeScheduler"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+// Raise the calling thread's nice value (per-thread on Linux).
+bool LowerThreadPriority(int nice)
+{
+    const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, nice) != 0) {
+        OH_LOG_WARN(LOG_APP, "setpriority(%{public}d) failed", nice);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+DecodeScheduler::DecodeScheduler(const std::string& name, size_t maxThreads)
+    : name_(name.substr(0, 15)), maxThreads_(std::max<size_t>(1, std::min(maxThreads, kMaxThreadsLimit)))
+{
+}
+
+DecodeScheduler::~DecodeScheduler()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+    queue_.clear();
+    cond_.notify_all();
+    exitCond_.wait(lock, [this]() { return threads_ == 0; });
+}
+
+DecodeScheduler& DecodeScheduler::Streams()
+{
+    static DecodeScheduler* scheduler = new DecodeScheduler("pcm-stream", kDefaultStreamThreads);
+    return *scheduler;
+}
+
+DecodeScheduler& DecodeScheduler::Background()
+{
+    const unsigned cores = std::thread::hardware_concurrency();
+    static DecodeScheduler* scheduler = new DecodeScheduler(
+        "pcm-background", std::max<size_t>(kDefaultBackgroundThreads, cores > 1 ? cores - 1 : 0));
+    return *scheduler;
+}
+
+void DecodeScheduler::Submit(Priority priority, Task task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Item item;
+    item.priority = priority;
+    item.seq = nextSeq_++;
+    item.queuedAt = Clock::now();
+    item.task = std::move(task);
+    queue_.push_back(std::move(item));
+    // Idle threads that have not woken up yet are already spoken for by earlier tasks.
+    if (queue_.size() > idle_ && threads_ < maxThreads_) {
+        SpawnLocked();
+    }
+    cond_.notify_one();
+    if (threads_ >= maxThreads_ && queue_.size() > idle_) {
+        OH_LOG_INFO(LOG_APP, "%{public}s: all %{public}llu threads busy, %{public}llu task(s) waiting",
+                    name_.c_str(), (unsigned long long)maxThreads_, (unsigned long long)queue_.size());
+    }
+}
+
+void DecodeScheduler::Parallel(Priority priority, size_t workers, const std::function<void(size_t worker)>& body)
+{
+    // Outlives the call: skipped tasks may only run after it returned.
+    struct Gate {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool closed = false;
+        size_t running = 0;
+    };
+    auto gate = std::make_shared<Gate>();
+    for (size_t worker = 1; worker < workers; worker++) {
+        Submit(priority, [gate, &body, worker]() {
+            {
+                std::lock_guard<std::mutex> lock(gate->mutex);
+                if (gate->closed) {
+                    return;
+                }
+                gate->running++;
+            }
+            body(worker);
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            if (--gate->running == 0) {
+                gate->cond.notify_all();
+            }
+        });
+    }
+    body(0);
+    std::unique_lock<std::mutex> lock(gate->mutex);
+    gate->closed = true;
+    gate->cond.wait(lock, [&gate]() { return gate->running == 0; });
+}
+
+void DecodeScheduler::SetMaxThreads(size_t maxThreads)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxThreads_ = std::max<size_t>(1, std::min(maxThreads, kMaxThreadsLimit));
+    for (size_t spawned = 0; queue_.size() > idle_ + spawned && threads_ < maxThreads_; spawned++) {
+        SpawnLocked();
+    }
+    cond_.notify_all();
+}
+
+DecodeScheduler::Stats DecodeScheduler::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.maxThreads = maxThreads_;
+    stats.threads = threads_;
+    stats.running = running_;
+    stats.queued = queue_.size();
+    stats.submitted = nextSeq_;
+    stats.completed = completed_;
+    stats.queueWaitUsMax = queueWaitUsMax_;
+    return stats;
+}
+
+const char* DecodeScheduler::PriorityName(Priority priority)
+{
+    switch (priority) {
+    case Priority::Low:
+        return "low";
+    case Priority::High:
+        return "high";
+    default:
+        return "normal";
+    }
+}
+
+void DecodeScheduler::SpawnLocked()
+{
+    threads_++;
+    std::thread([this]() { WorkerLoop(); }).detach();
+}
+
+DecodeScheduler::Item DecodeScheduler::PopLocked()
+{
+    auto best = std::max_element(queue_.begin(), queue_.end(), [](const Item& a, const Item& b) {
+        return a.priority != b.priority ? a.priority < b.priority : a.seq > b.seq;
+    });
+    Item item = std::move(*best);
+    queue_.erase(best);
+    return item;
+}
+
+void DecodeScheduler::WorkerLoop()
+{
+    pthread_setname_np(pthread_self(), name_.c_str());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        idle_++;
+        const bool woken = cond_.wait_for(lock, kIdleKeepAlive, [this]() {
+            return stop_ || !queue_.empty() || threads_ > maxThreads_;
+        });
+        idle_--;
+        if (stop_ || threads_ > maxThreads_ || (!woken && queue_.empty())) {
+            break;
+        }
+        if (queue_.empty()) {
+            continue;
+        }
+
+        Item item = PopLocked();
+        const int64_t waitUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - item.queuedAt).count();
+        queueWaitUsMax_ = std::max(queueWaitUsMax_, waitUs);
+        running_++;
+        lock.unlock();
+
+        const bool lowered = item.priority == Priority::Low && LowerThreadPriority(kLowPriorityNice);
+        item.task();
+        item.task = nullptr;  // release captured state outside the lock
+
+        lock.lock();
+        running_--;
+        completed_++;
+        if (lowered) {
+            break;
+        }
+    }
+
+    threads_--;
+    // A retiring thread hands queued work over to a fresh one.
+    if (!stop_ && queue_.size() > idle_ && threads_ < maxThreads_) {
+        SpawnLocked();
+        cond_.notify_one();
+    }
+    exitCond_.notify_all();
+}
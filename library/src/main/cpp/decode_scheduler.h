@@ -0,0 +1,114 @@
+#ifndef DECODE_SCHEDULER_H
+#define DECODE_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Threads owned by the library for long-running decode work.
+//
+// A streaming decode occupies its thread for the whole playback, so running
+// it as napi_async_work would pin a thread of the shared async-work pool that
+// the rest of the app relies on. Decodes are submitted here instead:
+//   - Streams():    live stream decoders, bounded so a burst of players cannot
+//                   spawn unbounded threads;
+//   - Background(): file decodes (decodeAudioAsync / decodeBatch), kept apart so
+//                   offline work never delays a player from starting. Its limit
+//                   is the process-wide cap on file decode concurrency: batch
+//                   workers fan out onto it with Parallel().
+// Each scheduler starts threads on demand up to its limit; a task submitted
+// while all threads are busy waits, higher priority first and FIFO within a
+// priority. Low tasks also run with a raised nice value; since an unprivileged
+// thread cannot lower it again, that thread retires afterwards. Threads idle
+// for longer than kIdleKeepAlive exit.
+//
+// Completion is up to the task (e.g. a threadsafe function back to JS).
+class DecodeScheduler {
+public:
+    enum class Priority {
+        Low = 0,
+        Normal = 1,
+        High = 2,
+    };
+
+    using Task = std::function<void()>;
+
+    static constexpr size_t kDefaultStreamThreads = 4;
+    static constexpr size_t kDefaultBackgroundThreads = 2;  // or cores - 1 if more
+    static constexpr size_t kMaxThreadsLimit = 16;
+    static constexpr int kLowPriorityNice = 10;
+    static constexpr std::chrono::seconds kIdleKeepAlive{30};
+
+    struct Stats {
+        size_t maxThreads = 0;
+        size_t threads = 0;  // alive (running or idle)
+        size_t running = 0;
+        size_t queued = 0;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        int64_t queueWaitUsMax = 0;  // longest wait of a task for a thread
+    };
+
+    // name: thread name (at most 15 characters).
+    DecodeScheduler(const std::string& name, size_t maxThreads);
+    // Waits for running tasks; queued ones are dropped.
+    ~DecodeScheduler();
+
+    DecodeScheduler(const DecodeScheduler&) = delete;
+    DecodeScheduler& operator=(const DecodeScheduler&) = delete;
+
+    // Process-wide instances (never destroyed, their threads may outlive main()).
+    static DecodeScheduler& Streams();
+    static DecodeScheduler& Background();
+
+    void Submit(Priority priority, Task task);
+
+    // Runs body(0) on the calling thread and body(1..workers-1) as tasks here,
+    // and returns once every body that started has returned. A task that has
+    // not started by the time body(0) returns is skipped, so body should pull
+    // from shared work until it runs out: then a caller on one of this
+    // scheduler's own threads cannot wait for tasks stuck behind it.
+    void Parallel(Priority priority, size_t workers, const std::function<void(size_t worker)>& body);
+
+    // Clamped to 1..kMaxThreadsLimit; surplus threads exit once idle.
+    void SetMaxThreads(size_t maxThreads);
+
+    Stats GetStats();
+
+    static const char* PriorityName(Priority priority);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Item {
+        Priority priority = Priority::Normal;
+        uint64_t seq = 0;
+        Clock::time_point queuedAt;
+        Task task;
+    };
+
+    void SpawnLocked();
+    void WorkerLoop();
+    Item PopLocked();
+
+    const std::string name_;
+    std::mutex mutex_;
+    std::condition_variable cond_;       // work queued, limit changed, stop
+    std::condition_variable exitCond_;   // a thread exited
+    std::vector<Item> queue_;
+    size_t maxThreads_;
+    size_t threads_ = 0;
+    size_t idle_ = 0;
+    size_t running_ = 0;
+    bool stop_ = false;
+    uint64_t nextSeq_ = 0;
+    uint64_t completed_ = 0;
+    int64_t queueWaitUsMax_ = 0;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "decode_stats.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+int HighestBit(uint64_t v)
+{
+    int bit = 0;
+    while (v >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0), sumNs_(0), minNs_(std::numeric_limits<uint64_t>::max()), maxNs_(0)
+{
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t ns)
+{
+    if (ns < kSubBuckets) {
+        return static_cast<size_t>(ns);
+    }
+    const int msb = HighestBit(ns);
+    if (msb >= kMaxBits) {
+        return kBucketCount - 1;
+    }
+    // Top kSubBucketBits bits below the leading one select the linear sub-bucket.
+    const int shift = msb - kSubBucketBits;
+    const uint64_t sub = (ns >> shift) - kSubBuckets;
+    return static_cast<size_t>(shift + 1) * kSubBuckets + static_cast<size_t>(sub);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    const uint64_t sub = index % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(int64_t ns)
+{
+    const uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    buckets_[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumNs_.fetch_add(v, std::memory_order_relaxed);
+
+    uint64_t cur = minNs_.load(std::memory_order_relaxed);
+    while (v < cur && !minNs_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+    cur = maxNs_.load(std::memory_order_relaxed);
+    while (v > cur && !maxNs_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Take() const
+{
+    Snapshot s;
+    std::array<uint64_t, kBucketCount> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return s;
+    }
+
+    s.count = total;
+    const uint64_t minNs = minNs_.load(std::memory_order_relaxed);
+    const uint64_t maxNs = maxNs_.load(std::memory_order_relaxed);
+    s.minNs = minNs == std::numeric_limits<uint64_t>::max() ? 0 : static_cast<int64_t>(minNs);
+    s.maxNs = static_cast<int64_t>(maxNs);
+    s.meanNs = static_cast<double>(sumNs_.load(std::memory_order_relaxed)) /
+               static_cast<double>(std::max<uint64_t>(count_.load(std::memory_order_relaxed), 1));
+
+    // Each percentile is the upper bound of the bucket holding its rank, clamped
+    // to the observed range. The last bucket has no upper bound; it reports the max.
+    const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+    int64_t* outputs[] = {&s.p50Ns, &s.p90Ns, &s.p99Ns, &s.p999Ns};
+    size_t q = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount && q < 4; i++) {
+        seen += counts[i];
+        while (q < 4 && static_cast<double>(seen) >= quantiles[q] * static_cast<double>(total)) {
+            const uint64_t upper = i + 1 == kBucketCount ? maxNs : BucketUpperBound(i);
+            const uint64_t v = std::min(std::max(upper, minNs), maxNs);
+            *outputs[q] = static_cast<int64_t>(v);
+            q++;
+        }
+    }
+    return s;
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sumNs_.store(0, std::memory_order_relaxed);
+    minNs_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    maxNs_.store(0, std::memory_order_relaxed);
+}
+
+DecodeStats::DecodeStats()
+    : bytesDecoded_(0), underruns_(0), ringHigh_(0), ringLow_(std::numeric_limits<uint64_t>::max()),
+      startNs_(NowNs())
+{
+}
+
+const char* DecodeStats::StageName(Stage stage)
+{
+    switch (stage) {
+        case Stage::Read: return "read";
+        case Stage::CodecWait: return "codecWait";
+        case Stage::Convert: return "convert";
+        case Stage::Eq: return "eq";
+        case Stage::Pitch: return "pitch";
+        case Stage::Drc: return "drc";
+        case Stage::Limiter: return "limiter";
+        case Stage::RingPush: return "ringPush";
+        case Stage::Fill: return "fill";
+        case Stage::Seek: return "seek";
+        default: return "unknown";
+    }
+}
+
+DecodeStats::Snapshot DecodeStats::Take() const
+{
+    Snapshot s;
+    for (size_t i = 0; i < kStageCount; i++) {
+        s.stages[i] = stages_[i].Take();
+    }
+    s.bytesDecoded = bytesDecoded_.load(std::memory_order_relaxed);
+    s.underruns = underruns_.load(std::memory_order_relaxed);
+    s.ringHighWaterBytes = ringHigh_.load(std::memory_order_relaxed);
+    const uint64_t low = ringLow_.load(std::memory_order_relaxed);
+    s.ringLowWaterBytes = low == std::numeric_limits<uint64_t>::max() ? 0 : low;
+    s.elapsedNs = NowNs() - startNs_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void DecodeStats::Reset()
+{
+    for (auto& h : stages_) {
+        h.Reset();
+    }
+    bytesDecoded_.store(0, std::memory_order_relaxed);
+    underruns_.store(0, std::memory_order_relaxed);
+    ringHigh_.store(0, std::memory_order_relaxed);
+    ringLow_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    startNs_.store(NowNs(), std::memory_order_relaxed);
+}
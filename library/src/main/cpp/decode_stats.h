@@ -0,0 +1,172 @@
+#ifndef DECODE_STATS_H
+#define DECODE_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Latency histogram with log-linear buckets (HdrHistogram layout) over
+// nanoseconds: values below kSubBuckets are exact, every power of two above
+// that is split into kSubBuckets linear buckets, so a percentile is reported
+// within 1/kSubBuckets (6.25 %) of the recorded value. Values from 2^kMaxBits ns
+// (~69 s) on land in the last bucket; percentiles there report the max.
+//
+// Record() is a few relaxed atomic adds and is safe from any thread. Take() may
+// run concurrently with recording; it then sees a slightly torn but usable view.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr uint64_t kSubBuckets = 1u << kSubBucketBits;
+    static constexpr int kMaxBits = 36;
+    static constexpr size_t kBucketCount = static_cast<size_t>(kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        int64_t minNs = 0;
+        int64_t maxNs = 0;
+        double meanNs = 0.0;
+        int64_t p50Ns = 0;
+        int64_t p90Ns = 0;
+        int64_t p99Ns = 0;
+        int64_t p999Ns = 0;
+    };
+
+    LatencyHistogram();
+
+    void Record(int64_t ns);
+    Snapshot Take() const;
+    // Not atomic with respect to concurrent Record() calls.
+    void Reset();
+
+    static size_t BucketIndex(uint64_t ns);
+    // Highest value that maps to bucket index.
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sumNs_;
+    std::atomic<uint64_t> minNs_;
+    std::atomic<uint64_t> maxNs_;
+};
+
+// Per-stage timing and buffer counters of one stream decoder (getStats()).
+//
+// Stages are timed where the work happens: demuxer reads and codec waits in
+// AudioDecoder, conversion and the DSP stages in DspChain (summed over the tiles
+// of one buffer, so each sample is one decoded buffer), ring pushes in the
+// stream decoder, fill/fillForWriteData on the render thread, and seeks from the
+// request to the first PCM at the new position.
+//
+// Stats are on unless the build defines FREE_PCM_NO_STATS (CMake option
+// FREE_PCM_STATS=OFF); kEnabled is then false and every recording call folds
+// away at compile time.
+class DecodeStats {
+public:
+#ifdef FREE_PCM_NO_STATS
+    static constexpr bool kEnabled = false;
+#else
+    static constexpr bool kEnabled = true;
+#endif
+
+    enum class Stage : uint32_t {
+        Read = 0,   // demuxer ReadSample
+        CodecWait,  // decode thread waiting for codec output
+        Convert,    // decoded samples -> float (and crossfade mix)
+        Eq,
+        Pitch,
+        Drc,
+        Limiter,
+        RingPush,   // float -> output format and ring buffer push, incl. waits for space
+        Fill,       // fill / fillForWriteData, incl. blocking reads
+        Seek,       // seek request -> first PCM at the target
+        Count,
+    };
+    static constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+
+    struct Snapshot {
+        LatencyHistogram::Snapshot stages[kStageCount];
+        uint64_t bytesDecoded = 0;
+        uint64_t underruns = 0;
+        uint64_t ringHighWaterBytes = 0;
+        uint64_t ringLowWaterBytes = 0;  // 0 until the first fill
+        int64_t elapsedNs = 0;           // since construction or the last Reset()
+    };
+
+    // Times one stage for the lifetime of the object; a null stats is a no-op.
+    class Timer {
+    public:
+        Timer(DecodeStats* stats, Stage stage)
+            : stats_(kEnabled ? stats : nullptr), stage_(stage), startNs_(stats_ ? NowNs() : 0)
+        {
+        }
+        ~Timer()
+        {
+            if (kEnabled && stats_) stats_->Record(stage_, NowNs() - startNs_);
+        }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        DecodeStats* stats_;
+        Stage stage_;
+        int64_t startNs_;
+    };
+
+    DecodeStats();
+
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // Key used in the getStats() result.
+    static const char* StageName(Stage stage);
+
+    void Record(Stage stage, int64_t ns)
+    {
+        if (kEnabled) stages_[static_cast<size_t>(stage)].Record(ns);
+    }
+    void AddBytesDecoded(uint64_t bytes)
+    {
+        if (kEnabled) bytesDecoded_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void AddUnderrun()
+    {
+        if (kEnabled) underruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Buffered bytes right after a push (producer side).
+    void ObserveRingHigh(size_t bufferedBytes)
+    {
+        if (!kEnabled) return;
+        uint64_t cur = ringHigh_.load(std::memory_order_relaxed);
+        while (bufferedBytes > cur &&
+               !ringHigh_.compare_exchange_weak(cur, bufferedBytes, std::memory_order_relaxed)) {
+        }
+    }
+    // Buffered bytes when a fill starts (consumer side).
+    void ObserveRingLow(size_t bufferedBytes)
+    {
+        if (!kEnabled) return;
+        uint64_t cur = ringLow_.load(std::memory_order_relaxed);
+        while (bufferedBytes < cur &&
+               !ringLow_.compare_exchange_weak(cur, bufferedBytes, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot Take() const;
+    // Not atomic with respect to concurrent recording.
+    void Reset();
+
+private:
+    std::array<LatencyHistogram, kStageCount> stages_;
+    std::atomic<uint64_t> bytesDecoded_;
+    std::atomic<uint64_t> underruns_;
+    std::atomic<uint64_t> ringHigh_;
+    std::atomic<uint64_t> ringLow_;
+    std::atomic<int64_t> startNs_;
+};
+
+#endif
@@ -0,0 +1,340 @@
+#include "decode_trace.h"
+
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> DecodeTrace::enabled_(false);
+
+namespace {
+
+constexpr uint32_t kPhaseBegin = 'B';
+constexpr uint32_t kPhaseEnd = 'E';
+constexpr uint32_t kPhaseInstant = 'i';
+constexpr size_t kThreadNameBytes = 32;
+
+// Fields are atomics so Dump() can copy a ring its owner is still writing.
+struct Event {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const char*> argName{nullptr};
+    std::atomic<int64_t> tsNs{0};
+    std::atomic<int64_t> arg{0};
+    std::atomic<uint32_t> phase{0};
+};
+
+struct ThreadBuffer {
+    ThreadBuffer(size_t cap, uint64_t sess, uint32_t threadId, std::string threadName)
+        : events(new Event[cap]), capacity(cap), session(sess), tid(threadId), name(std::move(threadName))
+    {
+    }
+
+    std::unique_ptr<Event[]> events;
+    const size_t capacity;
+    const uint64_t session;
+    const uint32_t tid;
+    std::string name;               // Registry::mutex
+    std::atomic<uint64_t> head{0};  // events written; only the owner thread stores
+    // Cleared when the owner thread exits or moves to a newer session; the next
+    // Start() then frees the buffer.
+    std::atomic<bool> owned{true};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<uint64_t> session{0};
+    size_t eventsPerThread = DecodeTrace::kDefaultEventsPerThread;
+    std::atomic<uint64_t> dropped{0};
+};
+
+// Never destroyed: threads may still record (or exit) during static destruction.
+Registry& GetRegistry()
+{
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+    uint64_t session = 0;
+    char name[kThreadNameBytes] = {};
+
+    ~ThreadSlot()
+    {
+        if (buffer) {
+            buffer->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot tlsSlot;
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string CurrentThreadName()
+{
+    if (tlsSlot.name[0] != '\0') {
+        return tlsSlot.name;
+    }
+    char name[kThreadNameBytes] = {};
+    if (prctl(PR_GET_NAME, name, 0, 0, 0) == 0) {
+        return name;
+    }
+    return std::string();
+}
+
+// Slow path of the first event of a thread in a session.
+ThreadBuffer* AcquireBuffer(uint64_t session)
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (tlsSlot.buffer) {
+        tlsSlot.buffer->owned.store(false, std::memory_order_release);
+        tlsSlot.buffer = nullptr;
+    }
+    // Start() may have run since the caller loaded the session.
+    session = registry.session.load(std::memory_order_relaxed);
+    tlsSlot.session = session;
+
+    const size_t threads = static_cast<size_t>(std::count_if(
+        registry.buffers.begin(), registry.buffers.end(),
+        [session](const std::unique_ptr<ThreadBuffer>& b) { return b->session == session; }));
+    if (threads >= DecodeTrace::kMaxThreads) {
+        // Make room by dropping the oldest ring of an exited thread (e.g. the
+        // per-decode feeder threads), so long sessions keep recent events.
+        auto exited = std::find_if(registry.buffers.begin(), registry.buffers.end(),
+                                   [session](const std::unique_ptr<ThreadBuffer>& b) {
+                                       return b->session == session && !b->owned.load(std::memory_order_acquire);
+                                   });
+        if (exited == registry.buffers.end()) {
+            return nullptr;
+        }
+        registry.buffers.erase(exited);
+    }
+    registry.buffers.push_back(std::make_unique<ThreadBuffer>(
+        registry.eventsPerThread, session, static_cast<uint32_t>(syscall(SYS_gettid)), CurrentThreadName()));
+    tlsSlot.buffer = registry.buffers.back().get();
+    return tlsSlot.buffer;
+}
+
+void Record(uint32_t phase, const char* name, const char* argName, int64_t arg)
+{
+    Registry& registry = GetRegistry();
+    const uint64_t session = registry.session.load(std::memory_order_relaxed);
+    ThreadBuffer* buffer = tlsSlot.buffer;
+    if (tlsSlot.session != session) {
+        if (!DecodeTrace::Enabled()) {
+            return;
+        }
+        buffer = AcquireBuffer(session);
+    }
+    if (!buffer) {
+        registry.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    // Orders the slot overwrite after head == index, so a concurrent Dump()
+    // that sees the new fields also sees the wrap and discards the slot.
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& e = buffer->events[index % buffer->capacity];
+    e.name.store(name, std::memory_order_relaxed);
+    e.argName.store(argName, std::memory_order_relaxed);
+    e.tsNs.store(NowNs(), std::memory_order_relaxed);
+    e.arg.store(arg, std::memory_order_relaxed);
+    e.phase.store(phase, std::memory_order_relaxed);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void AppendEscaped(std::string* out, const char* s)
+{
+    for (; s != nullptr && *s != '\0'; s++) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back(static_cast<char>(c));
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out->append(buf);
+        } else {
+            out->push_back(static_cast<char>(c));
+        }
+    }
+}
+
+struct EventCopy {
+    const char* name;
+    const char* argName;
+    int64_t tsNs;
+    int64_t arg;
+    uint32_t phase;
+};
+
+void AppendEvent(std::string* out, const EventCopy& e, int pid, uint32_t tid)
+{
+    char buf[128];
+    out->append(",\n{\"name\":\"");
+    AppendEscaped(out, e.name);
+    const int64_t us = e.tsNs / 1000;
+    const int64_t frac = e.tsNs % 1000;
+    snprintf(buf, sizeof(buf), "\",\"cat\":\"free_pcm\",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":%d,\"tid\":%u",
+             static_cast<char>(e.phase), static_cast<long long>(us), static_cast<long long>(frac < 0 ? -frac : frac),
+             pid, tid);
+    out->append(buf);
+    if (e.phase == kPhaseInstant) {
+        out->append(",\"s\":\"t\"");
+    }
+    if (e.argName != nullptr) {
+        out->append(",\"args\":{\"");
+        AppendEscaped(out, e.argName);
+        snprintf(buf, sizeof(buf), "\":%lld}", static_cast<long long>(e.arg));
+        out->append(buf);
+    }
+    out->push_back('}');
+}
+
+void AppendThread(std::string* out, const ThreadBuffer& buffer, int pid)
+{
+    char buf[96];
+    snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"",
+             pid, buffer.tid);
+    out->append(buf);
+    AppendEscaped(out, buffer.name.c_str());
+    out->append("\"}}");
+
+    const uint64_t head = buffer.head.load(std::memory_order_acquire);
+    const uint64_t first = head > buffer.capacity ? head - buffer.capacity : 0;
+    std::vector<EventCopy> copies;
+    copies.reserve(static_cast<size_t>(head - first));
+    for (uint64_t i = first; i < head; i++) {
+        const Event& e = buffer.events[i % buffer.capacity];
+        copies.push_back({e.name.load(std::memory_order_relaxed), e.argName.load(std::memory_order_relaxed),
+                          e.tsNs.load(std::memory_order_relaxed), e.arg.load(std::memory_order_relaxed),
+                          e.phase.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Slots the owner wrapped onto (or is writing) while they were copied.
+    const uint64_t head2 = buffer.head.load(std::memory_order_relaxed);
+    const uint64_t valid = head2 + 1 > buffer.capacity ? head2 + 1 - buffer.capacity : 0;
+
+    // After a wrap the oldest events may be ends of scopes whose begin was
+    // overwritten; leave those out so the viewer does not close outer scopes.
+    int depth = 0;
+    for (uint64_t i = std::max(first, valid); i < head; i++) {
+        const EventCopy& e = copies[static_cast<size_t>(i - first)];
+        if (e.name == nullptr) {
+            continue;
+        }
+        if (e.phase == kPhaseBegin) {
+            depth++;
+        } else if (e.phase == kPhaseEnd) {
+            if (depth == 0) {
+                continue;
+            }
+            depth--;
+        }
+        AppendEvent(out, e, pid, buffer.tid);
+    }
+}
+
+} // namespace
+
+void DecodeTrace::Start(size_t eventsPerThread)
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.eventsPerThread = std::min(std::max(eventsPerThread, kMinEventsPerThread), kMaxEventsPerThread);
+    registry.session.fetch_add(1, std::memory_order_relaxed);
+    registry.dropped.store(0, std::memory_order_relaxed);
+    // Buffers still owned stay until their thread records again (it may be
+    // writing right now); they belong to an old session and are not dumped.
+    registry.buffers.erase(std::remove_if(registry.buffers.begin(), registry.buffers.end(),
+                                          [](const std::unique_ptr<ThreadBuffer>& b) {
+                                              return !b->owned.load(std::memory_order_acquire);
+                                          }),
+                           registry.buffers.end());
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void DecodeTrace::Stop()
+{
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void DecodeTrace::Begin(const char* name, const char* argName, int64_t arg)
+{
+    if (Enabled()) Record(kPhaseBegin, name, argName, arg);
+}
+
+// Not gated on the flag: the end of a recorded begin is kept after Stop().
+void DecodeTrace::End(const char* name)
+{
+    Record(kPhaseEnd, name, nullptr, 0);
+}
+
+void DecodeTrace::Instant(const char* name, const char* argName, int64_t arg)
+{
+    if (Enabled()) Record(kPhaseInstant, name, argName, arg);
+}
+
+void DecodeTrace::SetThreadName(const char* name)
+{
+    if (name == nullptr) {
+        return;
+    }
+    strncpy(tlsSlot.name, name, kThreadNameBytes - 1);
+    tlsSlot.name[kThreadNameBytes - 1] = '\0';
+    if (tlsSlot.buffer) {
+        std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+        tlsSlot.buffer->name = tlsSlot.name;
+    }
+}
+
+std::string DecodeTrace::Dump()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const uint64_t session = registry.session.load(std::memory_order_relaxed);
+    const int pid = static_cast<int>(getpid());
+
+    std::string out;
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"free_pcm\"}}",
+             pid);
+    out.append(buf);
+
+    size_t threads = 0;
+    uint64_t recorded = 0;
+    uint64_t overwritten = 0;
+    for (const auto& buffer : registry.buffers) {
+        if (session == 0 || buffer->session != session) {
+            continue;
+        }
+        AppendThread(&out, *buffer, pid);
+        const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        threads++;
+        recorded += head;
+        overwritten += head > buffer->capacity ? head - buffer->capacity : 0;
+    }
+    snprintf(buf, sizeof(buf),
+             "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"threads\":%zu,\"recordedEvents\":%llu,"
+             "\"overwrittenEvents\":%llu,\"droppedEvents\":%llu}}\n",
+             threads, static_cast<unsigned long long>(recorded), static_cast<unsigned long long>(overwritten),
+             static_cast<unsigned long long>(registry.dropped.load(std::memory_order_relaxed)));
+    out.append(buf);
+    return out;
+}
@@ -0,0 +1,77 @@
+#ifndef DECODE_TRACE_H
+#define DECODE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in timeline tracing of the decode pipeline, exported as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Events are begin/end pairs (Scope) and instants, each with an optional
+// integer argument. Every thread records into its own fixed-size ring of
+// events, so recording takes no lock: a relaxed load of the enabled flag, a
+// clock read and a few relaxed stores. When the ring is full the oldest events
+// are overwritten, which bounds memory to eventsPerThread * sizeof(event) per
+// recording thread. At most kMaxThreads rings are kept per session; past that
+// the oldest ring of an exited thread is freed for the new one. A thread's ring
+// is allocated on its first event after Start(); while tracing is stopped
+// nothing is allocated and every call returns after the flag check.
+//
+// Names and argument names must be string literals (only the pointer is
+// stored). Dump() may run while tracing; events overwritten during the copy
+// are left out.
+class DecodeTrace {
+public:
+    static constexpr size_t kDefaultEventsPerThread = 8192;
+    static constexpr size_t kMinEventsPerThread = 256;
+    static constexpr size_t kMaxEventsPerThread = 1u << 20;
+    static constexpr size_t kMaxThreads = 64;
+
+    // Begin/end pair for the lifetime of the object. A scope begun before Stop()
+    // still records its end.
+    class Scope {
+    public:
+        explicit Scope(const char* name, const char* argName = nullptr, int64_t arg = 0)
+            : name_(Enabled() ? name : nullptr)
+        {
+            if (name_) Begin(name_, argName, arg);
+        }
+        ~Scope()
+        {
+            if (name_) End(name_);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name_;
+    };
+
+    static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Start a new session; events of the previous one are discarded.
+    // eventsPerThread is clamped to [kMinEventsPerThread, kMaxEventsPerThread].
+    static void Start(size_t eventsPerThread = kDefaultEventsPerThread);
+    // Stop recording; the session stays available to Dump().
+    static void Stop();
+
+    static void Begin(const char* name, const char* argName = nullptr, int64_t arg = 0);
+    static void End(const char* name);
+    static void Instant(const char* name, const char* argName = nullptr, int64_t arg = 0);
+
+    // Label the calling thread in the trace (copied, up to 31 bytes). Threads
+    // without a label show their OS thread name.
+    static void SetThreadName(const char* name);
+
+    // The current session as a Chrome trace-event JSON object. otherData holds
+    // the session counters: threads, recordedEvents, overwrittenEvents (lost to
+    // wrap-around) and droppedEvents (more than kMaxThreads live threads).
+    static std::string Dump();
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef DECODE_WAKEUP_H
+#define DECODE_WAKEUP_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// The single wait primitive of a decode thread.
+//
+// Codec buffer callbacks, seek requests, pause/resume and cancel all signal the
+// same condition variable, so the decode thread blocks without timers and
+// reacts to any of them immediately. Predicates may read state guarded by other
+// locks (or atomics); the writer only has to call Notify()/NotifyState() after
+// changing it.
+//
+// - NotifyState(): state a predicate looks at changed (e.g. a codec buffer
+//   became available).
+// - Notify(): an external event happened; also bumps the generation so loops
+//   that poll several sources (seek, cancel, ...) wake up via WaitChanged().
+//
+// Wakeups() counts how often a blocked waiter was woken (including wakeups
+// whose predicate still failed), i.e. the decode thread's wakeup rate.
+class DecodeWakeup {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    DecodeWakeup() = default;
+    DecodeWakeup(const DecodeWakeup&) = delete;
+    DecodeWakeup& operator=(const DecodeWakeup&) = delete;
+
+    void Notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_++;
+        }
+        cond_.notify_all();
+    }
+
+    void NotifyState()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        cond_.notify_all();
+    }
+
+    uint64_t Generation()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return generation_;
+    }
+
+    uint64_t Wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+    // Block until pred() holds.
+    template <typename Pred>
+    void Wait(Pred pred)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, Counted(pred));
+    }
+
+    // Block until pred() holds or Notify() was called after Generation() returned seen.
+    template <typename Pred>
+    void WaitChanged(uint64_t seen, Pred pred)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, Counted([&]() { return generation_ != seen || pred(); }));
+    }
+
+    // As WaitChanged(), giving up at deadline. Returns false on timeout.
+    template <typename Pred>
+    bool WaitChangedUntil(uint64_t seen, Clock::time_point deadline, Pred pred)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_until(lock, deadline, Counted([&]() { return generation_ != seen || pred(); }));
+    }
+
+private:
+    // Every evaluation after the first one follows a wakeup.
+    template <typename Pred>
+    auto Counted(Pred pred)
+    {
+        return [this, pred, first = true]() mutable {
+            if (!first) {
+                wakeups_.fetch_add(1, std::memory_order_relaxed);
+            }
+            first = false;
+            return pred();
+        };
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint64_t generation_ = 0;
+    std::atomic<uint64_t> wakeups_{0};
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "dsp_chain.h"
+
+DspChain::DspChain(PcmEqualizer& eq, PcmPitchShifter& pitch, DrcProcessor& drc, TruePeakLimiter& limiter)
+    : eq_(eq), pitch_(pitch), drc_(drc), limiter_(limiter), channelCount_(0), volL_(1.0f), volR_(1.0f),
+      stageMask_(0), stats_(nullptr)
+{
+}
+
+void DspChain::Configure(int32_t channelCount, uint32_t stageMask, float volL, float volR)
+{
+    channelCount_ = channelCount;
+    volL_ = volL;
+    volR_ = volR;
+    if (channelCount_ != 1 && channelCount_ != 2) {
+        stageMask &= ~static_cast<uint32_t>(kStageChannelVolume);
+    }
+    stageMask_ = stageMask & kStageAll;
+}
+
+void DspChain::ApplyChannelVolume(float* samples, size_t frameCount) const
+{
+    if (channelCount_ == 1) {
+        for (size_t i = 0; i < frameCount; i++) {
+            samples[i] *= volL_;
+        }
+        return;
+    }
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i * 2] *= volL_;
+        samples[i * 2 + 1] *= volR_;
+    }
+}
+
+void DspChain::ProcessStages(float* samples, size_t frameCount)
+{
+    int64_t t = (DecodeStats::kEnabled && stats_ != nullptr) ? DecodeStats::NowNs() : 0;
+    if ((stageMask_ & kStageEq) != 0) {
+        eq_.ProcessFloat(samples, frameCount);
+        Lap(DecodeStats::Stage::Eq, &t);
+    }
+    if ((stageMask_ & kStagePitch) != 0) {
+        pitch_.ProcessFloat(samples, frameCount);
+        Lap(DecodeStats::Stage::Pitch, &t);
+    }
+    if ((stageMask_ & kStageChannelVolume) != 0) {
+        ApplyChannelVolume(samples, frameCount);
+        if (DecodeStats::kEnabled && stats_ != nullptr) {
+            t = DecodeStats::NowNs();
+        }
+    }
+    if ((stageMask_ & kStageDrc) != 0) {
+        drc_.ProcessFloat(samples, frameCount);
+        Lap(DecodeStats::Stage::Drc, &t);
+    }
+    if ((stageMask_ & kStageLimiter) != 0) {
+        limiter_.ProcessFloat(samples, frameCount);
+        Lap(DecodeStats::Stage::Limiter, &t);
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef DSP_CHAIN_H
+#define DSP_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "decode_stats.h"
+#include "drc_processor.h"
+#include "pcm_equalizer.h"
+#include "pcm_pitch_shifter.h"
+#include "true_peak_limiter.h"
+
+// Float DSP chain for the stream decoder.
+//
+// Run() has the caller's source convert the whole buffer into the chain's
+// float scratch, runs every enabled stage over it in turn, and hands it to the
+// caller's sink:
+//   EQ -> pitch -> channel volume -> DRC -> limiter.
+// The stages are compute-bound (a scratch pass costs about 1 ns/frame against
+// 18-48 ns/frame for EQ, limiter and DRC), so processing in cache-sized tiles
+// measured no faster than these plain per-buffer passes
+// (BM_DspChainTenMinutes).
+//
+// With SetStats() every Run() also records the time of each enabled stage: the
+// source as DecodeStats::Stage::Convert, the sink as Stage::RingPush, and EQ,
+// pitch, DRC and limiter as their own stages.
+class DspChain {
+public:
+    enum Stage : uint32_t {
+        kStageEq = 1u << 0,
+        kStagePitch = 1u << 1,
+        kStageChannelVolume = 1u << 2,
+        kStageDrc = 1u << 3,
+        kStageLimiter = 1u << 4,
+    };
+    static constexpr uint32_t kStageAll = (1u << 5) - 1;
+
+    DspChain(PcmEqualizer& eq, PcmPitchShifter& pitch, DrcProcessor& drc, TruePeakLimiter& limiter);
+
+    // stageMask: OR of Stage bits. Channel volume is only applied to mono/stereo.
+    // volL/volR: linear gains for the channel volume stage (mono uses volL).
+    void Configure(int32_t channelCount, uint32_t stageMask, float volL, float volR);
+
+    // Process frameCount frames.
+    // source(float* samples, size_t frames) fills frames * ch samples.
+    // sink(const float* samples, size_t frames) consumes them and returns false
+    // to stop; Run then returns false.
+    template <typename Source, typename Sink>
+    bool Run(size_t frameCount, Source&& source, Sink&& sink);
+
+    // Stage timing target; nullptr (the default) disables timing.
+    void SetStats(DecodeStats* stats) { stats_ = stats; }
+
+private:
+    void ProcessStages(float* samples, size_t frameCount);
+    void ApplyChannelVolume(float* samples, size_t frameCount) const;
+
+    // Records the time since *t for stage and restarts *t.
+    void Lap(DecodeStats::Stage stage, int64_t* t)
+    {
+        if (!DecodeStats::kEnabled || stats_ == nullptr) return;
+        const int64_t now = DecodeStats::NowNs();
+        stats_->Record(stage, now - *t);
+        *t = now;
+    }
+
+    PcmEqualizer& eq_;
+    PcmPitchShifter& pitch_;
+    DrcProcessor& drc_;
+    TruePeakLimiter& limiter_;
+
+    int32_t channelCount_;
+    float volL_;
+    float volR_;
+    uint32_t stageMask_;
+
+    DecodeStats* stats_;
+
+    // Float DSP scratch (normalized), grown to the largest buffer seen.
+    std::vector<float> scratch_;
+};
+
+template <typename Source, typename Sink>
+bool DspChain::Run(size_t frameCount, Source&& source, Sink&& sink)
+{
+    if (channelCount_ <= 0) return false;
+
+    const size_t sampleCount = frameCount * static_cast<size_t>(channelCount_);
+    if (scratch_.size() < sampleCount) {
+        scratch_.resize(sampleCount);
+    }
+    float* samples = scratch_.data();
+
+    int64_t t = (DecodeStats::kEnabled && stats_ != nullptr) ? DecodeStats::NowNs() : 0;
+    source(samples, frameCount);
+    Lap(DecodeStats::Stage::Convert, &t);
+    ProcessStages(samples, frameCount);
+    t = (DecodeStats::kEnabled && stats_ != nullptr) ? DecodeStats::NowNs() : 0;
+    const bool ok = sink(static_cast<const float*>(samples), frameCount);
+    Lap(DecodeStats::Stage::RingPush, &t);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,321 @@
+#include "gapless_trim.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "GaplessTrim"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+// Decoder delay of the reference MP3 decoder on top of the LAME encoder delay.
+constexpr int64_t kMp3DecoderDelay = 529;
+constexpr size_t kMp3ScanBytes = 8192;
+// moov/udta/meta/ilst nesting is shallow; anything deeper is not iTunes metadata.
+constexpr uint64_t kMaxTagBoxBytes = 64 * 1024;
+
+bool ReadAt(int fd, uint64_t offset, void* data, size_t size)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t n = pread(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        offset += static_cast<uint64_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint32_t Be32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t Be64(const uint8_t* p)
+{
+    return (static_cast<uint64_t>(Be32(p)) << 32) | Be32(p + 4);
+}
+
+// ---------------------------------------------------------------------------
+// MP3: LAME tag inside the Xing/Info frame
+// ---------------------------------------------------------------------------
+
+bool ReadMp3Info(int fd, uint64_t fileSize, GaplessInfo* info)
+{
+    // Skip an ID3v2 tag (syncsafe size, optional footer).
+    uint64_t offset = 0;
+    uint8_t id3[10];
+    if (fileSize >= sizeof(id3) && ReadAt(fd, 0, id3, sizeof(id3)) && memcmp(id3, "ID3", 3) == 0) {
+        const uint64_t size = (static_cast<uint64_t>(id3[6] & 0x7f) << 21) | ((id3[7] & 0x7f) << 14) |
+                              ((id3[8] & 0x7f) << 7) | (id3[9] & 0x7f);
+        offset = sizeof(id3) + size + ((id3[5] & 0x10) ? 10 : 0);
+    }
+    if (offset >= fileSize) {
+        return false;
+    }
+
+    uint8_t buf[kMp3ScanBytes];
+    const size_t len = static_cast<size_t>(std::min<uint64_t>(sizeof(buf), fileSize - offset));
+    if (!ReadAt(fd, offset, buf, len)) {
+        return false;
+    }
+
+    static const int32_t kRates[3][3] = {
+        {44100, 48000, 32000},  // MPEG-1
+        {22050, 24000, 16000},  // MPEG-2
+        {11025, 12000, 8000},   // MPEG-2.5
+    };
+
+    for (size_t i = 0; i + 4 <= len; i++) {
+        const uint8_t* h = buf + i;
+        if (h[0] != 0xff || (h[1] & 0xe0) != 0xe0) {
+            continue;
+        }
+        const int version = (h[1] >> 3) & 3;  // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+        const int layer = (h[1] >> 1) & 3;    // 1 = Layer III
+        const int bitrateIndex = h[2] >> 4;
+        const int rateIndex = (h[2] >> 2) & 3;
+        if (version == 1 || layer != 1 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+            continue;
+        }
+        const bool mpeg1 = (version == 3);
+        const bool mono = ((h[3] >> 6) == 3);
+        const size_t sideInfo = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+
+        // Only the first frame can carry the tag.
+        size_t p = i + 4 + sideInfo;
+        if (p + 8 > len || (memcmp(buf + p, "Xing", 4) != 0 && memcmp(buf + p, "Info", 4) != 0)) {
+            return false;
+        }
+        const uint32_t flags = Be32(buf + p + 4);
+        p += 8;
+        p += (flags & 0x1) ? 4 : 0;    // frame count
+        p += (flags & 0x2) ? 4 : 0;    // byte count
+        p += (flags & 0x4) ? 100 : 0;  // TOC
+        p += (flags & 0x8) ? 4 : 0;    // quality
+        // LAME extension: 9-byte encoder string, ..., 12-bit delay and padding at +21.
+        if (p + 24 > len) {
+            return false;
+        }
+        const uint8_t* lame = buf + p;
+        const int64_t delay = (static_cast<int64_t>(lame[21]) << 4) | (lame[22] >> 4);
+        const int64_t padding = (static_cast<int64_t>(lame[22] & 0x0f) << 8) | lame[23];
+        if (delay == 0 && padding == 0) {
+            return false;
+        }
+        info->delayFrames = delay + kMp3DecoderDelay;
+        info->paddingFrames = std::max<int64_t>(0, padding - kMp3DecoderDelay);
+        info->sampleRate = kRates[mpeg1 ? 0 : (version == 2 ? 1 : 2)][rateIndex];
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// MP4: ----:com.apple.iTunes:iTunSMPB in moov/udta/meta/ilst
+// ---------------------------------------------------------------------------
+
+// Find the first child box of type inside [begin, end); returns its payload range.
+bool FindBox(int fd, uint64_t begin, uint64_t end, const char* type, uint64_t* bodyBegin, uint64_t* bodyEnd)
+{
+    uint64_t pos = begin;
+    while (pos + 8 <= end) {
+        uint8_t hdr[16];
+        if (!ReadAt(fd, pos, hdr, 8)) {
+            return false;
+        }
+        uint64_t size = Be32(hdr);
+        uint64_t header = 8;
+        if (size == 1) {
+            if (pos + 16 > end || !ReadAt(fd, pos + 8, hdr + 8, 8)) {
+                return false;
+            }
+            size = Be64(hdr + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = end - pos;
+        }
+        if (size < header || size > end - pos) {
+            return false;
+        }
+        if (memcmp(hdr + 4, type, 4) == 0) {
+            *bodyBegin = pos + header;
+            *bodyEnd = pos + size;
+            return true;
+        }
+        pos += size;
+    }
+    return false;
+}
+
+bool ParseSmpb(const std::string& text, GaplessInfo* info)
+{
+    // " 00000000 00000840 000001CA 00000000003F31F6 ...": reserved, delay, padding, length.
+    unsigned int reserved = 0;
+    unsigned int delay = 0;
+    unsigned int padding = 0;
+    if (sscanf(text.c_str(), " %x %x %x", &reserved, &delay, &padding) != 3) {
+        return false;
+    }
+    if (delay == 0 && padding == 0) {
+        return false;
+    }
+    info->delayFrames = delay;
+    info->paddingFrames = padding;
+    info->sampleRate = 0;
+    return true;
+}
+
+bool ReadMp4Info(int fd, uint64_t fileSize, GaplessInfo* info)
+{
+    uint64_t b = 0;
+    uint64_t e = 0;
+    if (!FindBox(fd, 0, fileSize, "moov", &b, &e) || !FindBox(fd, b, e, "udta", &b, &e) ||
+        !FindBox(fd, b, e, "meta", &b, &e)) {
+        return false;
+    }
+    // meta is a full box: version/flags precede the children.
+    if (!FindBox(fd, b + 4, e, "ilst", &b, &e)) {
+        return false;
+    }
+
+    uint64_t pos = b;
+    while (pos < e) {
+        uint64_t fb = 0;
+        uint64_t fe = 0;
+        if (!FindBox(fd, pos, e, "----", &fb, &fe)) {
+            return false;
+        }
+        pos = fe;
+        if (fe - fb > kMaxTagBoxBytes) {
+            continue;
+        }
+        uint64_t nb = 0;
+        uint64_t ne = 0;
+        uint64_t db = 0;
+        uint64_t de = 0;
+        // name and data are full boxes; data also has a 4-byte locale.
+        if (!FindBox(fd, fb, fe, "name", &nb, &ne) || ne - nb != 4 + 8 || !FindBox(fd, fb, fe, "data", &db, &de) ||
+            de - db <= 8) {
+            continue;
+        }
+        char name[8];
+        if (!ReadAt(fd, nb + 4, name, sizeof(name)) || memcmp(name, "iTunSMPB", sizeof(name)) != 0) {
+            continue;
+        }
+        std::string text(static_cast<size_t>(de - db - 8), '\0');
+        if (!ReadAt(fd, db + 8, &text[0], text.size())) {
+            return false;
+        }
+        return ParseSmpb(text, info);
+    }
+    return false;
+}
+
+} // namespace
+
+bool ReadGaplessInfo(const std::string& path, GaplessInfo* info)
+{
+    if (info == nullptr) {
+        return false;
+    }
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    bool ok = false;
+    uint8_t head[8];
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(head)) && ReadAt(fd, 0, head, sizeof(head))) {
+        const uint64_t size = static_cast<uint64_t>(st.st_size);
+        GaplessInfo found;
+        ok = (memcmp(head + 4, "ftyp", 4) == 0) ? ReadMp4Info(fd, size, &found) : ReadMp3Info(fd, size, &found);
+        if (ok) {
+            *info = found;
+            OH_LOG_INFO(LOG_APP, "Gapless info: delay %{public}lld, padding %{public}lld frames",
+                        (long long)found.delayFrames, (long long)found.paddingFrames);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+// ============================================================================
+// PcmTrimmer
+// ============================================================================
+
+void PcmTrimmer::Configure(const GaplessInfo& info, int32_t sampleRate, size_t frameBytes)
+{
+    held_.clear();
+    startFrames_ = std::max<int64_t>(0, info.delayFrames);
+    endFrames_ = std::max<int64_t>(0, info.paddingFrames);
+    // Metadata counts frames at the source rate; the codec may have been set up to resample.
+    if (info.sampleRate > 0 && sampleRate > 0 && info.sampleRate != sampleRate) {
+        startFrames_ = startFrames_ * sampleRate / info.sampleRate;
+        endFrames_ = endFrames_ * sampleRate / info.sampleRate;
+    }
+    skip_ = static_cast<size_t>(startFrames_) * frameBytes;
+    hold_ = static_cast<size_t>(endFrames_) * frameBytes;
+    held_.reserve(hold_);
+}
+
+bool PcmTrimmer::Feed(const uint8_t* data, size_t size, int64_t ptsMs, const AudioDecoder::PcmDataCallback& out)
+{
+    if (skip_ > 0) {
+        const size_t n = std::min(skip_, size);
+        skip_ -= n;
+        data += n;
+        size -= n;
+        if (size == 0) {
+            return true;
+        }
+    }
+    if (hold_ == 0) {
+        return out(data, size, ptsMs);
+    }
+
+    // Forward everything older than the last hold_ bytes: withheld bytes first.
+    const size_t total = held_.size() + size;
+    if (total <= hold_) {
+        held_.insert(held_.end(), data, data + size);
+        return true;
+    }
+    size_t emit = total - hold_;
+    const size_t fromHeld = std::min(emit, held_.size());
+    if (fromHeld > 0 && !out(held_.data(), fromHeld, ptsMs)) {
+        return false;
+    }
+    emit -= fromHeld;
+    if (emit > 0 && !out(data, emit, ptsMs)) {
+        return false;
+    }
+    held_.erase(held_.begin(), held_.begin() + static_cast<std::ptrdiff_t>(fromHeld));
+    held_.insert(held_.end(), data + emit, data + size);
+    return true;
+}
+
+void PcmTrimmer::OnSeek()
+{
+    skip_ = 0;
+    held_.clear();
+}
+
+void PcmTrimmer::Finish()
+{
+    held_.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef GAPLESS_TRIM_H
+#define GAPLESS_TRIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "audio_decoder.h"
+
+// Encoder delay/padding of a compressed track, in frames at sampleRate.
+// Decoders output the encoder's priming frames at the start and pad the last
+// packet; both have to be dropped for tracks to join without a gap.
+struct GaplessInfo {
+    int64_t delayFrames = 0;
+    int64_t paddingFrames = 0;
+    int32_t sampleRate = 0;  // 0 = unknown (taken as the decoder output rate)
+};
+
+// Read delay/padding from a local file: the LAME/Xing header of an MP3, or the
+// iTunSMPB tag of an MP4/M4A. False when the file carries neither.
+bool ReadGaplessInfo(const std::string& path, GaplessInfo* info);
+
+// Drops the first skip bytes of a track and withholds the last hold bytes,
+// which are discarded at EOS. Sits between the decoder and the PCM consumer;
+// Feed() forwards to out in order, at most two calls per input chunk.
+class PcmTrimmer {
+public:
+    // Set up from gapless info for decoder output at sampleRate with frameBytes per frame.
+    void Configure(const GaplessInfo& info, int32_t sampleRate, size_t frameBytes);
+
+    bool Feed(const uint8_t* data, size_t size, int64_t ptsMs, const AudioDecoder::PcmDataCallback& out);
+
+    // After a decoder seek the start trim no longer applies and withheld PCM is stale.
+    void OnSeek();
+
+    // EOS: the withheld padding is dropped.
+    void Finish();
+
+    int64_t TrimStartFrames() const { return startFrames_; }
+    int64_t TrimEndFrames() const { return endFrames_; }
+
+private:
+    size_t skip_ = 0;
+    size_t hold_ = 0;
+    std::vector<uint8_t> held_;
+    int64_t startFrames_ = 0;
+    int64_t endFrames_ = 0;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef FREE_PCM_HOST_HILOG_LOG_H
+#define FREE_PCM_HOST_HILOG_LOG_H
+
+// Host stand-in for the NDK <hilog/log.h>, used only by the host build (the
+// include path of the host targets puts host/ first). Same types and macros;
+// OH_LOG_Print drops the {public}/{private} privacy tags and writes to stderr
+// when the level reaches FREE_PCM_LOG (debug|info|warn|error, default warn).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LOG_APP = 0,
+} LogType;
+
+typedef enum {
+    LOG_DEBUG = 3,
+    LOG_INFO = 4,
+    LOG_WARN = 5,
+    LOG_ERROR = 6,
+    LOG_FATAL = 7,
+} LogLevel;
+
+int OH_LOG_Print(LogType type, LogLevel level, unsigned int domain, const char* tag, const char* fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef LOG_DOMAIN
+#define LOG_DOMAIN 0
+#endif
+
+#ifndef LOG_TAG
+#define LOG_TAG NULL
+#endif
+
+#define OH_LOG_DEBUG(type, ...) ((void)OH_LOG_Print((type), LOG_DEBUG, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_INFO(type, ...) ((void)OH_LOG_Print((type), LOG_INFO, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_WARN(type, ...) ((void)OH_LOG_Print((type), LOG_WARN, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_ERROR(type, ...) ((void)OH_LOG_Print((type), LOG_ERROR, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_FATAL(type, ...) ((void)OH_LOG_Print((type), LOG_FATAL, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+
+#endif
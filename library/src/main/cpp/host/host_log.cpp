@@ -0,0 +1,70 @@
+#include <hilog/log.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+LogLevel ThresholdFromEnv()
+{
+    const char* env = std::getenv("FREE_PCM_LOG");
+    if (env == nullptr) {
+        return LOG_WARN;
+    }
+    if (std::strcmp(env, "debug") == 0) {
+        return LOG_DEBUG;
+    }
+    if (std::strcmp(env, "info") == 0) {
+        return LOG_INFO;
+    }
+    if (std::strcmp(env, "error") == 0) {
+        return LOG_ERROR;
+    }
+    return LOG_WARN;
+}
+
+const char* LevelName(LogLevel level)
+{
+    switch (level) {
+        case LOG_DEBUG: return "D";
+        case LOG_INFO: return "I";
+        case LOG_WARN: return "W";
+        case LOG_ERROR: return "E";
+        default: return "F";
+    }
+}
+
+// "%{public}d" -> "%d"
+std::string StripPrivacyTags(const char* fmt)
+{
+    std::string out(fmt);
+    for (const char* tag : {"{public}", "{private}"}) {
+        const size_t len = std::strlen(tag);
+        for (size_t pos = out.find(tag); pos != std::string::npos; pos = out.find(tag, pos)) {
+            out.erase(pos, len);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+extern "C" int OH_LOG_Print(LogType type, LogLevel level, unsigned int domain, const char* tag, const char* fmt, ...)
+{
+    (void)type;
+    (void)domain;
+    static const LogLevel threshold = ThresholdFromEnv();
+    if (level < threshold || fmt == nullptr) {
+        return 0;
+    }
+    const std::string format = StripPrivacyTags(fmt);
+    char line[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), format.c_str(), args);
+    va_end(args);
+    return std::fprintf(stderr, "%s %s: %s\n", LevelName(level), tag != nullptr ? tag : "-", line);
+}
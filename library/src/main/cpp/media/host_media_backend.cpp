@@ -0,0 +1,761 @@
+#include "host_media_backend.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "pcm_convert.h"
+
+namespace media {
+
+namespace {
+
+// Same values as OH_AVErrCode.
+constexpr int32_t kErrInvalidVal = 3;
+constexpr int32_t kErrIo = 4;
+constexpr int32_t kErrUnknown = 6;
+constexpr int32_t kErrInvalidState = 8;
+
+// Codec input buffers; large enough for a packet of 8-channel F32 at 1024 frames.
+constexpr int32_t kInputCapacity = 64 * 1024;
+// The SSE S24 kernel reads one byte past the last sample.
+constexpr size_t kTailPadding = 4;
+
+// Source layout handed from the source to the codec through the codec config:
+// sampleRate, channelCount, sampleFormat as little-endian int32.
+constexpr size_t kLayoutConfigSize = 12;
+
+int32_t BytesPerSample(int32_t sampleFormat)
+{
+    switch (sampleFormat) {
+        case 1: return 2;
+        case 2: return static_cast<int32_t>(pcm_convert::kS24Bytes);
+        case 3: return 4;
+        case 4: return 4;
+        default: return 0;
+    }
+}
+
+struct PcmLayout {
+    int32_t sampleRate = 0;
+    int32_t channelCount = 0;
+    int32_t sampleFormat = 0;
+
+    bool Valid() const { return sampleRate > 0 && channelCount > 0 && BytesPerSample(sampleFormat) > 0; }
+    int32_t FrameBytes() const { return channelCount * BytesPerSample(sampleFormat); }
+};
+
+void PutLe32(std::vector<uint8_t>* out, int32_t v)
+{
+    const uint32_t u = static_cast<uint32_t>(v);
+    for (int i = 0; i < 4; i++) {
+        out->push_back(static_cast<uint8_t>(u >> (8 * i)));
+    }
+}
+
+uint32_t GetLe32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t GetLe16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint64_t GetLe64(const uint8_t* p)
+{
+    return static_cast<uint64_t>(GetLe32(p)) | (static_cast<uint64_t>(GetLe32(p + 4)) << 32);
+}
+
+std::vector<uint8_t> EncodeLayout(const PcmLayout& layout)
+{
+    std::vector<uint8_t> config;
+    PutLe32(&config, layout.sampleRate);
+    PutLe32(&config, layout.channelCount);
+    PutLe32(&config, layout.sampleFormat);
+    return config;
+}
+
+bool DecodeLayout(const std::vector<uint8_t>& config, PcmLayout* layout)
+{
+    if (config.size() != kLayoutConfigSize) {
+        return false;
+    }
+    layout->sampleRate = static_cast<int32_t>(GetLe32(config.data()));
+    layout->channelCount = static_cast<int32_t>(GetLe32(config.data() + 4));
+    layout->sampleFormat = static_cast<int32_t>(GetLe32(config.data() + 8));
+    return layout->Valid();
+}
+
+// Per-call delay of latencyUs + U(0, jitterUs).
+class Delay {
+public:
+    Delay(int64_t latencyUs, int64_t jitterUs, uint32_t seed)
+        : latencyUs_(std::max<int64_t>(latencyUs, 0)), jitterUs_(std::max<int64_t>(jitterUs, 0)), rng_(seed)
+    {
+    }
+
+    std::chrono::microseconds Next()
+    {
+        int64_t us = latencyUs_;
+        if (jitterUs_ > 0) {
+            us += std::uniform_int_distribution<int64_t>(0, jitterUs_)(rng_);
+        }
+        return std::chrono::microseconds(us);
+    }
+
+private:
+    int64_t latencyUs_;
+    int64_t jitterUs_;
+    std::mt19937 rng_;
+};
+
+class HostBuffer final : public Buffer {
+public:
+    explicit HostBuffer(int32_t capacity)
+        : capacity_(std::max<int32_t>(capacity, 0)), data_(static_cast<size_t>(capacity_) + kTailPadding)
+    {
+    }
+
+    uint8_t* Addr() override { return data_.data(); }
+    int32_t Capacity() override { return capacity_; }
+
+    bool GetAttr(BufferAttr* attr) override
+    {
+        *attr = attr_;
+        return true;
+    }
+
+    bool SetAttr(const BufferAttr& attr) override
+    {
+        if (attr.size < 0 || attr.offset < 0 || attr.offset + attr.size > capacity_) {
+            return false;
+        }
+        attr_ = attr;
+        return true;
+    }
+
+private:
+    int32_t capacity_;
+    std::vector<uint8_t> data_;
+    BufferAttr attr_;
+};
+
+class HostSource final : public Source {
+public:
+    HostSource(int32_t fd, const PcmLayout& layout, int64_t dataOffset, int64_t dataSize, const std::string& mimeType)
+        : fd_(fd), layout_(layout), dataOffset_(dataOffset), mimeType_(mimeType)
+    {
+        // Whole frames only.
+        const int64_t frameBytes = layout_.FrameBytes();
+        dataSize_ = dataSize - dataSize % frameBytes;
+    }
+
+    // Parses a RIFF/RF64 WAVE header; returns false if the file is not one.
+    // *supported is false for WAV files that are not PCM/float.
+    static bool ParseWav(int32_t fd, int64_t offset, int64_t size, PcmLayout* layout, int64_t* dataOffset,
+                         int64_t* dataSize, bool* supported)
+    {
+        uint8_t riff[12];
+        if (size < 12 || pread(fd, riff, sizeof(riff), offset) != static_cast<ssize_t>(sizeof(riff))) {
+            return false;
+        }
+        const bool rf64 = std::memcmp(riff, "RF64", 4) == 0;
+        if ((!rf64 && std::memcmp(riff, "RIFF", 4) != 0) || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+            return false;
+        }
+
+        *supported = false;
+        uint64_t rf64DataSize = 0;
+        bool haveFmt = false;
+        int64_t pos = 12;
+        while (pos + 8 <= size) {
+            uint8_t header[8];
+            if (pread(fd, header, sizeof(header), offset + pos) != static_cast<ssize_t>(sizeof(header))) {
+                return true;
+            }
+            const uint32_t chunkSize = GetLe32(header + 4);
+            const int64_t body = pos + 8;
+
+            if (std::memcmp(header, "ds64", 4) == 0 && chunkSize >= 16) {
+                uint8_t ds64[16];
+                if (pread(fd, ds64, sizeof(ds64), offset + body) == static_cast<ssize_t>(sizeof(ds64))) {
+                    rf64DataSize = GetLe64(ds64 + 8);
+                }
+            } else if (std::memcmp(header, "fmt ", 4) == 0 && chunkSize >= 16) {
+                uint8_t fmt[40] = {0};
+                const size_t want = std::min<size_t>(chunkSize, sizeof(fmt));
+                if (pread(fd, fmt, want, offset + body) != static_cast<ssize_t>(want)) {
+                    return true;
+                }
+                uint16_t tag = GetLe16(fmt);
+                const int32_t channels = GetLe16(fmt + 2);
+                const int32_t sampleRate = static_cast<int32_t>(GetLe32(fmt + 4));
+                const int32_t bits = GetLe16(fmt + 14);
+                if (tag == 0xFFFE && want >= 26) {
+                    // WAVE_FORMAT_EXTENSIBLE: the sub-format GUID starts with the format tag.
+                    tag = GetLe16(fmt + 24);
+                }
+                int32_t sampleFormat = 0;
+                if (tag == 1) {
+                    sampleFormat = bits == 16 ? 1 : (bits == 24 ? 2 : (bits == 32 ? 3 : 0));
+                } else if (tag == 3 && bits == 32) {
+                    sampleFormat = 4;
+                }
+                *layout = PcmLayout{sampleRate, channels, sampleFormat};
+                haveFmt = layout->Valid();
+            } else if (std::memcmp(header, "data", 4) == 0) {
+                if (!haveFmt) {
+                    return true;
+                }
+                int64_t bytes = (rf64 && chunkSize == 0xFFFFFFFFu) ? static_cast<int64_t>(rf64DataSize) : chunkSize;
+                bytes = std::min(bytes, size - body);
+                *dataOffset = offset + body;
+                *dataSize = bytes;
+                *supported = bytes >= 0;
+                return true;
+            }
+            pos = body + chunkSize + (chunkSize & 1);
+        }
+        return true;
+    }
+
+    bool GetInfo(SourceInfo* info) override
+    {
+        info->trackCount = 1;
+        const int64_t frames = dataSize_ / layout_.FrameBytes();
+        info->durationUs = frames * 1000000 / layout_.sampleRate;
+        return true;
+    }
+
+    bool GetTrackInfo(uint32_t trackIndex, TrackInfo* info) override
+    {
+        if (trackIndex != 0) {
+            return false;
+        }
+        info->mimeType = mimeType_;
+        info->sampleRate = layout_.sampleRate;
+        info->channelCount = layout_.channelCount;
+        info->sampleFormat = layout_.sampleFormat;
+        info->codecConfig = EncodeLayout(layout_);
+        return true;
+    }
+
+    int32_t Fd() const { return fd_; }
+    const PcmLayout& Layout() const { return layout_; }
+    int64_t DataOffset() const { return dataOffset_; }
+    int64_t DataSize() const { return dataSize_; }
+
+private:
+    int32_t fd_;
+    PcmLayout layout_;
+    int64_t dataOffset_;
+    int64_t dataSize_ = 0;
+    std::string mimeType_;
+};
+
+// Serves packetFrames-sized packets; a seek lands on the packet boundary at or
+// before the target, like a sync sample.
+class HostDemuxer final : public Demuxer {
+public:
+    HostDemuxer(const HostSource& source, int32_t packetFrames, Delay delay)
+        : source_(source), packetFrames_(std::max<int32_t>(packetFrames, 1)), delay_(delay)
+    {
+    }
+
+    int32_t SelectTrack(uint32_t trackIndex) override
+    {
+        if (trackIndex != 0) {
+            return kErrInvalidVal;
+        }
+        selected_ = true;
+        return kOk;
+    }
+
+    int32_t SeekToTime(int64_t timeMs) override
+    {
+        if (timeMs < 0) {
+            return kErrInvalidVal;
+        }
+        const PcmLayout& layout = source_.Layout();
+        int64_t frame = timeMs * layout.sampleRate / 1000;
+        frame -= frame % packetFrames_;
+        position_ = std::min(frame * layout.FrameBytes(), source_.DataSize());
+        return kOk;
+    }
+
+    int32_t ReadSample(uint32_t trackIndex, Buffer* buffer) override
+    {
+        if (!selected_ || trackIndex != 0) {
+            return kErrInvalidState;
+        }
+        if (buffer == nullptr) {
+            return kErrInvalidVal;
+        }
+        std::this_thread::sleep_for(delay_.Next());
+
+        const PcmLayout& layout = source_.Layout();
+        const int64_t frameBytes = layout.FrameBytes();
+        BufferAttr attr;
+        attr.pts = position_ / frameBytes * 1000000 / layout.sampleRate;
+
+        const int64_t remaining = source_.DataSize() - position_;
+        if (remaining <= 0) {
+            attr.flags = kBufferFlagEos;
+            buffer->SetAttr(attr);
+            return kOk;
+        }
+
+        const int64_t capacity = buffer->Capacity() - buffer->Capacity() % frameBytes;
+        const int64_t bytes = std::min({static_cast<int64_t>(packetFrames_) * frameBytes, remaining, capacity});
+        if (bytes <= 0) {
+            return kErrInvalidVal;
+        }
+        if (pread(source_.Fd(), buffer->Addr(), static_cast<size_t>(bytes), source_.DataOffset() + position_) !=
+            static_cast<ssize_t>(bytes)) {
+            return kErrIo;
+        }
+        attr.size = static_cast<int32_t>(bytes);
+        buffer->SetAttr(attr);
+        position_ += bytes;
+        return kOk;
+    }
+
+private:
+    const HostSource& source_;
+    int32_t packetFrames_;
+    Delay delay_;
+    bool selected_ = false;
+    int64_t position_ = 0;
+};
+
+// Pass-through "decoder" with the OH_AudioCodec state machine and buffer flow:
+// input buffers are issued through onInputBufferAvailable, every pushed one is
+// converted into a free output buffer after the decode delay, and is issued
+// again once its output is out. A pushed EOS yields an empty EOS output.
+// Callbacks come from the codec's worker thread without internal locks held;
+// Stop/Flush/Reset/destruction wait for a callback in progress to return.
+class HostCodec final : public Codec {
+public:
+    HostCodec(int32_t bufferCount, int64_t failAtPacket, Delay delay) : delay_(delay), failAtPacket_(failAtPacket)
+    {
+        const size_t count = static_cast<size_t>(std::max<int32_t>(bufferCount, 1));
+        for (size_t i = 0; i < count; i++) {
+            inputs_.push_back(std::make_unique<HostBuffer>(kInputCapacity));
+        }
+        inputOwned_.assign(count, false);
+        outputOwned_.assign(count, false);
+        worker_ = std::thread([this]() { Run(); });
+    }
+
+    ~HostCodec() override
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            quit_ = true;
+            generation_++;
+            cond_.notify_all();
+        }
+        worker_.join();
+    }
+
+    HostCodec(const HostCodec&) = delete;
+    HostCodec& operator=(const HostCodec&) = delete;
+
+    int32_t RegisterCallbacks(const CodecCallbacks& callbacks, void* userData) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Initialized) {
+            return kErrInvalidState;
+        }
+        callbacks_ = callbacks;
+        userData_ = userData;
+        return kOk;
+    }
+
+    int32_t Configure(const CodecFormat& format) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Initialized) {
+            return kErrInvalidState;
+        }
+        PcmLayout in;
+        if (!DecodeLayout(format.codecConfig, &in) || format.sampleRate != in.sampleRate ||
+            format.channelCount != in.channelCount || BytesPerSample(format.sampleFormat) == 0) {
+            return kErrInvalidVal;
+        }
+        in_ = in;
+        out_ = PcmLayout{in.sampleRate, in.channelCount, format.sampleFormat};
+
+        const int32_t inBytes = BytesPerSample(in_.sampleFormat);
+        const int32_t outBytes = BytesPerSample(out_.sampleFormat);
+        const int32_t outCapacity = (kInputCapacity / inBytes) * outBytes;
+        outputs_.clear();
+        for (size_t i = 0; i < inputs_.size(); i++) {
+            outputs_.push_back(std::make_unique<HostBuffer>(outCapacity));
+        }
+        state_ = State::Configured;
+        return kOk;
+    }
+
+    int32_t Prepare() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Configured) {
+            return kErrInvalidState;
+        }
+        state_ = State::Prepared;
+        return kOk;
+    }
+
+    int32_t Start() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Running) {
+            return kOk;
+        }
+        if (state_ != State::Prepared && state_ != State::Flushed && state_ != State::Stopped) {
+            return kErrInvalidState;
+        }
+        state_ = State::Running;
+        inputEos_ = false;
+        freeOutputs_.clear();
+        for (size_t i = 0; i < outputs_.size(); i++) {
+            freeOutputs_.push_back(static_cast<uint32_t>(i));
+        }
+        for (size_t i = 0; i < inputs_.size(); i++) {
+            jobs_.push_back(Job{JobType::IssueInput, static_cast<uint32_t>(i)});
+        }
+        cond_.notify_all();
+        return kOk;
+    }
+
+    int32_t Stop() override { return Halt(State::Stopped); }
+    int32_t Flush() override { return Halt(State::Flushed); }
+    int32_t Reset() override { return Halt(State::Initialized); }
+
+    int32_t PushInputBuffer(uint32_t index) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Running) {
+            return kErrInvalidState;
+        }
+        if (index >= inputs_.size() || !inputOwned_[index]) {
+            return kErrInvalidVal;
+        }
+        inputOwned_[index] = false;
+        jobs_.push_back(Job{JobType::Decode, index});
+        cond_.notify_all();
+        return kOk;
+    }
+
+    int32_t FreeOutputBuffer(uint32_t index) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::Running && state_ != State::Flushed) {
+            return kErrInvalidState;
+        }
+        if (index >= outputs_.size() || !outputOwned_[index]) {
+            return kErrInvalidVal;
+        }
+        outputOwned_[index] = false;
+        freeOutputs_.push_back(index);
+        cond_.notify_all();
+        return kOk;
+    }
+
+private:
+    enum class State {
+        Initialized,
+        Configured,
+        Prepared,
+        Running,
+        Flushed,
+        Stopped,
+    };
+
+    enum class JobType {
+        IssueInput,
+        Decode,
+    };
+
+    struct Job {
+        JobType type;
+        uint32_t index;
+    };
+
+    // Stop/Flush/Reset: drop queued work, take all buffers back and wait until
+    // the worker is out of its current job.
+    int32_t Halt(State target)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (target == State::Flushed && state_ != State::Running && state_ != State::Flushed) {
+            return kErrInvalidState;
+        }
+        if (target == State::Stopped && state_ == State::Initialized) {
+            return kErrInvalidState;
+        }
+        generation_++;
+        jobs_.clear();
+        freeOutputs_.clear();
+        std::fill(inputOwned_.begin(), inputOwned_.end(), false);
+        std::fill(outputOwned_.begin(), outputOwned_.end(), false);
+        cond_.notify_all();
+        cond_.wait(lock, [this]() { return !busy_; });
+        if (target == State::Stopped && (state_ == State::Configured || state_ == State::Prepared)) {
+            return kOk;
+        }
+        if (target == State::Initialized) {
+            formatReported_ = false;
+        }
+        state_ = target;
+        return kOk;
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+            if (quit_) {
+                return;
+            }
+            const Job job = jobs_.front();
+            jobs_.pop_front();
+            const uint64_t generation = generation_;
+            busy_ = true;
+            if (job.type == JobType::IssueInput) {
+                IssueInput(lock, job.index);
+            } else {
+                Decode(lock, job.index, generation);
+            }
+            busy_ = false;
+            cond_.notify_all();
+        }
+    }
+
+    void IssueInput(std::unique_lock<std::mutex>& lock, uint32_t index)
+    {
+        if (dead_) {
+            return;
+        }
+        inputOwned_[index] = true;
+        const CodecCallbacks callbacks = callbacks_;
+        Buffer* buffer = inputs_[index].get();
+        lock.unlock();
+        if (callbacks.onInputBufferAvailable) {
+            callbacks.onInputBufferAvailable(index, buffer, userData_);
+        }
+        lock.lock();
+    }
+
+    void Decode(std::unique_lock<std::mutex>& lock, uint32_t index, uint64_t generation)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + delay_.Next();
+        cond_.wait_until(lock, deadline, [this, generation]() { return generation_ != generation; });
+        cond_.wait(lock, [this, generation]() { return generation_ != generation || !freeOutputs_.empty(); });
+        if (generation_ != generation) {
+            return;
+        }
+        if (dead_) {
+            return;
+        }
+        if (packets_++ == failAtPacket_) {
+            // Like a codec that has died: no more buffers either way, not even for
+            // packets already pushed.
+            dead_ = true;
+            const CodecCallbacks callbacks = callbacks_;
+            lock.unlock();
+            if (callbacks.onError) {
+                callbacks.onError(kErrUnknown, userData_);
+            }
+            lock.lock();
+            return;
+        }
+        const uint32_t outIndex = freeOutputs_.front();
+        freeOutputs_.pop_front();
+        const bool reportFormat = !formatReported_;
+        formatReported_ = true;
+        const CodecCallbacks callbacks = callbacks_;
+        HostBuffer* input = inputs_[index].get();
+        HostBuffer* output = outputs_[outIndex].get();
+        lock.unlock();
+
+        BufferAttr attr;
+        input->GetAttr(&attr);
+        BufferAttr outAttr;
+        outAttr.pts = attr.pts;
+        outAttr.flags = attr.flags;
+        outAttr.size = Convert(input->Addr() + attr.offset, attr.size, output->Addr());
+        output->SetAttr(outAttr);
+        const bool eos = (attr.flags & kBufferFlagEos) != 0;
+
+        if (reportFormat && callbacks.onOutputFormatChanged) {
+            CodecFormat format;
+            format.sampleRate = out_.sampleRate;
+            format.channelCount = out_.channelCount;
+            format.sampleFormat = out_.sampleFormat;
+            callbacks.onOutputFormatChanged(format, userData_);
+        }
+
+        lock.lock();
+        if (generation_ != generation) {
+            freeOutputs_.push_back(outIndex);
+            return;
+        }
+        outputOwned_[outIndex] = true;
+        lock.unlock();
+        if (callbacks.onOutputBufferAvailable) {
+            callbacks.onOutputBufferAvailable(outIndex, output, userData_);
+        }
+        lock.lock();
+
+        // After EOS no more input is requested until Flush/Stop + Start.
+        if (eos) {
+            inputEos_ = true;
+        } else if (generation_ == generation && !inputEos_) {
+            IssueInput(lock, index);
+        }
+    }
+
+    // Converts whole frames of in_ to out_; returns the output size in bytes.
+    int32_t Convert(const uint8_t* in, int32_t inSize, uint8_t* out)
+    {
+        const int32_t frames = inSize > 0 ? inSize / in_.FrameBytes() : 0;
+        const size_t samples = static_cast<size_t>(frames) * static_cast<size_t>(in_.channelCount);
+        if (samples == 0) {
+            return 0;
+        }
+        if (in_.sampleFormat == out_.sampleFormat) {
+            const size_t bytes = static_cast<size_t>(frames) * static_cast<size_t>(in_.FrameBytes());
+            std::memcpy(out, in, bytes);
+            return static_cast<int32_t>(bytes);
+        }
+
+        constexpr float kNormS16 = 1.0f / 32768.0f;
+        constexpr float kNormS32 = 1.0f / 2147483648.0f;
+        scratch_.resize(samples);
+        float* f = scratch_.data();
+        switch (in_.sampleFormat) {
+            case 1: pcm_convert::S16ToFloat(reinterpret_cast<const int16_t*>(in), f, samples, kNormS16, 1.0f); break;
+            case 2: pcm_convert::S24ToFloat(in, f, samples, kNormS32, 1.0f); break;
+            case 3: pcm_convert::S32ToFloat(reinterpret_cast<const int32_t*>(in), f, samples, kNormS32, 1.0f); break;
+            default: pcm_convert::F32ToFloat(reinterpret_cast<const float*>(in), f, samples, 1.0f); break;
+        }
+        switch (out_.sampleFormat) {
+            case 1:
+                pcm_convert::FloatToS16(f, reinterpret_cast<int16_t*>(out), samples, 32768.0f);
+                break;
+            case 2:
+                for (size_t i = 0; i < samples; i++) {
+                    const float v = std::min(std::max(f[i] * 8388608.0f, -8388608.0f), 8388607.0f);
+                    const uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(std::lround(v)));
+                    out[i * 3] = static_cast<uint8_t>(u);
+                    out[i * 3 + 1] = static_cast<uint8_t>(u >> 8);
+                    out[i * 3 + 2] = static_cast<uint8_t>(u >> 16);
+                }
+                break;
+            case 3:
+                pcm_convert::FloatToS32(f, reinterpret_cast<int32_t*>(out), samples, 2147483648.0f);
+                break;
+            default:
+                std::memcpy(out, f, samples * sizeof(float));
+                break;
+        }
+        return static_cast<int32_t>(samples) * BytesPerSample(out_.sampleFormat);
+    }
+
+    Delay delay_;
+    const int64_t failAtPacket_;
+    std::vector<std::unique_ptr<HostBuffer>> inputs_;
+    std::vector<std::unique_ptr<HostBuffer>> outputs_;
+    std::vector<float> scratch_;  // worker thread only
+    PcmLayout in_;
+    PcmLayout out_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    State state_ = State::Initialized;
+    CodecCallbacks callbacks_ = {};
+    void* userData_ = nullptr;
+    std::deque<Job> jobs_;
+    std::deque<uint32_t> freeOutputs_;
+    std::vector<bool> inputOwned_;   // issued to the client, not pushed back yet
+    std::vector<bool> outputOwned_;  // issued to the client, not freed yet
+    uint64_t generation_ = 0;        // bumped by Stop/Flush/Reset: stale work is dropped
+    bool busy_ = false;
+    bool inputEos_ = false;
+    bool formatReported_ = false;
+    bool quit_ = false;
+    int64_t packets_ = 0;            // decode jobs taken since construction
+    bool dead_ = false;              // failAtPacket_ reached
+    std::thread worker_;
+};
+
+} // namespace
+
+std::unique_ptr<Source> HostMediaBackend::CreateSourceWithFd(int32_t fd, int64_t offset, int64_t size)
+{
+    if (fd < 0 || offset < 0 || size <= 0) {
+        return nullptr;
+    }
+    PcmLayout layout;
+    int64_t dataOffset = offset;
+    int64_t dataSize = size;
+    bool supported = true;
+    if (!HostSource::ParseWav(fd, offset, size, &layout, &dataOffset, &dataSize, &supported)) {
+        layout = PcmLayout{options_.rawSampleRate, options_.rawChannelCount, options_.rawSampleFormat};
+        supported = layout.Valid();
+    }
+    if (!supported) {
+        return nullptr;
+    }
+    return std::make_unique<HostSource>(fd, layout, dataOffset, dataSize, options_.mimeType);
+}
+
+std::unique_ptr<Source> HostMediaBackend::CreateSourceWithUri(const std::string& uri)
+{
+    (void)uri;
+    return nullptr;
+}
+
+std::unique_ptr<Demuxer> HostMediaBackend::CreateDemuxer(Source& source)
+{
+    return std::make_unique<HostDemuxer>(static_cast<HostSource&>(source), options_.packetFrames,
+                                         Delay(options_.readLatencyUs, options_.readJitterUs, NextSeed()));
+}
+
+std::unique_ptr<Codec> HostMediaBackend::CreateAudioDecoder(const std::string& mimeType)
+{
+    if (mimeType != options_.mimeType) {
+        return nullptr;
+    }
+    return std::make_unique<HostCodec>(options_.codecBuffers, options_.failAtPacket,
+                                       Delay(options_.decodeLatencyUs, options_.decodeJitterUs, NextSeed()));
+}
+
+std::unique_ptr<Buffer> HostMediaBackend::CreateBuffer(int32_t capacity)
+{
+    if (capacity <= 0) {
+        return nullptr;
+    }
+    return std::make_unique<HostBuffer>(capacity);
+}
+
+Backend& Backend::Default()
+{
+    static HostMediaBackend backend;
+    return backend;
+}
+
+} // namespace media
@@ -0,0 +1,68 @@
+#ifndef HOST_MEDIA_BACKEND_H
+#define HOST_MEDIA_BACKEND_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "media_backend.h"
+
+namespace media {
+
+// Host stand-in for the OH media framework, used to benchmark the decode
+// pipeline (DecodeToPcmStream, seek, ring buffer feeding) on Linux.
+//
+// Sources are PCM WAV files (16/24/32-bit integer, 32-bit float, including
+// WAVE_FORMAT_EXTENSIBLE and RF64) or headerless raw PCM in the layout given by
+// Options. The track is reported with Options::mimeType rather than
+// "audio/raw", so the decoder takes its codec path; the "codec" converts the
+// source sample format to the configured output format (no resampling or
+// channel mapping) on its own thread with the OH_AudioCodec buffer callbacks.
+//
+// Device-side costs are modelled as per-call delays of latency + U(0, jitter)
+// microseconds: one per demuxer ReadSample (I/O, network) and one per decoded
+// packet (codec). Jitter is drawn from a seeded generator, so runs repeat.
+// Options::failAtPacket makes the codec die mid-stream through onError.
+// URIs are not supported.
+class HostMediaBackend final : public Backend {
+public:
+    struct Options {
+        // Layout of headerless input (files without a RIFF/RF64 header).
+        int32_t rawSampleRate = 48000;
+        int32_t rawChannelCount = 2;
+        int32_t rawSampleFormat = 1;  // AudioSampleFormat: 1=S16LE, 2=S24LE, 3=S32LE, 4=F32LE
+
+        std::string mimeType = "audio/x-host-pcm";
+        int32_t packetFrames = 1024;  // frames per demuxed sample, also the seek granularity
+        int32_t codecBuffers = 4;     // input and output buffers each
+        int64_t failAtPacket = -1;    // codec reports onError instead of decoding this packet (0-based)
+
+        int64_t readLatencyUs = 0;
+        int64_t readJitterUs = 0;
+        int64_t decodeLatencyUs = 0;
+        int64_t decodeJitterUs = 0;
+        uint32_t seed = 1;
+    };
+
+    HostMediaBackend() = default;
+    explicit HostMediaBackend(const Options& options) : options_(options) {}
+
+    const Options& GetOptions() const { return options_; }
+
+    std::unique_ptr<Source> CreateSourceWithFd(int32_t fd, int64_t offset, int64_t size) override;
+    std::unique_ptr<Source> CreateSourceWithUri(const std::string& uri) override;
+    std::unique_ptr<Demuxer> CreateDemuxer(Source& source) override;
+    std::unique_ptr<Codec> CreateAudioDecoder(const std::string& mimeType) override;
+    std::unique_ptr<Buffer> CreateBuffer(int32_t capacity) override;
+
+private:
+    uint32_t NextSeed() { return options_.seed + seedCounter_.fetch_add(1); }
+
+    Options options_;
+    std::atomic<uint32_t> seedCounter_{0};
+};
+
+} // namespace media
+
+#endif
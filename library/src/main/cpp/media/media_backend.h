@@ -0,0 +1,135 @@
+#ifndef MEDIA_BACKEND_H
+#define MEDIA_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Platform layer under AudioDecoder: source, demuxer and audio codec.
+//
+// The interfaces follow the OH_AVSource / OH_AVDemuxer / OH_AudioCodec calls
+// the decoder makes one to one (same states, same asynchronous buffer
+// callbacks, same error-code convention: 0 is success), so the decode loop,
+// seek coordination and tail-seek window run unchanged on either side:
+//   - oh_media_backend.cpp:   the OH media framework (device builds);
+//   - host_media_backend.cpp: a stand-in serving packets from WAV/raw files
+//                             with configurable latency, for host benchmarks.
+// Backend::Default() is defined by whichever of the two is linked.
+namespace media {
+
+constexpr int32_t kOk = 0;
+
+// Same value as AVCODEC_BUFFER_FLAGS_EOS.
+constexpr uint32_t kBufferFlagEos = 1u << 0;
+
+// Same layout as OH_AVCodecBufferAttr; pts in microseconds.
+struct BufferAttr {
+    int64_t pts = 0;
+    int32_t size = 0;
+    int32_t offset = 0;
+    uint32_t flags = 0;
+};
+
+// Data buffer: codec input/output buffers, or one created by Backend::CreateBuffer.
+class Buffer {
+public:
+    virtual ~Buffer() = default;
+
+    virtual uint8_t* Addr() = 0;
+    virtual int32_t Capacity() = 0;
+    virtual bool GetAttr(BufferAttr* attr) = 0;
+    virtual bool SetAttr(const BufferAttr& attr) = 0;
+};
+
+struct SourceInfo {
+    int32_t trackCount = 0;
+    int64_t durationUs = 0;  // 0 = unknown
+};
+
+// Fields the track does not carry stay 0 / empty.
+struct TrackInfo {
+    std::string mimeType;
+    int32_t sampleRate = 0;
+    int32_t channelCount = 0;
+    int32_t sampleFormat = 0;          // AudioSampleFormat: 1=S16LE, 2=S24LE, 3=S32LE, 4=F32LE
+    std::vector<uint8_t> codecConfig;  // extradata/csd
+};
+
+// Decoder configuration; bitrate <= 0 is not set.
+struct CodecFormat {
+    int32_t sampleRate = 0;
+    int32_t channelCount = 0;
+    int32_t bitrate = 0;
+    int32_t sampleFormat = 0;
+    std::vector<uint8_t> codecConfig;
+};
+
+class Source {
+public:
+    virtual ~Source() = default;
+
+    virtual bool GetInfo(SourceInfo* info) = 0;
+    virtual bool GetTrackInfo(uint32_t trackIndex, TrackInfo* info) = 0;
+};
+
+// Must be destroyed before its Source.
+class Demuxer {
+public:
+    virtual ~Demuxer() = default;
+
+    virtual int32_t SelectTrack(uint32_t trackIndex) = 0;
+    // Seeks to the closest sync sample at or before timeMs.
+    virtual int32_t SeekToTime(int64_t timeMs) = 0;
+    // Fills buffer with the next sample and its attributes; at the end of the
+    // track an empty sample flagged kBufferFlagEos.
+    virtual int32_t ReadSample(uint32_t trackIndex, Buffer* buffer) = 0;
+};
+
+// Called from codec threads. A Buffer passed in stays valid until its index is
+// handed back (PushInputBuffer / FreeOutputBuffer) or the codec is stopped.
+struct CodecCallbacks {
+    void (*onError)(int32_t errorCode, void* userData);
+    void (*onOutputFormatChanged)(const CodecFormat& format, void* userData);
+    void (*onInputBufferAvailable)(uint32_t index, Buffer* buffer, void* userData);
+    void (*onOutputBufferAvailable)(uint32_t index, Buffer* buffer, void* userData);
+};
+
+// Asynchronous audio decoder with the OH_AudioCodec state machine:
+// Configure -> Prepare -> Start; Stop keeps the configuration (Start resumes),
+// Reset returns to the initialized state (callbacks stay registered).
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    virtual int32_t RegisterCallbacks(const CodecCallbacks& callbacks, void* userData) = 0;
+    virtual int32_t Configure(const CodecFormat& format) = 0;
+    virtual int32_t Prepare() = 0;
+    virtual int32_t Start() = 0;
+    virtual int32_t Stop() = 0;
+    virtual int32_t Flush() = 0;
+    virtual int32_t Reset() = 0;
+    virtual int32_t PushInputBuffer(uint32_t index) = 0;
+    virtual int32_t FreeOutputBuffer(uint32_t index) = 0;
+};
+
+class Backend {
+public:
+    virtual ~Backend() = default;
+
+    // The backend of this build: OH on device, the host stand-in otherwise.
+    static Backend& Default();
+
+    // Factories return nullptr on failure. The fd stays owned by the caller and
+    // must outlive the source.
+    virtual std::unique_ptr<Source> CreateSourceWithFd(int32_t fd, int64_t offset, int64_t size) = 0;
+    virtual std::unique_ptr<Source> CreateSourceWithUri(const std::string& uri) = 0;
+    virtual std::unique_ptr<Demuxer> CreateDemuxer(Source& source) = 0;
+    virtual std::unique_ptr<Codec> CreateAudioDecoder(const std::string& mimeType) = 0;
+    virtual std::unique_ptr<Buffer> CreateBuffer(int32_t capacity) = 0;
+};
+
+} // namespace media
+
+#endif
@@ -0,0 +1,306 @@
+#include "media_backend.h"
+
+#include <multimedia/player_framework/native_avbuffer.h>
+#include <multimedia/player_framework/native_avcodec_audiocodec.h>
+#include <multimedia/player_framework/native_avcodec_base.h>
+#include <multimedia/player_framework/native_avdemuxer.h>
+#include <multimedia/player_framework/native_avformat.h>
+#include <multimedia/player_framework/native_avsource.h>
+#include <mutex>
+
+namespace media {
+
+namespace {
+
+static_assert(static_cast<uint32_t>(AVCODEC_BUFFER_FLAGS_EOS) == kBufferFlagEos,
+              "kBufferFlagEos must match AVCODEC_BUFFER_FLAGS_EOS");
+static_assert(static_cast<int32_t>(AV_ERR_OK) == kOk, "kOk must match AV_ERR_OK");
+
+class OhBuffer final : public Buffer {
+public:
+    OhBuffer(OH_AVBuffer* buffer, bool owned) : buffer_(buffer), owned_(owned) {}
+
+    ~OhBuffer() override
+    {
+        if (owned_ && buffer_ != nullptr) {
+            OH_AVBuffer_Destroy(buffer_);
+        }
+    }
+
+    OhBuffer(const OhBuffer&) = delete;
+    OhBuffer& operator=(const OhBuffer&) = delete;
+
+    OH_AVBuffer* Native() const { return buffer_; }
+
+    // Codec buffers: the same index may come back with another OH_AVBuffer.
+    void Rebind(OH_AVBuffer* buffer) { buffer_ = buffer; }
+
+    uint8_t* Addr() override { return OH_AVBuffer_GetAddr(buffer_); }
+
+    int32_t Capacity() override { return OH_AVBuffer_GetCapacity(buffer_); }
+
+    bool GetAttr(BufferAttr* attr) override
+    {
+        OH_AVCodecBufferAttr native = {0};
+        if (OH_AVBuffer_GetBufferAttr(buffer_, &native) != AV_ERR_OK) {
+            return false;
+        }
+        attr->pts = native.pts;
+        attr->size = native.size;
+        attr->offset = native.offset;
+        attr->flags = native.flags;
+        return true;
+    }
+
+    bool SetAttr(const BufferAttr& attr) override
+    {
+        OH_AVCodecBufferAttr native = {0};
+        native.pts = attr.pts;
+        native.size = attr.size;
+        native.offset = attr.offset;
+        native.flags = attr.flags;
+        return OH_AVBuffer_SetBufferAttr(buffer_, &native) == AV_ERR_OK;
+    }
+
+private:
+    OH_AVBuffer* buffer_;
+    bool owned_;
+};
+
+OH_AVBuffer* NativeBuffer(Buffer* buffer)
+{
+    return buffer != nullptr ? static_cast<OhBuffer*>(buffer)->Native() : nullptr;
+}
+
+class OhSource final : public Source {
+public:
+    explicit OhSource(OH_AVSource* source) : source_(source) {}
+    ~OhSource() override { OH_AVSource_Destroy(source_); }
+
+    OhSource(const OhSource&) = delete;
+    OhSource& operator=(const OhSource&) = delete;
+
+    OH_AVSource* Native() const { return source_; }
+
+    bool GetInfo(SourceInfo* info) override
+    {
+        OH_AVFormat* format = OH_AVSource_GetSourceFormat(source_);
+        if (!format) {
+            return false;
+        }
+        const bool ok = OH_AVFormat_GetIntValue(format, OH_MD_KEY_TRACK_COUNT, &info->trackCount);
+        // OH_MD_KEY_DURATION is in microseconds.
+        int64_t durationUs = 0;
+        info->durationUs =
+            (OH_AVFormat_GetLongValue(format, OH_MD_KEY_DURATION, &durationUs) && durationUs > 0) ? durationUs : 0;
+        OH_AVFormat_Destroy(format);
+        return ok;
+    }
+
+    bool GetTrackInfo(uint32_t trackIndex, TrackInfo* info) override
+    {
+        OH_AVFormat* format = OH_AVSource_GetTrackFormat(source_, trackIndex);
+        if (!format) {
+            return false;
+        }
+        const char* mime = nullptr;
+        OH_AVFormat_GetStringValue(format, OH_MD_KEY_CODEC_MIME, &mime);
+        info->mimeType = mime != nullptr ? mime : "";
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_SAMPLE_RATE, &info->sampleRate);
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_CHANNEL_COUNT, &info->channelCount);
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, &info->sampleFormat);
+
+        uint8_t* config = nullptr;
+        size_t configSize = 0;
+        if (OH_AVFormat_GetBuffer(format, OH_MD_KEY_CODEC_CONFIG, &config, &configSize) && config != nullptr &&
+            configSize > 0) {
+            info->codecConfig.assign(config, config + configSize);
+        } else {
+            info->codecConfig.clear();
+        }
+        OH_AVFormat_Destroy(format);
+        return true;
+    }
+
+private:
+    OH_AVSource* source_;
+};
+
+class OhDemuxer final : public Demuxer {
+public:
+    explicit OhDemuxer(OH_AVDemuxer* demuxer) : demuxer_(demuxer) {}
+    ~OhDemuxer() override { OH_AVDemuxer_Destroy(demuxer_); }
+
+    OhDemuxer(const OhDemuxer&) = delete;
+    OhDemuxer& operator=(const OhDemuxer&) = delete;
+
+    int32_t SelectTrack(uint32_t trackIndex) override
+    {
+        return static_cast<int32_t>(OH_AVDemuxer_SelectTrackByID(demuxer_, trackIndex));
+    }
+
+    int32_t SeekToTime(int64_t timeMs) override
+    {
+        return static_cast<int32_t>(OH_AVDemuxer_SeekToTime(demuxer_, timeMs, SEEK_MODE_CLOSEST_SYNC));
+    }
+
+    int32_t ReadSample(uint32_t trackIndex, Buffer* buffer) override
+    {
+        return static_cast<int32_t>(OH_AVDemuxer_ReadSampleBuffer(demuxer_, trackIndex, NativeBuffer(buffer)));
+    }
+
+private:
+    OH_AVDemuxer* demuxer_;
+};
+
+class OhCodec final : public Codec {
+public:
+    explicit OhCodec(OH_AVCodec* codec) : codec_(codec) {}
+    ~OhCodec() override { OH_AudioCodec_Destroy(codec_); }
+
+    OhCodec(const OhCodec&) = delete;
+    OhCodec& operator=(const OhCodec&) = delete;
+
+    int32_t RegisterCallbacks(const CodecCallbacks& callbacks, void* userData) override
+    {
+        callbacks_ = callbacks;
+        userData_ = userData;
+        OH_AVCodecCallback native = {&OnError, &OnStreamChanged, &OnNeedInputBuffer, &OnNewOutputBuffer};
+        return OH_AudioCodec_RegisterCallback(codec_, native, this);
+    }
+
+    int32_t Configure(const CodecFormat& format) override
+    {
+        OH_AVFormat* native = OH_AVFormat_Create();
+        if (!native) {
+            return AV_ERR_NO_MEMORY;
+        }
+        OH_AVFormat_SetIntValue(native, OH_MD_KEY_AUD_SAMPLE_RATE, format.sampleRate);
+        OH_AVFormat_SetIntValue(native, OH_MD_KEY_AUD_CHANNEL_COUNT, format.channelCount);
+        if (format.bitrate > 0) {
+            OH_AVFormat_SetIntValue(native, OH_MD_KEY_BITRATE, format.bitrate);
+        }
+        OH_AVFormat_SetIntValue(native, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, format.sampleFormat);
+        if (!format.codecConfig.empty()) {
+            OH_AVFormat_SetBuffer(native, OH_MD_KEY_CODEC_CONFIG, format.codecConfig.data(),
+                                  format.codecConfig.size());
+        }
+        const int32_t ret = OH_AudioCodec_Configure(codec_, native);
+        OH_AVFormat_Destroy(native);
+        return ret;
+    }
+
+    int32_t Prepare() override { return OH_AudioCodec_Prepare(codec_); }
+    int32_t Start() override { return OH_AudioCodec_Start(codec_); }
+    int32_t Stop() override { return OH_AudioCodec_Stop(codec_); }
+    int32_t Flush() override { return OH_AudioCodec_Flush(codec_); }
+    int32_t Reset() override { return OH_AudioCodec_Reset(codec_); }
+    int32_t PushInputBuffer(uint32_t index) override { return OH_AudioCodec_PushInputBuffer(codec_, index); }
+    int32_t FreeOutputBuffer(uint32_t index) override { return OH_AudioCodec_FreeOutputBuffer(codec_, index); }
+
+private:
+    using Slots = std::vector<std::unique_ptr<OhBuffer>>;
+
+    // One wrapper per buffer index, reused for the lifetime of the codec.
+    Buffer* Wrap(Slots& slots, uint32_t index, OH_AVBuffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(slotMutex_);
+        if (index >= slots.size()) {
+            slots.resize(index + 1);
+        }
+        if (!slots[index]) {
+            slots[index] = std::make_unique<OhBuffer>(buffer, false);
+        } else {
+            slots[index]->Rebind(buffer);
+        }
+        return slots[index].get();
+    }
+
+    static void OnError(OH_AVCodec* /*codec*/, int32_t errorCode, void* userData)
+    {
+        auto* self = static_cast<OhCodec*>(userData);
+        if (self->callbacks_.onError) {
+            self->callbacks_.onError(errorCode, self->userData_);
+        }
+    }
+
+    static void OnStreamChanged(OH_AVCodec* /*codec*/, OH_AVFormat* format, void* userData)
+    {
+        auto* self = static_cast<OhCodec*>(userData);
+        if (!self->callbacks_.onOutputFormatChanged) {
+            return;
+        }
+        CodecFormat changed;
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_SAMPLE_RATE, &changed.sampleRate);
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUD_CHANNEL_COUNT, &changed.channelCount);
+        OH_AVFormat_GetIntValue(format, OH_MD_KEY_AUDIO_SAMPLE_FORMAT, &changed.sampleFormat);
+        self->callbacks_.onOutputFormatChanged(changed, self->userData_);
+    }
+
+    static void OnNeedInputBuffer(OH_AVCodec* /*codec*/, uint32_t index, OH_AVBuffer* buffer, void* userData)
+    {
+        auto* self = static_cast<OhCodec*>(userData);
+        if (self->callbacks_.onInputBufferAvailable) {
+            self->callbacks_.onInputBufferAvailable(index, self->Wrap(self->inputs_, index, buffer), self->userData_);
+        }
+    }
+
+    static void OnNewOutputBuffer(OH_AVCodec* /*codec*/, uint32_t index, OH_AVBuffer* buffer, void* userData)
+    {
+        auto* self = static_cast<OhCodec*>(userData);
+        if (self->callbacks_.onOutputBufferAvailable) {
+            self->callbacks_.onOutputBufferAvailable(index, self->Wrap(self->outputs_, index, buffer),
+                                                     self->userData_);
+        }
+    }
+
+    OH_AVCodec* codec_;
+    CodecCallbacks callbacks_ = {};
+    void* userData_ = nullptr;
+    std::mutex slotMutex_;
+    Slots inputs_;
+    Slots outputs_;
+};
+
+class OhBackend final : public Backend {
+public:
+    std::unique_ptr<Source> CreateSourceWithFd(int32_t fd, int64_t offset, int64_t size) override
+    {
+        OH_AVSource* source = OH_AVSource_CreateWithFD(fd, offset, size);
+        return source != nullptr ? std::make_unique<OhSource>(source) : nullptr;
+    }
+
+    std::unique_ptr<Source> CreateSourceWithUri(const std::string& uri) override
+    {
+        OH_AVSource* source = OH_AVSource_CreateWithURI(const_cast<char*>(uri.c_str()));
+        return source != nullptr ? std::make_unique<OhSource>(source) : nullptr;
+    }
+
+    std::unique_ptr<Demuxer> CreateDemuxer(Source& source) override
+    {
+        OH_AVDemuxer* demuxer = OH_AVDemuxer_CreateWithSource(static_cast<OhSource&>(source).Native());
+        return demuxer != nullptr ? std::make_unique<OhDemuxer>(demuxer) : nullptr;
+    }
+
+    std::unique_ptr<Codec> CreateAudioDecoder(const std::string& mimeType) override
+    {
+        OH_AVCodec* codec = OH_AudioCodec_CreateByMime(mimeType.c_str(), false);
+        return codec != nullptr ? std::make_unique<OhCodec>(codec) : nullptr;
+    }
+
+    std::unique_ptr<Buffer> CreateBuffer(int32_t capacity) override
+    {
+        OH_AVBuffer* buffer = OH_AVBuffer_Create(capacity);
+        return buffer != nullptr ? std::make_unique<OhBuffer>(buffer, true) : nullptr;
+    }
+};
+
+} // namespace
+
+Backend& Backend::Default()
+{
+    static OhBackend backend;
+    return backend;
+}
+
+} // namespace media
@@ -0,0 +1,539 @@
+#include "napi_batch_decoder.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#undef LOG_TAG
+#define LOG_TAG "NapiBatchDecoder"
+
+namespace napi_batch_decoder {
+
+namespace {
+
+int64_t NowMs()
+{
+    using namespace std::chrono;
+    return static_cast<int64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+int64_t GetFileSize(const std::string& path)
+{
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(st.st_size);
+}
+
+bool GetStringProperty(napi_env env, napi_value obj, const char* name, std::string& out)
+{
+    bool has = false;
+    napi_has_named_property(env, obj, name, &has);
+    if (!has) {
+        return false;
+    }
+    napi_value v;
+    napi_get_named_property(env, obj, name, &v);
+    napi_valuetype t;
+    napi_typeof(env, v, &t);
+    if (t != napi_string) {
+        return false;
+    }
+
+    size_t len = 0;
+    napi_get_value_string_utf8(env, v, nullptr, 0, &len);
+    out.resize(len + 1);
+    napi_get_value_string_utf8(env, v, &out[0], len + 1, &len);
+    out.resize(len);
+    return true;
+}
+
+int32_t GetInt32Property(napi_env env, napi_value obj, const char* name, int32_t defaultValue)
+{
+    bool has = false;
+    napi_has_named_property(env, obj, name, &has);
+    if (!has) {
+        return defaultValue;
+    }
+    napi_value v;
+    napi_get_named_property(env, obj, name, &v);
+    napi_valuetype t;
+    napi_typeof(env, v, &t);
+    if (t != napi_number) {
+        return defaultValue;
+    }
+    int32_t out = defaultValue;
+    napi_get_value_int32(env, v, &out);
+    return out;
+}
+
+bool GetBoolProperty(napi_env env, napi_value obj, const char* name, bool defaultValue)
+{
+    bool has = false;
+    napi_has_named_property(env, obj, name, &has);
+    if (!has) {
+        return defaultValue;
+    }
+    napi_value v;
+    napi_get_named_property(env, obj, name, &v);
+    bool out = defaultValue;
+    if (napi_get_value_bool(env, v, &out) != napi_ok) {
+        return defaultValue;
+    }
+    return out;
+}
+
+void SetDoubleProperty(napi_env env, napi_value obj, const char* name, double value)
+{
+    napi_value v;
+    napi_create_double(env, value, &v);
+    napi_set_named_property(env, obj, name, v);
+}
+
+void SetBoolProperty(napi_env env, napi_value obj, const char* name, bool value)
+{
+    napi_value v;
+    napi_get_boolean(env, value, &v);
+    napi_set_named_property(env, obj, name, v);
+}
+
+void QueueBatchEvent(BatchDecodeContext* ctx, std::unique_ptr<BatchDecodeEventPayload> payload)
+{
+    if (!ctx || ctx->eventTsfn == nullptr) {
+        return;
+    }
+    napi_status st = napi_call_threadsafe_function(ctx->eventTsfn, payload.get(), napi_tsfn_nonblocking);
+    if (st == napi_ok) {
+        (void)payload.release();
+    }
+}
+
+// 置位取消标志并唤醒所有工作线程（解码线程不再定时轮询取消标志）
+void CancelBatch(BatchDecodeContext* ctx)
+{
+    ctx->cancel.store(true);
+    for (const auto& wakeup : ctx->wakeups) {
+        wakeup->Notify();
+    }
+}
+
+int32_t DefaultConcurrency()
+{
+    const unsigned cores = std::thread::hardware_concurrency();
+    return (cores > 1) ? static_cast<int32_t>(cores - 1) : 1;
+}
+
+// 工作线程：持有一个 AudioDecoder，循环领取任务直到队列耗尽或被取消。
+void RunBatchWorker(BatchDecodeContext* ctx, size_t worker)
+{
+    AudioDecoder decoder;
+    decoder.SetFileOutputOptions(ctx->fileOutput);
+    decoder.SetWakeup(ctx->wakeups[worker].get());
+    const size_t jobCount = ctx->jobs.size();
+
+    while (!ctx->cancel.load()) {
+        const size_t index = ctx->nextJob.fetch_add(1);
+        if (index >= jobCount) {
+            break;
+        }
+
+        BatchDecodeJob& job = ctx->jobs[index];
+        const int64_t startMs = NowMs();
+
+        AudioDecoder::ProgressCallback cb = [ctx, index, &job](double progress, int64_t ptsMs, int64_t durationMs) {
+            // 最后一次回调携带最终时长（未知时长时为最终 pts），用于统计实时倍率
+            job.durationMs = (durationMs > 0) ? durationMs : ptsMs;
+
+            if (ctx->onProgressRef == nullptr) {
+                return;
+            }
+            auto payload = std::make_unique<BatchDecodeEventPayload>();
+            payload->type = BatchDecodeEventType::Progress;
+            payload->jobIndex = static_cast<int32_t>(index);
+            payload->progress = progress;
+            payload->ptsMs = ptsMs;
+            payload->durationMs = durationMs;
+            QueueBatchEvent(ctx, std::move(payload));
+        };
+
+        job.success = decoder.DecodeFileWithProgress(job.inputPathOrUri, job.outputPath, job.sampleRate,
+                                                     job.channelCount, job.bitrate, cb, &ctx->cancel);
+        job.cancelled = !job.success && ctx->cancel.load();
+        job.elapsedMs = NowMs() - startMs;
+
+        if (job.success) {
+            job.outputBytes = GetFileSize(job.outputPath);
+        }
+
+        OH_LOG_INFO(LOG_APP, "Batch job %{public}zu %{public}s in %{public}lld ms", index,
+                    job.success ? "done" : (job.cancelled ? "cancelled" : "failed"), (long long)job.elapsedMs);
+
+        if (ctx->onJobDoneRef != nullptr) {
+            auto payload = std::make_unique<BatchDecodeEventPayload>();
+            payload->type = BatchDecodeEventType::JobDone;
+            payload->jobIndex = static_cast<int32_t>(index);
+            payload->success = job.success;
+            payload->cancelled = job.cancelled;
+            payload->outputBytes = job.outputBytes;
+            payload->durationMs = job.durationMs;
+            payload->elapsedMs = job.elapsedMs;
+            QueueBatchEvent(ctx, std::move(payload));
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// 批量解码事件回调
+// ============================================================================
+
+void CallJsBatchEvent(napi_env env, napi_value /*jsCallback*/, void* context, void* data)
+{
+    auto* ctx = static_cast<BatchDecodeContext*>(context);
+    std::unique_ptr<BatchDecodeEventPayload> payload(static_cast<BatchDecodeEventPayload*>(data));
+    if (!ctx || !payload || env == nullptr) {
+        return;
+    }
+
+    napi_ref ref = (payload->type == BatchDecodeEventType::Progress) ? ctx->onProgressRef : ctx->onJobDoneRef;
+    if (ref == nullptr) {
+        return;
+    }
+    napi_value cb;
+    napi_get_reference_value(env, ref, &cb);
+    if (cb == nullptr) {
+        return;
+    }
+
+    napi_value arg;
+    napi_create_object(env, &arg);
+
+    napi_value jobIndex;
+    napi_create_int32(env, payload->jobIndex, &jobIndex);
+    napi_set_named_property(env, arg, "jobIndex", jobIndex);
+
+    switch (payload->type) {
+    case BatchDecodeEventType::Progress:
+        SetDoubleProperty(env, arg, "progress", payload->progress);
+        SetDoubleProperty(env, arg, "ptsMs", static_cast<double>(payload->ptsMs));
+        SetDoubleProperty(env, arg, "durationMs", static_cast<double>(payload->durationMs));
+        break;
+    case BatchDecodeEventType::JobDone:
+        SetBoolProperty(env, arg, "success", payload->success);
+        SetBoolProperty(env, arg, "cancelled", payload->cancelled);
+        SetDoubleProperty(env, arg, "outputBytes", static_cast<double>(payload->outputBytes));
+        SetDoubleProperty(env, arg, "durationMs", static_cast<double>(payload->durationMs));
+        SetDoubleProperty(env, arg, "elapsedMs", static_cast<double>(payload->elapsedMs));
+        break;
+    default:
+        break;
+    }
+
+    napi_value argv[1] = {arg};
+    napi_value result;
+    napi_call_function(env, nullptr, cb, 1, argv, &result);
+}
+
+// ============================================================================
+// 批量解码任务
+// ============================================================================
+
+void ExecuteBatchDecode(napi_env /*env*/, void* data)
+{
+    auto* ctx = static_cast<BatchDecodeContext*>(data);
+    if (!ctx) {
+        return;
+    }
+
+    const int64_t startMs = NowMs();
+
+    // 当前（后台调度器）线程作为 worker 0，其余 worker 作为同一调度器上的任务排队：
+    // 所有批次与 decodeAudioAsync 共用 backgroundThreads 上限；任务领完时尚未启动的 worker 直接跳过
+    DecodeScheduler::Background().Parallel(DecodeScheduler::Priority::Normal, static_cast<size_t>(ctx->concurrency),
+                                           [ctx](size_t worker) { RunBatchWorker(ctx, worker); });
+
+    // 取消后未被领取的任务记为 cancelled
+    const size_t claimed = std::min(ctx->nextJob.load(), ctx->jobs.size());
+    for (size_t i = claimed; i < ctx->jobs.size(); i++) {
+        ctx->jobs[i].cancelled = true;
+    }
+
+    ctx->elapsedMs = NowMs() - startMs;
+}
+
+void CompleteBatchDecode(napi_env env, napi_status /*status*/, void* data)
+{
+    auto* ctx = static_cast<BatchDecodeContext*>(data);
+    if (!ctx) {
+        return;
+    }
+
+    if (ctx->eventTsfn != nullptr) {
+        napi_release_threadsafe_function(ctx->eventTsfn, napi_tsfn_release);
+        ctx->eventTsfn = nullptr;
+    }
+
+    int32_t succeeded = 0;
+    int32_t failed = 0;
+    int32_t cancelled = 0;
+    int64_t outputBytes = 0;
+    int64_t mediaMs = 0;
+
+    napi_value jobResults;
+    napi_create_array_with_length(env, ctx->jobs.size(), &jobResults);
+    for (size_t i = 0; i < ctx->jobs.size(); i++) {
+        const BatchDecodeJob& job = ctx->jobs[i];
+        if (job.success) {
+            succeeded++;
+            outputBytes += job.outputBytes;
+            mediaMs += job.durationMs;
+        } else if (job.cancelled) {
+            cancelled++;
+        } else {
+            failed++;
+        }
+
+        napi_value item;
+        napi_create_object(env, &item);
+        SetBoolProperty(env, item, "success", job.success);
+        SetBoolProperty(env, item, "cancelled", job.cancelled);
+        SetDoubleProperty(env, item, "outputBytes", static_cast<double>(job.outputBytes));
+        SetDoubleProperty(env, item, "durationMs", static_cast<double>(job.durationMs));
+        SetDoubleProperty(env, item, "elapsedMs", static_cast<double>(job.elapsedMs));
+        napi_set_element(env, jobResults, static_cast<uint32_t>(i), item);
+    }
+
+    const double elapsedSec = static_cast<double>(std::max<int64_t>(ctx->elapsedMs, 1)) / 1000.0;
+
+    napi_value result;
+    napi_create_object(env, &result);
+    SetDoubleProperty(env, result, "total", static_cast<double>(ctx->jobs.size()));
+    SetDoubleProperty(env, result, "succeeded", succeeded);
+    SetDoubleProperty(env, result, "failed", failed);
+    SetDoubleProperty(env, result, "cancelled", cancelled);
+    SetDoubleProperty(env, result, "concurrency", ctx->concurrency);
+    SetDoubleProperty(env, result, "elapsedMs", static_cast<double>(ctx->elapsedMs));
+    SetDoubleProperty(env, result, "outputBytes", static_cast<double>(outputBytes));
+    SetDoubleProperty(env, result, "bytesPerSecond", static_cast<double>(outputBytes) / elapsedSec);
+    SetDoubleProperty(env, result, "realtimeFactor", static_cast<double>(mediaMs) / 1000.0 / elapsedSec);
+    napi_set_named_property(env, result, "jobs", jobResults);
+
+    OH_LOG_INFO(LOG_APP, "Batch decode finished: %{public}d ok, %{public}d failed, %{public}d cancelled, %{public}lld ms",
+                succeeded, failed, cancelled, (long long)ctx->elapsedMs);
+
+    if (ctx->deferred != nullptr) {
+        napi_resolve_deferred(env, ctx->deferred, result);
+        ctx->deferred = nullptr;
+    }
+
+    if (ctx->selfRef != nullptr) {
+        napi_delete_reference(env, ctx->selfRef);
+        ctx->selfRef = nullptr;
+    }
+}
+
+napi_value BatchDecodeCancel(napi_env env, napi_callback_info info)
+{
+    size_t argc = 0;
+    void* data = nullptr;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, &data);
+    auto* ctx = static_cast<BatchDecodeContext*>(data);
+    if (ctx) {
+        CancelBatch(ctx);
+    }
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+void FinalizeBatchDecode(napi_env env, void* finalize_data, void* /*finalize_hint*/)
+{
+    auto* ctx = static_cast<BatchDecodeContext*>(finalize_data);
+    if (!ctx) {
+        return;
+    }
+
+    CancelBatch(ctx);
+
+    if (ctx->onProgressRef != nullptr) {
+        napi_delete_reference(env, ctx->onProgressRef);
+        ctx->onProgressRef = nullptr;
+    }
+    if (ctx->onJobDoneRef != nullptr) {
+        napi_delete_reference(env, ctx->onJobDoneRef);
+        ctx->onJobDoneRef = nullptr;
+    }
+
+    delete ctx;
+}
+
+napi_value DecodeBatch(napi_env env, napi_callback_info info)
+{
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    bool isArray = false;
+    if (argc >= 1) {
+        napi_is_array(env, args[0], &isArray);
+    }
+    if (!isArray) {
+        napi_throw_error(env, nullptr, "decodeBatch requires a jobs array");
+        return nullptr;
+    }
+
+    uint32_t jobCount = 0;
+    napi_get_array_length(env, args[0], &jobCount);
+
+    std::vector<BatchDecodeJob> jobs;
+    jobs.reserve(jobCount);
+    for (uint32_t i = 0; i < jobCount; i++) {
+        napi_value item;
+        napi_get_element(env, args[0], i, &item);
+        napi_valuetype t;
+        napi_typeof(env, item, &t);
+
+        BatchDecodeJob job;
+        if (t != napi_object || !GetStringProperty(env, item, "inputPathOrUri", job.inputPathOrUri) ||
+            !GetStringProperty(env, item, "outputPath", job.outputPath)) {
+            napi_throw_error(env, nullptr, "decodeBatch: each job requires inputPathOrUri and outputPath");
+            return nullptr;
+        }
+        job.sampleRate = GetInt32Property(env, item, "sampleRate", 0);
+        job.channelCount = GetInt32Property(env, item, "channelCount", 0);
+        job.bitrate = GetInt32Property(env, item, "bitrate", 0);
+        jobs.push_back(std::move(job));
+    }
+
+    // options
+    int32_t concurrency = DefaultConcurrency();
+    AudioDecoder::FileOutputOptions fileOutput;
+    if (argc >= 2 && args[1] != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, args[1], &t);
+        if (t == napi_object) {
+            const int32_t c = GetInt32Property(env, args[1], "concurrency", 0);
+            if (c > 0) {
+                concurrency = c;
+            }
+            const int32_t blockBytes = GetInt32Property(env, args[1], "writeBlockBytes", 0);
+            if (blockBytes > 0) {
+                fileOutput.writer.blockBytes = static_cast<size_t>(blockBytes);
+            }
+            fileOutput.writer.directIo = GetBoolProperty(env, args[1], "directIo", false);
+            fileOutput.preallocate = GetBoolProperty(env, args[1], "preallocate", false);
+
+            std::string container;
+            if (GetStringProperty(env, args[1], "container", container) && container == "wav") {
+                fileOutput.container = AudioDecoder::OutputContainer::Wav;
+            }
+
+            std::string sync;
+            if (GetStringProperty(env, args[1], "syncPolicy", sync)) {
+                if (sync == "close") {
+                    fileOutput.writer.sync = PcmFileWriter::SyncPolicy::kOnClose;
+                } else if (sync == "block") {
+                    fileOutput.writer.sync = PcmFileWriter::SyncPolicy::kPerBlock;
+                }
+            }
+        }
+    }
+    concurrency = std::min(concurrency, kMaxBatchConcurrency);
+    concurrency = std::max(1, std::min(concurrency, static_cast<int32_t>(jobs.size())));
+
+    // callbacks
+    napi_value onProgress = nullptr;
+    napi_value onJobDone = nullptr;
+    if (argc >= 3 && args[2] != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, args[2], &t);
+        if (t == napi_object) {
+            napi_get_named_property(env, args[2], "onProgress", &onProgress);
+            napi_get_named_property(env, args[2], "onJobDone", &onJobDone);
+        }
+    }
+
+    auto* ctx = new BatchDecodeContext();
+    ctx->env = env;
+    ctx->jobs = std::move(jobs);
+    ctx->concurrency = concurrency;
+    ctx->fileOutput = fileOutput;
+    for (int32_t i = 0; i < concurrency; i++) {
+        ctx->wakeups.push_back(std::make_unique<DecodeWakeup>());
+    }
+
+    OH_LOG_INFO(LOG_APP, "DecodeBatch called: %{public}zu jobs, concurrency %{public}d", ctx->jobs.size(),
+                concurrency);
+
+    napi_value taskObj;
+    napi_create_object(env, &taskObj);
+
+    // Keep task object alive while batch running.
+    napi_create_reference(env, taskObj, 1, &ctx->selfRef);
+
+    napi_value donePromise;
+    napi_create_promise(env, &ctx->deferred, &donePromise);
+    napi_set_named_property(env, taskObj, "done", donePromise);
+
+    if (onProgress != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, onProgress, &t);
+        if (t == napi_function) {
+            napi_create_reference(env, onProgress, 1, &ctx->onProgressRef);
+        }
+    }
+    if (onJobDone != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, onJobDone, &t);
+        if (t == napi_function) {
+            napi_create_reference(env, onJobDone, 1, &ctx->onJobDoneRef);
+        }
+    }
+
+    if (ctx->onProgressRef != nullptr || ctx->onJobDoneRef != nullptr) {
+        // Create a noop JS function required by TSFN.
+        napi_value noop;
+        napi_create_function(
+            env, "noop", NAPI_AUTO_LENGTH,
+            [](napi_env env, napi_callback_info /*info*/) -> napi_value {
+                napi_value undef;
+                napi_get_undefined(env, &undef);
+                return undef;
+            },
+            nullptr, &noop);
+
+        napi_value tsfnName;
+        napi_create_string_utf8(env, "BatchDecodeEvent", NAPI_AUTO_LENGTH, &tsfnName);
+        napi_create_threadsafe_function(env, noop, nullptr, tsfnName, 0, 1, nullptr, nullptr, ctx, CallJsBatchEvent,
+                                        &ctx->eventTsfn);
+    }
+
+    napi_value cancelFn;
+    napi_create_function(env, "cancel", NAPI_AUTO_LENGTH, BatchDecodeCancel, ctx, &cancelFn);
+    napi_set_named_property(env, taskObj, "cancel", cancelFn);
+
+    napi_wrap(env, taskObj, ctx, FinalizeBatchDecode, nullptr, nullptr);
+
+    // 整批在后台解码调度器上执行，不占用 napi 异步工作线程
+    if (!napi_utils::QueueDecodeWork(env, DecodeScheduler::Background(), DecodeScheduler::Priority::Normal,
+                                     "BatchDecode", ExecuteBatchDecode, CompleteBatchDecode, ctx)) {
+        // 未能排队则 complete 不会被调用：在此以 schedule 错误拒绝 done，并释放 eventTsfn 与 selfRef；
+        // ctx 随后由 wrap 的 finalizer 释放
+        OH_LOG_ERROR(LOG_APP, "Failed to schedule batch decode");
+        if (ctx->eventTsfn != nullptr) {
+            napi_release_threadsafe_function(ctx->eventTsfn, napi_tsfn_release);
+            ctx->eventTsfn = nullptr;
+        }
+        napi_value errObj = napi_utils::CreateErrorObject(env, "schedule", -1, "Failed to schedule decode work");
+        napi_reject_deferred(env, ctx->deferred, errObj);
+        ctx->deferred = nullptr;
+        napi_delete_reference(env, ctx->selfRef);
+        ctx->selfRef = nullptr;
+    }
+
+    return taskObj;
+}
+
+} // namespace napi_batch_decoder
@@ -0,0 +1,81 @@
+#ifndef NAPI_BATCH_DECODER_H
+#define NAPI_BATCH_DECODER_H
+
+#include <napi/native_api.h>
+#include "../audio_decoder.h"
+#include "../napi/napi_utils.h"
+#include "../types/decoder_types.h"
+#include <hilog/log.h>
+
+namespace napi_batch_decoder {
+
+// 并发数上限（每个工作线程持有一个 codec 实例）
+constexpr int32_t kMaxBatchConcurrency = 16;
+
+// ============================================================================
+// 批量解码事件回调
+// ============================================================================
+
+/**
+ * @brief 调用 JS 批量解码事件回调（onProgress / onJobDone）
+ * @param env NAPI 环境
+ * @param jsCallback JS 回调函数（未使用）
+ * @param context 批量解码上下文
+ * @param data 事件数据
+ */
+void CallJsBatchEvent(
+    napi_env env,
+    napi_value jsCallback,
+    void* context,
+    void* data);
+
+// ============================================================================
+// 批量解码任务
+// ============================================================================
+
+/**
+ * @brief 执行批量解码：当前线程与 concurrency-1 个工作线程共同领取任务
+ * @param env NAPI 环境
+ * @param data 批量解码上下文
+ */
+void ExecuteBatchDecode(napi_env env, void* data);
+
+/**
+ * @brief 完成批量解码，resolve done Promise（汇总结果）
+ * @param env NAPI 环境
+ * @param status 异步状态
+ * @param data 批量解码上下文
+ */
+void CompleteBatchDecode(napi_env env, napi_status status, void* data);
+
+/**
+ * @brief 请求取消批量解码（正在解码的任务尽快停止，未开始的任务不再执行）
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value BatchDecodeCancel(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 释放批量解码上下文
+ * @param env NAPI 环境
+ * @param finalize_data 批量解码上下文
+ * @param finalize_hint 未使用
+ */
+void FinalizeBatchDecode(napi_env env, void* finalize_data, void* finalize_hint);
+
+/**
+ * @brief 批量解码音频文件的 NAPI 接口
+ *
+ * 参数：
+ * - jobs: 任务数组，每项 { inputPathOrUri, outputPath, sampleRate?, channelCount?, bitrate? }
+ * - options: 可选 { concurrency? }，默认 CPU 核数 - 1（至少 1）
+ * - callbacks: 可选 { onProgress?, onJobDone? }
+ *
+ * @return { done: Promise<BatchDecodeResult>, cancel(): void }
+ */
+napi_value DecodeBatch(napi_env env, napi_callback_info info);
+
+} // namespace napi_batch_decoder
+
+#endif // NAPI_BATCH_DECODER_H
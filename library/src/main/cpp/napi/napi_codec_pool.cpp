@@ -0,0 +1,131 @@
+#include "napi_codec_pool.h"
+#include <algorithm>
+
+#undef LOG_TAG
+#define LOG_TAG "NapiCodecPool"
+
+namespace napi_codec_pool {
+
+void ExecutePrewarmCodecs(napi_env /*env*/, void* data)
+{
+    auto* ctx = static_cast<CodecPrewarmContext*>(data);
+    if (!ctx) {
+        return;
+    }
+    for (const std::string& mime : ctx->mimeTypes) {
+        ctx->created += static_cast<uint32_t>(
+            AudioDecoder::PrewarmCodecs(mime, static_cast<size_t>(ctx->countPerMime)));
+    }
+}
+
+void CompletePrewarmCodecs(napi_env env, napi_status /*status*/, void* data)
+{
+    auto* ctx = static_cast<CodecPrewarmContext*>(data);
+    if (!ctx) {
+        return;
+    }
+
+    napi_value result;
+    napi_create_uint32(env, ctx->created, &result);
+    napi_resolve_deferred(env, ctx->deferred, result);
+
+    napi_delete_async_work(env, ctx->work);
+    delete ctx;
+}
+
+napi_value PrewarmCodecs(napi_env env, napi_callback_info info)
+{
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    bool isArray = false;
+    if (argc >= 1) {
+        napi_is_array(env, args[0], &isArray);
+    }
+    if (!isArray) {
+        napi_throw_error(env, nullptr, "prewarmCodecs requires a mimeTypes array");
+        return nullptr;
+    }
+
+    auto* ctx = new CodecPrewarmContext();
+
+    uint32_t count = 0;
+    napi_get_array_length(env, args[0], &count);
+    for (uint32_t i = 0; i < count; i++) {
+        napi_value item;
+        napi_get_element(env, args[0], i, &item);
+        size_t len = 0;
+        if (napi_get_value_string_utf8(env, item, nullptr, 0, &len) != napi_ok || len == 0) {
+            continue;
+        }
+        std::string mime;
+        mime.resize(len + 1);
+        napi_get_value_string_utf8(env, item, &mime[0], len + 1, &len);
+        mime.resize(len);
+        ctx->mimeTypes.push_back(std::move(mime));
+    }
+
+    if (argc >= 2) {
+        int32_t perMime = 1;
+        if (napi_get_value_int32(env, args[1], &perMime) == napi_ok) {
+            ctx->countPerMime = std::max(0, std::min(perMime, kMaxPrewarmPerMime));
+        }
+    }
+
+    napi_value promise;
+    napi_create_promise(env, &ctx->deferred, &promise);
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, "PrewarmCodecs", NAPI_AUTO_LENGTH, &resourceName);
+    napi_create_async_work(env, nullptr, resourceName, ExecutePrewarmCodecs, CompletePrewarmCodecs, ctx,
+                           &ctx->work);
+    napi_queue_async_work(env, ctx->work);
+    return promise;
+}
+
+napi_value SetCodecPoolSize(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int32_t maxIdle = 0;
+    if (argc < 1 || napi_get_value_int32(env, args[0], &maxIdle) != napi_ok) {
+        napi_throw_error(env, nullptr, "setCodecPoolSize(maxIdle) requires a number");
+        return nullptr;
+    }
+    CodecPool::Shared().SetMaxIdle(static_cast<size_t>(std::max(0, maxIdle)));
+    return nullptr;
+}
+
+napi_value GetCodecPoolStats(napi_env env, napi_callback_info /*info*/)
+{
+    const CodecPool::Stats stats = CodecPool::Shared().GetStats();
+
+    napi_value obj;
+    napi_create_object(env, &obj);
+    auto setNumber = [env, obj](const char *name, double value) {
+        napi_value v;
+        napi_create_double(env, value, &v);
+        napi_set_named_property(env, obj, name, v);
+    };
+
+    setNumber("warmHits", static_cast<double>(stats.warmHits));
+    setNumber("resetHits", static_cast<double>(stats.resetHits));
+    setNumber("misses", static_cast<double>(stats.misses));
+    setNumber("creates", static_cast<double>(stats.creates));
+    setNumber("createFailures", static_cast<double>(stats.createFailures));
+    setNumber("evictions", static_cast<double>(stats.evictions));
+    setNumber("discards", static_cast<double>(stats.discards));
+    setNumber("createMsAvg", stats.creates > 0
+                                 ? static_cast<double>(stats.createUsTotal) / 1000.0 / static_cast<double>(stats.creates)
+                                 : 0.0);
+    setNumber("createMsLast", static_cast<double>(stats.createUsLast) / 1000.0);
+    setNumber("createMsMax", static_cast<double>(stats.createUsMax) / 1000.0);
+    setNumber("idle", static_cast<double>(stats.idle));
+    setNumber("maxIdle", static_cast<double>(stats.maxIdle));
+    return obj;
+}
+
+} // namespace napi_codec_pool
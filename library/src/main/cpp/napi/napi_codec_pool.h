@@ -0,0 +1,66 @@
+#ifndef NAPI_CODEC_POOL_H
+#define NAPI_CODEC_POOL_H
+
+#include <napi/native_api.h>
+#include "../audio_decoder.h"
+#include "../codec_pool.h"
+#include "../napi/napi_utils.h"
+#include "../types/decoder_types.h"
+#include <hilog/log.h>
+
+namespace napi_codec_pool {
+
+// 每个 MIME 一次最多预创建的 codec 数
+constexpr int32_t kMaxPrewarmPerMime = 8;
+
+// ============================================================================
+// 解码器实例池接口
+// ============================================================================
+
+/**
+ * @brief 执行预创建：在工作线程上为每个 MIME 创建 codec 放入实例池
+ * @param env NAPI 环境
+ * @param data 预创建上下文
+ */
+void ExecutePrewarmCodecs(napi_env env, void* data);
+
+/**
+ * @brief 完成预创建，resolve 成功创建的 codec 数
+ * @param env NAPI 环境
+ * @param status 异步状态
+ * @param data 预创建上下文
+ */
+void CompletePrewarmCodecs(napi_env env, napi_status status, void* data);
+
+/**
+ * @brief 预创建 codec 放入进程级实例池，缩短首次解码的准备时间
+ *
+ * 参数：
+ * - mimeTypes: MIME 类型数组（如 "audio/mpeg"、"audio/flac"）
+ * - countPerMime: 每个 MIME 创建的个数（可选，默认 1，最大 kMaxPrewarmPerMime）
+ *
+ * @return Promise<number> 成功创建的 codec 数
+ */
+napi_value PrewarmCodecs(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 设置实例池最多保留的空闲 codec 数（0 关闭复用，超出的空闲 codec 立即销毁）
+ *
+ * 参数：
+ * - maxIdle: 空闲 codec 上限（0~CodecPool::kMaxIdleLimit）
+ *
+ * @return undefined
+ */
+napi_value SetCodecPoolSize(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 获取实例池统计：命中/未命中次数与 codec 创建耗时
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return CodecPoolStats 对象
+ */
+napi_value GetCodecPoolStats(napi_env env, napi_callback_info info);
+
+} // namespace napi_codec_pool
+
+#endif // NAPI_CODEC_POOL_H
@@ -153,7 +153,6 @@ void CompleteDecodeAudioAsync(napi_env env, napi_status /*status*/, void* data)
         napi_reject_deferred(env, ctx->deferred, errObj);
     }
 
-    napi_delete_async_work(env, ctx->work);
     delete ctx;
 }
 
@@ -211,7 +210,6 @@ napi_value DecodeAudioAsync(napi_env env, napi_callback_info info)
 
     auto* ctx = new DecodeAudioAsyncContext();
     ctx->env = env;
-    ctx->work = nullptr;
     ctx->deferred = nullptr;
     ctx->tsfn = nullptr;
     ctx->inputPathOrUri = input;
@@ -241,10 +239,18 @@ napi_value DecodeAudioAsync(napi_env env, napi_callback_info info)
             &ctx->tsfn);
     }
 
-    napi_value workName;
-    napi_create_string_utf8(env, "DecodeAudioAsync", NAPI_AUTO_LENGTH, &workName);
-    napi_create_async_work(env, nullptr, workName, ExecuteDecodeAudioAsync, CompleteDecodeAudioAsync, ctx, &ctx->work);
-    napi_queue_async_work(env, ctx->work);
+    // 文件解码在后台解码调度器上执行，不占用 napi 异步工作线程
+    if (!napi_utils::QueueDecodeWork(env, DecodeScheduler::Background(), DecodeScheduler::Priority::Normal,
+                                     "DecodeAudioAsync", ExecuteDecodeAudioAsync, CompleteDecodeAudioAsync, ctx)) {
+        // 未能排队则 complete 不会被调用：在此拒绝 promise 并释放上下文
+        OH_LOG_ERROR(LOG_APP, "Failed to schedule decode");
+        if (ctx->tsfn != nullptr) {
+            napi_release_threadsafe_function(ctx->tsfn, napi_tsfn_release);
+        }
+        napi_value errObj = napi_utils::CreateErrorObject(env, "schedule", -1, "Failed to schedule decode work");
+        napi_reject_deferred(env, ctx->deferred, errObj);
+        delete ctx;
+    }
 
     return promise;
 }
@@ -0,0 +1,78 @@
+#include "napi_scheduler.h"
+
+#undef LOG_TAG
+#define LOG_TAG "NapiScheduler"
+
+namespace napi_scheduler {
+
+namespace {
+
+void ApplyThreads(napi_env env, napi_value options, const char* name, DecodeScheduler& scheduler)
+{
+    bool has = false;
+    napi_has_named_property(env, options, name, &has);
+    if (!has) {
+        return;
+    }
+    napi_value v;
+    napi_get_named_property(env, options, name, &v);
+    int32_t threads = 0;
+    if (napi_get_value_int32(env, v, &threads) == napi_ok && threads > 0) {
+        scheduler.SetMaxThreads(static_cast<size_t>(threads));
+        OH_LOG_INFO(LOG_APP, "%{public}s set to %{public}d", name, threads);
+    }
+}
+
+napi_value CreateStatsObject(napi_env env, const DecodeScheduler::Stats& stats)
+{
+    napi_value obj;
+    napi_create_object(env, &obj);
+    auto setNumber = [env, obj](const char *name, double value) {
+        napi_value v;
+        napi_create_double(env, value, &v);
+        napi_set_named_property(env, obj, name, v);
+    };
+
+    setNumber("maxThreads", static_cast<double>(stats.maxThreads));
+    setNumber("threads", static_cast<double>(stats.threads));
+    setNumber("running", static_cast<double>(stats.running));
+    setNumber("queued", static_cast<double>(stats.queued));
+    setNumber("submitted", static_cast<double>(stats.submitted));
+    setNumber("completed", static_cast<double>(stats.completed));
+    setNumber("queueWaitMsMax", static_cast<double>(stats.queueWaitUsMax) / 1000.0);
+    return obj;
+}
+
+} // namespace
+
+napi_value ConfigureDecodeScheduler(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_valuetype t = napi_undefined;
+    if (argc >= 1) {
+        napi_typeof(env, args[0], &t);
+    }
+    if (t != napi_object) {
+        napi_throw_error(env, nullptr, "configureDecodeScheduler requires an options object");
+        return nullptr;
+    }
+
+    ApplyThreads(env, args[0], "streamThreads", DecodeScheduler::Streams());
+    ApplyThreads(env, args[0], "backgroundThreads", DecodeScheduler::Background());
+    return nullptr;
+}
+
+napi_value GetDecodeSchedulerStats(napi_env env, napi_callback_info /*info*/)
+{
+    napi_value obj;
+    napi_create_object(env, &obj);
+    napi_set_named_property(env, obj, "streams", CreateStatsObject(env, DecodeScheduler::Streams().GetStats()));
+    napi_set_named_property(env, obj, "background",
+                            CreateStatsObject(env, DecodeScheduler::Background().GetStats()));
+    return obj;
+}
+
+} // namespace napi_scheduler
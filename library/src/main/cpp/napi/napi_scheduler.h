@@ -0,0 +1,35 @@
+#ifndef NAPI_SCHEDULER_H
+#define NAPI_SCHEDULER_H
+
+#include <napi/native_api.h>
+#include "../decode_scheduler.h"
+#include <hilog/log.h>
+
+namespace napi_scheduler {
+
+// ============================================================================
+// 解码线程调度器接口
+// ============================================================================
+
+/**
+ * @brief 设置解码调度器的线程上限
+ *
+ * 参数：
+ * - options.streamThreads: 流式解码线程上限（可选，1~DecodeScheduler::kMaxThreadsLimit）
+ * - options.backgroundThreads: 后台文件解码线程上限（可选，同上）
+ *
+ * @return undefined
+ */
+napi_value ConfigureDecodeScheduler(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 获取解码调度器统计（streams / background 两组）
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return DecodeSchedulerStats 对象
+ */
+napi_value GetDecodeSchedulerStats(napi_env env, napi_callback_info info);
+
+} // namespace napi_scheduler
+
+#endif // NAPI_SCHEDULER_H
@@ -1,16 +1,27 @@
 #include "napi_stream_decoder.h"
+#include "../pcm_convert.h"
+#include "../pcm_disk_cache.h"
+#include "../gapless_trim.h"
+#include "../preroll_decoder.h"
+#include "../decode_trace.h"
 #include <thread>
 
 #undef LOG_TAG
 #define LOG_TAG "NapiStreamDecoder"
 
 #include <chrono>
+#include <ctime>
 
 namespace napi_stream_decoder {
 
 namespace {
 
 constexpr size_t kAdaptiveRingAlignStep = 64 * 1024;
+// Upper bound for the optional played-PCM history (backward in-buffer seeks).
+constexpr int32_t kMaxHistoryMs = 60 * 1000;
+// PCM of the next queued track decoded ahead, so its source is open and the codec primed at the splice.
+constexpr int64_t kPrerollStageMs = 2000;
+constexpr int32_t kMaxCrossfadeMs = 12 * 1000;
 
 bool IsHttpSource(const std::string& inputPathOrUri)
 {
@@ -36,6 +47,27 @@ size_t AlignUpRingBytes(size_t value)
     return ((value + kAdaptiveRingAlignStep - 1) / kAdaptiveRingAlignStep) * kAdaptiveRingAlignStep;
 }
 
+uint64_t PcmBytesPerSecond(int32_t sampleRate, int32_t channelCount, int32_t actualSampleFormat)
+{
+    return (sampleRate > 0 && channelCount > 0)
+               ? static_cast<uint64_t>(sampleRate) * static_cast<uint64_t>(channelCount) *
+                     static_cast<uint64_t>(GetPcmBytesPerSample(actualSampleFormat))
+               : 0;
+}
+
+// Bounds for the adaptive ring size, both for the initial estimate and for runtime resizing.
+void GetAdaptiveRingLimits(const PcmStreamDecoderContext* ctx, uint64_t pcmBytesPerSecond,
+                           size_t* minLimit, size_t* maxLimit)
+{
+    const bool isHttp = IsHttpSource(ctx->inputPathOrUri);
+    *minLimit = isHttp ? (192 * 1024) : (256 * 1024);
+    if (pcmBytesPerSecond >= 1024ULL * 1024ULL) {
+        *minLimit = isHttp ? (256 * 1024) : (512 * 1024);
+    }
+
+    *maxLimit = isHttp ? (8 * 1024 * 1024) : (16 * 1024 * 1024);
+}
+
 size_t ComputeAdaptiveRingBytes(const PcmStreamDecoderContext* ctx,
                                int32_t sampleRate,
                                int32_t channelCount,
@@ -43,12 +75,7 @@ size_t ComputeAdaptiveRingBytes(const PcmStreamDecoderContext* ctx,
                                int64_t durationMs)
 {
     const bool isHttp = IsHttpSource(ctx->inputPathOrUri);
-    const int32_t bytesPerSample = GetPcmBytesPerSample(actualSampleFormat);
-    const uint64_t pcmBytesPerSecond =
-        (sampleRate > 0 && channelCount > 0)
-            ? static_cast<uint64_t>(sampleRate) * static_cast<uint64_t>(channelCount) *
-                  static_cast<uint64_t>(bytesPerSample)
-            : 0;
+    const uint64_t pcmBytesPerSecond = PcmBytesPerSecond(sampleRate, channelCount, actualSampleFormat);
     const uint64_t encodedBytesPerSecond = (ctx->bitrate > 0) ? ((static_cast<uint64_t>(ctx->bitrate) + 7ULL) / 8ULL) : 0;
 
     double targetSec = 1.35;
@@ -64,12 +91,9 @@ size_t ComputeAdaptiveRingBytes(const PcmStreamDecoderContext* ctx,
         targetSec = 1.50;
     }
 
-    size_t minLimit = isHttp ? (192 * 1024) : (256 * 1024);
-    if (pcmBytesPerSecond >= 1024ULL * 1024ULL) {
-        minLimit = isHttp ? (256 * 1024) : (512 * 1024);
-    }
-
-    size_t maxLimit = isHttp ? (8 * 1024 * 1024) : (16 * 1024 * 1024);
+    size_t minLimit = 0;
+    size_t maxLimit = 0;
+    GetAdaptiveRingLimits(ctx, pcmBytesPerSecond, &minLimit, &maxLimit);
 
     uint64_t desired = 0;
     if (pcmBytesPerSecond > 0) {
@@ -97,6 +121,145 @@ size_t ComputeAdaptiveRingBytes(const PcmStreamDecoderContext* ctx,
     return ringBytes;
 }
 
+// Convert samples straight into ring storage (no staging buffer). Handles the
+// wrap-around split, including a sample straddling the two segments when the
+// ring capacity is not a multiple of the sample size.
+// convert(first, count, out) writes samples [first, first + count) to out.
+template <typename Sample, typename Convert>
+bool PushConverted(audio::PcmRingBuffer& ring, size_t sampleCount, Convert convert,
+                   const std::atomic<bool>* cancelFlag)
+{
+    constexpr size_t kSampleBytes = sizeof(Sample);
+    constexpr size_t kBounceSamples = 256;
+    const size_t totalBytes = sampleCount * kSampleBytes;
+    size_t written = 0;
+    while (written < totalBytes) {
+        const audio::PcmRingBuffer::WriteRegions w = ring.ReserveWrite(totalBytes - written, cancelFlag);
+        const size_t n = w.Total();
+        if (n == 0) {
+            return false;
+        }
+        for (size_t seg = 0; seg < 2; seg++) {
+            uint8_t* dst = w.data[seg];
+            size_t left = w.len[seg];
+            while (left > 0) {
+                const size_t idx = written / kSampleBytes;
+                const size_t within = written % kSampleBytes;
+                if (within == 0 && left >= kSampleBytes) {
+                    size_t count = left / kSampleBytes;
+                    if (reinterpret_cast<uintptr_t>(dst) % alignof(Sample) == 0) {
+                        convert(idx, count, reinterpret_cast<Sample*>(dst));
+                    } else {
+                        // Misaligned segment: convert through a small aligned bounce buffer.
+                        count = std::min(count, kBounceSamples);
+                        Sample bounce[kBounceSamples];
+                        convert(idx, count, bounce);
+                        memcpy(dst, bounce, count * kSampleBytes);
+                    }
+                    dst += count * kSampleBytes;
+                    left -= count * kSampleBytes;
+                    written += count * kSampleBytes;
+                } else {
+                    Sample v;
+                    convert(idx, 1, &v);
+                    const size_t part = std::min(kSampleBytes - within, left);
+                    memcpy(dst, reinterpret_cast<const uint8_t*>(&v) + within, part);
+                    dst += part;
+                    left -= part;
+                    written += part;
+                }
+            }
+        }
+        ring.CommitWrite(n);
+    }
+    return true;
+}
+
+constexpr int64_t kCacheChunkFrames = 4096;
+constexpr int64_t kCacheReadAheadBytes = 1024 * 1024;
+// Same tail window DecodeToPcmStream keeps open for seeks after EOS.
+constexpr auto kCacheTailSeekWindow = std::chrono::milliseconds(2500);
+
+// Replay a cached decode through the callbacks DecodeToPcmStream would drive,
+// so fill/fillForWriteData/seekTo behave the same while no codec is created.
+// Seeks are exact: the target maps straight to a frame offset in the mapping.
+bool StreamFromCache(PcmStreamDecoderContext* ctx, const PcmDiskCache::Mapping& cached,
+                     const AudioDecoder::InfoCallback& infoCb, const AudioDecoder::ProgressCallback& progressCb,
+                     const AudioDecoder::PcmDataCallback& pcmCb, const AudioDecoder::SeekPollCallback& seekPollCb,
+                     const AudioDecoder::SeekAppliedCallback& seekAppliedCb, const AudioDecoder::EosCallback& eosCb)
+{
+    const PcmDiskCache::Index& idx = cached.GetIndex();
+    const int64_t chunkBytes = kCacheChunkFrames * idx.bytesPerFrame;
+    int64_t offset = 0;
+    int32_t lastPercent = -1;
+
+    auto pollSeek = [&]() {
+        int64_t targetMs = 0;
+        uint64_t seq = 0;
+        if (!seekPollCb(targetMs, seq)) {
+            return false;
+        }
+        if (targetMs < 0) {
+            targetMs = 0;
+        }
+        const int64_t frame = std::min(idx.frameCount, targetMs * idx.sampleRate / 1000);
+        offset = frame * idx.bytesPerFrame;
+        cached.WillNeed(offset, kCacheReadAheadBytes);
+        lastPercent = -1;
+        seekAppliedCb(seq, true, targetMs);
+        return true;
+    };
+
+    progressCb(0.0, 0, 0);
+    infoCb(idx.sampleRate, idx.channelCount, idx.sampleFormat, idx.durationMs);
+
+    while (!ctx->cancel.load()) {
+        if (pollSeek()) {
+            continue;
+        }
+
+        if (offset >= idx.dataBytes) {
+            if (!eosCb()) {
+                break;
+            }
+            bool resumed = false;
+            const auto deadline = std::chrono::steady_clock::now() + kCacheTailSeekWindow;
+            while (true) {
+                const uint64_t gen = ctx->wakeup.Generation();
+                if (ctx->cancel.load()) {
+                    break;
+                }
+                if (pollSeek()) {
+                    resumed = true;
+                    break;
+                }
+                if (!ctx->wakeup.WaitChangedUntil(gen, deadline, [ctx]() { return ctx->cancel.load(); })) {
+                    break;
+                }
+            }
+            if (!resumed) {
+                break;
+            }
+            continue;
+        }
+
+        const int64_t ptsMs = offset / idx.bytesPerFrame * 1000 / idx.sampleRate;
+        const int32_t percent = static_cast<int32_t>(offset * 100 / idx.dataBytes);
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            const double p = (idx.durationMs > 0) ? std::min(1.0, static_cast<double>(ptsMs) / idx.durationMs) : -1.0;
+            progressCb(p, ptsMs, idx.durationMs);
+        }
+
+        const int64_t n = std::min(chunkBytes, idx.dataBytes - offset);
+        if (!pcmCb(cached.Data() + offset, static_cast<size_t>(n), ptsMs)) {
+            break;
+        }
+        offset += n;
+    }
+    return true;
+}
+
 } // namespace
 
 // ============================================================================
@@ -262,6 +425,68 @@ void CallJsDecoderEvent(napi_env env, napi_value /*jsCb*/, void *context, void *
         napi_call_function(env, nullptr, cb, 1, argv, &result);
         break;
     }
+    case DecoderEventType::RingResize: {
+        if (ctx->onRingResizeRef == nullptr) {
+            break;
+        }
+        napi_value cb;
+        napi_get_reference_value(env, ctx->onRingResizeRef, &cb);
+        if (cb == nullptr) {
+            break;
+        }
+
+        napi_value arg;
+        napi_create_object(env, &arg);
+
+        napi_value v;
+        napi_create_double(env, static_cast<double>(payload->ringOldBytes), &v);
+        napi_set_named_property(env, arg, "oldBytes", v);
+        napi_create_double(env, static_cast<double>(payload->ringNewBytes), &v);
+        napi_set_named_property(env, arg, "newBytes", v);
+        napi_create_string_utf8(env, payload->ringReason, NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, arg, "reason", v);
+        napi_create_double(env, payload->ringFillPercent, &v);
+        napi_set_named_property(env, arg, "fillPercent", v);
+        napi_create_double(env, static_cast<double>(payload->ringUnderruns), &v);
+        napi_set_named_property(env, arg, "underruns", v);
+        napi_create_double(env, payload->ringReadLatencyMs, &v);
+        napi_set_named_property(env, arg, "readLatencyMs", v);
+
+        napi_value argv[1] = {arg};
+        napi_value result;
+        napi_call_function(env, nullptr, cb, 1, argv, &result);
+        break;
+    }
+    case DecoderEventType::TrackChange: {
+        if (ctx->onTrackChangeRef == nullptr) {
+            break;
+        }
+        napi_value cb;
+        napi_get_reference_value(env, ctx->onTrackChangeRef, &cb);
+        if (cb == nullptr) {
+            break;
+        }
+
+        napi_value arg;
+        napi_create_object(env, &arg);
+
+        napi_value v;
+        napi_create_double(env, static_cast<double>(payload->trackId), &v);
+        napi_set_named_property(env, arg, "trackId", v);
+        napi_create_string_utf8(env, payload->trackUri.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, arg, "uri", v);
+        napi_create_double(env, static_cast<double>(payload->durationMs), &v);
+        napi_set_named_property(env, arg, "durationMs", v);
+        napi_create_double(env, static_cast<double>(payload->trimStartFrames), &v);
+        napi_set_named_property(env, arg, "trimStartFrames", v);
+        napi_create_double(env, static_cast<double>(payload->trimEndFrames), &v);
+        napi_set_named_property(env, arg, "trimEndFrames", v);
+
+        napi_value argv[1] = {arg};
+        napi_value result;
+        napi_call_function(env, nullptr, cb, 1, argv, &result);
+        break;
+    }
     default:
         break;
     }
@@ -273,6 +498,13 @@ static uint64_t NowMs()
     return static_cast<uint64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
 }
 
+static int64_t ThreadCpuUs()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000LL + ts.tv_nsec / 1000;
+}
+
 static void QueueSeekEvent(PcmStreamDecoderContext *ctx, uint64_t seq, bool success, int32_t code,
                            const std::string &message, int64_t targetMs) {
     if (!ctx || ctx->eventTsfn == nullptr) {
@@ -290,6 +522,74 @@ static void QueueSeekEvent(PcmStreamDecoderContext *ctx, uint64_t seq, bool succ
     (void)napi_call_threadsafe_function(ctx->eventTsfn, payload, napi_tsfn_nonblocking);
 }
 
+static void QueueRingResizeEvent(PcmStreamDecoderContext *ctx, size_t oldBytes, size_t newBytes,
+                                 audio::RingResizePolicy::Reason reason, double fillPercent, uint64_t underruns,
+                                 int64_t readLatencyUs) {
+    if (!ctx || ctx->eventTsfn == nullptr) {
+        return;
+    }
+
+    auto *payload = new DecoderEventPayload();
+    payload->type = DecoderEventType::RingResize;
+    payload->ringOldBytes = oldBytes;
+    payload->ringNewBytes = newBytes;
+    payload->ringReason = audio::RingResizePolicy::ReasonName(reason);
+    payload->ringFillPercent = fillPercent;
+    payload->ringUnderruns = underruns;
+    payload->ringReadLatencyMs = static_cast<double>(readLatencyUs) / 1000.0;
+
+    (void)napi_call_threadsafe_function(ctx->eventTsfn, payload, napi_tsfn_nonblocking);
+}
+
+// Feed the resize policy from the decode thread (the ring producer) and apply its decision.
+// A shrink below the unread amount is kept pending and retried until the consumer drained it.
+static void MaybeResizeRing(PcmStreamDecoderContext *ctx, AudioDecoder *decoder) {
+    if (!ctx->adaptiveRing || !ctx->ring) {
+        return;
+    }
+    audio::PcmRingBuffer &ring = *ctx->ring;
+    const size_t oldBytes = ring.Capacity();
+    const audio::PcmRingBuffer::MemoryStats mem = ring.GetMemoryStats();
+    const double fillPercent =
+        (oldBytes > 0) ? 100.0 * static_cast<double>(mem.bufferedBytes) / static_cast<double>(oldBytes) : 0.0;
+    const uint64_t underruns = ctx->underrunCount.load();
+
+    if (ctx->ringPendingBytes != 0) {
+        if (ring.Resize(ctx->ringPendingBytes)) {
+            QueueRingResizeEvent(ctx, ctx->ringBytes, ctx->ringPendingBytes, ctx->ringPendingReason, fillPercent,
+                                 underruns, 0);
+            ctx->ringBytes = ctx->ringPendingBytes;
+            ctx->ringPendingBytes = 0;
+            ctx->ringResizeCount.fetch_add(1);
+            ctx->ringPolicy.Applied(NowMs());
+        }
+        return;
+    }
+
+    audio::RingResizePolicy::Sample sample;
+    sample.nowMs = NowMs();
+    sample.capacityBytes = oldBytes;
+    sample.bufferedBytes = mem.bufferedBytes;
+    sample.underruns = underruns;
+    sample.readLatencyUs = decoder ? decoder->TakeReadLatencyPeakUs() : 0;
+    sample.bytesPerSecond =
+        PcmBytesPerSecond(ctx->actualSampleRate, ctx->actualChannelCount, ctx->actualSampleFormat);
+
+    const audio::RingResizePolicy::Decision d = ctx->ringPolicy.Update(sample);
+    if (d.reason == audio::RingResizePolicy::Reason::None) {
+        return;
+    }
+    if (ring.Resize(d.newBytes)) {
+        QueueRingResizeEvent(ctx, oldBytes, d.newBytes, d.reason, fillPercent, underruns, sample.readLatencyUs);
+        ctx->ringBytes = d.newBytes;
+        ctx->ringResizeCount.fetch_add(1);
+        ctx->ringPolicy.Applied(sample.nowMs);
+    } else {
+        ctx->ringPendingBytes = d.newBytes;
+        ctx->ringPendingReason = d.reason;
+    }
+}
+
 static void QueueDrcMeterEvent(PcmStreamDecoderContext *ctx, double levelDb, double gainDb, double grDb) {
     if (!ctx || ctx->eventTsfn == nullptr) {
         return;
@@ -304,6 +604,610 @@ static void QueueDrcMeterEvent(PcmStreamDecoderContext *ctx, double levelDb, dou
     (void)napi_call_threadsafe_function(ctx->eventTsfn, payload, napi_tsfn_nonblocking);
 }
 
+// Second input of a crossfade: the start of the next track, in the same format as pcm,
+// mixed in from firstFrame of a windowFrames-long equal-power ramp.
+struct CrossfadeInput {
+    const uint8_t *pcm;
+    size_t firstFrame;
+    size_t windowFrames;
+};
+
+// Passthrough push (no DSP stage active), timed as the ring push stage.
+static bool PushPassthrough(PcmStreamDecoderContext *ctx, const uint8_t *pcm, size_t size) {
+    DecodeStats::Timer timer(&ctx->stats, DecodeStats::Stage::RingPush);
+    const bool ok = ctx->ring->Push(pcm, size, &ctx->cancel);
+    ctx->stats.ObserveRingHigh(ctx->ring->Available());
+    return ok;
+}
+
+// Adopt the latest published DSP parameter snapshots (decode thread). A stage whose
+// snapshot changed is re-applied to its processor before the next buffer.
+static void AcquireDspParams(PcmStreamDecoderContext *ctx) {
+    if (ctx->eqParams.Acquire()) {
+        ctx->eqParamsApplied = false;
+    }
+    if (ctx->drcParams.Acquire()) {
+        ctx->drcParamsApplied = false;
+    }
+    if (ctx->pitchParams.Acquire()) {
+        ctx->pitchParamsApplied = false;
+    }
+    (void)ctx->channelVolumeParams.Acquire();
+}
+
+// Run decoded PCM through the float DSP chain (or straight through when no stage is
+// active) into the ring. A crossfade input is mixed into the chain's scratch before
+// any stage, so both tracks share one EQ/DRC/limiter pass; the incoming side is
+// converted into crossfadeScratchF.
+static bool ProcessPcm(PcmStreamDecoderContext *ctx, const uint8_t *pcm, size_t size, const CrossfadeInput *mix) {
+    AcquireDspParams(ctx);
+    const EqParams &eqParams = ctx->eqParams.Current();
+    const DrcParams &drcParams = ctx->drcParams.Current();
+    const PitchParams &pitchParams = ctx->pitchParams.Current();
+
+    const bool needEq = eqParams.enabled && ctx->eq.IsReady();
+
+    const bool needDrc = drcParams.enabled && ctx->drc.IsReady();
+
+    const bool needPitch = pitchParams.enabled && ctx->pitchShifter.IsReady() && pitchParams.semitones != 0;
+
+    // Per-channel volume compensation.
+    const float volL = ctx->channelVolumeParams.Current().left;
+    const float volR = ctx->channelVolumeParams.Current().right;
+
+    const int32_t ch = ctx->actualChannelCount;
+
+    const bool chanVolSupported = (ch == 1 || ch == 2);
+    const bool needChanVol = chanVolSupported &&
+                             ((ch == 1 && volL != 1.0f) || (ch == 2 && (volL != 1.0f || volR != 1.0f)));
+
+    // A crossfade always goes through the chain: the mix has to pass the limiter.
+    const bool needDsp = needEq || needChanVol || needDrc || needPitch || mix != nullptr;
+
+    // Packed S24LE input is widened to S32LE (value << 8): straight into ring storage
+    // on the passthrough path, or by the chain's source when DSP is active.
+    const bool packed24 = (ctx->sourceSampleFormat == 2);
+    size_t sampleCount = 0;
+    if (packed24) {
+        const size_t sampleCount24 = size / 3;
+        const size_t frameCount24 = (ch > 0) ? (sampleCount24 / static_cast<size_t>(ch)) : 0;
+        sampleCount = frameCount24 * static_cast<size_t>(ch);
+        if (frameCount24 == 0) {
+            return true;
+        }
+
+        if (ctx->s32GlobalMaxAbs < (1LL << 30)) {
+            ctx->s32GlobalMaxAbs = (1LL << 30);
+        }
+
+        if (!needDsp) {
+            DecodeStats::Timer timer(&ctx->stats, DecodeStats::Stage::RingPush);
+            const bool ok = PushConverted<int32_t>(*ctx->ring, sampleCount, [pcm](size_t i, size_t k, int32_t* out) {
+                pcm_convert::S24ToS32(pcm + i * pcm_convert::kS24Bytes, out, k);
+            }, &ctx->cancel);
+            ctx->stats.ObserveRingHigh(ctx->ring->Available());
+            return ok;
+        }
+    }
+
+    const int32_t sf = ctx->actualSampleFormat;
+    const int32_t bytesPerSample = (sf == 4) ? 4 : ((sf == 3) ? 4 : 2);  // F32LE=4, S32LE=4, S16LE=2
+    if (bytesPerSample != 2 && bytesPerSample != 4) {
+        return PushPassthrough(ctx, pcm, size);
+    }
+
+    if (!needDsp) {
+        return PushPassthrough(ctx, pcm, size);
+    }
+
+    if (!packed24) {
+        sampleCount = size / static_cast<size_t>(bytesPerSample);
+    }
+    const size_t frameCount = sampleCount / static_cast<size_t>(ch);
+    if (frameCount == 0) {
+        return PushPassthrough(ctx, pcm, size);
+    }
+
+    if (needEq) {
+        if (!ctx->eqParamsApplied) {
+            ctx->eq.SetGainsDbStereo(eqParams.gainsDb[0], eqParams.gainsDb[1]);
+            ctx->eqParamsApplied = true;
+        }
+        ctx->eq.SetEnabled(true);
+    } else {
+        ctx->eq.SetEnabled(false);
+    }
+
+    // Apply DRC params (lazy) if enabled.
+    if (needDrc) {
+        if (!ctx->drcParamsApplied) {
+            ctx->drc.SetParams(drcParams.thresholdDb, drcParams.ratio, drcParams.attackMs, drcParams.releaseMs,
+                               drcParams.makeupDb);
+            ctx->drcParamsApplied = true;
+        }
+        ctx->drc.SetEnabled(true);
+    } else {
+        ctx->drc.SetEnabled(false);
+    }
+
+    if (needPitch) {
+        if (!ctx->pitchParamsApplied) {
+            ctx->pitchShifter.SetSemitones(pitchParams.semitones);
+            ctx->pitchParamsApplied = true;
+        }
+        ctx->pitchShifter.SetEnabled(true);
+    } else {
+        ctx->pitchShifter.SetEnabled(false);
+    }
+
+    // Float DSP pipeline to avoid hard clipping artifacts.
+    float norm = 1.0f;
+    float denorm = 1.0f;
+    if (bytesPerSample == 2) {
+        // S16LE
+        norm = 1.0f / 32768.0f;
+        denorm = 32768.0f;
+    } else if (sf == 4) {
+        // F32LE: already in float format, no denorm needed
+    } else {
+        // S32LE: use global persistent maxAbs for stable normalization.
+        // This prevents "volume rollercoaster" when source data scale is ambiguous.
+        // Packed S24 already pinned maxAbs to the Q31 range above.
+        if (!packed24) {
+            // Update global maxAbs monotonically (only increases, never decreases).
+            const int32_t* in = reinterpret_cast<const int32_t*>(pcm);
+            ctx->s32GlobalMaxAbs = pcm_convert::AbsMaxS32(in, sampleCount, ctx->s32GlobalMaxAbs);
+            if (mix != nullptr) {
+                const int32_t* next = reinterpret_cast<const int32_t*>(mix->pcm);
+                ctx->s32GlobalMaxAbs = pcm_convert::AbsMaxS32(next, sampleCount, ctx->s32GlobalMaxAbs);
+            }
+        }
+
+        // Choose normalization based on global maxAbs (stable across entire track).
+        // S32LE can come in different effective scales:
+        // - 16-bit scale: abs <= ~32768
+        // - 24-bit scale: abs <= ~8388608 (2^23)
+        // - Q31 scale:    abs up to ~2^31
+        if (ctx->s32GlobalMaxAbs <= (1LL << 20)) {
+            norm = 1.0f / 32768.0f;
+        } else if (ctx->s32GlobalMaxAbs <= (1LL << 27)) {
+            norm = 1.0f / 8388608.0f;
+        } else {
+            norm = 1.0f / 2147483648.0f;
+        }
+        denorm = 1.0f / norm;
+    }
+
+    // EQ preamp keeps headroom for positive band gains; applied while loading the scratch.
+    const float preamp = needEq ? eqParams.preamp : 1.0f;
+
+    uint32_t stages = DspChain::kStageLimiter;
+    if (needEq) stages |= DspChain::kStageEq;
+    if (needPitch) stages |= DspChain::kStagePitch;
+    if (needChanVol) stages |= DspChain::kStageChannelVolume;
+    if (needDrc) stages |= DspChain::kStageDrc;
+    ctx->dspChain.Configure(ch, stages, volL, volR);
+
+    const size_t chs = static_cast<size_t>(ch);
+    auto load = [packed24, bytesPerSample, sf, norm, preamp, chs](const uint8_t* src, float* f, size_t n) {
+        const size_t count = n * chs;
+        if (packed24) {
+            pcm_convert::S24ToFloat(src, f, count, norm, preamp);
+        } else if (bytesPerSample == 2) {
+            pcm_convert::S16ToFloat(reinterpret_cast<const int16_t*>(src), f, count, norm, preamp);
+        } else if (sf == 4) {
+            pcm_convert::F32ToFloat(reinterpret_cast<const float*>(src), f, count, preamp);
+        } else {
+            pcm_convert::S32ToFloat(reinterpret_cast<const int32_t*>(src), f, count, norm, preamp);
+        }
+    };
+    auto source = [ctx, pcm, mix, chs, &load](float* f, size_t n) {
+        load(pcm, f, n);
+        if (mix != nullptr) {
+            std::vector<float>& next = ctx->crossfadeScratchF;
+            if (next.size() < n * chs) {
+                next.resize(n * chs);
+            }
+            load(mix->pcm, next.data(), n);
+            PcmCrossfade::MixTile(f, next.data(), n, chs, mix->firstFrame, mix->windowFrames);
+        }
+    };
+
+    auto sink = [ctx, bytesPerSample, sf, denorm, chs](const float* f, size_t n) {
+        const size_t count = n * chs;
+        if (bytesPerSample == 2) {
+            // S16LE output: convert straight into ring storage
+            return PushConverted<int16_t>(*ctx->ring, count, [f, denorm](size_t i, size_t k, int16_t* out) {
+                pcm_convert::FloatToS16(f + i, out, k, denorm);
+            }, &ctx->cancel);
+        }
+
+        if (sf == 4) {
+            // F32LE output: the scratch is already the final format
+            return ctx->ring->Push(reinterpret_cast<const uint8_t *>(f), count * sizeof(float), &ctx->cancel);
+        }
+
+        // S32LE output: convert straight into ring storage
+        return PushConverted<int32_t>(*ctx->ring, count, [f, denorm](size_t i, size_t k, int32_t* out) {
+            pcm_convert::FloatToS32(f + i, out, k, denorm);
+        }, &ctx->cancel);
+    };
+
+    const bool pushed = ctx->dspChain.Run(frameCount, source, sink);
+    ctx->stats.ObserveRingHigh(ctx->ring->Available());
+
+    if (needDrc) {
+        const uint64_t now = NowMs();
+        if ((now - ctx->drcMeterLastEmitMs) >= 100) {
+            ctx->drcMeterLastEmitMs = now;
+            QueueDrcMeterEvent(ctx,
+                              static_cast<double>(ctx->drc.GetLastLevelDb()),
+                              static_cast<double>(ctx->drc.GetLastGainDb()),
+                              static_cast<double>(ctx->drc.GetLastGrDb()));
+        }
+    }
+
+    return pushed;
+}
+
+// ============================================================================
+// 播放队列（gapless）
+// ============================================================================
+
+static bool HasNextTrack(PcmStreamDecoderContext *ctx) {
+    std::lock_guard<std::mutex> lock(ctx->queueMutex);
+    return ctx->preroll != nullptr || !ctx->queue.empty();
+}
+
+// Pre-decoder for track, with the codec set up for the current output format so the PCM
+// splices as is. Called with queueMutex held.
+static std::unique_ptr<PrerollDecoder> StartPrerollLocked(PcmStreamDecoderContext *ctx, const QueuedTrack &track) {
+    PrerollDecoder::Params params;
+    params.id = track.id;
+    params.uri = track.uri;
+    params.sampleRate = ctx->actualSampleRate;
+    params.channelCount = ctx->actualChannelCount;
+    params.bitrate = ctx->bitrate;
+    params.sampleFormat = ctx->sourceSampleFormat;
+    params.stageBytes = static_cast<size_t>(
+        PcmBytesPerSecond(ctx->actualSampleRate, ctx->actualChannelCount, ctx->sourceSampleFormat) *
+        kPrerollStageMs / 1000);
+    params.gaplessTrim = ctx->gaplessTrim;
+    params.delayFrames = track.delayFrames;
+    params.paddingFrames = track.paddingFrames;
+    auto preroll = std::make_unique<PrerollDecoder>(params, &ctx->wakeup);
+    preroll->Decoder()->SetStats(&ctx->stats);
+    preroll->Start();
+    return preroll;
+}
+
+static QueuedTrack TrackOf(const PrerollDecoder::Params &params) {
+    QueuedTrack track;
+    track.id = params.id;
+    track.uri = params.uri;
+    track.delayFrames = params.delayFrames;
+    track.paddingFrames = params.paddingFrames;
+    return track;
+}
+
+static QueuedTrack TrackOf(const TrackChangeInfo &change) {
+    QueuedTrack track;
+    track.id = change.id;
+    track.uri = change.uri;
+    track.delayFrames = change.delayFrames;
+    track.paddingFrames = change.paddingFrames;
+    return track;
+}
+
+// Start pre-decoding the next queued track once the stream format is known. Called by the
+// ring producer. Not while a rewind is pending: the queue is about to be reordered.
+static void MaybeStartPreroll(PcmStreamDecoderContext *ctx) {
+    if (ctx->queuedCount.load() == 0 || ctx->actualSampleRate <= 0 || ctx->rewindRequested.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ctx->queueMutex);
+    if (ctx->preroll != nullptr || ctx->queue.empty()) {
+        return;
+    }
+    QueuedTrack track = std::move(ctx->queue.front());
+    ctx->queue.pop_front();
+    ctx->queuedCount.store(static_cast<uint32_t>(ctx->queue.size()));
+    ctx->preroll = StartPrerollLocked(ctx, track);
+}
+
+// JS thread, for a seek the ring cannot serve: while tracks spliced behind the playing one
+// are still ahead of the read cursor, the target lies in the playing track. Withdraw them
+// from the ring (clearing it) and leave the rest to the decode thread (TakeRewind); the seek
+// then takes the usual path. False if the decode thread has already exited, so nothing could
+// decode the playing track again; the ring is left as it was.
+static bool RequestRewind(PcmStreamDecoderContext *ctx) {
+    if (!ctx->ring || !ctx->ring->HasPendingSegment()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(ctx->queueMutex);
+    if (ctx->queueClosed) {
+        return false;
+    }
+    auto &changes = ctx->pendingTrackChanges;
+    const size_t dropped = std::min(ctx->ring->ClearPendingSegments(), changes.size());
+    if (dropped == 0) {
+        return true;
+    }
+    // The playing track is the last one the reader reached, reported or not.
+    const size_t reached = changes.size() - dropped;
+    ctx->rewindTrack = (reached > 0) ? TrackOf(changes[reached - 1]) : ctx->playingTrack;
+    for (size_t i = reached; i < changes.size(); i++) {
+        ctx->rewindRequeue.push_back(TrackOf(changes[i]));
+    }
+    changes.erase(changes.begin() + static_cast<std::ptrdiff_t>(reached), changes.end());
+    ctx->rewindRequested.store(true);
+    OH_LOG_INFO(LOG_APP, "Seek back into track %{public}llu: %{public}zu spliced track(s) withdrawn",
+                (unsigned long long)ctx->rewindTrack.id, dropped);
+    return true;
+}
+
+// Decode thread, with no pre-decoder feeding the stream: serve a pending rewind. The withdrawn
+// tracks go back to the head of the queue, followed by the one being pre-decoded, and the
+// returned pre-decoder decodes the playing track again; it continues the current segment and
+// picks up the seek like any active decoder. nullptr when no rewind is pending.
+static std::unique_ptr<PrerollDecoder> TakeRewind(PcmStreamDecoderContext *ctx) {
+    if (!ctx->rewindRequested.load()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(ctx->queueMutex);
+    std::deque<QueuedTrack> requeue;
+    requeue.swap(ctx->rewindRequeue);
+    if (ctx->preroll) {
+        requeue.push_back(TrackOf(ctx->preroll->GetParams()));
+        ctx->preroll->Cancel();
+        ctx->retiredPrerolls.push_back(std::move(ctx->preroll));
+    }
+    ctx->queue.insert(ctx->queue.begin(), std::make_move_iterator(requeue.begin()),
+                      std::make_move_iterator(requeue.end()));
+    ctx->queuedCount.store(static_cast<uint32_t>(ctx->queue.size()));
+    ctx->rewindRequested.store(false);
+    return StartPrerollLocked(ctx, ctx->rewindTrack);
+}
+
+static void QueueTrackChangeEvent(PcmStreamDecoderContext *ctx, const TrackChangeInfo &change) {
+    if (!ctx || ctx->eventTsfn == nullptr) {
+        return;
+    }
+
+    auto *payload = new DecoderEventPayload();
+    payload->type = DecoderEventType::TrackChange;
+    payload->trackId = change.id;
+    payload->trackUri = change.uri;
+    payload->durationMs = change.durationMs;
+    payload->trimStartFrames = change.trimStartFrames;
+    payload->trimEndFrames = change.trimEndFrames;
+
+    (void)napi_call_threadsafe_function(ctx->eventTsfn, payload, napi_tsfn_nonblocking);
+}
+
+// JS thread: report the track starts the read cursor has passed (or a seek dropped).
+static void PollTrackChanges(PcmStreamDecoderContext *ctx) {
+    if (!ctx->ring) {
+        return;
+    }
+    const uint64_t count = ctx->ring->GetSegmentCount();
+    while (ctx->trackChangesReported < count) {
+        TrackChangeInfo change;
+        {
+            std::lock_guard<std::mutex> lock(ctx->queueMutex);
+            if (ctx->pendingTrackChanges.empty()) {
+                break;
+            }
+            change = std::move(ctx->pendingTrackChanges.front());
+            ctx->pendingTrackChanges.pop_front();
+            ctx->playingTrack = TrackOf(change);
+        }
+        ctx->trackChangesReported++;
+        QueueTrackChangeEvent(ctx, change);
+    }
+}
+
+// ============================================================================
+// 交叉淡入淡出
+// ============================================================================
+
+// Play out the withheld tail of the current track unmixed.
+static void FlushCrossfadeTail(PcmStreamDecoderContext *ctx) {
+    const uint8_t *data = nullptr;
+    size_t n = 0;
+    while ((n = ctx->crossfade.PopTail(&data)) > 0) {
+        if (!ProcessPcm(ctx, data, n, nullptr)) {
+            ctx->crossfade.Clear();
+            return;
+        }
+    }
+}
+
+// Ring producer: size the window for the current format after setCrossfadeMs or a track
+// with another source format.
+static void ApplyCrossfadeWindow(PcmStreamDecoderContext *ctx) {
+    const int32_t ms = ctx->crossfadeMs.load();
+    const size_t frameBytes = static_cast<size_t>(std::max(ctx->actualChannelCount, 0)) *
+                              static_cast<size_t>(GetPcmBytesPerSample(ctx->sourceSampleFormat));
+    if (ms == ctx->crossfadeAppliedMs && frameBytes == ctx->crossfade.FrameBytes()) {
+        return;
+    }
+    FlushCrossfadeTail(ctx);
+    const size_t frames = (ms > 0 && ctx->actualSampleRate > 0)
+                              ? static_cast<size_t>(static_cast<int64_t>(ctx->actualSampleRate) * ms / 1000)
+                              : 0;
+    ctx->crossfade.Configure(frameBytes, frames);
+    ctx->crossfadeAppliedMs = ms;
+}
+
+// Decode thread: mix the withheld tail of the ended track with the start of the next one,
+// whose pre-decoder keeps running on its own thread meanwhile. The decode-thread CPU time
+// spent on the overlap (conversion, mix, DSP) is recorded for getBufferStats().
+static void CrossfadeIntoNext(PcmStreamDecoderContext *ctx, PrerollDecoder *next) {
+    const size_t frameBytes = ctx->crossfade.FrameBytes();
+    const size_t windowFrames = ctx->crossfade.TailBytes() / frameBytes;
+    const int64_t cpuStartUs = ThreadCpuUs();
+    size_t pos = 0;
+    const uint8_t *out = nullptr;
+    size_t n = 0;
+    while (!ctx->cancel.load() && (n = ctx->crossfade.PopTail(&out)) > 0) {
+        uint8_t *in = ctx->crossfade.IncomingChunk();
+        const size_t got = next->ReadStaged(in, n, &ctx->cancel);
+        if (got < n) {
+            // The next track is shorter than the window.
+            memset(in + got, 0, n - got);
+        }
+        // A seek requested meanwhile replaces the ring contents anyway.
+        if (ctx->seekSeq_.load() != ctx->seekHandledSeq_.load()) {
+            ctx->crossfade.Clear();
+            break;
+        }
+        const CrossfadeInput mix{in, pos, windowFrames};
+        if (!ProcessPcm(ctx, out, n, &mix)) {
+            ctx->crossfade.Clear();
+            break;
+        }
+        pos += n / frameBytes;
+    }
+
+    const int64_t cpuUs = ThreadCpuUs() - cpuStartUs;
+    const int64_t audioMs =
+        (ctx->actualSampleRate > 0) ? static_cast<int64_t>(pos) * 1000 / ctx->actualSampleRate : 0;
+    ctx->crossfadeCount.fetch_add(1);
+    ctx->crossfadeLastAudioMs.store(audioMs);
+    ctx->crossfadeLastCpuUs.store(cpuUs);
+    OH_LOG_INFO(LOG_APP, "Crossfade of %{public}lld ms took %{public}lld us decode-thread CPU", (long long)audioMs,
+                (long long)cpuUs);
+}
+
+// Decode thread, after the current track ended: splice each queued track into the ring
+// right behind the previous one. Staged PCM is replayed through the stream callbacks
+// here, then the pre-decoder's own thread keeps feeding them; this thread only waits.
+// A seek back into an earlier track (RequestRewind) stops the spliced decoder and decodes
+// that track again before the queue goes on. Returns the result of the last decode.
+static bool PlayQueuedTracks(PcmStreamDecoderContext *ctx, const PrerollDecoder::Callbacks &callbacks,
+                             AudioDecoder **activeDecoder, bool ok) {
+    while (!ctx->cancel.load() && ctx->ring) {
+        MaybeStartPreroll(ctx);
+        std::unique_ptr<PrerollDecoder> next = TakeRewind(ctx);
+        const bool resume = next != nullptr;
+        {
+            std::lock_guard<std::mutex> lock(ctx->queueMutex);
+            auto &retired = ctx->retiredPrerolls;
+            retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                         [](const std::unique_ptr<PrerollDecoder> &p) { return p->IsFinished(); }),
+                          retired.end());
+            if (!resume) {
+                next = std::move(ctx->preroll);
+            }
+            // Closed together with the check, so a rewind is never requested after the last look.
+            if (!next && !ctx->rewindRequested.load()) {
+                ctx->queueClosed = true;
+            }
+        }
+        if (!next) {
+            if (ctx->rewindRequested.load()) {
+                continue;
+            }
+            break;
+        }
+        const PrerollDecoder::Params &params = next->GetParams();
+
+        std::string stage;
+        int32_t code = 0;
+        std::string message;
+        PrerollDecoder::Info info;
+        if (!next->WaitInfo(&info, &ctx->cancel)) {
+            next->Cancel();
+            ok = next->Join();
+            if (next->TakeStagedError(&stage, &code, &message)) {
+                callbacks.errorCb(stage, code, message);
+            }
+            continue;
+        }
+        const int32_t outFormat = (info.sampleFormat == 2) ? 3 : info.sampleFormat;
+        if (info.sampleRate != ctx->actualSampleRate || info.channelCount != ctx->actualChannelCount ||
+            outFormat != ctx->actualSampleFormat) {
+            OH_LOG_ERROR(LOG_APP, "Queued track %{public}s skipped: %{public}d Hz/%{public}d ch/fmt %{public}d",
+                         params.uri.c_str(), info.sampleRate, info.channelCount, info.sampleFormat);
+            next->Cancel();
+            (void)next->Join();
+            callbacks.errorCb("queue_format", -1, "Queued track output format differs from the stream: " + params.uri);
+            continue;
+        }
+
+        // Both sides of a crossfade are converted with one source format. A resumed track
+        // starts at the seek target, which replaces the held tail.
+        const bool crossfade =
+            !resume && ctx->crossfade.TailBytes() > 0 && info.sampleFormat == ctx->sourceSampleFormat;
+        if (resume) {
+            ctx->crossfade.Clear();
+        } else if (!crossfade) {
+            FlushCrossfadeTail(ctx);
+        }
+
+        ctx->sourceSampleFormat = info.sampleFormat;
+        if (!resume) {
+            // Spliced under queueMutex: RequestRewind sees the segment and its change together.
+            std::lock_guard<std::mutex> lock(ctx->queueMutex);
+            if (ctx->rewindRequested.load()) {
+                // A seek went back into the playing track first; this one follows the withdrawn.
+                ctx->rewindRequeue.push_back(TrackOf(params));
+                next->Cancel();
+                ctx->retiredPrerolls.push_back(std::move(next));
+                continue;
+            }
+            TrackChangeInfo change;
+            change.id = params.id;
+            change.uri = params.uri;
+            change.durationMs = info.durationMs;
+            change.trimStartFrames = next->TrimStartFrames();
+            change.trimEndFrames = next->TrimEndFrames();
+            change.delayFrames = params.delayFrames;
+            change.paddingFrames = params.paddingFrames;
+            ctx->pendingTrackChanges.push_back(std::move(change));
+            ctx->ring->ResetEos();
+            ctx->ring->MarkSegmentStart();
+            OH_LOG_INFO(LOG_APP, "Gapless switch to track %{public}llu: %{public}s", (unsigned long long)params.id,
+                        params.uri.c_str());
+        } else {
+            OH_LOG_INFO(LOG_APP, "Decoding track %{public}llu again for a seek: %{public}s",
+                        (unsigned long long)params.id, params.uri.c_str());
+        }
+        *activeDecoder = next->Decoder();
+        if (crossfade) {
+            CrossfadeIntoNext(ctx, next.get());
+        }
+
+        if (next->Activate(callbacks)) {
+            ctx->wakeup.Wait([ctx, &next]() {
+                return next->IsFinished() || ctx->cancel.load() || ctx->rewindRequested.load();
+            });
+        }
+        // A rewind withdrew this track; its end, errors included, no longer matter.
+        const bool rewound = ctx->rewindRequested.load();
+        if (ctx->cancel.load() || rewound) {
+            next->Cancel();
+        }
+        ok = next->Join();
+        *activeDecoder = nullptr;
+        if (rewound) {
+            continue;
+        }
+        if (next->TakeStagedError(&stage, &code, &message)) {
+            callbacks.errorCb(stage, code, message);
+        }
+        // Ended while still staged: its EOS was not forwarded yet.
+        if (next->EndedWhileStaged() && !ctx->cancel.load()) {
+            (void)callbacks.eosCb();
+        }
+    }
+    if (!ctx->cancel.load() && ctx->ring) {
+        FlushCrossfadeTail(ctx);
+    }
+    return ok;
+}
+
 // ============================================================================
 // 流式解码器方法
 // ============================================================================
@@ -337,11 +1241,14 @@ napi_value PcmDecoderFill(napi_env env, napi_callback_info info) {
 
     size_t n = 0;
     if (ctx->ring) {
+        DecodeStats::Timer fillTimer(&ctx->stats, DecodeStats::Stage::Fill);
+        ctx->stats.ObserveRingLow(ctx->ring->Available());
         n = ctx->ring->Read(reinterpret_cast<uint8_t *>(buf), len);
         // Only pad zeros when EOS is marked, not during normal playback
         if (n < len && ctx->ring->IsEosMarked()) {
             memset(reinterpret_cast<uint8_t *>(buf) + n, 0, len - n);
         }
+        PollTrackChanges(ctx);
     }
 
     napi_value out;
@@ -396,6 +1303,9 @@ napi_value PcmDecoderFillForWriteData(napi_env env, napi_callback_info info) {
         return zero;
     }
 
+    // Report track starts passed by the previous reads.
+    PollTrackChanges(ctx);
+
     // Check if decoder is paused - don't block in paused state
     if (ctx->decoderPaused.load()) {
         napi_value zero;
@@ -403,12 +1313,17 @@ napi_value PcmDecoderFillForWriteData(napi_env env, napi_callback_info info) {
         return zero;
     }
 
+    DecodeStats::Timer fillTimer(&ctx->stats, DecodeStats::Stage::Fill);
+    DecodeTrace::Scope trace("fillForWriteData", "bytes", static_cast<int64_t>(len));
+
     // Fast path: data already available
     const size_t avail = ctx->ring->Available();
+    ctx->stats.ObserveRingLow(avail);
     if (avail >= len) {
-        (void)ctx->ring->Read(reinterpret_cast<uint8_t *>(buf), len);
+        const size_t n = ctx->ring->Read(reinterpret_cast<uint8_t *>(buf), len);
         napi_value out;
-        napi_create_int32(env, static_cast<int32_t>(len), &out);
+        // A concurrent seek may clear the ring mid-read; report INVALID in that case.
+        napi_create_int32(env, (n >= len) ? static_cast<int32_t>(len) : 0, &out);
         return out;
     }
 
@@ -455,7 +1370,11 @@ napi_value PcmDecoderFillForWriteData(napi_env env, napi_callback_info info) {
         }
     }
 
-    const size_t n = ctx->ring->ReadBlocking(reinterpret_cast<uint8_t *>(buf), len, waitTimeoutMs);
+    size_t n = 0;
+    {
+        DecodeTrace::Scope readTrace("ReadBlocking", "timeoutMs", waitTimeoutMs);
+        n = ctx->ring->ReadBlocking(reinterpret_cast<uint8_t *>(buf), len, waitTimeoutMs);
+    }
     
     if (n >= len) {
         napi_value out;
@@ -463,7 +1382,13 @@ napi_value PcmDecoderFillForWriteData(napi_env env, napi_callback_info info) {
         return out;
     }
     
-    // Timeout or partial read - return 0 to signal INVALID
+    // Timeout or partial read - return 0 to signal INVALID.
+    // Count it as an underrun for ring sizing unless a seek just emptied the ring.
+    if (!ctx->ring->IsEosMarked() && ctx->seekSeq_.load() == ctx->seekHandledSeq_.load()) {
+        ctx->underrunCount.fetch_add(1);
+        ctx->stats.AddUnderrun();
+        DecodeTrace::Instant("underrun", "availableBytes", static_cast<int64_t>(ctx->ring->Available()));
+    }
     napi_value zero;
     napi_create_int32(env, 0, &zero);
     return zero;
@@ -476,6 +1401,7 @@ napi_value PcmDecoderClose(napi_env env, napi_callback_info info) {
     auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
     if (ctx) {
         ctx->cancel.store(true);
+        ctx->wakeup.Notify();
         if (ctx->ring) {
             ctx->ring->Cancel();
         }
@@ -485,6 +1411,19 @@ napi_value PcmDecoderClose(napi_env env, napi_callback_info info) {
     return undef;
 }
 
+// Publish an EQ snapshot (JS thread), deriving the preamp that keeps headroom for
+// positive band gains.
+static void PublishEqParams(PcmStreamDecoderContext *ctx, EqParams params) {
+    float maxPosGainDb = 0.0f;
+    for (const auto &gains : params.gainsDb) {
+        for (float g : gains) {
+            maxPosGainDb = std::max(maxPosGainDb, g);
+        }
+    }
+    params.preamp = (maxPosGainDb > 0.0f) ? std::pow(10.0f, -(maxPosGainDb + 2.0f) / 20.0f) : 1.0f;
+    ctx->eqParams.Publish(params);
+}
+
 napi_value PcmDecoderSetEqEnabled(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value args[1] = {nullptr};
@@ -498,10 +1437,9 @@ napi_value PcmDecoderSetEqEnabled(napi_env env, napi_callback_info info) {
 
     bool enabled = false;
     napi_get_value_bool(env, args[0], &enabled);
-    ctx->eqEnabled.store(enabled);
-
-    // Force worker to re-apply config.
-    ctx->eqVersion.fetch_add(1);
+    EqParams params = ctx->eqParams.Published();
+    params.enabled = enabled;
+    PublishEqParams(ctx, params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -533,6 +1471,7 @@ napi_value PcmDecoderSetEqGains(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
+    EqParams params = ctx->eqParams.Published();
     for (uint32_t i = 0; i < len; i++) {
         napi_value v;
         napi_get_element(env, args[0], i, &v);
@@ -553,12 +1492,11 @@ napi_value PcmDecoderSetEqGains(napi_env env, napi_callback_info info) {
             gainDb = -24.0;
         }
 
-        const int32_t gain100 = static_cast<int32_t>(std::lround(gainDb * 100.0));
-        ctx->eqGainsDb100Stereo[0][i].store(gain100);
-        ctx->eqGainsDb100Stereo[1][i].store(gain100);
+        params.gainsDb[0][i] = static_cast<float>(gainDb);
+        params.gainsDb[1][i] = static_cast<float>(gainDb);
     }
 
-    ctx->eqVersion.fetch_add(1);
+    PublishEqParams(ctx, params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -582,8 +1520,9 @@ napi_value PcmDecoderSetDrcEnabled(napi_env env, napi_callback_info info) {
 
     bool enabled = false;
     napi_get_value_bool(env, args[0], &enabled);
-    ctx->drcEnabled.store(enabled);
-    ctx->drcVersion.fetch_add(1);
+    DrcParams params = ctx->drcParams.Published();
+    params.enabled = enabled;
+    ctx->drcParams.Publish(params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -637,13 +1576,13 @@ napi_value PcmDecoderSetDrcParams(napi_env env, napi_callback_info info) {
     if (makeupDb < -12.0) makeupDb = -12.0;
     if (makeupDb > 24.0) makeupDb = 24.0;
 
-    ctx->drcThresholdDb100.store(static_cast<int32_t>(std::lround(thresholdDb * 100.0)));
-    ctx->drcRatio1000.store(static_cast<int32_t>(std::lround(ratio * 1000.0)));
-    ctx->drcAttackMs100.store(static_cast<int32_t>(std::lround(attackMs * 100.0)));
-    ctx->drcReleaseMs100.store(static_cast<int32_t>(std::lround(releaseMs * 100.0)));
-    ctx->drcMakeupDb100.store(static_cast<int32_t>(std::lround(makeupDb * 100.0)));
-
-    ctx->drcVersion.fetch_add(1);
+    DrcParams params = ctx->drcParams.Published();
+    params.thresholdDb = static_cast<float>(thresholdDb);
+    params.ratio = static_cast<float>(ratio);
+    params.attackMs = static_cast<float>(attackMs);
+    params.releaseMs = static_cast<float>(releaseMs);
+    params.makeupDb = static_cast<float>(makeupDb);
+    ctx->drcParams.Publish(params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -663,12 +1602,9 @@ napi_value PcmDecoderSetPitchEnabled(napi_env env, napi_callback_info info) {
 
     bool enabled = false;
     napi_get_value_bool(env, args[0], &enabled);
-    ctx->pitchEnabled.store(enabled);
-    ctx->pitchVersion.fetch_add(1);
-
-    if (ctx->pitchShifter.IsReady()) {
-        ctx->pitchShifter.SetEnabled(enabled);
-    }
+    PitchParams params = ctx->pitchParams.Published();
+    params.enabled = enabled;
+    ctx->pitchParams.Publish(params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -704,12 +1640,63 @@ napi_value PcmDecoderSetPitchSemitones(napi_env env, napi_callback_info info) {
         semitones = PcmPitchShifter::kMaxSemitones;
     }
 
-    ctx->pitchSemitones.store(semitones);
-    ctx->pitchVersion.fetch_add(1);
+    PitchParams params = ctx->pitchParams.Published();
+    params.semitones = semitones;
+    ctx->pitchParams.Publish(params);
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+napi_value PcmDecoderSetWatermarks(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr, nullptr};
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (!ctx || argc < 2) {
+        napi_throw_error(env, nullptr, "setWatermarks(highPercent, lowPercent) requires 2 arguments");
+        return nullptr;
+    }
+
+    int32_t high = 0;
+    int32_t low = 0;
+    if (napi_get_value_int32(env, args[0], &high) != napi_ok || napi_get_value_int32(env, args[1], &low) != napi_ok) {
+        napi_throw_error(env, nullptr, "highPercent and lowPercent must be numbers");
+        return nullptr;
+    }
+
+    // Invalid levels (including 0, 0) switch watermark mode off; the ring validates.
+    ctx->watermarkHighPercent.store(std::max(high, 0));
+    ctx->watermarkLowPercent.store(std::max(low, 0));
+    if (ctx->ring) {
+        ctx->ring->SetWatermarks(static_cast<uint32_t>(std::max(high, 0)), static_cast<uint32_t>(std::max(low, 0)));
+    }
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+napi_value PcmDecoderSetCrossfadeMs(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (!ctx || argc < 1) {
+        napi_throw_error(env, nullptr, "setCrossfadeMs(ms) requires 1 argument");
+        return nullptr;
+    }
 
-    if (ctx->pitchShifter.IsReady()) {
-        ctx->pitchShifter.SetSemitones(semitones);
+    int32_t ms = 0;
+    if (napi_get_value_int32(env, args[0], &ms) != napi_ok) {
+        napi_throw_error(env, nullptr, "ms must be a number");
+        return nullptr;
     }
+    // Picked up by the decode thread with the next PCM; a held tail is played out first.
+    ctx->crossfadeMs.store(std::min(std::max(ms, 0), kMaxCrossfadeMs));
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -727,6 +1714,7 @@ napi_value PcmDecoderSetEqGainsLR(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
+    EqParams params = ctx->eqParams.Published();
     auto parseOne = [&](napi_value arr, size_t chIndex) -> bool {
         bool isArray = false;
         napi_is_array(env, arr, &isArray);
@@ -754,8 +1742,7 @@ napi_value PcmDecoderSetEqGainsLR(napi_env env, napi_callback_info info) {
             } else if (gainDb < -24.0) {
                 gainDb = -24.0;
             }
-            const int32_t gain100 = static_cast<int32_t>(std::lround(gainDb * 100.0));
-            ctx->eqGainsDb100Stereo[chIndex][i].store(gain100);
+            params.gainsDb[chIndex][i] = static_cast<float>(gainDb);
         }
         return true;
     };
@@ -765,7 +1752,7 @@ napi_value PcmDecoderSetEqGainsLR(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
-    ctx->eqVersion.fetch_add(1);
+    PublishEqParams(ctx, params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -783,7 +1770,7 @@ napi_value PcmDecoderSetChannelVolumes(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
-    auto parseCoeff = [&](napi_value v, int32_t &out1000) -> bool {
+    auto parseCoeff = [&](napi_value v, float &out) -> bool {
         double d = 0.0;
         if (napi_get_value_double(env, v, &d) != napi_ok) {
             int32_t i = 0;
@@ -794,19 +1781,17 @@ napi_value PcmDecoderSetChannelVolumes(napi_env env, napi_callback_info info) {
         }
         if (d < 0.0) d = 0.0;
         if (d > 2.0) d = 2.0;
-        out1000 = static_cast<int32_t>(std::lround(d * 1000.0));
+        out = static_cast<float>(d);
         return true;
     };
 
-    int32_t l1000 = 1000;
-    int32_t r1000 = 1000;
-    if (!parseCoeff(args[0], l1000) || !parseCoeff(args[1], r1000)) {
+    ChannelVolumeParams params;
+    if (!parseCoeff(args[0], params.left) || !parseCoeff(args[1], params.right)) {
         napi_throw_error(env, nullptr, "setChannelVolumes expects two numbers");
         return nullptr;
     }
 
-    ctx->channelVol1000[0].store(l1000);
-    ctx->channelVol1000[1].store(r1000);
+    ctx->channelVolumeParams.Publish(params);
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -827,6 +1812,7 @@ napi_value PcmDecoderPause(napi_env env, napi_callback_info info) {
     }
 
     ctx->decoderPaused.store(true);
+    DecodeTrace::Instant("pauseDecoder");
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -843,6 +1829,8 @@ napi_value PcmDecoderResume(napi_env env, napi_callback_info info) {
     }
 
     ctx->decoderPaused.store(false);
+    DecodeTrace::Instant("resumeDecoder");
+    ctx->wakeup.Notify();
 
     napi_value undef;
     napi_get_undefined(env, &undef);
@@ -868,6 +1856,29 @@ napi_value PcmDecoderIsAlive(napi_env env, napi_callback_info info) {
 // Seek 功能实现
 // ============================================================================
 
+// Serve a seek from PCM that is already in the ring (unplayed data or the retained
+// history): the read cursor moves and the decoder keeps appending after the buffered
+// data, so there is no codec flush or demuxer seek. Only possible while no decoder seek
+// is in flight (its output replaces the ring).
+static bool TrySeekWithinBuffer(PcmStreamDecoderContext *ctx, int64_t positionMs) {
+    if (!ctx->ring) {
+        ctx->decoderSeekCount++;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(ctx->seekMutex_);
+    if (ctx->seekSeq_.load() != ctx->seekHandledSeq_.load()) {
+        ctx->decoderSeekCount++;
+        return false;
+    }
+    if (!ctx->ring->SeekWithinBuffer(static_cast<uint64_t>(positionMs))) {
+        ctx->decoderSeekCount++;
+        return false;
+    }
+    ctx->targetPositionMs_.store(positionMs);
+    ctx->localSeekCount++;
+    return true;
+}
+
 napi_value PcmDecoderSeekTo(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value args[1] = {nullptr};
@@ -904,89 +1915,334 @@ napi_value PcmDecoderSeekTo(napi_env env, napi_callback_info info) {
     }
 
     OH_LOG_INFO(LOG_APP, "PcmDecoderSeekTo called: positionMs=%{public}lld", (long long)positionMs);
+    DecodeTrace::Instant("seekTo", "positionMs", positionMs);
+
+    napi_value accepted;
+    if (TrySeekWithinBuffer(ctx, positionMs)) {
+        napi_get_boolean(env, true, &accepted);
+        return accepted;
+    }
+
+    // The next queued track is spliced but not reached yet: the seek goes back into this one.
+    if (!RequestRewind(ctx)) {
+        OH_LOG_INFO(LOG_APP, "PcmDecoderSeekTo refused: decoding has ended");
+        napi_get_boolean(env, false, &accepted);
+        return accepted;
+    }
 
     // Request a seek to be applied by the decode thread.
     // We clear the ring immediately to stop feeding old PCM after renderer.flush().
     {
         std::lock_guard<std::mutex> lock(ctx->seekMutex_);
         ctx->targetPositionMs_.store(positionMs);
+        // Seek latency counts from the first of coalesced requests.
+        int64_t noRequest = 0;
+        (void)ctx->seekRequestNs.compare_exchange_strong(noRequest, DecodeStats::NowNs());
         // Increment after writing the target to keep reads consistent.
         (void)ctx->seekSeq_.fetch_add(1);
     }
+    ctx->wakeup.Notify();
 
     if (ctx->ring) {
         ctx->ring->ResetEos();
         ctx->ring->Clear();
     }
 
-    napi_value undef;
-    napi_get_undefined(env, &undef);
-    return undef;
+    napi_get_boolean(env, true, &accepted);
+    return accepted;
 }
 
 napi_value PcmDecoderSeekToAsync(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value args[1] = {nullptr};
     void *data = nullptr;
-    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (!ctx || argc < 1) {
+        napi_throw_error(env, nullptr, "seekToAsync(positionMs) requires 1 argument");
+        return nullptr;
+    }
+
+    int64_t positionMs = 0;
+    {
+        // ArkTS number may arrive as double on some runtimes.
+        napi_status st = napi_get_value_int64(env, args[0], &positionMs);
+        if (st != napi_ok) {
+            double d = 0.0;
+            if (napi_get_value_double(env, args[0], &d) == napi_ok) {
+                positionMs = static_cast<int64_t>(std::llround(d));
+            } else {
+                int32_t i = 0;
+                if (napi_get_value_int32(env, args[0], &i) != napi_ok) {
+                    napi_throw_error(env, nullptr, "positionMs must be a number");
+                    return nullptr;
+                }
+                positionMs = static_cast<int64_t>(i);
+            }
+        }
+    }
+    if (positionMs < 0) {
+        napi_throw_error(env, nullptr, "positionMs must be >= 0");
+        return nullptr;
+    }
+
+    DecodeTrace::Instant("seekToAsync", "positionMs", positionMs);
+
+    napi_deferred deferred;
+    napi_value promise;
+    napi_create_promise(env, &deferred, &promise);
+
+    // Reject previous pending seek promise if any.
+    if (ctx->seekDeferred != nullptr) {
+        napi_value errObj = napi_utils::CreateErrorObject(env, "seek", -2, "Seek was superseded by a new seek request");
+        napi_reject_deferred(env, ctx->seekDeferred, errObj);
+        ctx->seekDeferred = nullptr;
+    }
+
+    if (TrySeekWithinBuffer(ctx, positionMs)) {
+        ctx->seekAwaitOutput.store(false);
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        napi_resolve_deferred(env, deferred, undef);
+        return promise;
+    }
+
+    // Same as seekTo.
+    if (!RequestRewind(ctx)) {
+        napi_value errObj = napi_utils::CreateErrorObject(env, "seek", -3, "Seek unavailable: decoding has ended");
+        napi_reject_deferred(env, deferred, errObj);
+        return promise;
+    }
+
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(ctx->seekMutex_);
+        ctx->targetPositionMs_.store(positionMs);
+        int64_t noRequest = 0;
+        (void)ctx->seekRequestNs.compare_exchange_strong(noRequest, DecodeStats::NowNs());
+        seq = ctx->seekSeq_.fetch_add(1) + 1;
+    }
+    ctx->wakeup.Notify();
+
+    ctx->seekDeferred = deferred;
+    ctx->seekDeferredSeq = seq;
+    ctx->seekAwaitSeq.store(seq);
+    ctx->seekAwaitOutput.store(true);
+
+    if (ctx->ring) {
+        ctx->ring->ResetEos();
+        ctx->ring->Clear();
+    }
+
+    return promise;
+}
+
+// ============================================================================
+// 播放队列方法
+// ============================================================================
+
+napi_value PcmDecoderEnqueue(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (!ctx || argc < 1) {
+        napi_throw_error(env, nullptr, "enqueue(uri, options?) requires at least 1 argument");
+        return nullptr;
+    }
+
+    napi_valuetype t;
+    napi_typeof(env, args[0], &t);
+    if (t != napi_string) {
+        napi_throw_error(env, nullptr, "uri must be a string");
+        return nullptr;
+    }
+    QueuedTrack track;
+    size_t len = 0;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &len);
+    track.uri.resize(len + 1);
+    napi_get_value_string_utf8(env, args[0], &track.uri[0], len + 1, &len);
+    track.uri.resize(len);
+
+    if (argc >= 2 && args[1] != nullptr) {
+        napi_typeof(env, args[1], &t);
+        if (t == napi_object) {
+            napi_value v;
+            double d = 0.0;
+            if (napi_get_named_property(env, args[1], "encoderDelayFrames", &v) == napi_ok &&
+                napi_get_value_double(env, v, &d) == napi_ok && d >= 0.0) {
+                track.delayFrames = static_cast<int64_t>(d);
+            }
+            if (napi_get_named_property(env, args[1], "paddingFrames", &v) == napi_ok &&
+                napi_get_value_double(env, v, &d) == napi_ok && d >= 0.0) {
+                track.paddingFrames = static_cast<int64_t>(d);
+            }
+        }
+    }
+
+    double id = -1.0;
+    {
+        std::lock_guard<std::mutex> lock(ctx->queueMutex);
+        if (!ctx->queueClosed && !ctx->cancel.load()) {
+            track.id = ++ctx->nextTrackId;
+            id = static_cast<double>(track.id);
+            ctx->queue.push_back(std::move(track));
+            ctx->queuedCount.store(static_cast<uint32_t>(ctx->queue.size()));
+        }
+    }
+    napi_value result;
+    napi_create_double(env, id, &result);
+    return result;
+}
+
+napi_value PcmDecoderClearQueue(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (ctx) {
+        std::lock_guard<std::mutex> lock(ctx->queueMutex);
+        ctx->queue.clear();
+        ctx->queuedCount.store(0);
+        // Tracks withdrawn by a seek back are queued again, so they go as well.
+        ctx->rewindRequeue.clear();
+        // Tracks already spliced into the ring keep playing; only the pre-decoder is dropped.
+        if (ctx->preroll) {
+            ctx->preroll->Cancel();
+            ctx->retiredPrerolls.push_back(std::move(ctx->preroll));
+        }
+    }
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+napi_value PcmDecoderGetBufferStats(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, &data);
     auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
-    if (!ctx || argc < 1) {
-        napi_throw_error(env, nullptr, "seekToAsync(positionMs) requires 1 argument");
+    if (!ctx) {
+        napi_throw_error(env, nullptr, "Failed to get decoder context");
         return nullptr;
     }
 
-    int64_t positionMs = 0;
-    {
-        // ArkTS number may arrive as double on some runtimes.
-        napi_status st = napi_get_value_int64(env, args[0], &positionMs);
-        if (st != napi_ok) {
-            double d = 0.0;
-            if (napi_get_value_double(env, args[0], &d) == napi_ok) {
-                positionMs = static_cast<int64_t>(std::llround(d));
-            } else {
-                int32_t i = 0;
-                if (napi_get_value_int32(env, args[0], &i) != napi_ok) {
-                    napi_throw_error(env, nullptr, "positionMs must be a number");
-                    return nullptr;
-                }
-                positionMs = static_cast<int64_t>(i);
-            }
+    audio::PcmRingBuffer::MemoryStats mem;
+    uint64_t bufferedMs = 0;
+    uint64_t historyMs = 0;
+    if (ctx->ring) {
+        mem = ctx->ring->GetMemoryStats();
+        const uint64_t bytesPerSecond = static_cast<uint64_t>(ctx->actualSampleRate > 0 ? ctx->actualSampleRate : 0) *
+                                        static_cast<uint64_t>(ctx->actualChannelCount > 0 ? ctx->actualChannelCount : 0) *
+                                        static_cast<uint64_t>(GetPcmBytesPerSample(ctx->actualSampleFormat));
+        if (bytesPerSecond > 0) {
+            bufferedMs = static_cast<uint64_t>(mem.bufferedBytes) * 1000ULL / bytesPerSecond;
+            historyMs = static_cast<uint64_t>(mem.historyBytes) * 1000ULL / bytesPerSecond;
         }
     }
-    if (positionMs < 0) {
-        napi_throw_error(env, nullptr, "positionMs must be >= 0");
-        return nullptr;
-    }
 
-    napi_deferred deferred;
-    napi_value promise;
-    napi_create_promise(env, &deferred, &promise);
+    napi_value result;
+    napi_create_object(env, &result);
+    auto setNumber = [env, result](const char *name, double value) {
+        napi_value v;
+        napi_create_double(env, value, &v);
+        napi_set_named_property(env, result, name, v);
+    };
+    setNumber("ringBytes", static_cast<double>(mem.capacityBytes));
+    setNumber("historyCapacityBytes", static_cast<double>(mem.historyCapacityBytes));
+    setNumber("allocatedBytes", static_cast<double>(mem.allocatedBytes));
+    setNumber("bufferedBytes", static_cast<double>(mem.bufferedBytes));
+    setNumber("bufferedMs", static_cast<double>(bufferedMs));
+    setNumber("historyBytes", static_cast<double>(mem.historyBytes));
+    setNumber("historyMs", static_cast<double>(historyMs));
+    // Ring positions count limiter output, which trails the source by this much.
+    const int64_t latencyFrames = ctx->limiterLatencyFrames.load();
+    setNumber("dspLatencyFrames", static_cast<double>(latencyFrames));
+    setNumber("dspLatencyMs", ctx->actualSampleRate > 0
+                                  ? static_cast<double>(latencyFrames) * 1000.0 / ctx->actualSampleRate
+                                  : 0.0);
+    setNumber("localSeeks", static_cast<double>(ctx->localSeekCount));
+    setNumber("decoderSeeks", static_cast<double>(ctx->decoderSeekCount));
+    setNumber("underruns", static_cast<double>(ctx->underrunCount.load()));
+    setNumber("ringResizes", static_cast<double>(ctx->ringResizeCount.load()));
+
+    audio::PcmRingBuffer::WakeupStats wake;
+    if (ctx->ring) {
+        wake = ctx->ring->GetWakeupStats();
+    }
+    setNumber("producerSleeps", static_cast<double>(wake.producerSleeps));
+    setNumber("producerWakeups", static_cast<double>(wake.producerWakeups));
+    setNumber("decodeWakeups", static_cast<double>(ctx->wakeup.Wakeups()));
+    setNumber("watermarkHighPercent", static_cast<double>(ctx->watermarkHighPercent.load()));
+    setNumber("watermarkLowPercent", static_cast<double>(ctx->watermarkLowPercent.load()));
+    setNumber("crossfades", static_cast<double>(ctx->crossfadeCount.load()));
+    setNumber("lastCrossfadeMs", static_cast<double>(ctx->crossfadeLastAudioMs.load()));
+    setNumber("lastCrossfadeCpuMs", static_cast<double>(ctx->crossfadeLastCpuUs.load()) / 1000.0);
+    return result;
+}
 
-    // Reject previous pending seek promise if any.
-    if (ctx->seekDeferred != nullptr) {
-        napi_value errObj = napi_utils::CreateErrorObject(env, "seek", -2, "Seek was superseded by a new seek request");
-        napi_reject_deferred(env, ctx->seekDeferred, errObj);
-        ctx->seekDeferred = nullptr;
+// Per-stage latency histograms (microseconds) and buffer counters since creation or resetStats().
+napi_value PcmDecoderGetStats(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (!ctx) {
+        napi_throw_error(env, nullptr, "Failed to get decoder context");
+        return nullptr;
     }
 
-    uint64_t seq = 0;
-    {
-        std::lock_guard<std::mutex> lock(ctx->seekMutex_);
-        ctx->targetPositionMs_.store(positionMs);
-        seq = ctx->seekSeq_.fetch_add(1) + 1;
-    }
+    const DecodeStats::Snapshot snap = ctx->stats.Take();
 
-    ctx->seekDeferred = deferred;
-    ctx->seekDeferredSeq = seq;
-    ctx->seekAwaitSeq.store(seq);
-    ctx->seekAwaitOutput.store(true);
+    auto setNumber = [env](napi_value obj, const char *name, double value) {
+        napi_value v;
+        napi_create_double(env, value, &v);
+        napi_set_named_property(env, obj, name, v);
+    };
 
-    if (ctx->ring) {
-        ctx->ring->ResetEos();
-        ctx->ring->Clear();
-    }
+    napi_value result;
+    napi_create_object(env, &result);
+    napi_value enabled;
+    napi_get_boolean(env, DecodeStats::kEnabled, &enabled);
+    napi_set_named_property(env, result, "enabled", enabled);
+    setNumber(result, "elapsedMs", static_cast<double>(snap.elapsedNs) / 1e6);
+    setNumber(result, "bytesDecoded", static_cast<double>(snap.bytesDecoded));
+    setNumber(result, "underruns", static_cast<double>(snap.underruns));
+    setNumber(result, "ringHighWaterBytes", static_cast<double>(snap.ringHighWaterBytes));
+    setNumber(result, "ringLowWaterBytes", static_cast<double>(snap.ringLowWaterBytes));
+
+    napi_value stages;
+    napi_create_object(env, &stages);
+    for (size_t i = 0; i < DecodeStats::kStageCount; i++) {
+        const LatencyHistogram::Snapshot &h = snap.stages[i];
+        napi_value stage;
+        napi_create_object(env, &stage);
+        setNumber(stage, "count", static_cast<double>(h.count));
+        setNumber(stage, "minUs", static_cast<double>(h.minNs) / 1000.0);
+        setNumber(stage, "meanUs", h.meanNs / 1000.0);
+        setNumber(stage, "p50Us", static_cast<double>(h.p50Ns) / 1000.0);
+        setNumber(stage, "p90Us", static_cast<double>(h.p90Ns) / 1000.0);
+        setNumber(stage, "p99Us", static_cast<double>(h.p99Ns) / 1000.0);
+        setNumber(stage, "p999Us", static_cast<double>(h.p999Ns) / 1000.0);
+        setNumber(stage, "maxUs", static_cast<double>(h.maxNs) / 1000.0);
+        napi_set_named_property(env, stages, DecodeStats::StageName(static_cast<DecodeStats::Stage>(i)), stage);
+    }
+    napi_set_named_property(env, result, "stages", stages);
+    return result;
+}
 
-    return promise;
+napi_value PcmDecoderResetStats(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    void *data = nullptr;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, &data);
+    auto *ctx = static_cast<PcmStreamDecoderContext *>(data);
+    if (ctx) {
+        ctx->stats.Reset();
+    }
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
 }
 
 napi_value PcmDecoderGetPosition(napi_env env, napi_callback_info info) {
@@ -1001,6 +2257,7 @@ napi_value PcmDecoderGetPosition(napi_env env, napi_callback_info info) {
 
     uint64_t positionMs = 0;
     if (ctx->ring) {
+        PollTrackChanges(ctx);
         positionMs = ctx->ring->GetPositionMs();
     }
 
@@ -1020,6 +2277,7 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
     }
 
     ctx->success = false;
+    DecodeTrace::SetThreadName("pcm-decode");
 
     // Initialize decoder state
     ctx->decoderPaused.store(false);
@@ -1032,26 +2290,59 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
     ctx->s32GlobalMaxAbs = 0;
 
     AudioDecoder decoder;
+    decoder.SetWakeup(&ctx->wakeup);
+    decoder.SetStats(&ctx->stats);
+
+    // Decoded-PCM disk cache (opt-in, local files only): replay a hit from the
+    // mapping, otherwise tee the decoder output into a new entry.
+    std::unique_ptr<PcmDiskCache> cache;
+    std::unique_ptr<PcmDiskCache::Mapping> cached;
+    std::unique_ptr<PcmDiskCache::Fill> cacheFill;
+    if (!ctx->cacheDir.empty() && !IsHttpSource(ctx->inputPathOrUri)) {
+        PcmDiskCache::Params params;
+        params.sampleRate = ctx->sampleRate;
+        params.channelCount = ctx->channelCount;
+        params.bitrate = ctx->bitrate;
+        params.sampleFormat = ctx->sampleFormat;
+        params.gaplessTrim = ctx->gaplessTrim;
+        std::string key;
+        cache = std::make_unique<PcmDiskCache>(ctx->cacheDir, ctx->cacheMaxBytes);
+        if (cache->MakeKey(ctx->inputPathOrUri, params, &key)) {
+            cached = cache->Open(key);
+            if (!cached) {
+                cacheFill = cache->BeginFill(key);
+            }
+        }
+    }
+    PcmDiskCache::Fill *fill = cacheFill.get();
+
+    AudioDecoder::InfoCallback infoCb = [ctx, fill](int32_t sr, int32_t cc, int32_t sf, int64_t durMs) {
+        if (fill != nullptr) {
+            (void)fill->SetFormat(sr, cc, sf, durMs);
+        }
 
-    AudioDecoder::InfoCallback infoCb = [ctx](int32_t sr, int32_t cc, int32_t sf, int64_t durMs) {
         ctx->eqSampleRate = sr;
         ctx->eqChannelCount = cc;
-        ctx->eqAppliedVersion = 0;
+        // Freshly initialized processors take the current snapshots with the next buffer.
+        AcquireDspParams(ctx);
+        ctx->eqParamsApplied = false;
+        ctx->drcParamsApplied = false;
+        ctx->pitchParamsApplied = false;
+
         ctx->eq.Init(sr, cc);
-        ctx->eq.SetEnabled(ctx->eqEnabled.load());
+        ctx->eq.SetEnabled(ctx->eqParams.Current().enabled);
 
-        ctx->drcAppliedVersion = 0;
         ctx->drc.Init(sr, cc);
-        ctx->drc.SetEnabled(ctx->drcEnabled.load());
+        ctx->drc.SetEnabled(ctx->drcParams.Current().enabled);
 
-        ctx->pitchAppliedVersion = 0;
         ctx->pitchShifter.Init(sr, cc);
-        ctx->pitchShifter.SetEnabled(ctx->pitchEnabled.load());
-        ctx->pitchShifter.SetSemitones(ctx->pitchSemitones.load());
+        ctx->pitchShifter.SetEnabled(ctx->pitchParams.Current().enabled);
+        ctx->pitchShifter.SetSemitones(ctx->pitchParams.Current().semitones);
 
         ctx->limiter.Init(sr, cc);
         ctx->limiter.SetEnabled(true);
         ctx->limiter.SetParams(-1.0f, 5.0f, 1.0f, 80.0f);
+        ctx->limiterLatencyFrames.store(static_cast<int64_t>(ctx->limiter.LatencyFrames()));
 
         ctx->actualSampleRate = sr;
         ctx->actualChannelCount = cc;
@@ -1068,6 +2359,21 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
             rb = ComputeAdaptiveRingBytes(ctx, sr, cc, ctx->actualSampleFormat, durMs);
             ctx->ringBytes = rb;
         }
+        if (ctx->adaptiveRing) {
+            size_t minBytes = 0;
+            size_t maxBytes = 0;
+            GetAdaptiveRingLimits(ctx, PcmBytesPerSecond(sr, cc, ctx->actualSampleFormat), &minBytes, &maxBytes);
+            if (ctx->ringMinBytes > 0) {
+                minBytes = ctx->ringMinBytes;
+            }
+            if (ctx->ringMaxBytes > 0) {
+                maxBytes = ctx->ringMaxBytes;
+            }
+            rb = std::min(std::max(rb, minBytes), std::max(minBytes, maxBytes));
+            ctx->ringBytes = rb;
+            ctx->ringPendingBytes = 0;
+            ctx->ringPolicy.Reset(minBytes, maxBytes, kAdaptiveRingAlignStep, NowMs());
+        }
 
         // 先发送 Ready 事件，让主线程尽早得到通知
         // 这样可以避免环形缓冲区分配延迟 Ready Promise 的 resolve
@@ -1091,11 +2397,20 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
         // 在发送 Ready 事件之后，再分配环形缓冲区
         // 这个操作在工作线程中进行，不会阻塞主线程
         const int32_t bytesPerSample = GetPcmBytesPerSample(ctx->actualSampleFormat);
+        const size_t frameBytes = static_cast<size_t>(cc) * static_cast<size_t>(bytesPerSample);
+        const size_t historyBytes =
+            (sr > 0 && frameBytes > 0)
+                ? static_cast<size_t>(static_cast<uint64_t>(ctx->historyMs) * static_cast<uint64_t>(sr) / 1000ULL) *
+                      frameBytes
+                : 0;
         ctx->ring = std::make_unique<audio::PcmRingBuffer>(rb,
-                                                           sr,            // sampleRate
-                                                           cc,            // channels
-                                                           bytesPerSample // bytesPerSample
+                                                           sr,             // sampleRate
+                                                           cc,             // channels
+                                                           bytesPerSample, // bytesPerSample
+                                                           historyBytes    // played PCM kept for backward seeks
         );
+        ctx->ring->SetWatermarks(static_cast<uint32_t>(ctx->watermarkHighPercent.load()),
+                                 static_cast<uint32_t>(ctx->watermarkLowPercent.load()));
     };
 
     AudioDecoder::ProgressCallback progressCb = [ctx](double progress, int64_t ptsMs, int64_t durationMs) {
@@ -1120,17 +2435,24 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
         }
     };
 
-    AudioDecoder::PcmDataCallback pcmCb = [ctx](const uint8_t *pcm, size_t size, int64_t /*ptsMs*/) {
+    // Decoder feeding the stream: this one, then the pre-decoder of each queued track.
+    AudioDecoder *activeDecoder = &decoder;
+    AudioDecoder::PcmDataCallback pushCb = [ctx](const uint8_t *pcm, size_t size, int64_t /*ptsMs*/) {
+        return ProcessPcm(ctx, pcm, size, nullptr);
+    };
+    AudioDecoder::PcmDataCallback pcmCb = [ctx, fill, &activeDecoder, &pushCb](const uint8_t *pcm, size_t size,
+                                                                                int64_t ptsMs) {
         // Check for pause state: wait until resumed instead of blocking on network.
         // This prevents network timeout during long pauses.
         // IMPORTANT: Also break out of pause if there's a pending seek request,
         // otherwise seek will be blocked forever.
-        while (ctx->decoderPaused.load() && !ctx->cancel.load()) {
-            // Check if there's a pending seek - must process it immediately
-            if (ctx->seekSeq_.load() != ctx->seekHandledSeq_.load()) {
-                break;  // Exit pause to process seek
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // Resume, close and seek all notify ctx->wakeup, so a parked decoder never wakes on a timer.
+        {
+            DecodeTrace::Scope pauseTrace(ctx->decoderPaused.load() ? "decoderPaused" : nullptr);
+            ctx->wakeup.Wait([ctx]() {
+                return !ctx->decoderPaused.load() || ctx->cancel.load() ||
+                       ctx->seekSeq_.load() != ctx->seekHandledSeq_.load();
+            });
         }
 
         if (ctx->cancel.load()) {
@@ -1139,6 +2461,12 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
         if (!ctx->ring) {
             return false;
         }
+        ctx->stats.AddBytesDecoded(size);
+
+        // Until the first seek everything decoded is contiguous from the start.
+        if (fill != nullptr && fill->IsActive()) {
+            (void)fill->Write(pcm, size);
+        }
 
         // While a seek is pending (requested but not handled), drop PCM output.
         // This avoids pushing "old" audio (especially for backward seeks).
@@ -1146,6 +2474,15 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
             return true;
         }
 
+        // First PCM at the seek target.
+        if (ctx->seekRequestNs.load(std::memory_order_relaxed) != 0) {
+            const int64_t requestNs = ctx->seekRequestNs.exchange(0);
+            if (requestNs != 0) {
+                ctx->stats.Record(DecodeStats::Stage::Seek, DecodeStats::NowNs() - requestNs);
+                DecodeTrace::Instant("seekFirstPcm", "positionMs", ctx->targetPositionMs_.load());
+            }
+        }
+
         // If seekToAsync is waiting for first post-seek PCM, resolve it now.
         if (ctx->seekAwaitOutput.load()) {
             const uint64_t awaitSeq = ctx->seekAwaitSeq.load();
@@ -1156,250 +2493,14 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
             }
         }
 
-        const bool eqEnabled = ctx->eqEnabled.load();
-        const bool needEq = eqEnabled && ctx->eq.IsReady();
-
-        const bool drcEnabled = ctx->drcEnabled.load();
-        const bool needDrc = drcEnabled && ctx->drc.IsReady();
-
-        const bool pitchEnabled = ctx->pitchEnabled.load();
-        const bool needPitch = pitchEnabled && ctx->pitchShifter.IsReady() && ctx->pitchSemitones.load() != 0;
-
-        // Per-channel volume compensation.
-        const int32_t volL1000 = ctx->channelVol1000[0].load();
-        const int32_t volR1000 = ctx->channelVol1000[1].load();
-
-        const int32_t ch = ctx->actualChannelCount;
-        
-        if (ctx->sourceSampleFormat == 2) {
-            const size_t sampleCount24 = size / 3;
-            const size_t frameCount24 = (ch > 0) ? (sampleCount24 / static_cast<size_t>(ch)) : 0;
-            const size_t outSamples = frameCount24 * static_cast<size_t>(ch);
-            const size_t bytesToProcess = outSamples * 4;
-            if (frameCount24 == 0 || bytesToProcess == 0) {
-                return true;
-            }
-
-            ctx->eqScratch32.resize(outSamples);
-            const uint8_t* p = pcm;
-            for (size_t i = 0; i < outSamples; i++) {
-                uint32_t u = static_cast<uint32_t>(p[0]) |
-                             (static_cast<uint32_t>(p[1]) << 8) |
-                             (static_cast<uint32_t>(p[2]) << 16);
-                int32_t v = (u & 0x00800000u) ? static_cast<int32_t>(u | 0xFF000000u) : static_cast<int32_t>(u);
-                ctx->eqScratch32[i] = static_cast<int32_t>(static_cast<uint32_t>(v) << 8);
-                p += 3;
-            }
-
-            pcm = reinterpret_cast<const uint8_t*>(ctx->eqScratch32.data());
-            size = bytesToProcess;
-
-            if (ctx->s32GlobalMaxAbs < (1LL << 30)) {
-                ctx->s32GlobalMaxAbs = (1LL << 30);
-            }
-        }
-
-        const int32_t sf = ctx->actualSampleFormat;
-        const int32_t bytesPerSample = (sf == 4) ? 4 : ((sf == 3) ? 4 : 2);  // F32LE=4, S32LE=4, S16LE=2
-        if (bytesPerSample != 2 && bytesPerSample != 4) {
-            return ctx->ring->Push(pcm, size, &ctx->cancel);
-        }
-
-        const bool chanVolSupported = (ch == 1 || ch == 2);
-        const bool needChanVol = chanVolSupported &&
-                                 ((ch == 1 && volL1000 != 1000) || (ch == 2 && (volL1000 != 1000 || volR1000 != 1000)));
-
-        if (!needEq && !needChanVol && !needDrc && !needPitch) {
-            return ctx->ring->Push(pcm, size, &ctx->cancel);
-        }
-
-        const size_t sampleCount = size / static_cast<size_t>(bytesPerSample);
-        const size_t frameCount = sampleCount / static_cast<size_t>(ch);
-        const size_t bytesToProcess = frameCount * static_cast<size_t>(ch) * static_cast<size_t>(bytesPerSample);
-        if (bytesToProcess == 0) {
-            return ctx->ring->Push(pcm, size, &ctx->cancel);
-        }
-
-        if (needEq) {
-            const uint32_t v = ctx->eqVersion.load();
-            if (v != ctx->eqAppliedVersion) {
-                std::array<float, PcmEqualizer::kBandCount> gl;
-                std::array<float, PcmEqualizer::kBandCount> gr;
-                for (size_t i = 0; i < PcmEqualizer::kBandCount; i++) {
-                    gl[i] = static_cast<float>(ctx->eqGainsDb100Stereo[0][i].load()) / 100.0f;
-                    gr[i] = static_cast<float>(ctx->eqGainsDb100Stereo[1][i].load()) / 100.0f;
-                }
-                ctx->eq.SetGainsDbStereo(gl, gr);
-                ctx->eqAppliedVersion = v;
-            }
-            ctx->eq.SetEnabled(true);
-        } else {
-            ctx->eq.SetEnabled(false);
-        }
-
-        // Apply DRC params (lazy) if enabled.
-        if (needDrc) {
-            const uint32_t dv = ctx->drcVersion.load();
-            if (dv != ctx->drcAppliedVersion) {
-                const float thr = static_cast<float>(ctx->drcThresholdDb100.load()) / 100.0f;
-                const float ratio = static_cast<float>(ctx->drcRatio1000.load()) / 1000.0f;
-                const float atk = static_cast<float>(ctx->drcAttackMs100.load()) / 100.0f;
-                const float rel = static_cast<float>(ctx->drcReleaseMs100.load()) / 100.0f;
-                const float makeup = static_cast<float>(ctx->drcMakeupDb100.load()) / 100.0f;
-                ctx->drc.SetParams(thr, ratio, atk, rel, makeup);
-                ctx->drcAppliedVersion = dv;
-            }
-            ctx->drc.SetEnabled(true);
-        } else {
-            ctx->drc.SetEnabled(false);
-        }
-
-        // Float DSP pipeline to avoid hard clipping artifacts.
-        ctx->dspScratchF.resize(sampleCount);
-
-        float norm = 1.0f;
-        float denorm = 1.0f;
-        if (bytesPerSample == 2) {
-            // S16LE
-            norm = 1.0f / 32768.0f;
-            denorm = 32768.0f;
-
-            const int16_t* in = reinterpret_cast<const int16_t*>(pcm);
-            for (size_t i = 0; i < sampleCount; i++) {
-                ctx->dspScratchF[i] = static_cast<float>(in[i]) * norm;
-            }
-        } else if (sf == 4) {
-            // F32LE: already in float format, just copy
-            const float* in = reinterpret_cast<const float*>(pcm);
-            for (size_t i = 0; i < sampleCount; i++) {
-                ctx->dspScratchF[i] = in[i];
-            }
-            // No denorm needed for F32LE
-            denorm = 1.0f;
-        } else {
-            // S32LE: use global persistent maxAbs for stable normalization.
-            // This prevents "volume rollercoaster" when source data scale is ambiguous.
-            const int32_t* in = reinterpret_cast<const int32_t*>(pcm);
-
-            // Update global maxAbs monotonically (only increases, never decreases).
-            for (size_t i = 0; i < sampleCount; i++) {
-                int64_t v = static_cast<int64_t>(in[i]);
-                if (v < 0) v = -v;
-                if (v > ctx->s32GlobalMaxAbs) {
-                    ctx->s32GlobalMaxAbs = v;
-                }
-            }
-
-            // Choose normalization based on global maxAbs (stable across entire track).
-            // S32LE can come in different effective scales:
-            // - 16-bit scale: abs <= ~32768
-            // - 24-bit scale: abs <= ~8388608 (2^23)
-            // - Q31 scale:    abs up to ~2^31
-            if (ctx->s32GlobalMaxAbs <= (1LL << 20)) {
-                norm = 1.0f / 32768.0f;
-            } else if (ctx->s32GlobalMaxAbs <= (1LL << 27)) {
-                norm = 1.0f / 8388608.0f;
-            } else {
-                norm = 1.0f / 2147483648.0f;
-            }
-            denorm = 1.0f / norm;
-            for (size_t i = 0; i < sampleCount; i++) {
-                ctx->dspScratchF[i] = static_cast<float>(in[i]) * norm;
-            }
-        }
-
-        if (needEq) {
-            float maxPosGainDb = 0.0f;
-            for (size_t c = 0; c < 2; c++) {
-                for (size_t i = 0; i < PcmEqualizer::kBandCount; i++) {
-                    const float g = static_cast<float>(ctx->eqGainsDb100Stereo[c][i].load()) / 100.0f;
-                    if (g > maxPosGainDb) {
-                        maxPosGainDb = g;
-                    }
-                }
-            }
-
-            if (maxPosGainDb > 0.0f) {
-                const float preampDb = -(maxPosGainDb + 2.0f);
-                const float preamp = std::pow(10.0f, preampDb / 20.0f);
-                for (size_t i = 0; i < sampleCount; i++) {
-                    ctx->dspScratchF[i] *= preamp;
-                }
-            }
-        }
-
-        if (needEq) {
-            ctx->eq.ProcessFloat(ctx->dspScratchF.data(), frameCount);
-        }
-
-        if (needPitch) {
-            const uint32_t pv = ctx->pitchVersion.load();
-            if (pv != ctx->pitchAppliedVersion) {
-                ctx->pitchShifter.SetSemitones(ctx->pitchSemitones.load());
-                ctx->pitchAppliedVersion = pv;
-            }
-            ctx->pitchShifter.SetEnabled(true);
-            ctx->pitchShifter.ProcessFloat(ctx->dspScratchF.data(), frameCount);
-        } else {
-            ctx->pitchShifter.SetEnabled(false);
-        }
-
-        if (needChanVol) {
-            const float l = static_cast<float>(volL1000) / 1000.0f;
-            const float r = static_cast<float>(volR1000) / 1000.0f;
-            if (ch == 1) {
-                for (size_t i = 0; i < frameCount; i++) {
-                    ctx->dspScratchF[i] *= l;
-                }
-            } else {
-                for (size_t i = 0; i < frameCount; i++) {
-                    ctx->dspScratchF[i * 2] *= l;
-                    ctx->dspScratchF[i * 2 + 1] *= r;
-                }
-            }
-        }
-
-        if (needDrc) {
-            ctx->drc.ProcessFloat(ctx->dspScratchF.data(), frameCount);
+        MaybeResizeRing(ctx, activeDecoder);
+        MaybeStartPreroll(ctx);
+        ApplyCrossfadeWindow(ctx);
 
-            const uint64_t now = NowMs();
-            if ((now - ctx->drcMeterLastEmitMs) >= 100) {
-                ctx->drcMeterLastEmitMs = now;
-                QueueDrcMeterEvent(ctx,
-                                  static_cast<double>(ctx->drc.GetLastLevelDb()),
-                                  static_cast<double>(ctx->drc.GetLastGainDb()),
-                                  static_cast<double>(ctx->drc.GetLastGrDb()));
-            }
-        }
-
-        ctx->limiter.ProcessFloat(ctx->dspScratchF.data(), frameCount);
-
-        if (bytesPerSample == 2) {
-            // S16LE output
-            ctx->eqScratch16.resize(sampleCount);
-            for (size_t i = 0; i < sampleCount; i++) {
-                float v = ctx->dspScratchF[i] * denorm;
-                if (v > 32767.0f) v = 32767.0f;
-                if (v < -32768.0f) v = -32768.0f;
-                ctx->eqScratch16[i] = static_cast<int16_t>(std::lround(v));
-            }
-            return ctx->ring->Push(reinterpret_cast<const uint8_t *>(ctx->eqScratch16.data()), size, &ctx->cancel);
-        }
-
-        if (sf == 4) {
-            // F32LE output: directly use the float scratch buffer
-            return ctx->ring->Push(reinterpret_cast<const uint8_t *>(ctx->dspScratchF.data()), size, &ctx->cancel);
-        }
-
-        // S32LE output
-        ctx->eqScratch32.resize(sampleCount);
-        for (size_t i = 0; i < sampleCount; i++) {
-            double v = static_cast<double>(ctx->dspScratchF[i]) * static_cast<double>(denorm);
-            if (v > 2147483647.0) v = 2147483647.0;
-            if (v < -2147483648.0) v = -2147483648.0;
-            ctx->eqScratch32[i] = static_cast<int32_t>(std::llround(v));
-        }
-        return ctx->ring->Push(reinterpret_cast<const uint8_t *>(ctx->eqScratch32.data()), size, &ctx->cancel);
+        // With a track queued, the last crossfade window is held back until this one ends.
+        const bool hold = ctx->crossfade.WindowFrames() > 0 && HasNextTrack(ctx);
+        DecodeTrace::Scope trace("processPcm", "bytes", static_cast<int64_t>(size));
+        return ctx->crossfade.Feed(pcm, size, ptsMs, hold, pushCb);
     };
 
     AudioDecoder::ErrorCallback errorCb = [ctx](const std::string &stage, int32_t code, const std::string &message) {
@@ -1421,12 +2522,17 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
         }
     };
 
-    AudioDecoder::SeekPollCallback seekPollCb = [ctx](int64_t &targetMs, uint64_t &seq) {
+    AudioDecoder::SeekPollCallback seekPollCb = [ctx, fill](int64_t &targetMs, uint64_t &seq) {
         const uint64_t req = ctx->seekSeq_.load();
         const uint64_t handled = ctx->seekHandledSeq_.load();
-        if (req == handled) {
+        // Left to the decoder of the track it goes back into (TakeRewind).
+        if (req == handled || ctx->rewindRequested.load()) {
             return false;
         }
+        // A seek before EOS leaves a gap in the cached PCM.
+        if (fill != nullptr) {
+            fill->Abandon();
+        }
         // targetPositionMs_ is written before seekSeq_ increment in seekTo().
         targetMs = ctx->targetPositionMs_.load();
         seq = req;
@@ -1434,37 +2540,119 @@ void ExecutePcmStreamDecode(napi_env /*env*/, void *data) {
     };
 
     AudioDecoder::SeekAppliedCallback seekAppliedCb = [ctx](uint64_t seq, bool success, int64_t targetMs) {
-        // Always advance handled seq so PCM output can resume.
-        ctx->seekHandledSeq_.store(seq);
-
         if (!success) {
+            // Always advance handled seq so PCM output can resume.
+            ctx->seekRequestNs.store(0);
+            ctx->seekHandledSeq_.store(seq);
             if (ctx->seekAwaitOutput.exchange(false)) {
                 QueueSeekEvent(ctx, seq, false, -1, "Seek failed", targetMs);
             }
             return;
         }
-        if (!ctx->ring) {
-            return;
-        }
+
+        // The held crossfade tail belongs to the old position.
+        ctx->crossfade.Clear();
 
         // Reset ring buffer to align position with target time.
-        ctx->ring->ResetEos();
-        ctx->ring->Clear();
-        ctx->ring->SetPositionMs(targetMs < 0 ? 0 : static_cast<uint64_t>(targetMs));
+        if (ctx->ring) {
+            ctx->ring->ResetEos();
+            ctx->ring->Clear();
+            ctx->ring->SetPositionMs(targetMs < 0 ? 0 : static_cast<uint64_t>(targetMs));
+        }
 
         // For seekToAsync: ensure await seq matches this seek request.
         ctx->seekAwaitSeq.store(seq);
+
+        // Mark handled only after the ring is rebased, so an in-buffer seek
+        // (TrySeekWithinBuffer) never runs against the pre-seek contents.
+        ctx->seekHandledSeq_.store(seq);
     };
 
-    AudioDecoder::EosCallback eosCb = [ctx]() {
+    // With a queued track next the stream goes on: no EOS and no tail seek window.
+    AudioDecoder::EosCallback eosCb = [ctx, fill]() {
+        if (fill != nullptr && fill->IsActive() && !ctx->cancel.load()) {
+            (void)fill->Commit();
+        }
+        if (!ctx->cancel.load() && HasNextTrack(ctx)) {
+            return false;
+        }
         if (ctx->ring) {
+            if (!ctx->cancel.load()) {
+                FlushCrossfadeTail(ctx);
+            }
             ctx->ring->MarkEos();
         }
+        return true;
     };
 
-    bool ok = decoder.DecodeToPcmStream(ctx->inputPathOrUri, ctx->sampleRate, ctx->channelCount, ctx->bitrate, infoCb,
-                                        progressCb, pcmCb, errorCb, &ctx->cancel, ctx->sampleFormat, seekPollCb,
-                                        seekAppliedCb, eosCb);
+    bool ok = false;
+    if (cached) {
+        // Cache entries are stored already trimmed.
+        ok = StreamFromCache(ctx, *cached, infoCb, progressCb, pcmCb, seekPollCb, seekAppliedCb, eosCb);
+    } else {
+        // Gapless trim of the first track; queued tracks are trimmed by their pre-decoder.
+        GaplessInfo gapless;
+        PcmTrimmer trimmer;
+        const bool trim = ctx->gaplessTrim && !IsHttpSource(ctx->inputPathOrUri) &&
+                          ReadGaplessInfo(ctx->inputPathOrUri, &gapless);
+        AudioDecoder::InfoCallback trimInfoCb = [&trimmer, &gapless, &infoCb](int32_t sr, int32_t cc, int32_t sf,
+                                                                               int64_t durMs) {
+            trimmer.Configure(gapless, sr, static_cast<size_t>(cc) * static_cast<size_t>(GetPcmBytesPerSample(sf)));
+            infoCb(sr, cc, sf, durMs);
+        };
+        AudioDecoder::PcmDataCallback trimPcmCb = [&trimmer, &pcmCb](const uint8_t *pcm, size_t size, int64_t ptsMs) {
+            return trimmer.Feed(pcm, size, ptsMs, pcmCb);
+        };
+        AudioDecoder::SeekAppliedCallback trimSeekAppliedCb = [&trimmer, &seekAppliedCb](uint64_t seq, bool success,
+                                                                                          int64_t targetMs) {
+            if (success) {
+                trimmer.OnSeek();
+            }
+            seekAppliedCb(seq, success, targetMs);
+        };
+        AudioDecoder::EosCallback trimEosCb = [&trimmer, &eosCb]() {
+            trimmer.Finish();
+            return eosCb();
+        };
+        ok = decoder.DecodeToPcmStream(ctx->inputPathOrUri, ctx->sampleRate, ctx->channelCount, ctx->bitrate,
+                                       trim ? trimInfoCb : infoCb, progressCb, trim ? trimPcmCb : pcmCb, errorCb,
+                                       &ctx->cancel, ctx->sampleFormat, seekPollCb,
+                                       trim ? trimSeekAppliedCb : seekAppliedCb, trim ? trimEosCb : eosCb);
+    }
+
+    // The first track's codec is done; back to the pool so later pre-decoders can pick it up.
+    decoder.ReleaseCodec();
+
+    if (!ctx->cancel.load()) {
+        // Whatever is still being cached did not reach EOS; queued tracks must not extend it.
+        if (fill != nullptr && fill->IsActive()) {
+            fill->Abandon();
+        }
+        PrerollDecoder::Callbacks callbacks;
+        callbacks.progressCb = progressCb;
+        callbacks.pcmCb = pcmCb;
+        callbacks.errorCb = errorCb;
+        callbacks.seekPollCb = seekPollCb;
+        callbacks.seekAppliedCb = seekAppliedCb;
+        callbacks.eosCb = eosCb;
+        ok = PlayQueuedTracks(ctx, callbacks, &activeDecoder, ok);
+    }
+
+    // Pre-decoders of a cancelled or cleared queue end here (their destructors cancel and join).
+    std::unique_ptr<PrerollDecoder> preroll;
+    std::vector<std::unique_ptr<PrerollDecoder>> retired;
+    {
+        std::lock_guard<std::mutex> lock(ctx->queueMutex);
+        preroll = std::move(ctx->preroll);
+        retired.swap(ctx->retiredPrerolls);
+        ctx->queueClosed = true;
+        ctx->queue.clear();
+        ctx->queuedCount.store(0);
+        ctx->rewindRequeue.clear();
+        ctx->rewindRequested.store(false);
+    }
+    preroll.reset();
+    retired.clear();
 
     ctx->success = ok;
     ctx->decoderAlive.store(false);  // Mark decoder as no longer alive
@@ -1521,9 +2709,6 @@ void CompletePcmStreamDecode(napi_env env, napi_status /*status*/, void *data) {
         napi_delete_reference(env, ctx->selfRef);
         ctx->selfRef = nullptr;
     }
-
-    napi_delete_async_work(env, ctx->work);
-    ctx->work = nullptr;
 }
 
 void FinalizePcmStreamDecoder(napi_env env, void *finalize_data, void * /*finalize_hint*/) {
@@ -1533,6 +2718,7 @@ void FinalizePcmStreamDecoder(napi_env env, void *finalize_data, void * /*finali
     }
 
     ctx->cancel.store(true);
+    ctx->wakeup.Notify();
     if (ctx->ring) {
         ctx->ring->Cancel();
     }
@@ -1549,6 +2735,14 @@ void FinalizePcmStreamDecoder(napi_env env, void *finalize_data, void * /*finali
         napi_delete_reference(env, ctx->onDrcMeterRef);
         ctx->onDrcMeterRef = nullptr;
     }
+    if (ctx->onRingResizeRef != nullptr) {
+        napi_delete_reference(env, ctx->onRingResizeRef);
+        ctx->onRingResizeRef = nullptr;
+    }
+    if (ctx->onTrackChangeRef != nullptr) {
+        napi_delete_reference(env, ctx->onTrackChangeRef);
+        ctx->onTrackChangeRef = nullptr;
+    }
 
     delete ctx;
 }
@@ -1589,6 +2783,17 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
     std::array<int32_t, PcmEqualizer::kBandCount> optEqGainsDb100 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
     bool optPitchEnabled = false;
     int32_t optPitchSemitones = 0;
+    std::string cacheDir;
+    int64_t cacheMaxBytes = 0;
+    int32_t historyMs = 0;
+    bool adaptiveRing = true;
+    int32_t ringMinBytes = 0;
+    int32_t ringMaxBytes = 0;
+    int32_t watermarkHigh = 0;
+    int32_t watermarkLow = 0;
+    bool gaplessTrim = true;
+    int32_t crossfadeMs = 0;
+    DecodeScheduler::Priority priority = DecodeScheduler::Priority::Normal;
 
     // options
     if (argc >= 2 && args[1] != nullptr) {
@@ -1683,6 +2888,97 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
                 }
                 optPitchSemitones = ps;
             }
+
+            if (napi_get_named_property(env, args[1], "cacheDir", &v) == napi_ok) {
+                napi_valuetype vt;
+                napi_typeof(env, v, &vt);
+                if (vt == napi_string) {
+                    size_t len = 0;
+                    napi_get_value_string_utf8(env, v, nullptr, 0, &len);
+                    cacheDir.resize(len + 1);
+                    napi_get_value_string_utf8(env, v, &cacheDir[0], len + 1, &len);
+                    cacheDir.resize(len);
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "cacheMaxBytes", &v) == napi_ok) {
+                double d = 0.0;
+                if (napi_get_value_double(env, v, &d) == napi_ok && d > 0.0) {
+                    cacheMaxBytes = static_cast<int64_t>(d);
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "adaptiveRing", &v) == napi_ok) {
+                bool b = true;
+                if (napi_get_value_bool(env, v, &b) == napi_ok) {
+                    adaptiveRing = b;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "ringMinBytes", &v) == napi_ok) {
+                int32_t b = 0;
+                if (napi_get_value_int32(env, v, &b) == napi_ok && b > 0) {
+                    ringMinBytes = b;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "ringMaxBytes", &v) == napi_ok) {
+                int32_t b = 0;
+                if (napi_get_value_int32(env, v, &b) == napi_ok && b > 0) {
+                    ringMaxBytes = b;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "watermarkHighPercent", &v) == napi_ok) {
+                int32_t pct = 0;
+                if (napi_get_value_int32(env, v, &pct) == napi_ok && pct > 0) {
+                    watermarkHigh = pct;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "watermarkLowPercent", &v) == napi_ok) {
+                int32_t pct = 0;
+                if (napi_get_value_int32(env, v, &pct) == napi_ok && pct > 0) {
+                    watermarkLow = pct;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "historyMs", &v) == napi_ok) {
+                int32_t ms = 0;
+                if (napi_get_value_int32(env, v, &ms) == napi_ok) {
+                    historyMs = std::min(std::max(ms, 0), kMaxHistoryMs);
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "crossfadeMs", &v) == napi_ok) {
+                int32_t ms = 0;
+                if (napi_get_value_int32(env, v, &ms) == napi_ok) {
+                    crossfadeMs = std::min(std::max(ms, 0), kMaxCrossfadeMs);
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "gaplessTrim", &v) == napi_ok) {
+                bool b = true;
+                if (napi_get_value_bool(env, v, &b) == napi_ok) {
+                    gaplessTrim = b;
+                }
+            }
+
+            if (napi_get_named_property(env, args[1], "priority", &v) == napi_ok) {
+                napi_valuetype vt;
+                napi_typeof(env, v, &vt);
+                if (vt == napi_string) {
+                    char buf[16] = {0};
+                    size_t len = 0;
+                    napi_get_value_string_utf8(env, v, buf, sizeof(buf), &len);
+                    const std::string p(buf, len);
+                    if (p == "high") {
+                        priority = DecodeScheduler::Priority::High;
+                    } else if (p == "low") {
+                        priority = DecodeScheduler::Priority::Low;
+                    }
+                }
+            }
         }
     }
 
@@ -1690,6 +2986,8 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
     napi_value onProgress = nullptr;
     napi_value onError = nullptr;
     napi_value onDrcMeter = nullptr;
+    napi_value onRingResize = nullptr;
+    napi_value onTrackChange = nullptr;
     if (argc >= 3 && args[2] != nullptr) {
         napi_valuetype t;
         napi_typeof(env, args[2], &t);
@@ -1697,24 +2995,58 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
             napi_get_named_property(env, args[2], "onProgress", &onProgress);
             napi_get_named_property(env, args[2], "onError", &onError);
             napi_get_named_property(env, args[2], "onDrcMeter", &onDrcMeter);
+            napi_get_named_property(env, args[2], "onRingResize", &onRingResize);
+            napi_get_named_property(env, args[2], "onTrackChange", &onTrackChange);
         }
     }
 
     auto *ctx = new PcmStreamDecoderContext();
     ctx->env = env;
-    ctx->work = nullptr;
     ctx->eventTsfn = nullptr;
+    ctx->priority = priority;
     ctx->readyDeferred = nullptr;
     ctx->doneDeferred = nullptr;
     ctx->selfRef = nullptr;
     ctx->onProgressRef = nullptr;
     ctx->onErrorRef = nullptr;
     ctx->onDrcMeterRef = nullptr;
+    ctx->onRingResizeRef = nullptr;
+    ctx->onTrackChangeRef = nullptr;
     ctx->inputPathOrUri = input;
     ctx->sampleRate = sampleRate;
     ctx->channelCount = channelCount;
     ctx->bitrate = bitrate;
     ctx->sampleFormat = sampleFormat;
+    ctx->cacheDir = cacheDir;
+    ctx->cacheMaxBytes = cacheMaxBytes;
+    ctx->historyMs = historyMs;
+    ctx->localSeekCount = 0;
+    ctx->decoderSeekCount = 0;
+    ctx->seekRequestNs.store(0);
+    ctx->dspChain.SetStats(&ctx->stats);
+    ctx->gaplessTrim = gaplessTrim;
+    ctx->crossfadeMs.store(crossfadeMs);
+    ctx->crossfadeAppliedMs = 0;
+    ctx->crossfadeCount.store(0);
+    ctx->crossfadeLastAudioMs.store(0);
+    ctx->limiterLatencyFrames.store(0);
+    ctx->crossfadeLastCpuUs.store(0);
+    ctx->queuedCount.store(0);
+    ctx->queueClosed = false;
+    ctx->nextTrackId = 0;
+    ctx->trackChangesReported = 0;
+    ctx->playingTrack.uri = ctx->inputPathOrUri;
+    ctx->rewindRequested.store(false);
+    // A fixed ringBytes keeps the ring size; set ringMin/MaxBytes to resize around it anyway.
+    ctx->adaptiveRing = adaptiveRing && (ringBytes == 0 || ringMinBytes > 0 || ringMaxBytes > 0);
+    ctx->ringMinBytes = static_cast<size_t>(ringMinBytes);
+    ctx->ringMaxBytes = static_cast<size_t>(ringMaxBytes);
+    ctx->ringPendingBytes = 0;
+    ctx->ringPendingReason = audio::RingResizePolicy::Reason::None;
+    ctx->underrunCount.store(0);
+    ctx->watermarkHighPercent.store(watermarkHigh);
+    ctx->watermarkLowPercent.store(watermarkLow);
+    ctx->ringResizeCount.store(0);
     ctx->cancel.store(false);
     ctx->success = false;
     ctx->readySettled = false;
@@ -1737,34 +3069,27 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
                                                        2 // 默认每样本字节数（S16LE）
     );
 
-    ctx->eqEnabled.store(optEqEnabled);
-    ctx->eqVersion.store(1);
+    EqParams eqParams;
+    eqParams.enabled = optEqEnabled;
     for (size_t i = 0; i < PcmEqualizer::kBandCount; i++) {
-        const int32_t g100 = hasEqGains ? optEqGainsDb100[i] : 0;
-        ctx->eqGainsDb100Stereo[0][i].store(g100);
-        ctx->eqGainsDb100Stereo[1][i].store(g100);
+        const float gainDb = hasEqGains ? static_cast<float>(optEqGainsDb100[i]) / 100.0f : 0.0f;
+        eqParams.gainsDb[0][i] = gainDb;
+        eqParams.gainsDb[1][i] = gainDb;
     }
-    ctx->channelVol1000[0].store(1000);
-    ctx->channelVol1000[1].store(1000);
-    ctx->eqAppliedVersion = 0;
+    PublishEqParams(ctx, eqParams);
+    ctx->eqParamsApplied = false;
     ctx->eqSampleRate = 0;
     ctx->eqChannelCount = 0;
 
-    // DRC defaults (disabled)
-    ctx->drcEnabled.store(false);
-    ctx->drcVersion.store(1);
-    ctx->drcThresholdDb100.store(static_cast<int32_t>(-20 * 100));
-    ctx->drcRatio1000.store(static_cast<int32_t>(4 * 1000));
-    ctx->drcAttackMs100.store(static_cast<int32_t>(10 * 100));
-    ctx->drcReleaseMs100.store(static_cast<int32_t>(100 * 100));
-    ctx->drcMakeupDb100.store(0);
-    ctx->drcAppliedVersion = 0;
+    // DRC defaults (disabled); channel volumes default to unity.
+    ctx->drcParamsApplied = false;
     ctx->drcMeterLastEmitMs = 0;
 
-    ctx->pitchEnabled.store(optPitchEnabled);
-    ctx->pitchVersion.store(1);
-    ctx->pitchSemitones.store(optPitchSemitones);
-    ctx->pitchAppliedVersion = 0;
+    PitchParams pitchParams;
+    pitchParams.enabled = optPitchEnabled;
+    pitchParams.semitones = optPitchSemitones;
+    ctx->pitchParams.Publish(pitchParams);
+    ctx->pitchParamsApplied = false;
 
     // Initialize seek state.
     ctx->seekSeq_.store(0);
@@ -1818,6 +3143,22 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
         }
     }
 
+    if (onRingResize != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, onRingResize, &t);
+        if (t == napi_function) {
+            napi_create_reference(env, onRingResize, 1, &ctx->onRingResizeRef);
+        }
+    }
+
+    if (onTrackChange != nullptr) {
+        napi_valuetype t;
+        napi_typeof(env, onTrackChange, &t);
+        if (t == napi_function) {
+            napi_create_reference(env, onTrackChange, 1, &ctx->onTrackChangeRef);
+        }
+    }
+
     // Create a noop JS function required by TSFN.
     napi_value noop;
     napi_create_function(
@@ -1894,6 +3235,35 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
     napi_create_function(env, "getPosition", NAPI_AUTO_LENGTH, PcmDecoderGetPosition, ctx, &getPositionFn);
     napi_set_named_property(env, decoderObj, "getPosition", getPositionFn);
 
+    napi_value getBufferStatsFn;
+    napi_create_function(env, "getBufferStats", NAPI_AUTO_LENGTH, PcmDecoderGetBufferStats, ctx, &getBufferStatsFn);
+    napi_set_named_property(env, decoderObj, "getBufferStats", getBufferStatsFn);
+
+    napi_value getStatsFn;
+    napi_create_function(env, "getStats", NAPI_AUTO_LENGTH, PcmDecoderGetStats, ctx, &getStatsFn);
+    napi_set_named_property(env, decoderObj, "getStats", getStatsFn);
+
+    napi_value resetStatsFn;
+    napi_create_function(env, "resetStats", NAPI_AUTO_LENGTH, PcmDecoderResetStats, ctx, &resetStatsFn);
+    napi_set_named_property(env, decoderObj, "resetStats", resetStatsFn);
+
+    napi_value setWatermarksFn;
+    napi_create_function(env, "setWatermarks", NAPI_AUTO_LENGTH, PcmDecoderSetWatermarks, ctx, &setWatermarksFn);
+    napi_set_named_property(env, decoderObj, "setWatermarks", setWatermarksFn);
+
+    // 播放队列（gapless）
+    napi_value enqueueFn;
+    napi_create_function(env, "enqueue", NAPI_AUTO_LENGTH, PcmDecoderEnqueue, ctx, &enqueueFn);
+    napi_set_named_property(env, decoderObj, "enqueue", enqueueFn);
+
+    napi_value setCrossfadeMsFn;
+    napi_create_function(env, "setCrossfadeMs", NAPI_AUTO_LENGTH, PcmDecoderSetCrossfadeMs, ctx, &setCrossfadeMsFn);
+    napi_set_named_property(env, decoderObj, "setCrossfadeMs", setCrossfadeMsFn);
+
+    napi_value clearQueueFn;
+    napi_create_function(env, "clearQueue", NAPI_AUTO_LENGTH, PcmDecoderClearQueue, ctx, &clearQueueFn);
+    napi_set_named_property(env, decoderObj, "clearQueue", clearQueueFn);
+
     // Decoder pause/resume for network timeout prevention during long pauses
     napi_value pauseDecoderFn;
     napi_create_function(env, "pauseDecoder", NAPI_AUTO_LENGTH, PcmDecoderPause, ctx, &pauseDecoderFn);
@@ -1910,10 +3280,24 @@ napi_value CreatePcmStreamDecoder(napi_env env, napi_callback_info info) {
     // wrap finalizer
     napi_wrap(env, decoderObj, ctx, FinalizePcmStreamDecoder, nullptr, nullptr);
 
-    napi_value workName;
-    napi_create_string_utf8(env, "PcmStreamDecode", NAPI_AUTO_LENGTH, &workName);
-    napi_create_async_work(env, nullptr, workName, ExecutePcmStreamDecode, CompletePcmStreamDecode, ctx, &ctx->work);
-    napi_queue_async_work(env, ctx->work);
+    // 解码线程由流式解码调度器提供（有界线程数、按优先级排队），不占用 napi 异步工作线程
+    if (!napi_utils::QueueDecodeWork(env, DecodeScheduler::Streams(), ctx->priority, "PcmStreamDecode",
+                                     ExecutePcmStreamDecode, CompletePcmStreamDecode, ctx)) {
+        // 未能排队则 complete 不会被调用：在此以 schedule 错误拒绝 ready/done，并释放 eventTsfn 与 selfRef；
+        // ctx 随后由 wrap 的 finalizer 释放
+        OH_LOG_ERROR(LOG_APP, "Failed to schedule stream decode");
+        ctx->success = false;
+        ctx->lastErrStage = "schedule";
+        ctx->lastErrCode = -1;
+        ctx->lastErrMessage = "Failed to schedule decode work";
+        if (ctx->readyDeferred != nullptr) {
+            napi_value errObj = napi_utils::CreateErrorObject(env, "schedule", -1, ctx->lastErrMessage);
+            napi_reject_deferred(env, ctx->readyDeferred, errObj);
+            ctx->readyDeferred = nullptr;
+            ctx->readySettled = true;
+        }
+        CompletePcmStreamDecode(env, napi_ok, ctx);
+    }
 
     return decoderObj;
 }
@@ -107,6 +107,14 @@ napi_value PcmDecoderSetPitchEnabled(napi_env env, napi_callback_info info);
 
 napi_value PcmDecoderSetPitchSemitones(napi_env env, napi_callback_info info);
 
+/**
+ * @brief 设置环形缓冲区高/低水位（百分比），低功耗播放时让解码成批进行
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value PcmDecoderSetWatermarks(napi_env env, napi_callback_info info);
+
 // ============================================================================
 // Seek 功能接口
 // ============================================================================
@@ -135,19 +143,67 @@ napi_value PcmDecoderSeekToAsync(napi_env env, napi_callback_info info);
  */
 napi_value PcmDecoderGetPosition(napi_env env, napi_callback_info info);
 
+/**
+ * @brief 获取环形缓冲区内存占用、缓冲/回看数据量与 seek 统计
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return PcmBufferStats 对象
+ */
+napi_value PcmDecoderGetBufferStats(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 获取各处理阶段的耗时分布（微秒）与缓冲计数
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return PcmDecoderStats 对象
+ */
+napi_value PcmDecoderGetStats(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 清零 getStats 的统计
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value PcmDecoderResetStats(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 将曲目加入播放队列，当前曲目结束后无缝衔接播放
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return 曲目 id（首个曲目为 0），解码已结束时返回 -1
+ */
+napi_value PcmDecoderEnqueue(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 清空播放队列（已拼接进缓冲区的曲目继续播放）
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value PcmDecoderClearQueue(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 设置队列曲目之间的交叉淡入淡出时长（毫秒，0 = 无缝衔接）
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value PcmDecoderSetCrossfadeMs(napi_env env, napi_callback_info info);
+
 // ============================================================================
 // 流式解码器异步工作
 // ============================================================================
 
 /**
- * @brief 执行流式解码任务
+ * @brief 执行流式解码任务（在流式解码调度器的线程上运行）
  * @param env NAPI 环境
  * @param data 解码器上下文
  */
 void ExecutePcmStreamDecode(napi_env env, void* data);
 
 /**
- * @brief 完成流式解码任务
+ * @brief 完成流式解码任务（JS 线程）
  * @param env NAPI 环境
  * @param status 异步状态
  * @param data 解码器上下文
@@ -0,0 +1,45 @@
+#include "napi_trace.h"
+
+#undef LOG_TAG
+#define LOG_TAG "NapiTrace"
+
+namespace napi_trace {
+
+napi_value StartTrace(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int64_t eventsPerThread = static_cast<int64_t>(DecodeTrace::kDefaultEventsPerThread);
+    napi_valuetype type = napi_undefined;
+    if (argc >= 1) {
+        napi_typeof(env, args[0], &type);
+    }
+    if (type != napi_undefined && type != napi_null) {
+        if (type != napi_number || napi_get_value_int64(env, args[0], &eventsPerThread) != napi_ok ||
+            eventsPerThread <= 0) {
+            napi_throw_error(env, nullptr, "startTrace(eventsPerThread) expects a positive number");
+            return nullptr;
+        }
+    }
+    DecodeTrace::Start(static_cast<size_t>(eventsPerThread));
+    OH_LOG_INFO(LOG_APP, "Trace started, %{public}lld events per thread", (long long)eventsPerThread);
+    return nullptr;
+}
+
+napi_value StopTrace(napi_env /*env*/, napi_callback_info /*info*/)
+{
+    DecodeTrace::Stop();
+    return nullptr;
+}
+
+napi_value DumpTrace(napi_env env, napi_callback_info /*info*/)
+{
+    const std::string json = DecodeTrace::Dump();
+    napi_value result;
+    napi_create_string_utf8(env, json.c_str(), json.size(), &result);
+    return result;
+}
+
+} // namespace napi_trace
@@ -0,0 +1,42 @@
+#ifndef NAPI_TRACE_H
+#define NAPI_TRACE_H
+
+#include <napi/native_api.h>
+#include "../decode_trace.h"
+#include <hilog/log.h>
+
+namespace napi_trace {
+
+// ============================================================================
+// 解码流水线时间线追踪接口
+// ============================================================================
+
+/**
+ * @brief 开始记录追踪事件（丢弃上一次的记录）
+ *
+ * 参数：
+ * - eventsPerThread: 每个线程保留的最近事件数（可选，默认 DecodeTrace::kDefaultEventsPerThread）
+ *
+ * @return undefined
+ */
+napi_value StartTrace(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 停止记录，已记录的事件仍可导出
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return undefined
+ */
+napi_value StopTrace(napi_env env, napi_callback_info info);
+
+/**
+ * @brief 导出本次记录为 Chrome trace-event JSON（chrome://tracing、ui.perfetto.dev）
+ * @param env NAPI 环境
+ * @param info 回调信息
+ * @return JSON 字符串
+ */
+napi_value DumpTrace(napi_env env, napi_callback_info info);
+
+} // namespace napi_trace
+
+#endif // NAPI_TRACE_H
@@ -2,6 +2,26 @@
 
 namespace napi_utils {
 
+namespace {
+
+struct DecodeWork {
+    napi_env env = nullptr;
+    napi_threadsafe_function done = nullptr;
+    napi_async_execute_callback execute = nullptr;
+    napi_async_complete_callback complete = nullptr;
+    void* data = nullptr;
+};
+
+// JS 线程：工作线程已释放 done，且其队列已清空
+void FinalizeDecodeWork(napi_env env, void* finalizeData, void* /*finalizeHint*/)
+{
+    auto* work = static_cast<DecodeWork*>(finalizeData);
+    work->complete(env, napi_ok, work->data);
+    delete work;
+}
+
+} // namespace
+
 napi_value CreateErrorObject(
     napi_env env,
     const std::string& stage,
@@ -25,4 +45,45 @@ napi_value CreateErrorObject(
     return err;
 }
 
+bool QueueDecodeWork(
+    napi_env env,
+    DecodeScheduler& scheduler,
+    DecodeScheduler::Priority priority,
+    const char* name,
+    napi_async_execute_callback execute,
+    napi_async_complete_callback complete,
+    void* data)
+{
+    // Create a noop JS function required by TSFN.
+    napi_value noop;
+    napi_create_function(
+        env, "noop", NAPI_AUTO_LENGTH,
+        [](napi_env env, napi_callback_info /*info*/) -> napi_value {
+            napi_value undef;
+            napi_get_undefined(env, &undef);
+            return undef;
+        },
+        nullptr, &noop);
+
+    auto* work = new DecodeWork();
+    work->env = env;
+    work->execute = execute;
+    work->complete = complete;
+    work->data = data;
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_threadsafe_function(env, noop, nullptr, resourceName, 0, 1, work, FinalizeDecodeWork, nullptr,
+                                        nullptr, &work->done) != napi_ok) {
+        delete work;
+        return false;
+    }
+
+    scheduler.Submit(priority, [work]() {
+        work->execute(work->env, work->data);
+        napi_release_threadsafe_function(work->done, napi_tsfn_release);
+    });
+    return true;
+}
+
 } // namespace napi_utils
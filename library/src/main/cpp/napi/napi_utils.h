@@ -3,6 +3,7 @@
 
 #include <napi/native_api.h>
 #include <string>
+#include "../decode_scheduler.h"
 
 namespace napi_utils {
 
@@ -23,6 +24,31 @@ napi_value CreateErrorObject(
     int32_t code,
     const std::string& message);
 
+/**
+ * @brief 在库自有的解码线程上执行任务（替代 napi_create_async_work）
+ *
+ * execute 在 scheduler 的线程上运行；结束后 complete 在 JS 线程上调用（status 恒为 napi_ok），
+ * 经一个内部线程安全函数的 finalize 回调送回。与 napi_async_work 一样，complete 与调用方
+ * 其他线程安全函数上的事件之间没有先后保证。
+ *
+ * @param env NAPI 环境
+ * @param scheduler 执行任务的调度器（流式解码 / 后台文件解码）
+ * @param priority 任务优先级
+ * @param name 资源名称
+ * @param execute 工作线程回调
+ * @param complete JS 线程完成回调
+ * @param data 传给两个回调的上下文
+ * @return 成功排队返回 true；返回 false 时 complete 不会被调用，由调用方结算 promise 并释放 data
+ */
+bool QueueDecodeWork(
+    napi_env env,
+    DecodeScheduler& scheduler,
+    DecodeScheduler::Priority priority,
+    const char* name,
+    napi_async_execute_callback execute,
+    napi_async_complete_callback complete,
+    void* data);
+
 } // namespace napi_utils
 
 #endif // NAPI_UTILS_H
@@ -1,6 +1,10 @@
 #include "napi/native_api.h"
 #include "napi/napi_decoder.h"
 #include "napi/napi_stream_decoder.h"
+#include "napi/napi_batch_decoder.h"
+#include "napi/napi_codec_pool.h"
+#include "napi/napi_scheduler.h"
+#include "napi/napi_trace.h"
 
 EXTERN_C_START
 static napi_value Init(napi_env env, napi_value exports)
@@ -8,9 +12,18 @@ static napi_value Init(napi_env env, napi_value exports)
     napi_property_descriptor desc[] = {
         { "decodeAudio", nullptr, napi_decoder::DecodeAudio, nullptr, nullptr, nullptr, napi_default, nullptr },
         { "decodeAudioAsync", nullptr, napi_decoder::DecodeAudioAsync, nullptr, nullptr, nullptr, napi_default, nullptr },
-        { "createPcmStreamDecoder", nullptr, napi_stream_decoder::CreatePcmStreamDecoder, nullptr, nullptr, nullptr, napi_default, nullptr }
+        { "createPcmStreamDecoder", nullptr, napi_stream_decoder::CreatePcmStreamDecoder, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "decodeBatch", nullptr, napi_batch_decoder::DecodeBatch, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "prewarmCodecs", nullptr, napi_codec_pool::PrewarmCodecs, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setCodecPoolSize", nullptr, napi_codec_pool::SetCodecPoolSize, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getCodecPoolStats", nullptr, napi_codec_pool::GetCodecPoolStats, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "configureDecodeScheduler", nullptr, napi_scheduler::ConfigureDecodeScheduler, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getDecodeSchedulerStats", nullptr, napi_scheduler::GetDecodeSchedulerStats, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "startTrace", nullptr, napi_trace::StartTrace, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "stopTrace", nullptr, napi_trace::StopTrace, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "dumpTrace", nullptr, napi_trace::DumpTrace, nullptr, nullptr, nullptr, napi_default, nullptr }
     };
-    napi_define_properties(env, exports, 3, desc);
+    napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
     return exports;
 }
 EXTERN_C_END
@@ -0,0 +1,308 @@
+#include "pcm_convert.h"
+
+#include <cmath>
+#include <cstring>
+
+// The NEON kernels use A64-only instructions (vcvtaq, vqtbl1q, vmaxvq); arm64-v8a
+// is the only shipped ARM ABI.
+#if !defined(FREE_PCM_CONVERT_NO_SIMD) && defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define PCM_CVT_USE_NEON 1
+#elif !defined(FREE_PCM_CONVERT_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_CVT_USE_SSE 1
+#endif
+
+namespace pcm_convert {
+
+namespace {
+
+inline int32_t WidenS24(const uint8_t* p)
+{
+    uint32_t u = static_cast<uint32_t>(p[0]) |
+                 (static_cast<uint32_t>(p[1]) << 8) |
+                 (static_cast<uint32_t>(p[2]) << 16);
+    int32_t v = (u & 0x00800000u) ? static_cast<int32_t>(u | 0xFF000000u) : static_cast<int32_t>(u);
+    return static_cast<int32_t>(static_cast<uint32_t>(v) << 8);
+}
+
+inline int16_t RoundS16(float x, float scale)
+{
+    float v = x * scale;
+    if (v > 32767.0f) v = 32767.0f;
+    if (v < -32768.0f) v = -32768.0f;
+    return static_cast<int16_t>(std::lround(v));
+}
+
+inline int32_t RoundS32(float x, float scale)
+{
+    double v = static_cast<double>(x) * static_cast<double>(scale);
+    if (v > 2147483647.0) v = 2147483647.0;
+    if (v < -2147483648.0) v = -2147483648.0;
+    return static_cast<int32_t>(std::llround(v));
+}
+
+#if defined(PCM_CVT_USE_NEON) || defined(PCM_CVT_USE_SSE)
+inline bool IsPowerOfTwo(float v)
+{
+    int exp = 0;
+    return v > 0.0f && std::frexp(v, &exp) == 0.5f;
+}
+#endif
+
+#if defined(PCM_CVT_USE_SSE)
+// Four packed S24 samples (12 bytes) widened to S32. Reads 4 bytes per sample,
+// so one byte past the fourth sample must be readable.
+inline __m128i LoadS24x4(const uint8_t* p)
+{
+    uint32_t w[4];
+    memcpy(&w[0], p, 4);
+    memcpy(&w[1], p + 3, 4);
+    memcpy(&w[2], p + 6, 4);
+    memcpy(&w[3], p + 9, 4);
+    const __m128i x = _mm_set_epi32(static_cast<int32_t>(w[3]), static_cast<int32_t>(w[2]),
+                                    static_cast<int32_t>(w[1]), static_cast<int32_t>(w[0]));
+    return _mm_slli_epi32(x, 8);
+}
+
+// std::lround semantics (ties away from zero) for |v| < 2^31: truncate, then
+// step away from zero when the exact remainder reaches one half.
+inline __m128i RoundHalfAway(__m128 v)
+{
+    const __m128i t = _mm_cvttps_epi32(v);
+    const __m128 d = _mm_sub_ps(v, _mm_cvtepi32_ps(t));
+    const __m128i up = _mm_castps_si128(_mm_cmpge_ps(d, _mm_set1_ps(0.5f)));
+    const __m128i down = _mm_castps_si128(_mm_cmple_ps(d, _mm_set1_ps(-0.5f)));
+    return _mm_add_epi32(_mm_sub_epi32(t, up), down);
+}
+
+inline __m128i RoundS16x4(const float* in, __m128 scale)
+{
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(in), scale);
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+    return RoundHalfAway(v);
+}
+#endif
+
+#if defined(PCM_CVT_USE_NEON)
+// Four packed S24 samples (12 bytes) widened to S32: byte 0 of each lane is zero
+// (out-of-range table index), bytes 1..3 are the sample. Reads 16 bytes.
+inline int32x4_t LoadS24x4(const uint8_t* p)
+{
+    static const uint8_t kIdx[16] = {255, 0, 1, 2, 255, 3, 4, 5, 255, 6, 7, 8, 255, 9, 10, 11};
+    return vreinterpretq_s32_u8(vqtbl1q_u8(vld1q_u8(p), vld1q_u8(kIdx)));
+}
+#endif
+
+}  // namespace
+
+void S16ToFloat(const int16_t* in, float* out, size_t count, float norm, float gain)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    const float32x4_t vn = vdupq_n_f32(norm);
+    const float32x4_t vg = vdupq_n_f32(gain);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t x = vld1q_s16(in + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+        vst1q_f32(out + i, vmulq_f32(vmulq_f32(lo, vn), vg));
+        vst1q_f32(out + i + 4, vmulq_f32(vmulq_f32(hi, vn), vg));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    const __m128 vn = _mm_set1_ps(norm);
+    const __m128 vg = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(lo, vn), vg));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_mul_ps(hi, vn), vg));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (static_cast<float>(in[i]) * norm) * gain;
+    }
+}
+
+void S32ToFloat(const int32_t* in, float* out, size_t count, float norm, float gain)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    const float32x4_t vn = vdupq_n_f32(norm);
+    const float32x4_t vg = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t x = vcvtq_f32_s32(vld1q_s32(in + i));
+        vst1q_f32(out + i, vmulq_f32(vmulq_f32(x, vn), vg));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    const __m128 vn = _mm_set1_ps(norm);
+    const __m128 vg = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(x, vn), vg));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (static_cast<float>(in[i]) * norm) * gain;
+    }
+}
+
+void F32ToFloat(const float* in, float* out, size_t count, float gain)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    const float32x4_t vg = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(in + i), vg));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    const __m128 vg = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), vg));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = in[i] * gain;
+    }
+}
+
+void S24ToFloat(const uint8_t* in, float* out, size_t count, float norm, float gain)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    const float32x4_t vn = vdupq_n_f32(norm);
+    const float32x4_t vg = vdupq_n_f32(gain);
+    for (; i + 6 <= count; i += 4) {
+        const float32x4_t x = vcvtq_f32_s32(LoadS24x4(in + i * kS24Bytes));
+        vst1q_f32(out + i, vmulq_f32(vmulq_f32(x, vn), vg));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    const __m128 vn = _mm_set1_ps(norm);
+    const __m128 vg = _mm_set1_ps(gain);
+    for (; i + 5 <= count; i += 4) {
+        const __m128 x = _mm_cvtepi32_ps(LoadS24x4(in + i * kS24Bytes));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(x, vn), vg));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (static_cast<float>(WidenS24(in + i * kS24Bytes)) * norm) * gain;
+    }
+}
+
+void S24ToS32(const uint8_t* in, int32_t* out, size_t count)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    for (; i + 6 <= count; i += 4) {
+        vst1q_s32(out + i, LoadS24x4(in + i * kS24Bytes));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    for (; i + 5 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), LoadS24x4(in + i * kS24Bytes));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = WidenS24(in + i * kS24Bytes);
+    }
+}
+
+int64_t AbsMaxS32(const int32_t* in, size_t count, int64_t current)
+{
+    size_t i = 0;
+    uint32_t maxAbs = 0;
+#if defined(PCM_CVT_USE_NEON)
+    // vabsq wraps INT32_MIN to itself, which reads as 2^31 once reinterpreted unsigned.
+    uint32x4_t vmax = vdupq_n_u32(0);
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t a = vreinterpretq_u32_s32(vabsq_s32(vld1q_s32(in + i)));
+        vmax = vmaxq_u32(vmax, a);
+    }
+    maxAbs = vmaxvq_u32(vmax);
+#elif defined(PCM_CVT_USE_SSE)
+    // SSE2 has no unsigned 32-bit max: track |x| biased by 2^31 with signed compares.
+    const __m128i bias = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+    __m128i vmax = bias;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i s = _mm_srai_epi32(x, 31);
+        const __m128i a = _mm_xor_si128(_mm_sub_epi32(_mm_xor_si128(x, s), s), bias);
+        const __m128i gt = _mm_cmpgt_epi32(a, vmax);
+        vmax = _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, vmax));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_xor_si128(vmax, bias));
+    for (size_t l = 0; l < 4; l++) {
+        if (lanes[l] > maxAbs) maxAbs = lanes[l];
+    }
+#endif
+    int64_t result = (static_cast<int64_t>(maxAbs) > current) ? static_cast<int64_t>(maxAbs) : current;
+    for (; i < count; i++) {
+        int64_t v = static_cast<int64_t>(in[i]);
+        if (v < 0) v = -v;
+        if (v > result) result = v;
+    }
+    return result;
+}
+
+void FloatToS16(const float* in, int16_t* out, size_t count, float scale)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i), vs), lo), hi);
+        const float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i + 4), vs), lo), hi);
+        // vcvtaq rounds to nearest with ties away from zero, as std::lround does.
+        vst1q_s16(out + i, vcombine_s16(vmovn_s32(vcvtaq_s32_f32(a)), vmovn_s32(vcvtaq_s32_f32(b))));
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    const __m128 vs = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = RoundS16x4(in + i, vs);
+        const __m128i b = RoundS16x4(in + i + 4, vs);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = RoundS16(in[i], scale);
+    }
+}
+
+void FloatToS32(const float* in, int32_t* out, size_t count, float scale)
+{
+    size_t i = 0;
+#if defined(PCM_CVT_USE_NEON)
+    if (IsPowerOfTwo(scale)) {
+        // vcvtaq saturates to the int32 range and rounds ties away from zero,
+        // matching clamp + std::llround on the exact product.
+        const float32x4_t vs = vdupq_n_f32(scale);
+        for (; i + 4 <= count; i += 4) {
+            vst1q_s32(out + i, vcvtaq_s32_f32(vmulq_f32(vld1q_f32(in + i), vs)));
+        }
+    }
+#elif defined(PCM_CVT_USE_SSE)
+    if (IsPowerOfTwo(scale)) {
+        // Floats at or above 2^31 saturate to INT32_MAX; the low clamp keeps the
+        // rounding step from wrapping INT32_MIN.
+        const __m128 vs = _mm_set1_ps(scale);
+        const __m128 lo = _mm_set1_ps(-2147483648.0f);
+        const __m128 top = _mm_set1_ps(2147483648.0f);
+        const __m128i maxS32 = _mm_set1_epi32(2147483647);
+        for (; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), vs), lo);
+            const __m128i big = _mm_castps_si128(_mm_cmpge_ps(v, top));
+            const __m128i r = RoundHalfAway(v);
+            const __m128i y = _mm_or_si128(_mm_and_si128(big, maxS32), _mm_andnot_si128(big, r));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), y);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = RoundS32(in[i], scale);
+    }
+}
+
+}  // namespace pcm_convert
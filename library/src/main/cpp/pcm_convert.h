@@ -0,0 +1,42 @@
+#ifndef PCM_CONVERT_H
+#define PCM_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Sample-format conversion kernels used by the stream decoder's float DSP path.
+//
+// Every kernel produces exactly what the former scalar loops produced:
+//   int -> float:   (static_cast<float>(x) * norm) * gain
+//   float -> S16:   clamp(x * scale, -32768, 32767), then std::lround
+//   float -> S32:   clamp(double(x) * scale, INT32 range), then std::llround
+// Kernels use NEON on arm64, SSE2 on x86_64 and plain C++ otherwise; define
+// FREE_PCM_CONVERT_NO_SIMD to force the scalar loops. Pointers need only
+// natural alignment of their element type. NaN inputs are not specified.
+// test/pcm_convert_test.cpp checks the kernels of the build host against these
+// definitions; the NEON kernels are unvalidated until it runs on arm64.
+namespace pcm_convert {
+
+// Packed little-endian S24 (3 bytes per sample), as produced by the decoder.
+constexpr size_t kS24Bytes = 3;
+
+void S16ToFloat(const int16_t* in, float* out, size_t count, float norm, float gain);
+void S32ToFloat(const int32_t* in, float* out, size_t count, float norm, float gain);
+void F32ToFloat(const float* in, float* out, size_t count, float gain);
+
+// S24 samples are widened to the S32 scale (value << 8) before normalization.
+void S24ToFloat(const uint8_t* in, float* out, size_t count, float norm, float gain);
+void S24ToS32(const uint8_t* in, int32_t* out, size_t count);
+
+// Returns max(current, max |in[i]|); |INT32_MIN| is 2^31.
+int64_t AbsMaxS32(const int32_t* in, size_t count, int64_t current);
+
+void FloatToS16(const float* in, int16_t* out, size_t count, float scale);
+
+// The vector path requires scale to be a power of two, so that x * scale is
+// exact in float. Any other scale falls back to the scalar double-precision loop.
+void FloatToS32(const float* in, int32_t* out, size_t count, float scale);
+
+}  // namespace pcm_convert
+
+#endif
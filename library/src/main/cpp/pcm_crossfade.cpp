@@ -0,0 +1,121 @@
+#include "pcm_crossfade.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void PcmCrossfade::Configure(size_t frameBytes, size_t windowFrames)
+{
+    frameBytes_ = frameBytes;
+    head_ = 0;
+    size_ = 0;
+    const size_t capacity = frameBytes * windowFrames;
+    if (fifo_.size() != capacity) {
+        fifo_.assign(capacity, 0);
+        fifo_.shrink_to_fit();
+    }
+    const size_t chunkBytes = (capacity > 0) ? frameBytes * kChunkFrames : 0;
+    if (outgoing_.size() != chunkBytes) {
+        outgoing_.assign(chunkBytes, 0);
+        outgoing_.shrink_to_fit();
+        incoming_.assign(chunkBytes, 0);
+        incoming_.shrink_to_fit();
+    }
+}
+
+bool PcmCrossfade::EmitFront(size_t n, const Output& out)
+{
+    const size_t capacity = fifo_.size();
+    while (n > 0) {
+        const size_t piece = std::min(n, capacity - head_);
+        const bool ok = out(fifo_.data() + head_, piece, -1);
+        head_ = (head_ + piece) % capacity;
+        size_ -= piece;
+        n -= piece;
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PcmCrossfade::Feed(const uint8_t* data, size_t size, int64_t ptsMs, bool hold, const Output& out)
+{
+    const size_t capacity = fifo_.size();
+    if (!hold || capacity == 0) {
+        if (size_ > 0 && !EmitFront(size_, out)) {
+            return false;
+        }
+        return out(data, size, ptsMs);
+    }
+
+    // Forward everything older than the last window: withheld bytes first.
+    const size_t total = size_ + size;
+    if (total > capacity) {
+        const size_t excess = total - capacity;
+        const size_t fromFifo = std::min(excess, size_);
+        if (fromFifo > 0 && !EmitFront(fromFifo, out)) {
+            return false;
+        }
+        const size_t direct = excess - fromFifo;
+        if (direct > 0) {
+            if (!out(data, direct, ptsMs)) {
+                return false;
+            }
+            data += direct;
+            size -= direct;
+        }
+    }
+
+    size_t tail = (head_ + size_) % capacity;
+    while (size > 0) {
+        const size_t piece = std::min(size, capacity - tail);
+        memcpy(fifo_.data() + tail, data, piece);
+        tail = (tail + piece) % capacity;
+        size_ += piece;
+        data += piece;
+        size -= piece;
+    }
+    return true;
+}
+
+size_t PcmCrossfade::PopTail(const uint8_t** data)
+{
+    const size_t n = std::min(size_, outgoing_.size());
+    const size_t capacity = fifo_.size();
+    size_t copied = 0;
+    while (copied < n) {
+        const size_t piece = std::min(n - copied, capacity - head_);
+        memcpy(outgoing_.data() + copied, fifo_.data() + head_, piece);
+        head_ = (head_ + piece) % capacity;
+        copied += piece;
+    }
+    size_ -= n;
+    *data = outgoing_.data();
+    return n;
+}
+
+void PcmCrossfade::Clear()
+{
+    head_ = 0;
+    size_ = 0;
+}
+
+void PcmCrossfade::MixTile(float* out, const float* in, size_t frames, size_t channels, size_t firstFrame,
+                           size_t windowFrames)
+{
+    if (windowFrames == 0) {
+        return;
+    }
+    const double step = (M_PI / 2.0) / static_cast<double>(windowFrames);
+    for (size_t f = 0; f < frames; f++) {
+        const double x = static_cast<double>(std::min(firstFrame + f, windowFrames)) * step;
+        const float gOut = static_cast<float>(std::cos(x));
+        const float gIn = static_cast<float>(std::sin(x));
+        float* o = out + f * channels;
+        const float* i = in + f * channels;
+        for (size_t c = 0; c < channels; c++) {
+            o[c] = o[c] * gOut + i[c] * gIn;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef PCM_CROSSFADE_H
+#define PCM_CROSSFADE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Equal-power crossfade between the end of one track and the start of the next.
+//
+// While another track is queued, Feed() keeps the last window of the current
+// track back from the stream (in a fixed FIFO, the way PcmTrimmer withholds
+// padding). When the track ends, the withheld tail is popped chunk by chunk and
+// mixed with the start of the next track: MixTile() weights the outgoing side
+// with cos and the incoming side with sin of the same quarter-period ramp, so
+// the summed power stays constant over the window.
+//
+// All buffers are sized by Configure(); nothing is allocated per chunk.
+class PcmCrossfade {
+public:
+    // Same signature as AudioDecoder::PcmDataCallback.
+    using Output = std::function<bool(const uint8_t* data, size_t size, int64_t ptsMs)>;
+
+    // Chunk size PopTail() hands out.
+    static constexpr size_t kChunkFrames = 4096;
+
+    // frameBytes of the decoder output; windowFrames 0 disables the crossfade.
+    // Any withheld PCM is dropped.
+    void Configure(size_t frameBytes, size_t windowFrames);
+
+    size_t FrameBytes() const { return frameBytes_; }
+    size_t WindowFrames() const { return frameBytes_ > 0 ? fifo_.size() / frameBytes_ : 0; }
+
+    // hold: keep the last window back (a next track is queued). Without hold the
+    // withheld PCM is released first, then data passes through.
+    bool Feed(const uint8_t* data, size_t size, int64_t ptsMs, bool hold, const Output& out);
+
+    // Withheld tail in bytes (whole frames).
+    size_t TailBytes() const { return size_; }
+
+    // Pop up to kChunkFrames of the tail; *data stays valid until the next call.
+    size_t PopTail(const uint8_t** data);
+
+    // Scratch for the incoming side of a chunk (kChunkFrames frames).
+    uint8_t* IncomingChunk() { return incoming_.data(); }
+
+    // Seek: the withheld PCM is stale.
+    void Clear();
+
+    // out = out * cos(x) + in * sin(x), x ramping from 0 to pi/2 over windowFrames;
+    // firstFrame is the position of the tile in the window.
+    static void MixTile(float* out, const float* in, size_t frames, size_t channels, size_t firstFrame,
+                        size_t windowFrames);
+
+private:
+    bool EmitFront(size_t n, const Output& out);
+
+    size_t frameBytes_ = 0;
+    std::vector<uint8_t> fifo_;  // circular, capacity = window
+    size_t head_ = 0;
+    size_t size_ = 0;
+    std::vector<uint8_t> outgoing_;
+    std::vector<uint8_t> incoming_;
+};
+
+#endif
@@ -0,0 +1,451 @@
+#include "pcm_disk_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "PcmDiskCache"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+constexpr char kIndexMagic[4] = {'F', 'P', 'C', 'M'};
+constexpr uint32_t kIndexVersion = 1;
+constexpr uint32_t kMaxKeyBytes = 8192;
+// Temporary/orphaned files younger than this may belong to a live fill.
+constexpr time_t kStaleSeconds = 60 * 60;
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t sampleRate;
+    int32_t channelCount;
+    int32_t sampleFormat;
+    int32_t bytesPerFrame;
+    int64_t durationMs;
+    int64_t frameCount;
+    int64_t dataBytes;
+    uint32_t keyBytes;
+    uint32_t reserved;
+};
+
+std::atomic<uint32_t> g_tmpCounter{0};
+
+int32_t BytesPerSample(int32_t sampleFormat)
+{
+    switch (sampleFormat) {
+        case 1: return 2;
+        case 2: return 3;
+        case 3:
+        case 4: return 4;
+        default: return 0;
+    }
+}
+
+std::string HashKey(const std::string& key)
+{
+    // FNV-1a; the full key is stored in the index and compared on open.
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h));
+    return buf;
+}
+
+bool EndsWith(const std::string& s, const char* suffix)
+{
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool ReadFully(int fd, void* data, size_t size)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool WriteFully(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// Mapping
+// ============================================================================
+
+PcmDiskCache::Mapping::~Mapping()
+{
+    if (data_ != nullptr) {
+        munmap(data_, mapBytes_);
+    }
+}
+
+void PcmDiskCache::Mapping::WillNeed(int64_t offset, int64_t bytes) const
+{
+    if (data_ == nullptr || offset < 0 || bytes <= 0 || static_cast<size_t>(offset) >= mapBytes_) {
+        return;
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = static_cast<size_t>(offset) / page * page;
+    const size_t end = std::min(mapBytes_, static_cast<size_t>(offset + bytes));
+    (void)madvise(data_ + start, end - start, MADV_WILLNEED);
+}
+
+// ============================================================================
+// Fill
+// ============================================================================
+
+PcmDiskCache::Fill::~Fill()
+{
+    Abandon();
+}
+
+bool PcmDiskCache::Fill::SetFormat(int32_t sampleRate, int32_t channelCount, int32_t sampleFormat,
+                                   int64_t durationMs)
+{
+    const int32_t bps = BytesPerSample(sampleFormat);
+    if (!active_ || sampleRate <= 0 || channelCount <= 0 || bps == 0) {
+        Abandon();
+        return false;
+    }
+    index_.sampleRate = sampleRate;
+    index_.channelCount = channelCount;
+    index_.sampleFormat = sampleFormat;
+    index_.bytesPerFrame = bps * channelCount;
+    index_.durationMs = durationMs;
+    hasFormat_ = true;
+    return true;
+}
+
+bool PcmDiskCache::Fill::Write(const uint8_t* data, size_t size)
+{
+    if (!active_ || !hasFormat_) {
+        return false;
+    }
+    if (!writer_.Write(data, size)) {
+        OH_LOG_ERROR(LOG_APP, "Cache write failed, abandoning entry %{public}s", hash_.c_str());
+        Abandon();
+        return false;
+    }
+    return true;
+}
+
+void PcmDiskCache::Fill::Abandon()
+{
+    if (!active_) {
+        return;
+    }
+    active_ = false;
+    (void)writer_.Close();
+    unlink(tmpPcm_.c_str());
+}
+
+bool PcmDiskCache::Fill::Commit()
+{
+    if (!active_ || !hasFormat_) {
+        Abandon();
+        return false;
+    }
+    const int64_t dataBytes = writer_.BytesWritten();
+    if (!writer_.Close()) {
+        OH_LOG_ERROR(LOG_APP, "Cache file close failed: %{public}s", tmpPcm_.c_str());
+        Abandon();
+        return false;
+    }
+    if (dataBytes <= 0 || dataBytes > cache_->maxBytes_) {
+        OH_LOG_INFO(LOG_APP, "Not caching %{public}lld bytes (budget %{public}lld)", (long long)dataBytes,
+                    (long long)cache_->maxBytes_);
+        Abandon();
+        return false;
+    }
+
+    index_.frameCount = dataBytes / index_.bytesPerFrame;
+    index_.dataBytes = index_.frameCount * index_.bytesPerFrame;
+    if (index_.durationMs <= 0) {
+        index_.durationMs = index_.frameCount * 1000 / index_.sampleRate;
+    }
+
+    const bool ok = cache_->Publish(*this);
+    if (!ok) {
+        Abandon();
+        return false;
+    }
+    active_ = false;
+    cache_->Trim();
+    return true;
+}
+
+// ============================================================================
+// PcmDiskCache
+// ============================================================================
+
+PcmDiskCache::PcmDiskCache(const std::string& dir, int64_t maxBytes)
+    : dir_(dir), maxBytes_(maxBytes > 0 ? maxBytes : kDefaultMaxBytes)
+{
+    while (dir_.size() > 1 && dir_.back() == '/') {
+        dir_.pop_back();
+    }
+}
+
+std::string PcmDiskCache::EntryPath(const std::string& hash, const char* ext) const
+{
+    return dir_ + "/" + hash + ext;
+}
+
+bool PcmDiskCache::MakeKey(const std::string& path, const Params& params, std::string* key) const
+{
+    struct stat st;
+    if (key == nullptr || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    char buf[160];
+    snprintf(buf, sizeof(buf), "\n%lld\n%lld.%09ld\n%d/%d/%d/%d/%d", (long long)st.st_size,
+             (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, params.sampleRate, params.channelCount,
+             params.bitrate, params.sampleFormat, params.gaplessTrim ? 1 : 0);
+    *key = path + buf;
+    return true;
+}
+
+std::unique_ptr<PcmDiskCache::Mapping> PcmDiskCache::Open(const std::string& key)
+{
+    const std::string hash = HashKey(key);
+    const std::string idxPath = EntryPath(hash, ".idx");
+
+    const int idxFd = open(idxPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (idxFd < 0) {
+        return nullptr;
+    }
+    IndexHeader h;
+    std::string storedKey;
+    bool valid = ReadFully(idxFd, &h, sizeof(h)) && memcmp(h.magic, kIndexMagic, 4) == 0 &&
+                 h.version == kIndexVersion && h.keyBytes == key.size() && h.keyBytes <= kMaxKeyBytes;
+    if (valid) {
+        storedKey.resize(h.keyBytes);
+        valid = ReadFully(idxFd, &storedKey[0], h.keyBytes) && storedKey == key;
+    }
+    close(idxFd);
+
+    const int32_t bps = valid ? BytesPerSample(h.sampleFormat) : 0;
+    if (!valid || bps == 0 || h.sampleRate <= 0 || h.channelCount <= 0 || h.bytesPerFrame != bps * h.channelCount ||
+        h.dataBytes <= 0 || h.dataBytes != h.frameCount * h.bytesPerFrame) {
+        return nullptr;
+    }
+
+    const std::string pcmPath = EntryPath(hash, ".pcm");
+    const int fd = open(pcmPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<int64_t>(st.st_size) < h.dataBytes) {
+        close(fd);
+        return nullptr;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(h.dataBytes), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        OH_LOG_ERROR(LOG_APP, "mmap failed for %{public}s, errno %{public}d", pcmPath.c_str(), errno);
+        return nullptr;
+    }
+    (void)madvise(p, static_cast<size_t>(h.dataBytes), MADV_SEQUENTIAL);
+
+    // Refresh the LRU stamp.
+    (void)utimensat(AT_FDCWD, idxPath.c_str(), nullptr, 0);
+
+    std::unique_ptr<Mapping> m(new Mapping());
+    m->index_.sampleRate = h.sampleRate;
+    m->index_.channelCount = h.channelCount;
+    m->index_.sampleFormat = h.sampleFormat;
+    m->index_.bytesPerFrame = h.bytesPerFrame;
+    m->index_.durationMs = h.durationMs;
+    m->index_.frameCount = h.frameCount;
+    m->index_.dataBytes = h.dataBytes;
+    m->data_ = static_cast<uint8_t*>(p);
+    m->mapBytes_ = static_cast<size_t>(h.dataBytes);
+    OH_LOG_INFO(LOG_APP, "Cache hit %{public}s: %{public}lld frames", hash.c_str(), (long long)h.frameCount);
+    return m;
+}
+
+std::unique_ptr<PcmDiskCache::Fill> PcmDiskCache::BeginFill(const std::string& key)
+{
+    if (key.size() > kMaxKeyBytes || (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Fill> fill(new Fill());
+    fill->cache_ = this;
+    fill->key_ = key;
+    fill->hash_ = HashKey(key);
+
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d-%u.tmp", static_cast<int>(getpid()), g_tmpCounter.fetch_add(1));
+    fill->tmpPcm_ = EntryPath(fill->hash_, suffix);
+
+    PcmFileWriter::Options opts;
+    // The index is only published after the data is durable.
+    opts.sync = PcmFileWriter::SyncPolicy::kOnClose;
+    if (!fill->writer_.Open(fill->tmpPcm_, opts)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to create cache file in %{public}s", dir_.c_str());
+        return nullptr;
+    }
+    fill->active_ = true;
+    return fill;
+}
+
+bool PcmDiskCache::Publish(Fill& fill)
+{
+    const std::string pcmPath = EntryPath(fill.hash_, ".pcm");
+    const std::string idxPath = EntryPath(fill.hash_, ".idx");
+    const std::string idxTmp = fill.tmpPcm_ + ".idx";
+
+    // Drop any previous index first so a reader never pairs it with new data.
+    unlink(idxPath.c_str());
+    if (rename(fill.tmpPcm_.c_str(), pcmPath.c_str()) != 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to publish cache data, errno %{public}d", errno);
+        return false;
+    }
+
+    IndexHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kIndexMagic, 4);
+    h.version = kIndexVersion;
+    h.sampleRate = fill.index_.sampleRate;
+    h.channelCount = fill.index_.channelCount;
+    h.sampleFormat = fill.index_.sampleFormat;
+    h.bytesPerFrame = fill.index_.bytesPerFrame;
+    h.durationMs = fill.index_.durationMs;
+    h.frameCount = fill.index_.frameCount;
+    h.dataBytes = fill.index_.dataBytes;
+    h.keyBytes = static_cast<uint32_t>(fill.key_.size());
+
+    const int fd = open(idxTmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && WriteFully(fd, &h, sizeof(h)) && WriteFully(fd, fill.key_.data(), fill.key_.size()) &&
+              fdatasync(fd) == 0;
+    if (fd >= 0 && close(fd) != 0) {
+        ok = false;
+    }
+    if (ok && rename(idxTmp.c_str(), idxPath.c_str()) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        OH_LOG_ERROR(LOG_APP, "Failed to publish cache index, errno %{public}d", errno);
+        unlink(idxTmp.c_str());
+        unlink(pcmPath.c_str());
+        return false;
+    }
+    OH_LOG_INFO(LOG_APP, "Cached %{public}s: %{public}lld bytes", fill.hash_.c_str(), (long long)h.dataBytes);
+    return true;
+}
+
+void PcmDiskCache::Trim()
+{
+    DIR* d = opendir(dir_.c_str());
+    if (d == nullptr) {
+        return;
+    }
+
+    struct Entry {
+        std::string hash;
+        time_t stamp;
+        int64_t bytes;
+    };
+    std::vector<Entry> entries;
+    std::vector<std::string> pcmFiles;
+    int64_t total = 0;
+    const time_t now = time(nullptr);
+
+    while (dirent* de = readdir(d)) {
+        const std::string name = de->d_name;
+        const std::string path = dir_ + "/" + name;
+        struct stat st;
+        if (name[0] == '.' || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (EndsWith(name, ".tmp") || EndsWith(name, ".tmp.idx")) {
+            if (now - st.st_mtime > kStaleSeconds) {
+                unlink(path.c_str());
+            } else {
+                total += static_cast<int64_t>(st.st_size);
+            }
+        } else if (EndsWith(name, ".idx")) {
+            entries.push_back({name.substr(0, name.size() - 4), st.st_mtime, static_cast<int64_t>(st.st_size)});
+            total += static_cast<int64_t>(st.st_size);
+        } else if (EndsWith(name, ".pcm")) {
+            pcmFiles.push_back(name.substr(0, name.size() - 4));
+            total += static_cast<int64_t>(st.st_size);
+        }
+    }
+    closedir(d);
+
+    // Attribute data files to their index; old data without an index is orphaned.
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+    for (const std::string& hash : pcmFiles) {
+        const std::string path = EntryPath(hash, ".pcm");
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        auto it = std::lower_bound(entries.begin(), entries.end(), hash,
+                                   [](const Entry& e, const std::string& h) { return e.hash < h; });
+        if (it != entries.end() && it->hash == hash) {
+            it->bytes += static_cast<int64_t>(st.st_size);
+        } else if (now - st.st_mtime > kStaleSeconds && unlink(path.c_str()) == 0) {
+            total -= static_cast<int64_t>(st.st_size);
+        }
+    }
+
+    if (total <= maxBytes_) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.stamp < b.stamp; });
+    for (const Entry& e : entries) {
+        if (total <= maxBytes_) {
+            break;
+        }
+        // Index first: the entry disappears atomically for new readers.
+        unlink(EntryPath(e.hash, ".idx").c_str());
+        unlink(EntryPath(e.hash, ".pcm").c_str());
+        total -= e.bytes;
+        OH_LOG_INFO(LOG_APP, "Evicted %{public}s (%{public}lld bytes)", e.hash.c_str(), (long long)e.bytes);
+    }
+}
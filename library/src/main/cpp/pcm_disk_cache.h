@@ -0,0 +1,130 @@
+#ifndef PCM_DISK_CACHE_H
+#define PCM_DISK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "pcm_file_writer.h"
+
+// On-disk cache of fully decoded PCM for local sources.
+//
+// Each entry is two files in the cache directory:
+//   <hash>.pcm  raw PCM exactly as the decoder produced it (payload at offset 0)
+//   <hash>.idx  small binary index: format, duration, frame count, full key
+// The key combines the source path, size and mtime with the decode parameters,
+// so editing or replacing the file is a miss. An entry only becomes visible
+// when its .idx is renamed into place, i.e. after a complete decode.
+//
+// The directory is trimmed to a byte budget in least-recently-used order; the
+// .idx mtime is the recency stamp and is refreshed on every hit. Files of an
+// evicted entry that is still mapped stay readable until it is unmapped.
+class PcmDiskCache {
+public:
+    static constexpr int64_t kDefaultMaxBytes = 512LL * 1024 * 1024;
+
+    // Decode parameters that change the produced PCM.
+    struct Params {
+        int32_t sampleRate = 0;
+        int32_t channelCount = 0;
+        int32_t bitrate = 0;
+        int32_t sampleFormat = 0;
+        bool gaplessTrim = false;  // encoder delay/padding dropped
+    };
+
+    // Format of the cached PCM (sampleFormat: 1=S16LE, 2=S24LE packed, 3=S32LE, 4=F32LE).
+    struct Index {
+        int32_t sampleRate = 0;
+        int32_t channelCount = 0;
+        int32_t sampleFormat = 0;
+        int32_t bytesPerFrame = 0;
+        int64_t durationMs = 0;
+        int64_t frameCount = 0;
+        int64_t dataBytes = 0;
+    };
+
+    // Read-only mapping of a cached entry.
+    class Mapping {
+    public:
+        ~Mapping();
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        const Index& GetIndex() const { return index_; }
+        const uint8_t* Data() const { return data_; }
+
+        // Ask the kernel to read ahead from byte offset (e.g. after a seek).
+        void WillNeed(int64_t offset, int64_t bytes) const;
+
+    private:
+        friend class PcmDiskCache;
+        Mapping() = default;
+
+        Index index_;
+        uint8_t* data_ = nullptr;
+        size_t mapBytes_ = 0;
+    };
+
+    // Writer for a new entry. Data goes to a temporary file through a
+    // PcmFileWriter; Commit() publishes it, destruction without Commit()
+    // discards it.
+    class Fill {
+    public:
+        ~Fill();
+
+        Fill(const Fill&) = delete;
+        Fill& operator=(const Fill&) = delete;
+
+        // Must be called before the first Write(). Returns false on an
+        // unsupported format, which also abandons the fill.
+        bool SetFormat(int32_t sampleRate, int32_t channelCount, int32_t sampleFormat, int64_t durationMs);
+        bool Write(const uint8_t* data, size_t size);
+
+        // Drop the entry (e.g. the stream was seeked or cancelled before EOS).
+        void Abandon();
+        bool IsActive() const { return active_; }
+
+        // Publish the entry and trim the cache to its budget.
+        bool Commit();
+
+    private:
+        friend class PcmDiskCache;
+        Fill() = default;
+
+        PcmDiskCache* cache_ = nullptr;
+        std::string key_;
+        std::string hash_;
+        std::string tmpPcm_;
+        PcmFileWriter writer_;
+        Index index_;
+        bool hasFormat_ = false;
+        bool active_ = false;
+    };
+
+    PcmDiskCache(const std::string& dir, int64_t maxBytes);
+
+    // Build the cache key for a local file. False if the path is not a
+    // regular file (the source is then not cacheable).
+    bool MakeKey(const std::string& path, const Params& params, std::string* key) const;
+
+    // Map a complete entry, or nullptr on a miss. A hit refreshes its LRU stamp.
+    std::unique_ptr<Mapping> Open(const std::string& key);
+
+    // Start writing a new entry, or nullptr if the directory is unusable.
+    std::unique_ptr<Fill> BeginFill(const std::string& key);
+
+    // Evict least-recently-used entries until the directory fits maxBytes.
+    // Temporary files left behind by a killed process are removed too.
+    void Trim();
+
+private:
+    std::string EntryPath(const std::string& hash, const char* ext) const;
+    bool Publish(Fill& fill);
+
+    std::string dir_;
+    int64_t maxBytes_;
+};
+
+#endif
@@ -2,10 +2,78 @@
 
 #include <cmath>
 
+#if !defined(FREE_PCM_EQ_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define PCM_EQ_USE_NEON 1
+#elif !defined(FREE_PCM_EQ_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_EQ_USE_SSE 1
+#endif
+
 namespace {
 
 static constexpr float kPi = 3.14159265358979323846f;
 
+// Minimal 4-lane float vector used by the channel-parallel biquad cascade.
+// Both shipped ABIs guarantee the baseline ISA (NEON on arm64-v8a, SSE2 on
+// x86_64), so dispatch is resolved at compile time.
+#if defined(PCM_EQ_USE_NEON)
+struct Lane4 {
+    float32x4_t v;
+    static Lane4 Load(const float* p) { return {vld1q_f32(p)}; }
+    void Store(float* p) const { vst1q_f32(p, v); }
+};
+inline Lane4 operator+(Lane4 a, Lane4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Lane4 operator-(Lane4 a, Lane4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Lane4 operator*(Lane4 a, Lane4 b) { return {vmulq_f32(a.v, b.v)}; }
+// Shift<N>(a, b) = {a[4-N..3], b[0..3-N]}: moves lanes up by N, feeding from a.
+template <size_t N>
+inline Lane4 Shift(Lane4 a, Lane4 b) { return {vextq_f32(a.v, b.v, 4 - N)}; }
+#elif defined(PCM_EQ_USE_SSE)
+struct Lane4 {
+    __m128 v;
+    static Lane4 Load(const float* p) { return {_mm_load_ps(p)}; }
+    void Store(float* p) const { _mm_store_ps(p, v); }
+};
+inline Lane4 operator+(Lane4 a, Lane4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Lane4 operator-(Lane4 a, Lane4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Lane4 operator*(Lane4 a, Lane4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+template <size_t N>
+inline Lane4 Shift(Lane4 a, Lane4 b);
+template <>
+inline Lane4 Shift<1>(Lane4 a, Lane4 b)
+{
+    const __m128 t = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(0, 0, 3, 3));
+    return {_mm_shuffle_ps(t, b.v, _MM_SHUFFLE(2, 1, 2, 0))};
+}
+template <>
+inline Lane4 Shift<2>(Lane4 a, Lane4 b) { return {_mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(1, 0, 3, 2))}; }
+#else
+struct Lane4 {
+    float v[4];
+    static Lane4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    void Store(float* p) const
+    {
+        p[0] = v[0];
+        p[1] = v[1];
+        p[2] = v[2];
+        p[3] = v[3];
+    }
+};
+inline Lane4 operator+(Lane4 a, Lane4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+inline Lane4 operator-(Lane4 a, Lane4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+inline Lane4 operator*(Lane4 a, Lane4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+template <size_t N>
+inline Lane4 Shift(Lane4 a, Lane4 b)
+{
+    Lane4 r;
+    for (size_t i = 0; i < 4; i++) {
+        r.v[i] = (i < N) ? a.v[4 - N + i] : b.v[i - N];
+    }
+    return r;
+}
+#endif
+
 }
 
 PcmEqualizer::PcmEqualizer()
@@ -30,7 +98,12 @@ void PcmEqualizer::Reset()
         for (size_t c = 0; c < 2; c++) {
             biquadsByCh_[c][b] = {1, 0, 0, 0, 0};
         }
+        for (size_t g = 0; g < kLaneGroups; g++) {
+            laneState_[g][b] = {};
+        }
     }
+    skewState_ = {};
+    RecalcLaneBiquads();
 }
 
 void PcmEqualizer::Init(int32_t sampleRate, int32_t channelCount)
@@ -168,6 +241,39 @@ void PcmEqualizer::RecalcBiquads()
         // channel 1: right
         biquadsByCh_[1][b] = MakePeaking(static_cast<float>(sampleRate_), freqsHz_[b], q, gainsDbStereo_[1][b]);
     }
+    RecalcLaneBiquads();
+}
+
+void PcmEqualizer::RecalcLaneBiquads()
+{
+    // Stereo uses independent L/R gains; every other layout (incl. mono) uses the
+    // left/mono set for all channels, matching the integer paths.
+    for (size_t g = 0; g < kLaneGroups; g++) {
+        for (size_t b = 0; b < kBandCount; b++) {
+            LaneBiquad& lq = laneBiquads_[g][b];
+            for (size_t l = 0; l < kLaneWidth; l++) {
+                const size_t c = g * kLaneWidth + l;
+                const Biquad& q = biquadsByCh_[(channelCount_ == 2 && c == 1) ? 1 : 0][b];
+                lq.b0[l] = q.b0;
+                lq.b1[l] = q.b1;
+                lq.b2[l] = q.b2;
+                lq.a1[l] = q.a1;
+                lq.a2[l] = q.a2;
+            }
+        }
+    }
+
+    // Padding lanes past the last band run an identity filter and are never output.
+    const size_t ch = (channelCount_ == 2) ? 2 : 1;
+    for (size_t j = 0; j < kSkewLanes; j++) {
+        const size_t b = j / ch;
+        const Biquad q = (b < kBandCount) ? biquadsByCh_[(ch == 2) ? (j % 2) : 0][b] : Biquad{1, 0, 0, 0, 0};
+        skewBiquad_.b0[j] = q.b0;
+        skewBiquad_.b1[j] = q.b1;
+        skewBiquad_.b2[j] = q.b2;
+        skewBiquad_.a1[j] = q.a1;
+        skewBiquad_.a2[j] = q.a2;
+    }
 }
 
 void PcmEqualizer::Process(int16_t* samples, size_t frameCount)
@@ -352,82 +458,159 @@ void PcmEqualizer::ProcessFloat(float* samples, size_t frameCount)
     }
 
     if (channelCount_ == 1) {
-        for (size_t i = 0; i < frameCount; i++) {
-            float x = samples[i];
-            for (size_t b = 0; b < kBandCount; b++) {
-                const Biquad& q = biquadsByCh_[0][b];
-                State& s = stateMono_[b];
-                const float y = (q.b0 * x) + (q.b1 * s.x1) + (q.b2 * s.x2) - (q.a1 * s.y1) - (q.a2 * s.y2);
-                s.x2 = s.x1;
-                s.x1 = x;
-                s.y2 = s.y1;
-                s.y1 = y;
-                x = y;
-            }
-            samples[i] = x;
-        }
+        ProcessFloatSkewed<1>(samples, frameCount);
         return;
     }
 
     if (channelCount_ == 2) {
-        // stereo interleaved
-        for (size_t i = 0; i < frameCount; i++) {
-            float xl = samples[i * 2];
-            float xr = samples[i * 2 + 1];
+        ProcessFloatSkewed<2>(samples, frameCount);
+        return;
+    }
 
-            for (size_t b = 0; b < kBandCount; b++) {
-                State& sl = stateStereo_[b][0];
-                State& sr = stateStereo_[b][1];
+    if (channelCount_ > 0 && channelCount_ <= static_cast<int32_t>(kMaxChannels)) {
+        ProcessFloatLanes(samples, frameCount);
+    }
+}
 
-                const Biquad& ql = biquadsByCh_[0][b];
-                const Biquad& qr = biquadsByCh_[1][b];
+// The 10 bands of one channel are serially dependent, so a channel-per-lane
+// layout leaves mono/stereo latency-bound. Here lane j holds band j / Ch of
+// channel j % Ch, and at step t band b filters frame t - b: every lane is
+// independent within a step and band outputs move up Ch lanes per step.
+// The fill/drain triangles (first and last kBandCount - 1 steps) run scalar
+// over the same state so no latency is carried across calls.
+template <size_t Ch>
+void PcmEqualizer::ProcessFloatSkewed(float* samples, size_t frameCount)
+{
+    constexpr size_t kLanes = kBandCount * Ch;
+    constexpr size_t kVecs = (kLanes + kLaneWidth - 1) / kLaneWidth;
+    constexpr size_t kLastBand = kBandCount - 1;
+    static_assert(kVecs * kLaneWidth <= kSkewLanes, "skew layout exceeds lane storage");
+
+    const SkewBiquad& q = skewBiquad_;
+    float* z1 = skewState_.z1;
+    float* z2 = skewState_.z2;
+
+    // In-flight band outputs from the previous step.
+    alignas(16) float y[kSkewLanes] = {};
+
+    auto scalarStep = [&](size_t t) {
+        // Descending so y[j - Ch] still holds the previous step's value.
+        for (size_t j = kLanes; j-- > 0;) {
+            const size_t b = j / Ch;
+            if (t < b || (t - b) >= frameCount) {
+                continue;
+            }
+            const float x = (b == 0) ? samples[t * Ch + j] : y[j - Ch];
+            const float out = q.b0[j] * x + z1[j];
+            z1[j] = q.b1[j] * x - q.a1[j] * out + z2[j];
+            z2[j] = q.b2[j] * x - q.a2[j] * out;
+            y[j] = out;
+        }
+        if (t >= kLastBand && (t - kLastBand) < frameCount) {
+            for (size_t c = 0; c < Ch; c++) {
+                samples[(t - kLastBand) * Ch + c] = y[kLastBand * Ch + c];
+            }
+        }
+    };
 
-                const float yl = (ql.b0 * xl) + (ql.b1 * sl.x1) + (ql.b2 * sl.x2) - (ql.a1 * sl.y1) - (ql.a2 * sl.y2);
-                sl.x2 = sl.x1;
-                sl.x1 = xl;
-                sl.y2 = sl.y1;
-                sl.y1 = yl;
-                xl = yl;
+    for (size_t t = 0; t < kLastBand; t++) {
+        scalarStep(t);
+    }
 
-                const float yr = (qr.b0 * xr) + (qr.b1 * sr.x1) + (qr.b2 * sr.x2) - (qr.a1 * sr.y1) - (qr.a2 * sr.y2);
-                sr.x2 = sr.x1;
-                sr.x1 = xr;
-                sr.y2 = sr.y1;
-                sr.y1 = yr;
-                xr = yr;
+    if (frameCount > kLastBand) {
+        Lane4 yv[kVecs];
+        Lane4 z1v[kVecs];
+        Lane4 z2v[kVecs];
+        for (size_t k = 0; k < kVecs; k++) {
+            yv[k] = Lane4::Load(y + k * kLaneWidth);
+            z1v[k] = Lane4::Load(z1 + k * kLaneWidth);
+            z2v[k] = Lane4::Load(z2 + k * kLaneWidth);
+        }
+
+        alignas(16) float xin[kLaneWidth] = {};
+        alignas(16) float tail[kLaneWidth] = {};
+        constexpr size_t kOutVec = (kLastBand * Ch) / kLaneWidth;
+        constexpr size_t kOutLane = (kLastBand * Ch) % kLaneWidth;
+
+        for (size_t t = kLastBand; t < frameCount; t++) {
+            for (size_t c = 0; c < Ch; c++) {
+                xin[kLaneWidth - Ch + c] = samples[t * Ch + c];
+            }
+            const Lane4 xv = Lane4::Load(xin);
+
+            for (size_t k = kVecs; k-- > 0;) {
+                const Lane4 x = Shift<Ch>((k == 0) ? xv : yv[k - 1], yv[k]);
+                const size_t o = k * kLaneWidth;
+                const Lane4 out = Lane4::Load(q.b0 + o) * x + z1v[k];
+                z1v[k] = Lane4::Load(q.b1 + o) * x - Lane4::Load(q.a1 + o) * out + z2v[k];
+                z2v[k] = Lane4::Load(q.b2 + o) * x - Lane4::Load(q.a2 + o) * out;
+                yv[k] = out;
             }
 
-            samples[i * 2] = xl;
-            samples[i * 2 + 1] = xr;
+            yv[kOutVec].Store(tail);
+            for (size_t c = 0; c < Ch; c++) {
+                samples[(t - kLastBand) * Ch + c] = tail[kOutLane + c];
+            }
+        }
+
+        for (size_t k = 0; k < kVecs; k++) {
+            yv[k].Store(y + k * kLaneWidth);
+            z1v[k].Store(z1 + k * kLaneWidth);
+            z2v[k].Store(z2 + k * kLaneWidth);
         }
-        return;
     }
 
-    if (channelCount_ > 0 && channelCount_ <= static_cast<int32_t>(kMaxChannels)) {
-        const size_t ch = static_cast<size_t>(channelCount_);
-        for (size_t i = 0; i < frameCount; i++) {
-            float x[kMaxChannels];
-            for (size_t c = 0; c < ch; c++) {
-                x[c] = samples[i * ch + c];
+    const size_t drainStart = (frameCount > kLastBand) ? frameCount : kLastBand;
+    for (size_t t = drainStart; t < frameCount + kLastBand; t++) {
+        scalarStep(t);
+    }
+}
+
+void PcmEqualizer::ProcessFloatLanes(float* samples, size_t frameCount)
+{
+    const size_t ch = static_cast<size_t>(channelCount_);
+    const size_t groups = (ch + kLaneWidth - 1) / kLaneWidth;
+
+    for (size_t g = 0; g < groups; g++) {
+        const size_t c0 = g * kLaneWidth;
+        const size_t lanes = (ch - c0 < kLaneWidth) ? (ch - c0) : kLaneWidth;
+
+        // Keep the whole cascade state in registers for the duration of the block.
+        Lane4 z1[kBandCount];
+        Lane4 z2[kBandCount];
+        for (size_t b = 0; b < kBandCount; b++) {
+            z1[b] = Lane4::Load(laneState_[g][b].z1);
+            z2[b] = Lane4::Load(laneState_[g][b].z2);
+        }
+        const std::array<LaneBiquad, kBandCount>& coeffs = laneBiquads_[g];
+
+        alignas(16) float frame[kLaneWidth] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float* p = samples + c0;
+        for (size_t i = 0; i < frameCount; i++, p += ch) {
+            for (size_t l = 0; l < lanes; l++) {
+                frame[l] = p[l];
             }
+            Lane4 x = Lane4::Load(frame);
 
             for (size_t b = 0; b < kBandCount; b++) {
-                const Biquad& q = biquadsByCh_[0][b];
-                for (size_t c = 0; c < ch; c++) {
-                    State& s = stateMulti_[b][c];
-                    const float y = (q.b0 * x[c]) + (q.b1 * s.x1) + (q.b2 * s.x2) - (q.a1 * s.y1) - (q.a2 * s.y2);
-                    s.x2 = s.x1;
-                    s.x1 = x[c];
-                    s.y2 = s.y1;
-                    s.y1 = y;
-                    x[c] = y;
-                }
+                const LaneBiquad& q = coeffs[b];
+                // Transposed direct form II:
+                // y = b0*x + z1; z1 = b1*x - a1*y + z2; z2 = b2*x - a2*y
+                const Lane4 y = Lane4::Load(q.b0) * x + z1[b];
+                z1[b] = Lane4::Load(q.b1) * x - Lane4::Load(q.a1) * y + z2[b];
+                z2[b] = Lane4::Load(q.b2) * x - Lane4::Load(q.a2) * y;
+                x = y;
             }
 
-            for (size_t c = 0; c < ch; c++) {
-                samples[i * ch + c] = x[c];
+            x.Store(frame);
+            for (size_t l = 0; l < lanes; l++) {
+                p[l] = frame[l];
             }
         }
-        return;
+
+        for (size_t b = 0; b < kBandCount; b++) {
+            z1[b].Store(laneState_[g][b].z1);
+            z2[b].Store(laneState_[g][b].z2);
+        }
     }
 }
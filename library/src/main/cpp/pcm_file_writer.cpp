@@ -0,0 +1,272 @@
+#include "pcm_file_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "PcmFileWriter"
+#define LOG_DOMAIN 0x3200
+
+PcmFileWriter::PcmFileWriter()
+    : fd_(-1), dataOffset_(0), directIo_(false), sync_(SyncPolicy::kNone), blockBytes_(0),
+      blocks_{nullptr, nullptr}, front_(nullptr), frontUsed_(0), bytesQueued_(0), pending_(nullptr),
+      pendingBytes_(0), bytesOnDisk_(0), stop_(false), failed_(false)
+{
+}
+
+PcmFileWriter::~PcmFileWriter()
+{
+    Close();
+}
+
+bool PcmFileWriter::Open(const std::string& path, const Options& options)
+{
+    return OpenAt(path, options, 0);
+}
+
+bool PcmFileWriter::SetFormat(const PcmFileFormat& /*format*/)
+{
+    return IsOpen();
+}
+
+void PcmFileWriter::OnBlockWritten(int64_t /*dataBytes*/)
+{
+}
+
+bool PcmFileWriter::OpenAt(const std::string& path, const Options& options, int64_t dataOffset)
+{
+    Close();
+
+    size_t block = std::min(std::max(options.blockBytes, kMinBlockBytes), kMaxBlockBytes);
+    block = (block + kIoAlign - 1) / kIoAlign * kIoAlign;
+
+    for (uint8_t*& b : blocks_) {
+        void* p = nullptr;
+        if (posix_memalign(&p, kIoAlign, block) != 0) {
+            OH_LOG_ERROR(LOG_APP, "Failed to allocate %{public}zu byte write block", block);
+            Close();
+            return false;
+        }
+        b = static_cast<uint8_t*>(p);
+    }
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    directIo_ = false;
+#ifdef O_DIRECT
+    if (options.directIo) {
+        fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+        directIo_ = (fd_ >= 0);
+        if (!directIo_) {
+            OH_LOG_INFO(LOG_APP, "O_DIRECT unavailable (errno %{public}d), using buffered I/O", errno);
+        }
+    }
+#endif
+    if (fd_ < 0) {
+        fd_ = open(path.c_str(), flags, 0644);
+    }
+    if (fd_ < 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to open output file: %{public}s", path.c_str());
+        Close();
+        return false;
+    }
+
+    if (dataOffset > 0 && lseek(fd_, static_cast<off_t>(dataOffset), SEEK_SET) < 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to seek to data offset %{public}lld", (long long)dataOffset);
+        Close();
+        return false;
+    }
+
+    dataOffset_ = dataOffset;
+    sync_ = options.sync;
+    blockBytes_ = block;
+    front_ = blocks_[0];
+    frontUsed_ = 0;
+    bytesQueued_ = 0;
+    pending_ = nullptr;
+    pendingBytes_ = 0;
+    bytesOnDisk_ = 0;
+    stop_ = false;
+    failed_.store(false);
+    thread_ = std::thread(&PcmFileWriter::WriterLoop, this);
+    return true;
+}
+
+bool PcmFileWriter::Preallocate(int64_t bytes)
+{
+    if (fd_ < 0 || bytes <= 0) {
+        return false;
+    }
+#ifdef FALLOC_FL_KEEP_SIZE
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes)) == 0) {
+        OH_LOG_INFO(LOG_APP, "Preallocated %{public}lld bytes", (long long)bytes);
+        return true;
+    }
+    OH_LOG_INFO(LOG_APP, "fallocate failed (errno %{public}d), continuing without preallocation", errno);
+#endif
+    return false;
+}
+
+bool PcmFileWriter::Write(const uint8_t* data, size_t size)
+{
+    if (fd_ < 0 || failed_.load()) {
+        return false;
+    }
+
+    while (size > 0) {
+        const size_t n = std::min(size, blockBytes_ - frontUsed_);
+        memcpy(front_ + frontUsed_, data, n);
+        frontUsed_ += n;
+        bytesQueued_ += static_cast<int64_t>(n);
+        data += n;
+        size -= n;
+        if (frontUsed_ == blockBytes_) {
+            SubmitFront();
+        }
+    }
+    return !failed_.load();
+}
+
+bool PcmFileWriter::Close()
+{
+    if (thread_.joinable()) {
+        if (frontUsed_ > 0) {
+            SubmitFront();
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            WaitIdle(lock);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    bool ok = !failed_.load();
+    if (fd_ >= 0) {
+        if (ok && sync_ != SyncPolicy::kNone && fdatasync(fd_) != 0) {
+            OH_LOG_ERROR(LOG_APP, "fdatasync failed, errno %{public}d", errno);
+            ok = false;
+        }
+        // Release preallocated blocks beyond the final size.
+        if (ok) {
+            (void)ftruncate(fd_, static_cast<off_t>(dataOffset_ + bytesQueued_));
+        }
+        if (close(fd_) != 0) {
+            ok = false;
+        }
+        fd_ = -1;
+    }
+
+    for (uint8_t*& b : blocks_) {
+        free(b);
+        b = nullptr;
+    }
+    front_ = nullptr;
+    frontUsed_ = 0;
+    return ok;
+}
+
+void PcmFileWriter::SubmitFront()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        WaitIdle(lock);
+        pending_ = front_;
+        pendingBytes_ = frontUsed_;
+    }
+    cond_.notify_all();
+
+    front_ = (front_ == blocks_[0]) ? blocks_[1] : blocks_[0];
+    frontUsed_ = 0;
+}
+
+void PcmFileWriter::WaitIdle(std::unique_lock<std::mutex>& lock)
+{
+    cond_.wait(lock, [this]() { return pending_ == nullptr; });
+}
+
+void PcmFileWriter::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [this]() { return stop_ || pending_ != nullptr; });
+        if (pending_ == nullptr) {
+            return;
+        }
+
+        uint8_t* block = pending_;
+        const size_t bytes = pendingBytes_;
+        lock.unlock();
+
+        if (!failed_.load()) {
+            bool ok = WriteFully(block, bytes);
+            if (ok && sync_ == SyncPolicy::kPerBlock && fdatasync(fd_) != 0) {
+                ok = false;
+            }
+            if (ok) {
+                bytesOnDisk_ += static_cast<int64_t>(bytes);
+                OnBlockWritten(bytesOnDisk_);
+            } else {
+                OH_LOG_ERROR(LOG_APP, "Block write failed, errno %{public}d", errno);
+                failed_.store(true);
+            }
+        }
+
+        lock.lock();
+        pending_ = nullptr;
+        pendingBytes_ = 0;
+        cond_.notify_all();
+    }
+}
+
+bool PcmFileWriter::WriteAt(int64_t offset, const uint8_t* data, size_t size)
+{
+    if (fd_ < 0) {
+        return false;
+    }
+    while (size > 0) {
+        const ssize_t n = pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        offset += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool PcmFileWriter::WriteFully(const uint8_t* data, size_t size)
+{
+#ifdef O_DIRECT
+    // O_DIRECT needs aligned lengths; only the final block can be short.
+    if (directIo_ && size % kIoAlign != 0) {
+        const int fl = fcntl(fd_, F_GETFL);
+        if (fl < 0 || fcntl(fd_, F_SETFL, fl & ~O_DIRECT) != 0) {
+            return false;
+        }
+        directIo_ = false;
+    }
+#endif
+    while (size > 0) {
+        const ssize_t n = write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef PCM_FILE_WRITER_H
+#define PCM_FILE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Destination for decoded PCM bytes.
+class PcmOutputSink {
+public:
+    virtual ~PcmOutputSink() = default;
+
+    // Returns false once the sink has failed; the caller should stop decoding.
+    virtual bool Write(const uint8_t* data, size_t size) = 0;
+};
+
+// Layout of the PCM written to a file (used by container writers).
+struct PcmFileFormat {
+    int32_t sampleRate = 0;
+    int32_t channelCount = 0;
+    int32_t bitsPerSample = 16;
+    bool isFloat = false;
+};
+
+// Double-buffered file writer (headerless PCM).
+//
+// Write() only copies into the front block. A full block is handed to a
+// dedicated writer thread and written with one write() call while the decode
+// thread fills the other block, so storage latency only stalls decoding when
+// the disk falls a whole block behind.
+class PcmFileWriter : public PcmOutputSink {
+public:
+    enum class SyncPolicy {
+        kNone = 0,       // leave flushing to the kernel
+        kOnClose = 1,    // fdatasync once in Close()
+        kPerBlock = 2,   // fdatasync after every block
+    };
+
+    struct Options {
+        // Block size, clamped to [kMinBlockBytes, kMaxBlockBytes] and rounded
+        // to kIoAlign. Two blocks are allocated.
+        size_t blockBytes = kDefaultBlockBytes;
+        // Open with O_DIRECT (falls back to buffered I/O if the file system refuses).
+        bool directIo = false;
+        SyncPolicy sync = SyncPolicy::kNone;
+    };
+
+    static constexpr size_t kMinBlockBytes = 1024 * 1024;
+    static constexpr size_t kMaxBlockBytes = 4 * 1024 * 1024;
+    static constexpr size_t kDefaultBlockBytes = kMinBlockBytes;
+    static constexpr size_t kIoAlign = 4096;
+
+    PcmFileWriter();
+    ~PcmFileWriter() override;
+
+    PcmFileWriter(const PcmFileWriter&) = delete;
+    PcmFileWriter& operator=(const PcmFileWriter&) = delete;
+
+    // Create/truncate path and start the writer thread.
+    virtual bool Open(const std::string& path, const Options& options);
+
+    // Describe the PCM that will follow. Raw output ignores it; container
+    // writers emit their header here. Call before the first Write().
+    virtual bool SetFormat(const PcmFileFormat& format);
+
+    // Reserve disk space for an expected output size without changing the
+    // file size (fallocate KEEP_SIZE). Best effort; false if unsupported.
+    bool Preallocate(int64_t bytes);
+
+    bool Write(const uint8_t* data, size_t size) override;
+
+    // Flush pending data, stop the writer thread, apply the sync policy and
+    // close the file. Returns false if any write failed. Safe to call twice.
+    bool Close();
+
+    bool IsOpen() const { return fd_ >= 0; }
+    // PCM bytes accepted by Write() (excluding any container header).
+    int64_t BytesWritten() const { return bytesQueued_; }
+
+protected:
+    // Open with PCM starting at dataOffset (a multiple of kIoAlign); the bytes
+    // before it are left for a header written with WriteAt().
+    bool OpenAt(const std::string& path, const Options& options, int64_t dataOffset);
+
+    // Synchronous pwrite outside the streamed region. With O_DIRECT, data,
+    // offset and size must be kIoAlign-aligned.
+    bool WriteAt(int64_t offset, const uint8_t* data, size_t size);
+
+    // Called on the writer thread after each block reaches the file, with the
+    // total PCM bytes written so far. Derived classes that override this must
+    // call Close() in their own destructor.
+    virtual void OnBlockWritten(int64_t dataBytes);
+
+private:
+    void WriterLoop();
+    // Hand the front block to the writer thread, waiting until it is idle.
+    void SubmitFront();
+    void WaitIdle(std::unique_lock<std::mutex>& lock);
+    bool WriteFully(const uint8_t* data, size_t size);
+
+    int fd_;
+    int64_t dataOffset_;
+    bool directIo_;
+    SyncPolicy sync_;
+    size_t blockBytes_;
+
+    uint8_t* blocks_[2];
+    uint8_t* front_;
+    size_t frontUsed_;
+    int64_t bytesQueued_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint8_t* pending_;      // block owned by the writer thread, or nullptr
+    size_t pendingBytes_;
+    int64_t bytesOnDisk_;   // writer thread only
+    bool stop_;
+    std::atomic<bool> failed_;
+};
+
+#endif
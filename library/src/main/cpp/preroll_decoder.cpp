@@ -0,0 +1,289 @@
+#include "preroll_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "PrerollDecoder"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+bool IsHttpUri(const std::string& uri)
+{
+    return uri.rfind("http://", 0) == 0 || uri.rfind("https://", 0) == 0;
+}
+
+size_t FrameBytes(int32_t channelCount, int32_t sampleFormat)
+{
+    const size_t bytesPerSample = (sampleFormat == 1) ? 2 : ((sampleFormat == 2) ? 3 : 4);
+    return static_cast<size_t>(channelCount > 0 ? channelCount : 0) * bytesPerSample;
+}
+
+} // namespace
+
+PrerollDecoder::PrerollDecoder(const Params& params, DecodeWakeup* wakeup) : params_(params), wakeup_(wakeup)
+{
+}
+
+PrerollDecoder::~PrerollDecoder()
+{
+    Cancel();
+    Join();
+}
+
+void PrerollDecoder::Start()
+{
+    thread_ = std::thread([this]() { Run(); });
+}
+
+void PrerollDecoder::Run()
+{
+    // Explicit values win; the file is only parsed for what is missing.
+    GaplessInfo gapless;
+    if (params_.gaplessTrim) {
+        if ((params_.delayFrames < 0 || params_.paddingFrames < 0) && !IsHttpUri(params_.uri)) {
+            (void)ReadGaplessInfo(params_.uri, &gapless);
+        }
+        if (params_.delayFrames >= 0) {
+            gapless.delayFrames = params_.delayFrames;
+        }
+        if (params_.paddingFrames >= 0) {
+            gapless.paddingFrames = params_.paddingFrames;
+        }
+    }
+
+    AudioDecoder::InfoCallback infoCb = [this, gapless](int32_t sr, int32_t cc, int32_t sf, int64_t durMs) {
+        trimmer_.Configure(gapless, sr, FrameBytes(cc, sf));
+        trimStartFrames_.store(trimmer_.TrimStartFrames());
+        trimEndFrames_.store(trimmer_.TrimEndFrames());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            info_.sampleRate = sr;
+            info_.channelCount = cc;
+            info_.sampleFormat = sf;
+            info_.durationMs = durMs;
+        }
+        hasInfo_.store(true);
+        wakeup_->Notify();
+    };
+
+    AudioDecoder::ProgressCallback progressCb = [this](double progress, int64_t ptsMs, int64_t durationMs) {
+        if (active_.load() && callbacks_.progressCb) {
+            callbacks_.progressCb(progress, ptsMs, durationMs);
+        }
+    };
+
+    AudioDecoder::PcmDataCallback deliver = [this](const uint8_t* data, size_t size, int64_t ptsMs) {
+        return Deliver(data, size, ptsMs);
+    };
+    AudioDecoder::PcmDataCallback pcmCb = [this, &deliver](const uint8_t* data, size_t size, int64_t ptsMs) {
+        return trimmer_.Feed(data, size, ptsMs, deliver);
+    };
+
+    AudioDecoder::ErrorCallback errorCb = [this](const std::string& stage, int32_t code, const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!active_.load()) {
+                if (!hasError_) {
+                    hasError_ = true;
+                    errStage_ = stage;
+                    errCode_ = code;
+                    errMessage_ = message;
+                }
+                return;
+            }
+        }
+        if (callbacks_.errorCb) {
+            callbacks_.errorCb(stage, code, message);
+        }
+    };
+
+    // Seeks belong to the track being played; a staged decoder never sees them.
+    AudioDecoder::SeekPollCallback seekPollCb = [this](int64_t& targetMs, uint64_t& seq) {
+        return active_.load() && callbacks_.seekPollCb && callbacks_.seekPollCb(targetMs, seq);
+    };
+
+    AudioDecoder::SeekAppliedCallback seekAppliedCb = [this](uint64_t seq, bool success, int64_t targetMs) {
+        if (success) {
+            trimmer_.OnSeek();
+        }
+        if (callbacks_.seekAppliedCb) {
+            callbacks_.seekAppliedCb(seq, success, targetMs);
+        }
+    };
+
+    AudioDecoder::EosCallback eosCb = [this]() {
+        trimmer_.Finish();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!active_.load()) {
+                endedWhileStaged_ = true;
+                return false;
+            }
+        }
+        return callbacks_.eosCb ? callbacks_.eosCb() : false;
+    };
+
+    decoder_.SetWakeup(wakeup_);
+    result_ = decoder_.DecodeToPcmStream(params_.uri, params_.sampleRate, params_.channelCount, params_.bitrate,
+                                         infoCb, progressCb, pcmCb, errorCb, &cancel_, params_.sampleFormat,
+                                         seekPollCb, seekAppliedCb, eosCb);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.store(true);
+    }
+    stageCond_.notify_all();
+    wakeup_->Notify();
+}
+
+bool PrerollDecoder::Deliver(const uint8_t* data, size_t size, int64_t ptsMs)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    // While Activate() drains the queue nothing new is staged, so the drain terminates.
+    stageCond_.wait(lock, [this, size]() {
+        return active_.load() || cancel_.load() ||
+               (!activating_ && (stagedBytes_ == 0 || stagedBytes_ + size <= params_.stageBytes));
+    });
+    if (cancel_.load()) {
+        return false;
+    }
+    if (!active_.load()) {
+        staged_.emplace_back(data, data + size);
+        stagedBytes_ += size;
+        lock.unlock();
+        if (readerWaiting_.load()) {
+            wakeup_->NotifyState();
+        }
+        return true;
+    }
+    lock.unlock();
+
+    if (!callbacks_.pcmCb(data, size, ptsMs)) {
+        // The consumer stopped (closed): end like a cancel rather than a decode error.
+        cancel_.store(true);
+        return false;
+    }
+    return true;
+}
+
+bool PrerollDecoder::WaitInfo(Info* info, const std::atomic<bool>* abort)
+{
+    wakeup_->Wait([this, abort]() { return hasInfo_.load() || finished_.load() || (abort && abort->load()); });
+    if (!hasInfo_.load() || (abort && abort->load())) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    *info = info_;
+    return true;
+}
+
+size_t PrerollDecoder::ReadStaged(uint8_t* dst, size_t size, const std::atomic<bool>* abort)
+{
+    size_t copied = 0;
+    while (copied < size) {
+        // Staging holds at most stageBytes, so never wait for more than half of it at once.
+        const size_t want = std::max<size_t>(1, std::min(size - copied, params_.stageBytes / 2));
+        readerWaiting_.store(true);
+        wakeup_->Wait([this, want, abort]() {
+            return stagedBytes_.load() >= want || finished_.load() || cancel_.load() || (abort && abort->load());
+        });
+        readerWaiting_.store(false);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (copied < size && !staged_.empty()) {
+                std::vector<uint8_t>& front = staged_.front();
+                const size_t n = std::min(size - copied, front.size());
+                memcpy(dst + copied, front.data(), n);
+                copied += n;
+                stagedBytes_ -= n;
+                if (n == front.size()) {
+                    staged_.pop_front();
+                } else {
+                    front.erase(front.begin(), front.begin() + static_cast<std::ptrdiff_t>(n));
+                }
+            }
+        }
+        stageCond_.notify_all();
+        if (finished_.load() || cancel_.load() || (abort && abort->load())) {
+            if (stagedBytes_.load() == 0) {
+                break;
+            }
+        }
+    }
+    return copied;
+}
+
+bool PrerollDecoder::Activate(const Callbacks& callbacks)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callbacks_ = callbacks;
+        activating_ = true;
+    }
+
+    size_t replayed = 0;
+    for (;;) {
+        std::vector<uint8_t> chunk;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (staged_.empty()) {
+                active_.store(true);
+                activating_ = false;
+                break;
+            }
+            chunk = std::move(staged_.front());
+            staged_.pop_front();
+            stagedBytes_ -= chunk.size();
+        }
+        if (!callbacks.pcmCb(chunk.data(), chunk.size(), -1)) {
+            Cancel();
+            return false;
+        }
+        replayed += chunk.size();
+    }
+    stageCond_.notify_all();
+    OH_LOG_INFO(LOG_APP, "Activated %{public}s after %{public}llu staged bytes", params_.uri.c_str(),
+                (unsigned long long)replayed);
+    return true;
+}
+
+void PrerollDecoder::Cancel()
+{
+    cancel_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    stageCond_.notify_all();
+    wakeup_->Notify();
+}
+
+bool PrerollDecoder::Join()
+{
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    return result_;
+}
+
+bool PrerollDecoder::EndedWhileStaged()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endedWhileStaged_;
+}
+
+bool PrerollDecoder::TakeStagedError(std::string* stage, int32_t* code, std::string* message)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hasError_) {
+        return false;
+    }
+    hasError_ = false;
+    *stage = errStage_;
+    *code = errCode_;
+    *message = errMessage_;
+    return true;
+}
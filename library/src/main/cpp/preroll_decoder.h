@@ -0,0 +1,134 @@
+#ifndef PREROLL_DECODER_H
+#define PREROLL_DECODER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "decode_wakeup.h"
+#include "gapless_trim.h"
+
+// Decodes the next source of a playlist ahead of time on its own thread.
+//
+// Until Activate() the decoder runs "staged": its PCM (already gapless-trimmed)
+// is kept in a bounded staging queue and the thread blocks once stageBytes are
+// buffered, so the source is opened and the codec primed while the current
+// track still plays. Activate() replays the staged PCM through the caller's
+// callbacks on the calling thread, then hands the running decoder over to the
+// same callbacks; the PCM reaches them as one contiguous sequence. From then on
+// only the thread of this object calls them.
+class PrerollDecoder {
+public:
+    struct Params {
+        uint64_t id = 0;  // caller's tag for the track
+        std::string uri;
+        int32_t sampleRate = 0;
+        int32_t channelCount = 0;
+        int32_t bitrate = 0;
+        int32_t sampleFormat = 0;
+        size_t stageBytes = 0;
+        bool gaplessTrim = true;
+        // Explicit encoder delay/padding (frames); < 0 reads them from the file.
+        int64_t delayFrames = -1;
+        int64_t paddingFrames = -1;
+    };
+
+    struct Info {
+        int32_t sampleRate = 0;
+        int32_t channelCount = 0;
+        int32_t sampleFormat = 0;
+        int64_t durationMs = 0;
+    };
+
+    // Used once active. eosCb is also called by the owner when the track ended while staged.
+    struct Callbacks {
+        AudioDecoder::ProgressCallback progressCb;
+        AudioDecoder::PcmDataCallback pcmCb;
+        AudioDecoder::ErrorCallback errorCb;
+        AudioDecoder::SeekPollCallback seekPollCb;
+        AudioDecoder::SeekAppliedCallback seekAppliedCb;
+        AudioDecoder::EosCallback eosCb;
+    };
+
+    // wakeup: shared with the owner's decode loop; notified when info arrives or decoding ends.
+    PrerollDecoder(const Params& params, DecodeWakeup* wakeup);
+    ~PrerollDecoder();
+
+    PrerollDecoder(const PrerollDecoder&) = delete;
+    PrerollDecoder& operator=(const PrerollDecoder&) = delete;
+
+    void Start();
+
+    // Block until the output format is known (true), or decoding ended or abort was set (false).
+    bool WaitInfo(Info* info, const std::atomic<bool>* abort);
+
+    // Take size bytes of staged PCM ahead of Activate(), waiting while the decoder is
+    // still producing (e.g. to mix the start of the track into a crossfade). Fewer
+    // bytes only when the track ended or was cancelled, or abort was set.
+    size_t ReadStaged(uint8_t* dst, size_t size, const std::atomic<bool>* abort);
+
+    // Replay staged PCM through callbacks.pcmCb, then switch the decoder over.
+    // False if pcmCb asked to stop (the decoder is cancelled).
+    bool Activate(const Callbacks& callbacks);
+
+    // Stop decoding; safe from any thread.
+    void Cancel();
+
+    bool IsFinished() const { return finished_.load(); }
+
+    // Wait for the decode thread; returns the DecodeToPcmStream result.
+    bool Join();
+
+    // The track reached EOS before Activate(): the owner has to run eosCb itself.
+    bool EndedWhileStaged();
+
+    // First error reported before Activate().
+    bool TakeStagedError(std::string* stage, int32_t* code, std::string* message);
+
+    const Params& GetParams() const { return params_; }
+    int64_t TrimStartFrames() const { return trimStartFrames_.load(); }
+    int64_t TrimEndFrames() const { return trimEndFrames_.load(); }
+    AudioDecoder* Decoder() { return &decoder_; }
+
+private:
+    void Run();
+    bool Deliver(const uint8_t* data, size_t size, int64_t ptsMs);
+
+    Params params_;
+    DecodeWakeup* wakeup_;
+    AudioDecoder decoder_;
+    std::thread thread_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> hasInfo_{false};
+    bool result_ = false;
+
+    // Decode thread only.
+    PcmTrimmer trimmer_;
+    std::atomic<int64_t> trimStartFrames_{0};
+    std::atomic<int64_t> trimEndFrames_{0};
+
+    std::mutex mutex_;
+    std::condition_variable stageCond_;
+    Info info_;
+    std::deque<std::vector<uint8_t>> staged_;
+    std::atomic<size_t> stagedBytes_{0};  // written under mutex_
+    std::atomic<bool> readerWaiting_{false};
+    bool activating_ = false;  // staging stopped, Activate() draining
+    std::atomic<bool> active_{false};
+    bool endedWhileStaged_ = false;
+    bool hasError_ = false;
+    std::string errStage_;
+    int32_t errCode_ = 0;
+    std::string errMessage_;
+    Callbacks callbacks_;
+};
+
+#endif
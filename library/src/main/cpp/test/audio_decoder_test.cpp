@@ -0,0 +1,388 @@
+// AudioDecoder::DecodeToPcmStream on the host media backend: every supported
+// source layout decodes to the same PCM, and seeks posted mid-stream resume at
+// the first packet at or after the target with contiguous data and matching
+// timestamps, with and without simulated read/decode delays. DecodeFile runs
+// inputs of far more than 100k packets through to the end, and a codec that
+// dies mid-stream ends both loops with an error instead of leaving them waiting.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "codec_pool.h"
+#include "decode_wakeup.h"
+#include "media/host_media_backend.h"
+#include "test_util.h"
+#include "wav_file_writer.h"
+
+namespace {
+
+constexpr int32_t kSampleRate = 48000;
+constexpr int32_t kChannels = 2;
+constexpr int64_t kFrameBytes = kChannels * sizeof(int16_t);
+constexpr int32_t kPacketFrames = 1024;
+
+// Pooled codecs keep pointers to the backend that created them.
+struct SharedPoolReset {
+    SharedPoolReset() { CodecPool::Shared().Clear(); }
+    ~SharedPoolReset() { CodecPool::Shared().Clear(); }
+};
+
+bool WriteWav(const std::string& path, const PcmFileFormat& format, const void* data, size_t size)
+{
+    WavFileWriter writer;
+    return writer.Open(path, PcmFileWriter::Options()) && writer.SetFormat(format) &&
+           writer.Write(static_cast<const uint8_t*>(data), size) && writer.Close();
+}
+
+bool WriteRaw(const std::string& path, const void* data, size_t size)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+media::HostMediaBackend::Options MakeOptions(int64_t readLatencyUs, int64_t readJitterUs, int64_t decodeLatencyUs,
+                                             int64_t decodeJitterUs)
+{
+    media::HostMediaBackend::Options options;
+    options.rawSampleRate = kSampleRate;
+    options.rawChannelCount = kChannels;
+    options.rawSampleFormat = 1;
+    options.packetFrames = kPacketFrames;
+    options.readLatencyUs = readLatencyUs;
+    options.readJitterUs = readJitterUs;
+    options.decodeLatencyUs = decodeLatencyUs;
+    options.decodeJitterUs = decodeJitterUs;
+    options.seed = test::Seed();
+    return options;
+}
+
+std::vector<uint8_t> DecodeAll(media::Backend& backend, const std::string& path)
+{
+    AudioDecoder decoder(backend);
+    std::vector<uint8_t> out;
+    std::atomic<bool> cancel(false);
+    const bool ok = decoder.DecodeToPcmStream(
+        path, 0, 0, 0, nullptr, nullptr,
+        [&out](const uint8_t* data, size_t size, int64_t) {
+            out.insert(out.end(), data, data + size);
+            return true;
+        },
+        nullptr, &cancel, 1, AudioDecoder::SeekPollCallback(), AudioDecoder::SeekAppliedCallback(),
+        []() { return false; });
+    EXPECT_TRUE(ok);
+    return out;
+}
+
+// 16-bit, 24-bit (WAVE_FORMAT_EXTENSIBLE), float and headerless sources of the
+// same 16-bit signal all decode to it exactly as S16.
+TEST(AudioDecoderTest, SourceLayoutsDecodeToTheSameS16)
+{
+    SharedPoolReset reset;
+    test::TempDir dir;
+    std::mt19937 rng = test::Rng(1);
+    std::vector<int16_t> pcm(kChannels * (kSampleRate / 2 + 777));
+    for (int16_t& s : pcm) {
+        s = static_cast<int16_t>(rng());
+    }
+    std::vector<uint8_t> s24(pcm.size() * 3);
+    std::vector<float> f32(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) {
+        const uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(pcm[i]) * 256);
+        s24[i * 3] = static_cast<uint8_t>(u);
+        s24[i * 3 + 1] = static_cast<uint8_t>(u >> 8);
+        s24[i * 3 + 2] = static_cast<uint8_t>(u >> 16);
+        f32[i] = static_cast<float>(pcm[i]) / 32768.0f;
+    }
+    const size_t s16Bytes = pcm.size() * sizeof(int16_t);
+    ASSERT_TRUE(WriteWav(dir.File("s16.wav"), PcmFileFormat{kSampleRate, kChannels, 16, false}, pcm.data(), s16Bytes));
+    ASSERT_TRUE(WriteWav(dir.File("s24.wav"), PcmFileFormat{kSampleRate, kChannels, 24, false}, s24.data(), s24.size()));
+    ASSERT_TRUE(WriteWav(dir.File("f32.wav"), PcmFileFormat{kSampleRate, kChannels, 32, true}, f32.data(),
+                         f32.size() * sizeof(float)));
+    ASSERT_TRUE(WriteRaw(dir.File("s16.pcm"), pcm.data(), s16Bytes));
+
+    const std::vector<uint8_t> expected(reinterpret_cast<const uint8_t*>(pcm.data()),
+                                        reinterpret_cast<const uint8_t*>(pcm.data()) + s16Bytes);
+    media::HostMediaBackend backend(MakeOptions(0, 0, 0, 0));
+    for (const char* name : {"s16.wav", "s24.wav", "f32.wav", "s16.pcm"}) {
+        SCOPED_TRACE(name);
+        EXPECT_TRUE(DecodeAll(backend, dir.File(name)) == expected);
+    }
+}
+
+// Frame f carries f in its two 16-bit samples, so every chunk says where it came from.
+std::vector<int16_t> IndexedFrames(int64_t frames)
+{
+    std::vector<int16_t> pcm(static_cast<size_t>(frames * kChannels));
+    for (int64_t f = 0; f < frames; f++) {
+        pcm[f * kChannels] = static_cast<int16_t>(f & 0xFFFF);
+        pcm[f * kChannels + 1] = static_cast<int16_t>(f >> 16);
+    }
+    return pcm;
+}
+
+int64_t FrameAt(const uint8_t* data)
+{
+    int16_t s[kChannels];
+    memcpy(s, data, sizeof(s));
+    return static_cast<int64_t>(static_cast<uint16_t>(s[0])) | (static_cast<int64_t>(s[1]) << 16);
+}
+
+int64_t PtsUs(int64_t frame) { return frame * 1000000 / kSampleRate; }
+
+// First frame the decoder passes on after a seek to targetMs: decoded packets
+// whose pts lies before the target are dropped.
+int64_t FirstFrameAfterSeek(int64_t targetMs)
+{
+    int64_t frame = 0;
+    while (PtsUs(frame) < targetMs * 1000) {
+        frame += kPacketFrames;
+    }
+    return frame;
+}
+
+// Posts the seeks of a plan from the PCM callback, after a given number of
+// chunks each, and checks every chunk against the source position.
+class SeekChecker {
+public:
+    struct Step {
+        int chunksBefore;
+        int64_t targetMs;
+    };
+
+    SeekChecker(int64_t totalFrames, std::vector<Step> plan) : totalFrames_(totalFrames), plan_(std::move(plan)) {}
+
+    bool Poll(int64_t& targetMs, uint64_t& seq)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_) {
+            return false;
+        }
+        pending_ = false;
+        targetMs = plan_[posted_ - 1].targetMs;
+        seq = posted_;
+        return true;
+    }
+
+    void Applied(uint64_t seq, bool success, int64_t targetMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_TRUE(success);
+        EXPECT_EQ(seq, posted_);
+        EXPECT_EQ(targetMs, plan_[seq - 1].targetMs);
+        next_ = FirstFrameAfterSeek(targetMs);
+        applied_++;
+    }
+
+    bool OnPcm(const uint8_t* data, size_t size, int64_t ptsUs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_EQ(size % kFrameBytes, 0u);
+        const int64_t frames = static_cast<int64_t>(size) / kFrameBytes;
+        const int64_t first = FrameAt(data);
+        EXPECT_EQ(first, next_) << "after " << applied_ << " seeks";
+        EXPECT_EQ(ptsUs, PtsUs(first));
+        for (int64_t i = 1; i < frames; i++) {
+            if (FrameAt(data + i * kFrameBytes) != first + i) {
+                ADD_FAILURE() << "chunk at frame " << first << " not contiguous at " << i;
+                break;
+            }
+        }
+        next_ = first + frames;
+        chunks_++;
+        if (!pending_ && posted_ < plan_.size() && chunks_ >= plan_[posted_].chunksBefore) {
+            chunks_ = 0;
+            posted_++;
+            pending_ = true;
+        }
+        return true;
+    }
+
+    void ExpectFinished()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_EQ(applied_, plan_.size());
+        EXPECT_EQ(next_, totalFrames_);
+    }
+
+private:
+    std::mutex mutex_;
+    const int64_t totalFrames_;
+    const std::vector<Step> plan_;
+    size_t posted_ = 0;
+    size_t applied_ = 0;
+    bool pending_ = false;
+    int chunks_ = 0;
+    int64_t next_ = 0;
+};
+
+// Forward, backward, packet-aligned (1024 frames = 21.333 ms, so 64 ms is frame
+// 3072) and repeated targets, without and with read/decode delays.
+TEST(AudioDecoderTest, SeeksResumeAtTheTargetPacket)
+{
+    SharedPoolReset reset;
+    test::TempDir dir;
+    const int64_t totalFrames = 4 * kSampleRate + 333;
+    const std::vector<int16_t> pcm = IndexedFrames(totalFrames);
+    const std::string path = dir.File("indexed.wav");
+    ASSERT_TRUE(WriteWav(path, PcmFileFormat{kSampleRate, kChannels, 16, false}, pcm.data(),
+                         pcm.size() * sizeof(int16_t)));
+    ASSERT_EQ(FirstFrameAfterSeek(64), 3072);
+
+    const std::vector<SeekChecker::Step> plan = {
+        {5, 3000}, {3, 500}, {1, 64}, {4, 2222}, {2, 2222}, {6, 0}, {10, 3900},
+    };
+    struct Delays {
+        int64_t readUs;
+        int64_t readJitterUs;
+        int64_t decodeUs;
+        int64_t decodeJitterUs;
+    };
+    for (const Delays& d : {Delays{0, 0, 0, 0}, Delays{50, 300, 100, 300}}) {
+        SCOPED_TRACE(testing::Message() << "read " << d.readUs << "+" << d.readJitterUs << " us, decode "
+                                        << d.decodeUs << "+" << d.decodeJitterUs << " us");
+        media::HostMediaBackend backend(MakeOptions(d.readUs, d.readJitterUs, d.decodeUs, d.decodeJitterUs));
+        AudioDecoder decoder(backend);
+        SeekChecker checker(totalFrames, plan);
+        std::atomic<bool> cancel(false);
+        const bool ok = decoder.DecodeToPcmStream(
+            path, 0, 0, 0, nullptr, nullptr,
+            [&checker](const uint8_t* data, size_t size, int64_t ptsUs) { return checker.OnPcm(data, size, ptsUs); },
+            nullptr, &cancel, 1,
+            [&checker](int64_t& targetMs, uint64_t& seq) { return checker.Poll(targetMs, seq); },
+            [&checker](uint64_t seq, bool success, int64_t targetMs) { checker.Applied(seq, success, targetMs); },
+            []() { return false; });
+        EXPECT_TRUE(ok);
+        checker.ExpectFinished();
+    }
+}
+
+// 120k packets of 16 frames: the file loop has no iteration cap, so a long
+// input (the packet count of hours of MP3) decodes whole.
+TEST(AudioDecoderTest, DecodeFileTakesLongInputs)
+{
+    SharedPoolReset reset;
+    test::TempDir dir;
+    constexpr int32_t kSmallPackets = 16;
+    constexpr int64_t kPackets = 120000;
+    const std::vector<int16_t> pcm = IndexedFrames(kPackets * kSmallPackets);
+    const size_t bytes = pcm.size() * sizeof(int16_t);
+    ASSERT_TRUE(WriteWav(dir.File("long.wav"), PcmFileFormat{kSampleRate, kChannels, 16, false}, pcm.data(), bytes));
+
+    media::HostMediaBackend::Options options = MakeOptions(0, 0, 0, 0);
+    options.packetFrames = kSmallPackets;
+    media::HostMediaBackend backend(options);
+    AudioDecoder decoder(backend);
+    ASSERT_TRUE(decoder.DecodeFile(dir.File("long.wav"), dir.File("long.pcm")));
+
+    std::vector<uint8_t> out(bytes + 1);
+    FILE* file = fopen(dir.File("long.pcm").c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    out.resize(fread(out.data(), 1, out.size(), file));
+    fclose(file);
+    ASSERT_EQ(out.size(), bytes);
+    EXPECT_EQ(memcmp(out.data(), pcm.data(), bytes), 0);
+}
+
+// Cancels the decode if it is still running after a few seconds, so a loop
+// left waiting fails the test instead of hanging it.
+class Watchdog {
+public:
+    Watchdog(DecodeWakeup& wakeup, std::atomic<bool>& cancel)
+        : thread_([this, &wakeup, &cancel]() {
+              std::unique_lock<std::mutex> lock(mutex_);
+              if (!cond_.wait_for(lock, std::chrono::seconds(10), [this]() { return done_; })) {
+                  cancel.store(true);
+                  wakeup.Notify();
+              }
+          })
+    {
+    }
+    ~Watchdog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool done_ = false;
+    std::thread thread_;
+};
+
+TEST(AudioDecoderTest, CodecErrorEndsTheDecode)
+{
+    SharedPoolReset reset;
+    test::TempDir dir;
+    const std::vector<int16_t> pcm = IndexedFrames(100 * kPacketFrames);
+    const std::string path = dir.File("indexed.wav");
+    ASSERT_TRUE(WriteWav(path, PcmFileFormat{kSampleRate, kChannels, 16, false}, pcm.data(),
+                         pcm.size() * sizeof(int16_t)));
+    media::HostMediaBackend::Options options = MakeOptions(0, 0, 0, 0);
+    options.failAtPacket = 20;
+    media::HostMediaBackend backend(options);
+
+    {
+        DecodeWakeup wakeup;  // outlives the decoder and its codec callbacks
+        AudioDecoder decoder(backend);
+        decoder.SetWakeup(&wakeup);
+        std::atomic<bool> cancel(false);
+        std::vector<std::string> errors;
+        int64_t frames = 0;
+        bool ok = true;
+        {
+            Watchdog watchdog(wakeup, cancel);
+            ok = decoder.DecodeToPcmStream(
+                path, 0, 0, 0, nullptr, nullptr,
+                [&frames](const uint8_t*, size_t size, int64_t) {
+                    frames += static_cast<int64_t>(size) / kFrameBytes;
+                    return true;
+                },
+                [&errors](const std::string& stage, int32_t code, const std::string&) {
+                    errors.push_back(stage + " " + std::to_string(code));
+                },
+                &cancel, 1, AudioDecoder::SeekPollCallback(), AudioDecoder::SeekAppliedCallback(),
+                []() { return false; });
+        }
+        EXPECT_FALSE(cancel.load()) << "the decode loop kept waiting after the codec error";
+        EXPECT_FALSE(ok);
+        EXPECT_EQ(errors, std::vector<std::string>{"codec 6"});
+        EXPECT_LE(frames, 20 * kPacketFrames);
+    }
+    {
+        DecodeWakeup wakeup;  // outlives the decoder and its codec callbacks
+        AudioDecoder decoder(backend);
+        decoder.SetWakeup(&wakeup);
+        std::atomic<bool> cancel(false);
+        bool ok = true;
+        {
+            Watchdog watchdog(wakeup, cancel);
+            ok = decoder.DecodeFileWithProgress(path, dir.File("out.pcm"), 0, 0, 0, nullptr, &cancel);
+        }
+        EXPECT_FALSE(cancel.load()) << "the file loop kept waiting after the codec error";
+        EXPECT_FALSE(ok);
+    }
+}
+
+} // namespace
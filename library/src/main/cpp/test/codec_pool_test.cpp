@@ -0,0 +1,297 @@
+// CodecPool: warm / reset / miss selection, LRU eviction, the idle limit,
+// discards and the stats, on fake codecs that count their destruction; then
+// the pool behind AudioDecoder on the host media backend, where reused codecs
+// must still decode the source exactly.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "codec_pool.h"
+#include "media/host_media_backend.h"
+#include "test_util.h"
+#include "wav_file_writer.h"
+
+namespace {
+
+int g_destroyed = 0;
+
+class FakeCodec final : public media::Codec {
+public:
+    ~FakeCodec() override { g_destroyed++; }
+
+    int32_t RegisterCallbacks(const media::CodecCallbacks&, void*) override { return media::kOk; }
+    int32_t Configure(const media::CodecFormat&) override { return media::kOk; }
+    int32_t Prepare() override { return media::kOk; }
+    int32_t Start() override { return media::kOk; }
+    int32_t Stop() override { return media::kOk; }
+    int32_t Flush() override { return media::kOk; }
+    int32_t Reset() override { return media::kOk; }
+    int32_t PushInputBuffer(uint32_t) override { return media::kOk; }
+    int32_t FreeOutputBuffer(uint32_t) override { return media::kOk; }
+};
+
+CodecPool::Config MakeConfig(int32_t sampleRate, int32_t sampleFormat = 1)
+{
+    CodecPool::Config config;
+    config.sampleRate = sampleRate;
+    config.channelCount = 2;
+    config.sampleFormat = sampleFormat;
+    return config;
+}
+
+CodecPool::Entry MakeEntry(const media::Backend* backend, const std::string& mime, const CodecPool::Config& config,
+                           bool configured = true)
+{
+    CodecPool::Entry entry;
+    entry.backend = backend;
+    entry.codec = new FakeCodec();
+    entry.mimeType = mime;
+    entry.configured = configured;
+    entry.config = config;
+    return entry;
+}
+
+class CodecPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override { g_destroyed = 0; }
+
+    // Only identities are compared; nothing is created through them.
+    media::HostMediaBackend backendA_;
+    media::HostMediaBackend backendB_;
+};
+
+TEST_F(CodecPoolTest, WarmResetAndMiss)
+{
+    CodecPool pool;
+    CodecPool::Entry entry;
+    EXPECT_EQ(pool.Acquire(&backendA_, "audio/flac", MakeConfig(48000), &entry), CodecPool::Reuse::Miss);
+    EXPECT_EQ(entry.codec, nullptr);
+
+    CodecPool::Entry released = MakeEntry(&backendA_, "audio/flac", MakeConfig(48000));
+    media::Codec* codec = released.codec;
+    ASSERT_TRUE(pool.Release(released));
+    EXPECT_EQ(pool.GetStats().idle, 1u);
+
+    // Another MIME or another backend never gets it.
+    EXPECT_EQ(pool.Acquire(&backendA_, "audio/mpeg", MakeConfig(48000), &entry), CodecPool::Reuse::Miss);
+    EXPECT_EQ(pool.Acquire(&backendB_, "audio/flac", MakeConfig(48000), &entry), CodecPool::Reuse::Miss);
+
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/flac", MakeConfig(48000), &entry), CodecPool::Reuse::Warm);
+    EXPECT_EQ(entry.codec, codec);
+    EXPECT_EQ(pool.GetStats().idle, 0u);
+    ASSERT_TRUE(pool.Release(entry));
+
+    // Any other setting, the extradata hash included, needs a reset.
+    CodecPool::Config other = MakeConfig(48000);
+    other.codecConfigHash = CodecPool::HashCodecConfig({1, 2, 3});
+    entry = CodecPool::Entry();
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/flac", other, &entry), CodecPool::Reuse::Reset);
+    EXPECT_EQ(entry.codec, codec);
+
+    // A codec that never finished configuring is not warm even with the same config.
+    entry.configured = false;
+    entry.config = other;
+    ASSERT_TRUE(pool.Release(entry));
+    EXPECT_EQ(pool.Acquire(&backendA_, "audio/flac", other, &entry), CodecPool::Reuse::Reset);
+    ASSERT_TRUE(pool.Release(entry));
+
+    const CodecPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.warmHits, 1u);
+    EXPECT_EQ(stats.resetHits, 2u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(g_destroyed, 0);
+    pool.Clear();
+    EXPECT_EQ(g_destroyed, 1);
+}
+
+// A warm match wins over a more recently parked codec of the same MIME; among
+// equals the most recent is taken.
+TEST_F(CodecPoolTest, PrefersWarmThenMostRecent)
+{
+    CodecPool pool;
+    CodecPool::Entry a = MakeEntry(&backendA_, "audio/mp4a-latm", MakeConfig(44100));
+    CodecPool::Entry b = MakeEntry(&backendA_, "audio/mp4a-latm", MakeConfig(48000));
+    CodecPool::Entry c = MakeEntry(&backendA_, "audio/mp4a-latm", MakeConfig(48000));
+    media::Codec* codecA = a.codec;
+    media::Codec* codecC = c.codec;
+    pool.Release(a);
+    pool.Release(b);
+    pool.Release(c);
+
+    CodecPool::Entry entry;
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/mp4a-latm", MakeConfig(44100), &entry), CodecPool::Reuse::Warm);
+    EXPECT_EQ(entry.codec, codecA);
+    pool.Discard(entry);
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/mp4a-latm", MakeConfig(48000), &entry), CodecPool::Reuse::Warm);
+    EXPECT_EQ(entry.codec, codecC);
+    pool.Discard(entry);
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/mp4a-latm", MakeConfig(96000), &entry), CodecPool::Reuse::Reset);
+    pool.Discard(entry);
+    EXPECT_EQ(g_destroyed, 3);
+    EXPECT_EQ(pool.GetStats().discards, 3u);
+}
+
+TEST_F(CodecPoolTest, EvictsLeastRecentlyUsed)
+{
+    CodecPool pool;
+    pool.SetMaxIdle(2);
+    std::vector<media::Codec*> codecs;
+    for (int32_t rate : {8000, 16000, 32000}) {
+        CodecPool::Entry e = MakeEntry(&backendA_, "audio/flac", MakeConfig(rate));
+        codecs.push_back(e.codec);
+        ASSERT_TRUE(pool.Release(e));
+    }
+    CodecPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.idle, 2u);
+    EXPECT_EQ(stats.maxIdle, 2u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(g_destroyed, 1);
+
+    CodecPool::Entry entry;
+    EXPECT_EQ(pool.Acquire(&backendA_, "audio/flac", MakeConfig(8000), &entry), CodecPool::Reuse::Reset);
+    EXPECT_EQ(entry.codec, codecs[2]);
+    pool.Release(entry);
+
+    // Taking a codec out and back makes it the most recent: the 16 kHz one goes.
+    pool.SetMaxIdle(1);
+    EXPECT_EQ(g_destroyed, 2);
+    EXPECT_EQ(pool.Acquire(&backendA_, "audio/flac", MakeConfig(32000), &entry), CodecPool::Reuse::Warm);
+    EXPECT_EQ(entry.codec, codecs[2]);
+    pool.Release(entry);
+
+    // 0 disables pooling: idle codecs go and released ones are destroyed.
+    pool.SetMaxIdle(0);
+    EXPECT_EQ(g_destroyed, 3);
+    EXPECT_FALSE(pool.Release(MakeEntry(&backendA_, "audio/flac", MakeConfig(8000))));
+    EXPECT_EQ(g_destroyed, 4);
+    EXPECT_EQ(pool.GetStats().idle, 0u);
+
+    pool.SetMaxIdle(1000);
+    EXPECT_EQ(pool.GetStats().maxIdle, CodecPool::kMaxIdleLimit);
+}
+
+// A parked codec's late callbacks must not reach the decoder that returned it.
+TEST_F(CodecPoolTest, ParksTheCallbackSignal)
+{
+    CodecPool pool;
+    DecodeWakeup decoderWakeup;
+    CodecPool::Entry entry = MakeEntry(&backendA_, "audio/flac", MakeConfig(48000));
+    entry.signal = new AudioDecoderSignal();
+    entry.signal->wakeup_.store(&decoderWakeup);
+    AudioDecoderSignal* signal = entry.signal;
+    ASSERT_TRUE(pool.Release(entry));
+    EXPECT_NE(signal->wakeup_.load(), &decoderWakeup);
+    EXPECT_NE(signal->wakeup_.load(), nullptr);
+
+    ASSERT_EQ(pool.Acquire(&backendA_, "audio/flac", MakeConfig(48000), &entry), CodecPool::Reuse::Warm);
+    EXPECT_EQ(entry.signal, signal);
+    pool.Discard(entry);
+    pool.Discard(CodecPool::Entry());
+    EXPECT_EQ(pool.GetStats().discards, 1u);
+}
+
+TEST_F(CodecPoolTest, CreateStatsAndConfigHash)
+{
+    CodecPool pool;
+    pool.RecordCreate(300, true);
+    pool.RecordCreate(100, true);
+    pool.RecordCreate(0, false);
+    const CodecPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.creates, 2u);
+    EXPECT_EQ(stats.createFailures, 1u);
+    EXPECT_EQ(stats.createUsTotal, 400);
+    EXPECT_EQ(stats.createUsLast, 100);
+    EXPECT_EQ(stats.createUsMax, 300);
+
+    EXPECT_EQ(CodecPool::HashCodecConfig({}), 0u);
+    EXPECT_NE(CodecPool::HashCodecConfig({0}), 0u);
+    EXPECT_NE(CodecPool::HashCodecConfig({1, 2}), CodecPool::HashCodecConfig({2, 1}));
+}
+
+// ---------------------------------------------------------------------------
+// Through AudioDecoder on the host backend.
+// ---------------------------------------------------------------------------
+
+bool WriteWav(const std::string& path, const std::vector<int16_t>& pcm)
+{
+    WavFileWriter writer;
+    return writer.Open(path, PcmFileWriter::Options()) && writer.SetFormat(PcmFileFormat{48000, 2, 16, false}) &&
+           writer.Write(reinterpret_cast<const uint8_t*>(pcm.data()), pcm.size() * sizeof(int16_t)) &&
+           writer.Close();
+}
+
+std::vector<uint8_t> DecodeAll(media::Backend& backend, const std::string& path, int32_t sampleFormat)
+{
+    AudioDecoder decoder(backend);
+    std::vector<uint8_t> out;
+    std::atomic<bool> cancel(false);
+    const bool ok = decoder.DecodeToPcmStream(
+        path, 0, 0, 0, nullptr, nullptr,
+        [&out](const uint8_t* data, size_t size, int64_t) {
+            out.insert(out.end(), data, data + size);
+            return true;
+        },
+        nullptr, &cancel, sampleFormat, AudioDecoder::SeekPollCallback(), AudioDecoder::SeekAppliedCallback(),
+        []() { return false; });
+    EXPECT_TRUE(ok);
+    return out;
+}
+
+// Pooled codecs keep pointers to the backend that created them.
+struct SharedPoolReset {
+    SharedPoolReset() { CodecPool::Shared().Clear(); }
+    ~SharedPoolReset() { CodecPool::Shared().Clear(); }
+};
+
+TEST(CodecPoolDecodeTest, ReusedCodecsDecodeExactly)
+{
+    SharedPoolReset reset;
+    test::TempDir dir;
+    std::mt19937 rng = test::Rng(1);
+    std::vector<int16_t> pcm(2 * 48000 / 2 + 2 * 333);
+    for (int16_t& s : pcm) {
+        s = static_cast<int16_t>(rng());
+    }
+    const std::string path = dir.File("source.wav");
+    ASSERT_TRUE(WriteWav(path, pcm));
+    const std::vector<uint8_t> s16(reinterpret_cast<const uint8_t*>(pcm.data()),
+                                   reinterpret_cast<const uint8_t*>(pcm.data() + pcm.size()));
+    std::vector<uint8_t> s32(pcm.size() * sizeof(int32_t));
+    for (size_t i = 0; i < pcm.size(); i++) {
+        const int32_t v = static_cast<int32_t>(pcm[i]) * 65536;
+        memcpy(&s32[i * sizeof(int32_t)], &v, sizeof(v));
+    }
+
+    media::HostMediaBackend backend;
+    const CodecPool::Stats before = CodecPool::Shared().GetStats();
+    EXPECT_TRUE(DecodeAll(backend, path, 1) == s16);
+    CodecPool::Stats stats = CodecPool::Shared().GetStats();
+    EXPECT_EQ(stats.misses - before.misses, 1u);
+    EXPECT_EQ(stats.creates - before.creates, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+
+    EXPECT_TRUE(DecodeAll(backend, path, 1) == s16);
+    EXPECT_TRUE(DecodeAll(backend, path, 3) == s32);
+    EXPECT_TRUE(DecodeAll(backend, path, 3) == s32);
+    stats = CodecPool::Shared().GetStats();
+    EXPECT_EQ(stats.misses - before.misses, 1u);
+    EXPECT_EQ(stats.warmHits - before.warmHits, 2u);
+    EXPECT_EQ(stats.resetHits - before.resetHits, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+
+    // Another backend gets its own codec.
+    media::HostMediaBackend other;
+    EXPECT_TRUE(DecodeAll(other, path, 1) == s16);
+    stats = CodecPool::Shared().GetStats();
+    EXPECT_EQ(stats.misses - before.misses, 2u);
+    EXPECT_EQ(stats.idle, 2u);
+}
+
+} // namespace
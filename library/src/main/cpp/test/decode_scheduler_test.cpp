@@ -0,0 +1,319 @@
+// DecodeScheduler: queue order by priority (FIFO within one), the thread
+// limit under load and while it changes, the nice value and retirement of low
+// priority threads, a 1000-task burst, the destructor dropping queued work,
+// and Parallel() fan-outs sharing the limit without waiting on queued helpers.
+// Run in the FREE_PCM_SANITIZE=thread build too.
+
+#include <gtest/gtest.h>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "decode_scheduler.h"
+
+namespace {
+
+using Priority = DecodeScheduler::Priority;
+
+// Polls pred for up to 10 s.
+template <typename Pred>
+bool WaitFor(Pred pred)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Tasks block in Pass() until Open().
+class Gate {
+public:
+    void Pass()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return open_; });
+    }
+    void Open()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cond_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool open_ = false;
+};
+
+// Counts tasks running at once.
+class Concurrency {
+public:
+    void Enter()
+    {
+        const int now = ++running_;
+        int seen = max_.load();
+        while (now > seen && !max_.compare_exchange_weak(seen, now)) {
+        }
+    }
+    void Leave() { --running_; }
+    int Max() const { return max_.load(); }
+    void ResetMax() { max_.store(running_.load()); }
+
+private:
+    std::atomic<int> running_{0};
+    std::atomic<int> max_{0};
+};
+
+int CurrentNice()
+{
+    return getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+}
+
+TEST(DecodeSchedulerTest, HigherPriorityFirstFifoWithin)
+{
+    DecodeScheduler scheduler("test-order", 1);
+    Gate gate;
+    scheduler.Submit(Priority::Normal, [&gate]() { gate.Pass(); });
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().running == 1; }));
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const char* name) {
+        return [&mutex, &order, name]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+    scheduler.Submit(Priority::Normal, record("n1"));
+    scheduler.Submit(Priority::High, record("h1"));
+    scheduler.Submit(Priority::Normal, record("n2"));
+    scheduler.Submit(Priority::High, record("h2"));
+    scheduler.Submit(Priority::Normal, record("n3"));
+    EXPECT_EQ(scheduler.GetStats().queued, 5u);
+    gate.Open();
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 6; }));
+    EXPECT_EQ(order, (std::vector<std::string>{"h1", "h2", "n1", "n2", "n3"}));
+    EXPECT_GE(scheduler.GetStats().queueWaitUsMax, 0);
+}
+
+// Low tasks run last and at a raised nice value; their thread retires, so the
+// next task runs at the original nice value again.
+TEST(DecodeSchedulerTest, LowPriorityRunsNicedOnARetiringThread)
+{
+    const int baseNice = CurrentNice();
+    DecodeScheduler scheduler("test-low", 1);
+    Gate gate;
+    scheduler.Submit(Priority::Normal, [&gate]() { gate.Pass(); });
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().running == 1; }));
+
+    std::mutex mutex;
+    std::vector<std::pair<std::string, int>> runs;
+    auto record = [&](const char* name) {
+        return [&mutex, &runs, name]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            runs.emplace_back(name, CurrentNice());
+        };
+    };
+    scheduler.Submit(Priority::Low, record("low"));
+    scheduler.Submit(Priority::Normal, record("normal"));
+    gate.Open();
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 3; }));
+    scheduler.Submit(Priority::High, record("high"));
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 4; }));
+
+    ASSERT_EQ(runs.size(), 3u);
+    EXPECT_EQ(runs[0].first, "normal");
+    EXPECT_EQ(runs[0].second, baseNice);
+    EXPECT_EQ(runs[1].first, "low");
+    EXPECT_EQ(runs[1].second, std::min(baseNice + DecodeScheduler::kLowPriorityNice, 19));
+    EXPECT_EQ(runs[2].first, "high");
+    EXPECT_EQ(runs[2].second, baseNice);
+    EXPECT_STREQ(DecodeScheduler::PriorityName(Priority::Low), "low");
+}
+
+TEST(DecodeSchedulerTest, ThreadLimitHoldsAndFollowsChanges)
+{
+    DecodeScheduler scheduler("test-limit", 3);
+    Concurrency concurrency;
+    auto gate = std::make_shared<Gate>();
+    for (int i = 0; i < 10; i++) {
+        scheduler.Submit(Priority::Normal, [&concurrency, gate]() {
+            concurrency.Enter();
+            gate->Pass();
+            concurrency.Leave();
+        });
+    }
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().running == 3; }));
+    DecodeScheduler::Stats stats = scheduler.GetStats();
+    EXPECT_EQ(stats.threads, 3u);
+    EXPECT_EQ(stats.queued, 7u);
+    EXPECT_EQ(stats.submitted, 10u);
+
+    // Raising the limit starts threads for the waiting tasks right away.
+    scheduler.SetMaxThreads(5);
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().running == 5; }));
+    EXPECT_EQ(scheduler.GetStats().queued, 5u);
+
+    // Lowering it lets running tasks finish; afterwards one task at a time runs.
+    scheduler.SetMaxThreads(1);
+    EXPECT_EQ(scheduler.GetStats().running, 5u);
+    gate->Open();
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 10; }));
+    EXPECT_EQ(concurrency.Max(), 5);
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().threads <= 1; }));
+
+    concurrency.ResetMax();
+    for (int i = 0; i < 20; i++) {
+        scheduler.Submit(Priority::Normal, [&concurrency]() {
+            concurrency.Enter();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            concurrency.Leave();
+        });
+    }
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 30; }));
+    EXPECT_EQ(concurrency.Max(), 1);
+
+    scheduler.SetMaxThreads(0);
+    EXPECT_EQ(scheduler.GetStats().maxThreads, 1u);
+    scheduler.SetMaxThreads(100);
+    EXPECT_EQ(scheduler.GetStats().maxThreads, DecodeScheduler::kMaxThreadsLimit);
+}
+
+// Tasks of all priorities submitted from several threads at once.
+TEST(DecodeSchedulerTest, BurstOfThousandTasks)
+{
+    DecodeScheduler scheduler("test-burst", 4);
+    Concurrency concurrency;
+    std::atomic<int> done(0);
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 4; t++) {
+        submitters.emplace_back([&, t]() {
+            for (int i = 0; i < 250; i++) {
+                const Priority priority = (i % 7 == 0)   ? Priority::Low
+                                          : (i % 3 == 0) ? Priority::High
+                                                         : Priority::Normal;
+                scheduler.Submit(priority, [&concurrency, &done]() {
+                    concurrency.Enter();
+                    done++;
+                    concurrency.Leave();
+                });
+                if ((i + t) % 50 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& t : submitters) {
+        t.join();
+    }
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 1000; }));
+    const DecodeScheduler::Stats stats = scheduler.GetStats();
+    EXPECT_EQ(done.load(), 1000);
+    EXPECT_EQ(stats.submitted, 1000u);
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_LE(stats.threads, 4u);
+    EXPECT_LE(concurrency.Max(), 4);
+}
+
+// The destructor waits for running tasks and drops the queued ones.
+TEST(DecodeSchedulerTest, DestructorWaitsForRunningDropsQueued)
+{
+    auto scheduler = std::make_unique<DecodeScheduler>("test-dtor", 1);
+    Gate gate;
+    std::atomic<bool> finished(false);
+    std::atomic<int> queuedRan(0);
+    scheduler->Submit(Priority::Normal, [&]() {
+        gate.Pass();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        finished.store(true);
+    });
+    ASSERT_TRUE(WaitFor([&]() { return scheduler->GetStats().running == 1; }));
+    for (int i = 0; i < 3; i++) {
+        scheduler->Submit(Priority::High, [&queuedRan]() { queuedRan++; });
+    }
+
+    std::thread opener([&gate]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.Open();
+    });
+    scheduler.reset();
+    EXPECT_TRUE(finished.load());
+    EXPECT_EQ(queuedRan.load(), 0);
+    opener.join();
+}
+
+// Parallel() called from the scheduler's only thread: the helpers cannot start
+// before the caller has done all the work, so they are skipped rather than
+// waited for, and later run as no-ops.
+TEST(DecodeSchedulerTest, ParallelSkipsHelpersThatDidNotStart)
+{
+    DecodeScheduler scheduler("test-skip", 1);
+    std::atomic<int> jobs(0);
+    std::atomic<int> helperCalls(0);
+    std::atomic<bool> returned(false);
+    scheduler.Submit(Priority::Normal, [&]() {
+        scheduler.Parallel(Priority::Normal, 4, [&](size_t worker) {
+            if (worker != 0) {
+                helperCalls++;
+            }
+            while (jobs.fetch_add(1) < 50) {
+            }
+        });
+        returned.store(true);
+    });
+    ASSERT_TRUE(WaitFor([&]() { return returned.load(); }));
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 4; }));
+    EXPECT_EQ(helperCalls.load(), 0);
+    EXPECT_EQ(scheduler.GetStats().submitted, 4u);
+}
+
+// Four batches of 4 workers each, started from tasks on a 3-thread scheduler:
+// all jobs get done, and at no time run more bodies than the limit.
+TEST(DecodeSchedulerTest, ParallelFanOutsShareTheLimit)
+{
+    DecodeScheduler scheduler("test-parallel", 3);
+    Concurrency concurrency;
+    std::atomic<int> batchesDone(0);
+    std::atomic<int> jobsDone(0);
+    for (int batch = 0; batch < 4; batch++) {
+        scheduler.Submit(Priority::Normal, [&]() {
+            std::atomic<int> next(0);
+            std::atomic<int> workersSeen(0);
+            scheduler.Parallel(Priority::Normal, 4, [&](size_t) {
+                workersSeen++;
+                concurrency.Enter();
+                while (next.fetch_add(1) < 100) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    jobsDone++;
+                }
+                concurrency.Leave();
+            });
+            // Every body that ran has returned, so the locals above may go.
+            EXPECT_GE(workersSeen.load(), 1);
+            batchesDone++;
+        });
+    }
+    ASSERT_TRUE(WaitFor([&]() { return batchesDone.load() == 4; }));
+    ASSERT_TRUE(WaitFor([&]() { return scheduler.GetStats().completed == 16; }));
+    EXPECT_EQ(jobsDone.load(), 400);
+    EXPECT_LE(concurrency.Max(), 3);
+    EXPECT_LE(scheduler.GetStats().threads, 3u);
+}
+
+} // namespace
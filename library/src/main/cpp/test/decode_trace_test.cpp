@@ -0,0 +1,502 @@
+// DecodeTrace: Dump() is valid Chrome trace-event JSON (checked with a small
+// parser below) holding the recorded scopes, instants, arguments and thread
+// names in order; nothing is recorded while stopped; a wrapped ring keeps the
+// newest events without unmatched ends; the per-session thread limit reuses the
+// rings of exited threads and counts drops; dumping while threads record stays
+// consistent. Run in the FREE_PCM_SANITIZE=thread build too.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "decode_trace.h"
+
+namespace {
+
+// Just enough JSON for the trace: objects, arrays, strings, numbers, literals.
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* Find(const std::string& key) const
+    {
+        for (const auto& kv : object) {
+            if (kv.first == key) {
+                return &kv.second;
+            }
+        }
+        return nullptr;
+    }
+    std::string Str(const std::string& key) const
+    {
+        const Json* v = Find(key);
+        return v && v->type == Type::String ? v->string : std::string();
+    }
+    double Num(const std::string& key) const
+    {
+        const Json* v = Find(key);
+        return v && v->type == Type::Number ? v->number : -1.0;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    // False on any syntax error or trailing garbage.
+    bool Parse(Json* out)
+    {
+        if (!Value(out)) {
+            return false;
+        }
+        SkipSpace();
+        return pos_ == text_.size();
+    }
+
+private:
+    void SkipSpace()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            pos_++;
+        }
+    }
+    bool Consume(char c)
+    {
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+    bool Literal(const char* word)
+    {
+        const std::string w(word);
+        if (text_.compare(pos_, w.size(), w) != 0) {
+            return false;
+        }
+        pos_ += w.size();
+        return true;
+    }
+
+    bool Value(Json* out)
+    {
+        SkipSpace();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        const char c = text_[pos_];
+        if (c == '{') {
+            out->type = Json::Type::Object;
+            pos_++;
+            if (Consume('}')) {
+                return true;
+            }
+            do {
+                std::string key;
+                Json value;
+                SkipSpace();
+                if (!String(&key) || !Consume(':') || !Value(&value)) {
+                    return false;
+                }
+                out->object.emplace_back(std::move(key), std::move(value));
+            } while (Consume(','));
+            return Consume('}');
+        }
+        if (c == '[') {
+            out->type = Json::Type::Array;
+            pos_++;
+            if (Consume(']')) {
+                return true;
+            }
+            do {
+                Json value;
+                if (!Value(&value)) {
+                    return false;
+                }
+                out->array.push_back(std::move(value));
+            } while (Consume(','));
+            return Consume(']');
+        }
+        if (c == '"') {
+            out->type = Json::Type::String;
+            return String(&out->string);
+        }
+        if (c == 't' || c == 'f') {
+            out->type = Json::Type::Bool;
+            out->boolean = c == 't';
+            return Literal(c == 't' ? "true" : "false");
+        }
+        if (c == 'n') {
+            return Literal("null");
+        }
+        // Numbers as JSON spells them: -?digits(.digits)?(e[+-]?digits)?
+        const size_t start = pos_;
+        if (text_[pos_] == '-') {
+            pos_++;
+        }
+        if (!Digits()) {
+            return false;
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            pos_++;
+            if (!Digits()) {
+                return false;
+            }
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            pos_++;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+                pos_++;
+            }
+            if (!Digits()) {
+                return false;
+            }
+        }
+        out->type = Json::Type::Number;
+        out->number = std::strtod(text_.substr(start, pos_ - start).c_str(), nullptr);
+        return true;
+    }
+
+    bool Digits()
+    {
+        const size_t start = pos_;
+        while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_]))) {
+            pos_++;
+        }
+        return pos_ > start;
+    }
+
+    // ASCII escapes only; the trace never writes anything else.
+    bool String(std::string* out)
+    {
+        if (pos_ >= text_.size() || text_[pos_] != '"') {
+            return false;
+        }
+        pos_++;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return false;
+            }
+            if (c != '\\') {
+                out->push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            const char e = text_[pos_++];
+            if (e == '"' || e == '\\' || e == '/') {
+                out->push_back(e);
+            } else if (e == 'n') {
+                out->push_back('\n');
+            } else if (e == 't') {
+                out->push_back('\t');
+            } else if (e == 'u' && pos_ + 4 <= text_.size()) {
+                const long code = std::strtol(text_.substr(pos_, 4).c_str(), nullptr, 16);
+                if (code >= 0x80) {
+                    return false;
+                }
+                out->push_back(static_cast<char>(code));
+                pos_ += 4;
+            } else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+};
+
+struct Trace {
+    Json root;
+    std::vector<const Json*> events;              // traceEvents without metadata
+    std::map<int64_t, std::string> threadNames;   // tid -> thread_name
+    const Json* otherData = nullptr;
+
+    double Counter(const char* key) const { return otherData ? otherData->Num(key) : -1.0; }
+    std::vector<const Json*> EventsOf(int64_t tid) const
+    {
+        std::vector<const Json*> out;
+        for (const Json* e : events) {
+            if (static_cast<int64_t>(e->Num("tid")) == tid) {
+                out.push_back(e);
+            }
+        }
+        return out;
+    }
+};
+
+// Parses a dump and checks the fields every event must carry.
+bool ParseTrace(const std::string& text, Trace* trace)
+{
+    JsonParser parser(text);
+    if (!parser.Parse(&trace->root) || trace->root.type != Json::Type::Object) {
+        ADD_FAILURE() << "not a JSON object:\n" << text.substr(0, 2000);
+        return false;
+    }
+    const Json* events = trace->root.Find("traceEvents");
+    trace->otherData = trace->root.Find("otherData");
+    if (events == nullptr || events->type != Json::Type::Array || trace->otherData == nullptr) {
+        ADD_FAILURE() << "missing traceEvents or otherData";
+        return false;
+    }
+    EXPECT_EQ(trace->root.Str("displayTimeUnit"), "ms");
+    for (const Json& e : events->array) {
+        const std::string ph = e.Str("ph");
+        EXPECT_GE(e.Num("pid"), 0.0);
+        if (ph == "M") {
+            if (e.Str("name") == "thread_name") {
+                const Json* args = e.Find("args");
+                trace->threadNames[static_cast<int64_t>(e.Num("tid"))] = args ? args->Str("name") : "";
+            }
+            continue;
+        }
+        EXPECT_TRUE(ph == "B" || ph == "E" || ph == "i") << ph;
+        EXPECT_EQ(e.Str("cat"), "free_pcm");
+        EXPECT_GE(e.Num("ts"), 0.0);
+        EXPECT_GE(e.Num("tid"), 0.0);
+        if (ph == "i") {
+            EXPECT_EQ(e.Str("s"), "t");
+        }
+        trace->events.push_back(&e);
+    }
+    return true;
+}
+
+// Per thread: timestamps never go back and no end comes without its begin.
+void ExpectWellFormed(const Trace& trace)
+{
+    for (const auto& thread : trace.threadNames) {
+        double lastTs = -1.0;
+        std::vector<std::string> open;
+        for (const Json* e : trace.EventsOf(thread.first)) {
+            EXPECT_GE(e->Num("ts"), lastTs);
+            lastTs = e->Num("ts");
+            if (e->Str("ph") == "B") {
+                open.push_back(e->Str("name"));
+            } else if (e->Str("ph") == "E") {
+                ASSERT_FALSE(open.empty()) << "unmatched end " << e->Str("name");
+                EXPECT_EQ(open.back(), e->Str("name"));
+                open.pop_back();
+            }
+        }
+    }
+}
+
+int64_t Tid(const Trace& trace, const std::string& name)
+{
+    for (const auto& thread : trace.threadNames) {
+        if (thread.second == name) {
+            return thread.first;
+        }
+    }
+    return -1;
+}
+
+class DecodeTraceTest : public ::testing::Test {
+protected:
+    void TearDown() override { DecodeTrace::Stop(); }
+};
+
+TEST_F(DecodeTraceTest, NothingRecordedWhileStopped)
+{
+    DecodeTrace::Start();
+    DecodeTrace::Stop();
+    std::thread([]() {
+        DecodeTrace::Scope scope("stopped", "n", 1);
+        DecodeTrace::Instant("stopped");
+        DecodeTrace::Begin("stopped");
+    }).join();
+    EXPECT_FALSE(DecodeTrace::Enabled());
+
+    Trace trace;
+    ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &trace));
+    EXPECT_TRUE(trace.events.empty());
+    EXPECT_EQ(trace.Counter("threads"), 0.0);
+    EXPECT_EQ(trace.Counter("recordedEvents"), 0.0);
+}
+
+TEST_F(DecodeTraceTest, ScopesInstantsArgsAndThreadNames)
+{
+    DecodeTrace::Start();
+    std::thread([]() {
+        DecodeTrace::SetThreadName("decode \"a\\b\"\n");
+        DecodeTrace::Scope outer("applySeek", "targetMs", 1234);
+        {
+            DecodeTrace::Scope inner("demuxer\tSeek");
+            DecodeTrace::Instant("underrun", "bytes", -7);
+        }
+        DecodeTrace::Instant("plain");
+    }).join();
+    // A scope begun before Stop() still records its end.
+    std::thread([]() {
+        DecodeTrace::SetThreadName("late");
+        DecodeTrace::Scope scope("spansStop");
+        DecodeTrace::Stop();
+        DecodeTrace::Instant("afterStop");
+    }).join();
+
+    Trace trace;
+    ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &trace));
+    ExpectWellFormed(trace);
+    EXPECT_EQ(trace.Counter("threads"), 2.0);
+    EXPECT_EQ(trace.Counter("recordedEvents"), 8.0);
+    EXPECT_EQ(trace.Counter("overwrittenEvents"), 0.0);
+    EXPECT_EQ(trace.Counter("droppedEvents"), 0.0);
+
+    const int64_t decodeTid = Tid(trace, "decode \"a\\b\"\n");
+    ASSERT_GE(decodeTid, 0);
+    const std::vector<const Json*> events = trace.EventsOf(decodeTid);
+    const std::vector<std::pair<std::string, std::string>> expected = {
+        {"B", "applySeek"}, {"B", "demuxer\tSeek"}, {"i", "underrun"}, {"E", "demuxer\tSeek"},
+        {"i", "plain"},     {"E", "applySeek"},
+    };
+    ASSERT_EQ(events.size(), expected.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i]->Str("ph"), expected[i].first) << i;
+        EXPECT_EQ(events[i]->Str("name"), expected[i].second) << i;
+    }
+    ASSERT_NE(events[0]->Find("args"), nullptr);
+    EXPECT_EQ(events[0]->Find("args")->Num("targetMs"), 1234.0);
+    ASSERT_NE(events[2]->Find("args"), nullptr);
+    EXPECT_EQ(events[2]->Find("args")->Find("bytes")->number, -7.0);
+    EXPECT_EQ(events[1]->Find("args"), nullptr);
+
+    const std::vector<const Json*> late = trace.EventsOf(Tid(trace, "late"));
+    ASSERT_EQ(late.size(), 2u);
+    EXPECT_EQ(late[0]->Str("ph"), "B");
+    EXPECT_EQ(late[1]->Str("ph"), "E");
+}
+
+// A 256-event ring under 1001 nested scopes keeps the newest events and leaves
+// out ends whose begin was overwritten.
+TEST_F(DecodeTraceTest, WrappedRingKeepsNewestEvents)
+{
+    DecodeTrace::Start(1);  // clamped up to kMinEventsPerThread
+    std::thread([]() {
+        DecodeTrace::SetThreadName("wrap");
+        DecodeTrace::Scope outer("outer");
+        for (int i = 0; i < 1000; i++) {
+            DecodeTrace::Scope inner("inner", "i", i);
+        }
+    }).join();
+
+    Trace trace;
+    ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &trace));
+    ExpectWellFormed(trace);
+    EXPECT_EQ(trace.Counter("recordedEvents"), 2002.0);
+    EXPECT_EQ(trace.Counter("overwrittenEvents"), 2002.0 - DecodeTrace::kMinEventsPerThread);
+
+    const std::vector<const Json*> events = trace.EventsOf(Tid(trace, "wrap"));
+    ASSERT_FALSE(events.empty());
+    EXPECT_LE(events.size(), DecodeTrace::kMinEventsPerThread);
+    // The outer end survives but its begin does not, so it is left out too.
+    EXPECT_EQ(events.back()->Str("name"), "inner");
+    EXPECT_EQ(events.back()->Str("ph"), "E");
+    const Json* lastBegin = events[events.size() - 2];
+    ASSERT_NE(lastBegin->Find("args"), nullptr);
+    EXPECT_EQ(lastBegin->Find("args")->Num("i"), 999.0);
+}
+
+// Exited threads make room for new ones; with kMaxThreads live rings the next
+// thread's events are dropped and counted.
+TEST_F(DecodeTraceTest, ThreadLimitReusesExitedRings)
+{
+    DecodeTrace::Start(DecodeTrace::kMinEventsPerThread);
+    const int exited = static_cast<int>(DecodeTrace::kMaxThreads) + 6;
+    for (int i = 0; i < exited; i++) {
+        std::thread([i]() { DecodeTrace::Instant("short", "i", i); }).join();
+    }
+    Trace trace;
+    ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &trace));
+    EXPECT_EQ(trace.Counter("threads"), static_cast<double>(DecodeTrace::kMaxThreads));
+    EXPECT_EQ(trace.Counter("droppedEvents"), 0.0);
+    ASSERT_FALSE(trace.events.empty());
+    EXPECT_EQ(trace.events.back()->Find("args")->Num("i"), static_cast<double>(exited - 1));
+
+    DecodeTrace::Start(DecodeTrace::kMinEventsPerThread);
+    std::mutex mutex;
+    std::condition_variable cond;
+    int recorded = 0;
+    bool release = false;
+    std::vector<std::thread> live;
+    for (size_t i = 0; i < DecodeTrace::kMaxThreads + 1; i++) {
+        live.emplace_back([&]() {
+            DecodeTrace::Instant("live");
+            std::unique_lock<std::mutex> lock(mutex);
+            recorded++;
+            cond.notify_all();
+            cond.wait(lock, [&]() { return release; });
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]() { return recorded == static_cast<int>(DecodeTrace::kMaxThreads) + 1; });
+    }
+    Trace full;
+    ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &full));
+    EXPECT_EQ(full.Counter("threads"), static_cast<double>(DecodeTrace::kMaxThreads));
+    EXPECT_EQ(full.Counter("droppedEvents"), 1.0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cond.notify_all();
+    for (std::thread& t : live) {
+        t.join();
+    }
+}
+
+// Dumps taken while four threads wrap their rings always parse and are well formed.
+TEST_F(DecodeTraceTest, DumpWhileRecording)
+{
+    DecodeTrace::Start(DecodeTrace::kMinEventsPerThread);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&stop, t]() {
+            const char* names[] = {"w0", "w1", "w2", "w3"};
+            DecodeTrace::SetThreadName(names[t]);
+            for (int64_t i = 0; !stop.load(); i++) {
+                DecodeTrace::Scope outer("fill", "i", i);
+                DecodeTrace::Scope inner("push");
+                DecodeTrace::Instant("tick");
+            }
+        });
+    }
+    for (int i = 0; i < 50; i++) {
+        Trace trace;
+        ASSERT_TRUE(ParseTrace(DecodeTrace::Dump(), &trace));
+        ExpectWellFormed(trace);
+        EXPECT_LE(trace.events.size(), 4 * DecodeTrace::kMinEventsPerThread);
+        std::this_thread::yield();
+    }
+    stop.store(true);
+    for (std::thread& w : writers) {
+        w.join();
+    }
+}
+
+} // namespace
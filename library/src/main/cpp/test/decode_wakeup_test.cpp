@@ -0,0 +1,167 @@
+// DecodeWakeup: no lost wakeups when predicates read state outside the wakeup's
+// own lock (atomics, other mutexes), generation semantics of Notify() and
+// WaitChanged*, and the wakeup counter. A lost wakeup shows up as a hang, which
+// ctest reports as a timeout. Run in the FREE_PCM_SANITIZE=thread build too.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "decode_wakeup.h"
+
+namespace {
+
+// Two threads hand a token back and forth through atomics, each blocking in
+// Wait() until it is its turn: every hand-off depends on the NotifyState() that
+// follows the store.
+TEST(DecodeWakeupTest, PingPongNeverLosesAWakeup)
+{
+    DecodeWakeup wakeup;
+    std::atomic<uint32_t> turn(0);
+    const uint32_t kRounds = 20000;
+
+    std::thread other([&]() {
+        for (uint32_t i = 1; i < 2 * kRounds; i += 2) {
+            wakeup.Wait([&]() { return turn.load() == i; });
+            turn.store(i + 1);
+            wakeup.NotifyState();
+        }
+    });
+    for (uint32_t i = 0; i < 2 * kRounds; i += 2) {
+        wakeup.Wait([&]() { return turn.load() == i; });
+        turn.store(i + 1);
+        wakeup.NotifyState();
+    }
+    other.join();
+    EXPECT_EQ(turn.load(), 2 * kRounds);
+}
+
+// The window the lock in NotifyState() closes: the state changes and is
+// notified after the waiter's predicate saw it unset but before the waiter
+// blocks. Forced here by notifying from inside the first predicate call; a
+// lost notification would only end at the deadline.
+TEST(DecodeWakeupTest, NotifyBetweenPredicateAndBlockIsNotLost)
+{
+    DecodeWakeup wakeup;
+    std::atomic<bool> ready(false);
+    std::thread notifier;
+    const DecodeWakeup::Clock::time_point start = DecodeWakeup::Clock::now();
+    wakeup.WaitChangedUntil(wakeup.Generation(), start + std::chrono::seconds(10), [&]() {
+        if (!notifier.joinable()) {
+            notifier = std::thread([&]() {
+                ready.store(true);
+                wakeup.NotifyState();
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return false;
+        }
+        return ready.load();
+    });
+    notifier.join();
+    EXPECT_LT(DecodeWakeup::Clock::now() - start, std::chrono::seconds(5));
+}
+
+// Several "codec callback" threads push into a queue under its own mutex, as
+// AudioDecoder's signal queues are; the decode thread drains it.
+TEST(DecodeWakeupTest, QueueUnderAnotherLock)
+{
+    DecodeWakeup wakeup;
+    std::mutex queueMutex;
+    std::queue<uint32_t> queue;
+    const uint32_t kProducers = 3;
+    const uint32_t kItems = 10000;
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (uint32_t i = 0; i < kItems; i++) {
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    queue.push(p * kItems + i);
+                }
+                wakeup.NotifyState();
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(kProducers, 0);
+    for (uint32_t received = 0; received < kProducers * kItems;) {
+        wakeup.Wait([&]() {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            return !queue.empty();
+        });
+        std::lock_guard<std::mutex> lock(queueMutex);
+        while (!queue.empty()) {
+            const uint32_t v = queue.front();
+            queue.pop();
+            // Each producer's items arrive in its own order.
+            ASSERT_EQ(v % kItems, next[v / kItems]++);
+            received++;
+        }
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+}
+
+TEST(DecodeWakeupTest, NotifyEndsWaitChangedWithoutPredicate)
+{
+    DecodeWakeup wakeup;
+    const uint64_t seen = wakeup.Generation();
+    std::atomic<bool> returned(false);
+    std::thread waiter([&]() {
+        wakeup.WaitChanged(seen, []() { return false; });
+        returned.store(true);
+    });
+
+    // NotifyState() does not bump the generation, so the waiter stays blocked.
+    wakeup.NotifyState();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(returned.load());
+
+    wakeup.Notify();
+    waiter.join();
+    EXPECT_TRUE(returned.load());
+    EXPECT_EQ(wakeup.Generation(), seen + 1);
+
+    // A Notify() that happened before the wait is not missed.
+    wakeup.WaitChanged(seen, []() { return false; });
+}
+
+TEST(DecodeWakeupTest, WaitChangedUntil)
+{
+    DecodeWakeup wakeup;
+    const uint64_t seen = wakeup.Generation();
+    const DecodeWakeup::Clock::time_point start = DecodeWakeup::Clock::now();
+    EXPECT_FALSE(wakeup.WaitChangedUntil(seen, start + std::chrono::milliseconds(10), []() { return false; }));
+    EXPECT_GE(DecodeWakeup::Clock::now() - start, std::chrono::milliseconds(10));
+
+    EXPECT_TRUE(wakeup.WaitChangedUntil(seen, start, []() { return true; }));
+    wakeup.Notify();
+    EXPECT_TRUE(wakeup.WaitChangedUntil(seen, start, []() { return false; }));
+}
+
+// Only evaluations after a wakeup count, not the first check.
+TEST(DecodeWakeupTest, CountsWakeupsOfBlockedWaiters)
+{
+    DecodeWakeup wakeup;
+    wakeup.Wait([]() { return true; });
+    wakeup.WaitChanged(wakeup.Generation(), []() { return true; });
+    EXPECT_EQ(wakeup.Wakeups(), 0u);
+
+    std::atomic<bool> ready(false);
+    std::thread waiter([&]() { wakeup.Wait([&]() { return ready.load(); }); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ready.store(true);
+    wakeup.NotifyState();
+    waiter.join();
+    EXPECT_GE(wakeup.Wakeups(), 1u);
+}
+
+} // namespace
@@ -0,0 +1,175 @@
+// DspChain: for every stage mask at 1, 2 and 6 channels, 40 callbacks of random
+// length through Run() are bit-identical to calling the enabled processors in
+// chain order by hand; channel volume is dropped above stereo; a refusing sink
+// stops Run(); with stats attached each run records exactly its enabled stages.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "decode_stats.h"
+#include "dsp_chain.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr int32_t kSampleRate = 48000;
+
+// One set of processors, configured the same way for the chain and the reference.
+struct Processors {
+    explicit Processors(int32_t channels)
+    {
+        eq.Init(kSampleRate, channels);
+        eq.SetGainsDb({4.0f, 3.0f, 1.5f, 0.0f, -1.0f, -2.0f, 0.5f, 2.0f, 3.5f, 5.0f});
+        eq.SetEnabled(true);
+        pitch.Init(kSampleRate, channels);
+        pitch.SetSemitones(3);
+        pitch.SetEnabled(true);
+        drc.Init(kSampleRate, channels);
+        drc.SetParams(-18.0f, 4.0f, 10.0f, 120.0f, 6.0f);
+        drc.SetEnabled(true);
+        limiter.Init(kSampleRate, channels);
+        limiter.SetParams(-1.0f, 5.0f, 1.0f, 80.0f);
+        limiter.SetEnabled(true);
+    }
+
+    PcmEqualizer eq;
+    PcmPitchShifter pitch;
+    DrcProcessor drc;
+    TruePeakLimiter limiter;
+};
+
+constexpr float kVolL = 0.7f;
+constexpr float kVolR = 1.3f;
+
+// The chain order written out: EQ -> pitch -> channel volume -> DRC -> limiter.
+void ReferenceStages(Processors& p, uint32_t mask, int32_t channels, float* samples, size_t frames)
+{
+    if (mask & DspChain::kStageEq) {
+        p.eq.ProcessFloat(samples, frames);
+    }
+    if (mask & DspChain::kStagePitch) {
+        p.pitch.ProcessFloat(samples, frames);
+    }
+    if ((mask & DspChain::kStageChannelVolume) && channels <= 2) {
+        for (size_t f = 0; f < frames; f++) {
+            samples[f * channels] *= kVolL;
+            if (channels == 2) {
+                samples[f * 2 + 1] *= kVolR;
+            }
+        }
+    }
+    if (mask & DspChain::kStageDrc) {
+        p.drc.ProcessFloat(samples, frames);
+    }
+    if (mask & DspChain::kStageLimiter) {
+        p.limiter.ProcessFloat(samples, frames);
+    }
+}
+
+TEST(DspChainTest, EveryMaskMatchesTheStagesInOrder)
+{
+    std::mt19937 rng = test::Rng(1);
+    std::uniform_real_distribution<float> sample(-0.8f, 0.8f);
+    for (int32_t channels : {1, 2, 6}) {
+        for (uint32_t mask = 0; mask <= DspChain::kStageAll; mask++) {
+            SCOPED_TRACE(testing::Message() << channels << " channels, mask " << mask);
+            Processors chained(channels);
+            Processors reference(channels);
+            DspChain chain(chained.eq, chained.pitch, chained.drc, chained.limiter);
+            chain.Configure(channels, mask, kVolL, kVolR);
+
+            std::vector<float> input;
+            std::vector<float> expected;
+            std::vector<float> output;
+            for (int call = 0; call < 40; call++) {
+                const size_t frames = 1 + rng() % 4096;
+                input.resize(frames * channels);
+                for (float& s : input) {
+                    s = sample(rng);
+                }
+                expected = input;
+                ReferenceStages(reference, mask, channels, expected.data(), frames);
+
+                output.clear();
+                const bool ok = chain.Run(
+                    frames,
+                    [&input, channels](float* out, size_t n) {
+                        std::copy_n(input.data(), n * channels, out);
+                    },
+                    [&output, channels](const float* in, size_t n) {
+                        output.insert(output.end(), in, in + n * channels);
+                        return true;
+                    });
+                ASSERT_TRUE(ok);
+                ASSERT_EQ(output.size(), expected.size());
+                // Bitwise, so NaN or -0 differences count too.
+                ASSERT_EQ(memcmp(output.data(), expected.data(), output.size() * sizeof(float)), 0)
+                    << "call " << call;
+            }
+        }
+    }
+}
+
+TEST(DspChainTest, RefusingSinkAndUnconfigured)
+{
+    Processors p(2);
+    DspChain chain(p.eq, p.pitch, p.drc, p.limiter);
+    int sourced = 0;
+    auto source = [&sourced](float* out, size_t n) {
+        std::fill_n(out, n * 2, 0.25f);
+        sourced++;
+    };
+    EXPECT_FALSE(chain.Run(64, source, [](const float*, size_t) { return true; }));
+    EXPECT_EQ(sourced, 0);
+
+    chain.Configure(2, DspChain::kStageAll, 1.0f, 1.0f);
+    EXPECT_FALSE(chain.Run(64, source, [](const float*, size_t) { return false; }));
+    EXPECT_TRUE(chain.Run(64, source, [](const float*, size_t) { return true; }));
+    EXPECT_EQ(sourced, 2);
+}
+
+TEST(DspChainTest, StatsRecordTheEnabledStages)
+{
+    if (!DecodeStats::kEnabled) {
+        GTEST_SKIP() << "built with FREE_PCM_NO_STATS";
+    }
+    using Stage = DecodeStats::Stage;
+    const std::vector<std::pair<uint32_t, Stage>> stages = {
+        {DspChain::kStageEq, Stage::Eq},
+        {DspChain::kStagePitch, Stage::Pitch},
+        {DspChain::kStageDrc, Stage::Drc},
+        {DspChain::kStageLimiter, Stage::Limiter},
+    };
+    for (uint32_t mask : {0u, uint32_t(DspChain::kStageEq | DspChain::kStageLimiter), DspChain::kStageAll}) {
+        SCOPED_TRACE(testing::Message() << "mask " << mask);
+        Processors p(2);
+        DspChain chain(p.eq, p.pitch, p.drc, p.limiter);
+        chain.Configure(2, mask, 1.0f, 1.0f);
+        DecodeStats stats;
+        chain.SetStats(&stats);
+        for (int i = 0; i < 3; i++) {
+            chain.Run(
+                256, [](float* out, size_t n) { std::fill_n(out, n * 2, 0.1f); },
+                [](const float*, size_t) { return true; });
+        }
+        chain.SetStats(nullptr);
+        chain.Run(
+            256, [](float* out, size_t n) { std::fill_n(out, n * 2, 0.1f); },
+            [](const float*, size_t) { return true; });
+
+        const DecodeStats::Snapshot s = stats.Take();
+        EXPECT_EQ(s.stages[static_cast<size_t>(Stage::Convert)].count, 3u);
+        EXPECT_EQ(s.stages[static_cast<size_t>(Stage::RingPush)].count, 3u);
+        for (const auto& stage : stages) {
+            EXPECT_EQ(s.stages[static_cast<size_t>(stage.second)].count, (mask & stage.first) ? 3u : 0u)
+                << DecodeStats::StageName(stage.second);
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,281 @@
+// Gapless trimming: PcmTrimmer passes exactly the bytes between the encoder
+// delay and padding for any chunking, with at most two outputs per chunk, and
+// rescales the frame counts to the decoder rate; ReadGaplessInfo reads the
+// LAME tag of MP3 files (behind an ID3v2 tag, MPEG-1 and MPEG-2) and the
+// iTunSMPB tag of MP4 files built here byte by byte.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gapless_trim.h"
+#include "test_util.h"
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes RandomBytes(std::mt19937& rng, size_t size)
+{
+    Bytes out(size);
+    for (uint8_t& b : out) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return out;
+}
+
+// Feeds data in random chunks; returns what came out and checks each chunk
+// produced at most two outputs.
+Bytes FeedInChunks(PcmTrimmer& trimmer, std::mt19937& rng, const Bytes& data, size_t maxChunk)
+{
+    Bytes out;
+    int calls = 0;
+    const AudioDecoder::PcmDataCallback sink = [&out, &calls](const uint8_t* p, size_t n, int64_t) {
+        EXPECT_GT(n, 0u);
+        out.insert(out.end(), p, p + n);
+        calls++;
+        return true;
+    };
+    for (size_t at = 0; at < data.size();) {
+        const size_t n = std::min<size_t>(1 + rng() % maxChunk, data.size() - at);
+        calls = 0;
+        EXPECT_TRUE(trimmer.Feed(data.data() + at, n, 0, sink));
+        EXPECT_LE(calls, 2);
+        at += n;
+    }
+    return out;
+}
+
+TEST(PcmTrimmerTest, PassesTheBytesBetweenDelayAndPadding)
+{
+    std::mt19937 rng = test::Rng(1);
+    constexpr size_t kFrameBytes = 4;
+    const GaplessInfo cases[] = {
+        {0, 0, 0}, {1105, 0, 0}, {0, 671, 0}, {2112, 458, 0}, {1105, 671, 44100}, {50000, 50000, 0},
+    };
+    for (const GaplessInfo& info : cases) {
+        for (size_t maxChunk : {size_t(7), size_t(4096), size_t(100000)}) {
+            SCOPED_TRACE(testing::Message() << "delay " << info.delayFrames << " padding " << info.paddingFrames
+                                            << " chunk " << maxChunk);
+            PcmTrimmer trimmer;
+            trimmer.Configure(info, 44100, kFrameBytes);
+            EXPECT_EQ(trimmer.TrimStartFrames(), info.delayFrames);
+            EXPECT_EQ(trimmer.TrimEndFrames(), info.paddingFrames);
+            const Bytes data = RandomBytes(rng, 60000 * kFrameBytes);
+            const Bytes out = FeedInChunks(trimmer, rng, data, maxChunk);
+            trimmer.Finish();
+
+            const size_t skip = static_cast<size_t>(info.delayFrames) * kFrameBytes;
+            const size_t hold = static_cast<size_t>(info.paddingFrames) * kFrameBytes;
+            if (skip + hold >= data.size()) {
+                EXPECT_TRUE(out.empty());
+                continue;
+            }
+            EXPECT_TRUE(out == Bytes(data.begin() + static_cast<ptrdiff_t>(skip),
+                                     data.end() - static_cast<ptrdiff_t>(hold)));
+        }
+    }
+}
+
+TEST(PcmTrimmerTest, RescalesToTheDecoderRate)
+{
+    PcmTrimmer trimmer;
+    trimmer.Configure(GaplessInfo{1000, 500, 44100}, 48000, 4);
+    EXPECT_EQ(trimmer.TrimStartFrames(), 1088);
+    EXPECT_EQ(trimmer.TrimEndFrames(), 544);
+    trimmer.Configure(GaplessInfo{-5, 500, 0}, 48000, 4);
+    EXPECT_EQ(trimmer.TrimStartFrames(), 0);
+    EXPECT_EQ(trimmer.TrimEndFrames(), 500);
+}
+
+// After a seek neither the start trim nor the withheld bytes apply; a refusing
+// output stops the feed.
+TEST(PcmTrimmerTest, SeekAndFailingOutput)
+{
+    std::mt19937 rng = test::Rng(2);
+    PcmTrimmer trimmer;
+    trimmer.Configure(GaplessInfo{100, 200, 0}, 48000, 4);
+    const Bytes first = RandomBytes(rng, 1000 * 4);
+    Bytes out = FeedInChunks(trimmer, rng, first, 512);
+    EXPECT_EQ(out.size(), (1000 - 100 - 200) * 4u);
+
+    trimmer.OnSeek();
+    const Bytes second = RandomBytes(rng, 1000 * 4);
+    out = FeedInChunks(trimmer, rng, second, 512);
+    EXPECT_TRUE(out == Bytes(second.begin(), second.end() - 200 * 4));
+
+    int calls = 0;
+    const AudioDecoder::PcmDataCallback refuse = [&calls](const uint8_t*, size_t, int64_t) {
+        calls++;
+        return false;
+    };
+    EXPECT_FALSE(trimmer.Feed(second.data(), 300 * 4, 0, refuse));
+    EXPECT_EQ(calls, 1);
+}
+
+// ---------------------------------------------------------------------------
+// ReadGaplessInfo
+// ---------------------------------------------------------------------------
+
+bool WriteFile(const std::string& path, const Bytes& data)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+void Append(Bytes* out, const std::string& s)
+{
+    out->insert(out->end(), s.begin(), s.end());
+}
+
+void AppendBe32(Bytes* out, uint32_t v)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out->push_back(static_cast<uint8_t>(v >> shift));
+    }
+}
+
+// First MP3 frame with a Xing/Info tag and the LAME extension: header, side
+// info, tag, the optional fields of flags, then the 12-bit delay and padding
+// at byte 21 of the extension.
+Bytes Mp3TagFrame(const uint8_t header[4], size_t sideInfo, const char* tag, uint32_t flags, uint32_t delay,
+                  uint32_t padding)
+{
+    Bytes frame(header, header + 4);
+    frame.resize(frame.size() + sideInfo, 0);
+    Append(&frame, tag);
+    AppendBe32(&frame, flags);
+    const size_t optional = ((flags & 0x1) ? 4 : 0) + ((flags & 0x2) ? 4 : 0) + ((flags & 0x4) ? 100 : 0) +
+                            ((flags & 0x8) ? 4 : 0);
+    frame.resize(frame.size() + optional, 0x55);
+    Bytes lame(36, 0);
+    std::copy_n("LAME3.100", 9, lame.begin());
+    lame[21] = static_cast<uint8_t>(delay >> 4);
+    lame[22] = static_cast<uint8_t>(((delay & 0xf) << 4) | (padding >> 8));
+    lame[23] = static_cast<uint8_t>(padding);
+    frame.insert(frame.end(), lame.begin(), lame.end());
+    frame.resize(frame.size() + 300, 0);
+    return frame;
+}
+
+TEST(ReadGaplessInfoTest, Mp3LameTag)
+{
+    test::TempDir dir;
+
+    // MPEG-1 Layer III, 44.1 kHz joint stereo, behind an ID3v2 tag whose body
+    // holds a decoy frame that must be skipped with the tag.
+    const uint8_t mpeg1[4] = {0xff, 0xfb, 0x90, 0x64};
+    Bytes body = Mp3TagFrame(mpeg1, 32, "Xing", 0, 1, 1);
+    body.resize(1000, 0);
+    Bytes file = {'I', 'D', '3', 4, 0, 0, 0, 0, static_cast<uint8_t>(body.size() >> 7),
+                  static_cast<uint8_t>(body.size() & 0x7f)};
+    file.insert(file.end(), body.begin(), body.end());
+    const Bytes frame = Mp3TagFrame(mpeg1, 32, "Info", 0xf, 576, 1200);
+    file.insert(file.end(), frame.begin(), frame.end());
+    ASSERT_TRUE(WriteFile(dir.File("mpeg1.mp3"), file));
+
+    GaplessInfo info;
+    ASSERT_TRUE(ReadGaplessInfo(dir.File("mpeg1.mp3"), &info));
+    EXPECT_EQ(info.delayFrames, 576 + 529);
+    EXPECT_EQ(info.paddingFrames, 1200 - 529);
+    EXPECT_EQ(info.sampleRate, 44100);
+
+    // MPEG-2 Layer III, 24 kHz mono, no optional Xing fields; padding shorter
+    // than the decoder delay clamps to 0.
+    const uint8_t mpeg2[4] = {0xff, 0xf3, 0x84, 0xc4};
+    ASSERT_TRUE(WriteFile(dir.File("mpeg2.mp3"), Mp3TagFrame(mpeg2, 9, "Xing", 0, 0, 100)));
+    ASSERT_TRUE(ReadGaplessInfo(dir.File("mpeg2.mp3"), &info));
+    EXPECT_EQ(info.delayFrames, 529);
+    EXPECT_EQ(info.paddingFrames, 0);
+    EXPECT_EQ(info.sampleRate, 24000);
+
+    // No tag in the first frame, a tag with zero delay and padding, no file.
+    Bytes plain(mpeg1, mpeg1 + 4);
+    plain.resize(2000, 0);
+    ASSERT_TRUE(WriteFile(dir.File("plain.mp3"), plain));
+    ASSERT_TRUE(WriteFile(dir.File("zero.mp3"), Mp3TagFrame(mpeg1, 32, "Info", 0, 0, 0)));
+    info = GaplessInfo{7, 8, 9};
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("plain.mp3"), &info));
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("zero.mp3"), &info));
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("missing.mp3"), &info));
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("plain.mp3"), nullptr));
+    EXPECT_EQ(info.delayFrames, 7);
+    EXPECT_EQ(info.paddingFrames, 8);
+}
+
+Bytes Box(const char* type, const Bytes& payload)
+{
+    Bytes box;
+    AppendBe32(&box, static_cast<uint32_t>(8 + payload.size()));
+    Append(&box, type);
+    box.insert(box.end(), payload.begin(), payload.end());
+    return box;
+}
+
+Bytes FullBox(const char* type, const Bytes& payload)
+{
+    Bytes body(4, 0);
+    body.insert(body.end(), payload.begin(), payload.end());
+    return Box(type, body);
+}
+
+Bytes Concat(std::initializer_list<Bytes> parts)
+{
+    Bytes out;
+    for (const Bytes& p : parts) {
+        out.insert(out.end(), p.begin(), p.end());
+    }
+    return out;
+}
+
+Bytes Str(const std::string& s)
+{
+    return Bytes(s.begin(), s.end());
+}
+
+// ----:com.apple.iTunes:<name> with a UTF-8 data box.
+Bytes ITunesTag(const std::string& name, const std::string& value)
+{
+    Bytes data = {0, 0, 0, 1, 0, 0, 0, 0};  // type (UTF-8) and locale
+    Append(&data, value);
+    return Box("----", Concat({FullBox("mean", Str("com.apple.iTunes")), FullBox("name", Str(name)),
+                               Box("data", data)}));
+}
+
+TEST(ReadGaplessInfoTest, Mp4ITunSmpb)
+{
+    test::TempDir dir;
+    const Bytes ftyp = Box("ftyp", Concat({Str("M4A "), Bytes(4, 0), Str("isomM4A ")}));
+    const Bytes ilst = Box("ilst", Concat({ITunesTag("iTunNORM", " 00000A2C 000009E5"),
+                                           ITunesTag("iTunSMPB", " 00000000 00000840 000001CA 00000000003F31F6")}));
+    const Bytes meta = FullBox("meta", Concat({Box("hdlr", Bytes(25, 0)), ilst}));
+    const Bytes moov = Box("moov", Concat({Box("mvhd", Bytes(100, 0)), Box("udta", meta)}));
+    ASSERT_TRUE(WriteFile(dir.File("tagged.m4a"), Concat({ftyp, Box("mdat", Bytes(5000, 0x11)), moov})));
+
+    GaplessInfo info;
+    ASSERT_TRUE(ReadGaplessInfo(dir.File("tagged.m4a"), &info));
+    EXPECT_EQ(info.delayFrames, 0x840);
+    EXPECT_EQ(info.paddingFrames, 0x1ca);
+    EXPECT_EQ(info.sampleRate, 0);
+
+    // Without the tag, or with a box size running past its parent.
+    const Bytes untagged = Box("moov", Box("udta", FullBox("meta", Box("ilst", ITunesTag("iTunNORM", " 0")))));
+    ASSERT_TRUE(WriteFile(dir.File("untagged.m4a"), Concat({ftyp, untagged})));
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("untagged.m4a"), &info));
+    Bytes broken = Concat({ftyp, moov});
+    broken[ftyp.size() + 1] = 0x10;  // moov claims a megabyte more than the file has
+    ASSERT_TRUE(WriteFile(dir.File("broken.m4a"), broken));
+    EXPECT_FALSE(ReadGaplessInfo(dir.File("broken.m4a"), &info));
+}
+
+} // namespace
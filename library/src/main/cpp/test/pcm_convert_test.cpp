@@ -0,0 +1,284 @@
+// pcm_convert kernels against the scalar definitions in pcm_convert.h, bit for
+// bit. Every case runs at element offsets 0..3 (so vector loads and stores are
+// unaligned) and counts 0..67 (every tail length after the 4- and 8-wide
+// loops), with input and output in buffers of exactly the used size so the
+// FREE_PCM_SANITIZE=address build catches reads or writes past the end.
+//
+// The kernels compiled here are the ones of the host: SSE2 on x86_64, NEON on
+// arm64. The NEON path is only validated where the tests run on an arm64 host.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "pcm_convert.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr size_t kMaxOffset = 4;
+constexpr size_t kMaxTail = 68;
+
+// Scalar definitions (pcm_convert.h).
+float RefToFloat(int32_t x, float norm, float gain)
+{
+    return (static_cast<float>(x) * norm) * gain;
+}
+
+int32_t RefS24(const uint8_t* p)
+{
+    const uint32_t u = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                       (static_cast<uint32_t>(p[2]) << 16);
+    return static_cast<int32_t>(u << 8);
+}
+
+int16_t RefS16(float x, float scale)
+{
+    float v = x * scale;
+    v = std::min(std::max(v, -32768.0f), 32767.0f);
+    return static_cast<int16_t>(std::lround(v));
+}
+
+int32_t RefS32(float x, float scale)
+{
+    double v = static_cast<double>(x) * static_cast<double>(scale);
+    v = std::min(std::max(v, -2147483648.0), 2147483647.0);
+    return static_cast<int32_t>(std::llround(v));
+}
+
+template <typename T>
+bool SameBits(const T& a, const T& b)
+{
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// Runs kernel(in, out, count) on in[first, first + count) copied to an
+// exact-size buffer at every offset, and compares each output element with
+// ref(element index in `in`).
+template <typename In, typename Out, typename Kernel, typename Ref>
+void CheckSlice(const std::vector<In>& in, size_t first, size_t count, size_t offset, Kernel kernel, Ref ref)
+{
+    std::vector<In> src(offset + count);
+    std::copy(in.begin() + static_cast<ptrdiff_t>(first), in.begin() + static_cast<ptrdiff_t>(first + count),
+              src.begin() + static_cast<ptrdiff_t>(offset));
+    std::vector<Out> dst(offset + count);
+    kernel(src.data() + offset, dst.data() + offset, count);
+    for (size_t i = 0; i < count; i++) {
+        const Out expected = ref(first + i);
+        if (!SameBits(dst[offset + i], expected)) {
+            FAIL() << "element " << first + i << " (offset " << offset << ", count " << count
+                   << "): " << +dst[offset + i] << " != " << +expected;
+        }
+    }
+}
+
+// The whole input in one call, then every tail length at every offset.
+template <typename In, typename Out, typename Kernel, typename Ref>
+void CheckAll(const std::vector<In>& in, Kernel kernel, Ref ref)
+{
+    for (size_t offset = 0; offset < kMaxOffset; offset++) {
+        CheckSlice<In, Out>(in, 0, in.size(), offset, kernel, ref);
+        for (size_t count = 0; count < kMaxTail && count <= in.size(); count++) {
+            CheckSlice<In, Out>(in, in.size() - count, count, offset, kernel, ref);
+        }
+    }
+}
+
+// Decoder normalizations (S16, S24 and Q31 scale) and EQ preamps.
+const float kNorms[] = {1.0f / 32768.0f, 1.0f / 8388608.0f, 1.0f / 2147483648.0f};
+const float kGains[] = {1.0f, 0.5f, 0.70794576f};
+
+std::vector<int32_t> S32Values(std::mt19937& rng)
+{
+    const int32_t kMin = std::numeric_limits<int32_t>::min();
+    const int32_t kMax = std::numeric_limits<int32_t>::max();
+    std::vector<int32_t> v = {0, 1, -1, kMin, kMin + 1, kMax, kMax - 1, 32767, -32768, 8388607, -8388608};
+    std::uniform_int_distribution<int32_t> any(kMin, kMax);
+    while (v.size() < 4096) {
+        v.push_back(any(rng));
+    }
+    return v;
+}
+
+TEST(PcmConvertTest, S16ToFloatEveryValue)
+{
+    std::vector<int16_t> in;
+    for (int32_t x = -32768; x <= 32767; x++) {
+        in.push_back(static_cast<int16_t>(x));
+    }
+    for (float norm : kNorms) {
+        for (float gain : kGains) {
+            CheckAll<int16_t, float>(
+                in, [&](const int16_t* s, float* d, size_t n) { pcm_convert::S16ToFloat(s, d, n, norm, gain); },
+                [&](size_t i) { return RefToFloat(in[i], norm, gain); });
+        }
+    }
+}
+
+TEST(PcmConvertTest, S32ToFloat)
+{
+    std::mt19937 rng = test::Rng(1);
+    const std::vector<int32_t> in = S32Values(rng);
+    for (float norm : kNorms) {
+        for (float gain : kGains) {
+            CheckAll<int32_t, float>(
+                in, [&](const int32_t* s, float* d, size_t n) { pcm_convert::S32ToFloat(s, d, n, norm, gain); },
+                [&](size_t i) { return RefToFloat(in[i], norm, gain); });
+        }
+    }
+}
+
+TEST(PcmConvertTest, F32ToFloat)
+{
+    std::mt19937 rng = test::Rng(2);
+    std::uniform_real_distribution<float> amp(-2.0f, 2.0f);
+    std::vector<float> in = {0.0f, -0.0f, 1.0f, -1.0f, std::numeric_limits<float>::denorm_min()};
+    while (in.size() < 4096) {
+        in.push_back(amp(rng));
+    }
+    for (float gain : kGains) {
+        CheckAll<float, float>(
+            in, [&](const float* s, float* d, size_t n) { pcm_convert::F32ToFloat(s, d, n, gain); },
+            [&](size_t i) { return in[i] * gain; });
+    }
+}
+
+// Packed S24 works on bytes: the exact-size buffer is what catches the vector
+// loads' over-read, and offsets 0..3 samples cover every 16-byte phase.
+TEST(PcmConvertTest, S24EveryValue)
+{
+    const size_t count = size_t{1} << 24;
+    std::vector<uint8_t> bytes(count * pcm_convert::kS24Bytes);
+    for (size_t v = 0; v < count; v++) {
+        bytes[v * 3] = static_cast<uint8_t>(v);
+        bytes[v * 3 + 1] = static_cast<uint8_t>(v >> 8);
+        bytes[v * 3 + 2] = static_cast<uint8_t>(v >> 16);
+    }
+
+    std::vector<int32_t> s32(count);
+    pcm_convert::S24ToS32(bytes.data(), s32.data(), count);
+    std::vector<float> f(count);
+    const float norm = 1.0f / 2147483648.0f;
+    pcm_convert::S24ToFloat(bytes.data(), f.data(), count, norm, 0.5f);
+    for (size_t i = 0; i < count; i++) {
+        const int32_t expected = RefS24(&bytes[i * 3]);
+        if (s32[i] != expected || !SameBits(f[i], RefToFloat(expected, norm, 0.5f))) {
+            FAIL() << "24-bit value " << i << ": " << s32[i] << ", " << f[i];
+        }
+    }
+}
+
+TEST(PcmConvertTest, S24Tails)
+{
+    std::mt19937 rng = test::Rng(3);
+    const size_t samples = 256;
+    std::vector<uint8_t> bytes(samples * pcm_convert::kS24Bytes);
+    for (uint8_t& b : bytes) {
+        b = static_cast<uint8_t>(rng());
+    }
+    for (size_t offset = 0; offset < kMaxOffset; offset++) {
+        for (size_t count = 0; count < kMaxTail; count++) {
+            const size_t first = samples - count;
+            std::vector<uint8_t> src((offset + count) * pcm_convert::kS24Bytes);
+            std::copy(bytes.begin() + static_cast<ptrdiff_t>(first * 3), bytes.end(),
+                      src.begin() + static_cast<ptrdiff_t>(offset * 3));
+            const uint8_t* s = src.data() + offset * 3;
+            std::vector<int32_t> s32(offset + count);
+            std::vector<float> f(offset + count);
+            pcm_convert::S24ToS32(s, s32.data() + offset, count);
+            pcm_convert::S24ToFloat(s, f.data() + offset, count, 1.0f / 8388608.0f, 0.70794576f);
+            for (size_t i = 0; i < count; i++) {
+                const int32_t expected = RefS24(s + i * 3);
+                ASSERT_EQ(s32[offset + i], expected) << "offset " << offset << ", count " << count << ", i " << i;
+                ASSERT_TRUE(SameBits(f[offset + i], RefToFloat(expected, 1.0f / 8388608.0f, 0.70794576f)))
+                    << "offset " << offset << ", count " << count << ", i " << i;
+            }
+        }
+    }
+}
+
+// INT32_MIN (|x| = 2^31) in every lane and in the scalar tail, and a running
+// maximum that is already larger.
+TEST(PcmConvertTest, AbsMaxS32)
+{
+    std::mt19937 rng = test::Rng(4);
+    std::uniform_int_distribution<int32_t> small(-1000, 1000);
+    for (size_t count = 0; count < kMaxTail; count++) {
+        for (size_t offset = 0; offset < kMaxOffset; offset++) {
+            std::vector<int32_t> buf(offset + count);
+            for (int32_t& v : buf) {
+                v = small(rng);
+            }
+            int32_t* in = buf.data() + offset;
+            int64_t expected = 0;
+            for (size_t i = 0; i < count; i++) {
+                expected = std::max<int64_t>(expected, std::llabs(static_cast<int64_t>(in[i])));
+            }
+            ASSERT_EQ(pcm_convert::AbsMaxS32(in, count, 0), expected) << "count " << count;
+            ASSERT_EQ(pcm_convert::AbsMaxS32(in, count, int64_t{1} << 40), int64_t{1} << 40);
+            for (size_t at = 0; at < count; at++) {
+                const int32_t saved = in[at];
+                in[at] = std::numeric_limits<int32_t>::min();
+                ASSERT_EQ(pcm_convert::AbsMaxS32(in, count, 0), int64_t{1} << 31) << "count " << count << ", at " << at;
+                in[at] = std::numeric_limits<int32_t>::max();
+                ASSERT_EQ(pcm_convert::AbsMaxS32(in, count, 0), int64_t{2147483647});
+                in[at] = saved;
+            }
+        }
+    }
+}
+
+// Float inputs for the output kernels at a given scale: every tie (k + 0.5) and
+// its neighbours across the output range, values past full scale in both
+// directions, infinities, and random samples.
+std::vector<float> FloatOutputValues(float scale, double fullScale, std::mt19937& rng)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> v = {0.0f, -0.0f, 1.0f, -1.0f, 1.5f, -1.5f, 100.0f, -100.0f, inf, -inf};
+    std::uniform_real_distribution<double> k(-fullScale, fullScale);
+    for (int i = 0; i < 4096; i++) {
+        const float tie = static_cast<float>((std::floor(k(rng)) + 0.5) / static_cast<double>(scale));
+        v.push_back(tie);
+        v.push_back(std::nextafter(tie, inf));
+        v.push_back(std::nextafter(tie, -inf));
+    }
+    std::uniform_real_distribution<float> amp(-1.2f, 1.2f);
+    while (v.size() < 16384) {
+        v.push_back(amp(rng));
+    }
+    return v;
+}
+
+TEST(PcmConvertTest, FloatToS16)
+{
+    std::mt19937 rng = test::Rng(5);
+    // The decoder's denorm (32768) and a scale that is not a power of two.
+    for (float scale : {32768.0f, 32767.0f, 1.0f}) {
+        const std::vector<float> in = FloatOutputValues(scale, 32768.0, rng);
+        CheckAll<float, int16_t>(
+            in, [&](const float* s, int16_t* d, size_t n) { pcm_convert::FloatToS16(s, d, n, scale); },
+            [&](size_t i) { return RefS16(in[i], scale); });
+    }
+}
+
+TEST(PcmConvertTest, FloatToS32)
+{
+    std::mt19937 rng = test::Rng(6);
+    // Decoder denorms (S16, S24 and Q31 scale; vector path) and scales that are
+    // not a power of two (scalar fallback).
+    for (float scale : {32768.0f, 8388608.0f, 2147483648.0f, 8388607.0f, 1000000000.0f}) {
+        const std::vector<float> in = FloatOutputValues(scale, std::min(2147483648.0, double{scale}), rng);
+        CheckAll<float, int32_t>(
+            in, [&](const float* s, int32_t* d, size_t n) { pcm_convert::FloatToS32(s, d, n, scale); },
+            [&](size_t i) { return RefS32(in[i], scale); });
+    }
+}
+
+} // namespace
@@ -0,0 +1,206 @@
+// PcmCrossfade: the FIFO withholds exactly the last window and releases every
+// byte once, in order, for any chunk sizes; MixTile follows the cos/sin ramp,
+// tiles of any split give the same mix, and the summed power of uncorrelated
+// signals stays constant across the window.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "pcm_crossfade.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr size_t kFrameBytes = 4;
+
+std::vector<uint8_t> RandomBytes(std::mt19937& rng, size_t size)
+{
+    std::vector<uint8_t> out(size);
+    for (uint8_t& b : out) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return out;
+}
+
+// Feeds data in random whole-frame chunks; everything passed on lands in *out.
+bool FeedInChunks(PcmCrossfade& xf, std::mt19937& rng, const std::vector<uint8_t>& data, bool hold,
+                  std::vector<uint8_t>* out)
+{
+    const PcmCrossfade::Output sink = [out](const uint8_t* p, size_t n, int64_t) {
+        out->insert(out->end(), p, p + n);
+        return true;
+    };
+    for (size_t at = 0; at < data.size();) {
+        const size_t n = std::min((1 + rng() % 3000) * kFrameBytes, data.size() - at);
+        if (!xf.Feed(data.data() + at, n, 0, hold, sink)) {
+            return false;
+        }
+        at += n;
+    }
+    return true;
+}
+
+std::vector<uint8_t> PopAll(PcmCrossfade& xf)
+{
+    std::vector<uint8_t> out;
+    const uint8_t* p = nullptr;
+    while (size_t n = xf.PopTail(&p)) {
+        EXPECT_LE(n, PcmCrossfade::kChunkFrames * kFrameBytes);
+        out.insert(out.end(), p, p + n);
+    }
+    return out;
+}
+
+// The window is larger than, equal to and smaller than the stream.
+TEST(PcmCrossfadeTest, HoldsBackExactlyTheLastWindow)
+{
+    std::mt19937 rng = test::Rng(1);
+    const size_t window = 10000;
+    for (size_t frames : {size_t(3000), window, size_t(123457)}) {
+        PcmCrossfade xf;
+        xf.Configure(kFrameBytes, window);
+        EXPECT_EQ(xf.WindowFrames(), window);
+        const std::vector<uint8_t> data = RandomBytes(rng, frames * kFrameBytes);
+        std::vector<uint8_t> passed;
+        ASSERT_TRUE(FeedInChunks(xf, rng, data, true, &passed));
+
+        const size_t held = std::min(frames, window) * kFrameBytes;
+        EXPECT_EQ(xf.TailBytes(), held);
+        ASSERT_EQ(passed.size(), data.size() - held);
+        EXPECT_TRUE(std::equal(passed.begin(), passed.end(), data.begin()));
+        const std::vector<uint8_t> tail = PopAll(xf);
+        EXPECT_TRUE(tail == std::vector<uint8_t>(data.end() - static_cast<ptrdiff_t>(held), data.end()));
+        EXPECT_EQ(xf.TailBytes(), 0u);
+    }
+}
+
+// Dropping the hold (the queue emptied) releases the withheld bytes before the
+// new ones; a window of 0 passes everything straight through.
+TEST(PcmCrossfadeTest, ReleasesInOrderWithoutHold)
+{
+    std::mt19937 rng = test::Rng(2);
+    const std::vector<uint8_t> data = RandomBytes(rng, 50000 * kFrameBytes);
+    const std::vector<uint8_t> first(data.begin(), data.begin() + 30000 * kFrameBytes);
+    const std::vector<uint8_t> second(data.begin() + 30000 * kFrameBytes, data.end());
+
+    PcmCrossfade xf;
+    xf.Configure(kFrameBytes, 8000);
+    std::vector<uint8_t> passed;
+    ASSERT_TRUE(FeedInChunks(xf, rng, first, true, &passed));
+    ASSERT_TRUE(FeedInChunks(xf, rng, second, false, &passed));
+    EXPECT_EQ(xf.TailBytes(), 0u);
+    EXPECT_TRUE(passed == data);
+
+    PcmCrossfade off;
+    off.Configure(kFrameBytes, 0);
+    passed.clear();
+    ASSERT_TRUE(FeedInChunks(off, rng, data, true, &passed));
+    EXPECT_EQ(off.TailBytes(), 0u);
+    EXPECT_TRUE(passed == data);
+}
+
+TEST(PcmCrossfadeTest, ClearAndFailingOutput)
+{
+    std::mt19937 rng = test::Rng(3);
+    const std::vector<uint8_t> data = RandomBytes(rng, 20000 * kFrameBytes);
+    PcmCrossfade xf;
+    xf.Configure(kFrameBytes, 5000);
+    std::vector<uint8_t> passed;
+    ASSERT_TRUE(FeedInChunks(xf, rng, data, true, &passed));
+    xf.Clear();
+    EXPECT_EQ(xf.TailBytes(), 0u);
+    EXPECT_TRUE(PopAll(xf).empty());
+
+    // A refusing sink stops the feed.
+    ASSERT_TRUE(FeedInChunks(xf, rng, data, true, &passed));
+    int calls = 0;
+    const PcmCrossfade::Output refuse = [&calls](const uint8_t*, size_t, int64_t) {
+        calls++;
+        return false;
+    };
+    EXPECT_FALSE(xf.Feed(data.data(), 100 * kFrameBytes, 0, true, refuse));
+    EXPECT_FALSE(xf.Feed(data.data(), 100 * kFrameBytes, 0, false, refuse));
+    EXPECT_EQ(calls, 2);
+}
+
+// One channel fading out at 1 and one fading in at 1 trace cos and sin.
+TEST(PcmCrossfadeTest, MixFollowsTheQuarterPeriodRamp)
+{
+    const size_t window = 4800;
+    std::vector<float> mix(2 * (window + 100));
+    std::vector<float> in(mix.size());
+    for (size_t f = 0; f < window + 100; f++) {
+        mix[2 * f] = 1.0f;
+        in[2 * f + 1] = 1.0f;
+    }
+    PcmCrossfade::MixTile(mix.data(), in.data(), window + 100, 2, 0, window);
+    for (size_t f = 0; f < window + 100; f++) {
+        const double x = (M_PI / 2.0) * static_cast<double>(std::min(f, window)) / static_cast<double>(window);
+        ASSERT_NEAR(mix[2 * f], std::cos(x), 1e-6) << f;
+        ASSERT_NEAR(mix[2 * f + 1], std::sin(x), 1e-6) << f;
+    }
+    EXPECT_EQ(mix[0], 1.0f);
+    EXPECT_EQ(mix[1], 0.0f);
+}
+
+// Tiles of any size mix the same as the whole window at once.
+TEST(PcmCrossfadeTest, TilesMatchOneShotMix)
+{
+    std::mt19937 rng = test::Rng(4);
+    std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+    const size_t channels = 6;
+    const size_t window = 9000;
+    std::vector<float> out(channels * window);
+    std::vector<float> in(out.size());
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = sample(rng);
+        in[i] = sample(rng);
+    }
+    std::vector<float> whole = out;
+    PcmCrossfade::MixTile(whole.data(), in.data(), window, channels, 0, window);
+    std::vector<float> tiled = out;
+    for (size_t f = 0; f < window;) {
+        const size_t n = std::min<size_t>(1 + rng() % PcmCrossfade::kChunkFrames, window - f);
+        PcmCrossfade::MixTile(tiled.data() + f * channels, in.data() + f * channels, n, channels, f, window);
+        f += n;
+    }
+    EXPECT_TRUE(tiled == whole);
+}
+
+// Uncorrelated noise of equal level on both sides: the power of the mix stays
+// within 5 % of the input power in every block across the window.
+TEST(PcmCrossfadeTest, EqualPowerForUncorrelatedSignals)
+{
+    std::mt19937 rng = test::Rng(5);
+    std::normal_distribution<float> noise(0.0f, 0.25f);
+    const size_t channels = 2;
+    const size_t window = 48000 * 2;
+    std::vector<float> out(channels * window);
+    std::vector<float> in(out.size());
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = noise(rng);
+        in[i] = noise(rng);
+    }
+    std::vector<float> mix = out;
+    PcmCrossfade::MixTile(mix.data(), in.data(), window, channels, 0, window);
+
+    const size_t block = 4800;
+    for (size_t f = 0; f < window; f += block) {
+        double pOut = 0.0;
+        double pIn = 0.0;
+        double pMix = 0.0;
+        for (size_t i = f * channels; i < (f + block) * channels; i++) {
+            pOut += static_cast<double>(out[i]) * out[i];
+            pIn += static_cast<double>(in[i]) * in[i];
+            pMix += static_cast<double>(mix[i]) * mix[i];
+        }
+        EXPECT_NEAR(pMix / (0.5 * (pOut + pIn)), 1.0, 0.05) << "block at frame " << f;
+    }
+}
+
+} // namespace
@@ -0,0 +1,270 @@
+// PcmDiskCache: round trip through Fill/Commit and Open, keys that change with
+// the source file and decode parameters, abandoned fills, LRU eviction by the
+// .idx stamp and clean-up of stale temporaries. The LRU stamp has one-second
+// resolution, so the tests set the stamps explicitly instead of sleeping.
+
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pcm_disk_cache.h"
+#include "test_util.h"
+
+namespace {
+
+std::vector<std::string> ListDir(const std::string& dir)
+{
+    std::vector<std::string> names;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* de = readdir(d)) {
+            if (de->d_name[0] != '.') {
+                names.push_back(de->d_name);
+            }
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool EndsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::vector<std::string> WithSuffix(const std::string& dir, const std::string& suffix)
+{
+    std::vector<std::string> out;
+    for (const std::string& name : ListDir(dir)) {
+        if (EndsWith(name, suffix)) {
+            out.push_back(name);
+        }
+    }
+    return out;
+}
+
+void SetMtime(const std::string& path, time_t t)
+{
+    const timespec times[2] = {{t, 0}, {t, 0}};
+    ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0) << path;
+}
+
+void WriteFile(const std::string& path, const std::string& content)
+{
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+std::vector<uint8_t> RandomPcm(std::mt19937& rng, size_t size)
+{
+    std::vector<uint8_t> out(size);
+    for (uint8_t& b : out) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return out;
+}
+
+// Fills and commits one S16 stereo entry.
+bool Store(PcmDiskCache& cache, const std::string& key, const std::vector<uint8_t>& pcm)
+{
+    std::unique_ptr<PcmDiskCache::Fill> fill = cache.BeginFill(key);
+    if (!fill || !fill->SetFormat(48000, 2, 1, 0)) {
+        return false;
+    }
+    for (size_t at = 0; at < pcm.size(); at += 5000) {
+        if (!fill->Write(pcm.data() + at, std::min<size_t>(5000, pcm.size() - at))) {
+            return false;
+        }
+    }
+    return fill->Commit();
+}
+
+TEST(PcmDiskCacheTest, RoundTripAndIndex)
+{
+    test::TempDir dir;
+    PcmDiskCache cache(dir.File("cache/"), 0);
+    std::mt19937 rng = test::Rng(1);
+    // Not a whole number of frames: the index rounds down to full frames.
+    const std::vector<uint8_t> pcm = RandomPcm(rng, 48000 * 4 * 3 + 2);
+
+    EXPECT_EQ(cache.Open("key"), nullptr);
+    ASSERT_TRUE(Store(cache, "key", pcm));
+    std::unique_ptr<PcmDiskCache::Mapping> m = cache.Open("key");
+    ASSERT_NE(m, nullptr);
+    const PcmDiskCache::Index& index = m->GetIndex();
+    EXPECT_EQ(index.sampleRate, 48000);
+    EXPECT_EQ(index.channelCount, 2);
+    EXPECT_EQ(index.sampleFormat, 1);
+    EXPECT_EQ(index.bytesPerFrame, 4);
+    EXPECT_EQ(index.frameCount, 48000 * 3);
+    EXPECT_EQ(index.dataBytes, 48000 * 4 * 3);
+    EXPECT_EQ(index.durationMs, 3000);  // derived when the fill gave none
+    EXPECT_TRUE(std::equal(m->Data(), m->Data() + index.dataBytes, pcm.begin()));
+    m->WillNeed(index.dataBytes / 2, 1 << 16);
+
+    // Only the published pair is left behind.
+    EXPECT_EQ(ListDir(dir.File("cache")).size(), 2u);
+    EXPECT_EQ(cache.Open("other key"), nullptr);
+}
+
+TEST(PcmDiskCacheTest, KeyFollowsSourceFileAndParams)
+{
+    test::TempDir dir;
+    const PcmDiskCache cache(dir.File("cache"), 0);
+    const std::string source = dir.File("song.flac");
+    WriteFile(source, "encoded bytes");
+    SetMtime(source, 1000000);
+
+    PcmDiskCache::Params params;
+    params.sampleRate = 48000;
+    params.channelCount = 2;
+    params.sampleFormat = 1;
+    std::string key;
+    std::string again;
+    ASSERT_TRUE(cache.MakeKey(source, params, &key));
+    ASSERT_TRUE(cache.MakeKey(source, params, &again));
+    EXPECT_EQ(key, again);
+
+    std::string changed;
+    SetMtime(source, 1000001);
+    ASSERT_TRUE(cache.MakeKey(source, params, &changed));
+    EXPECT_NE(changed, key);
+
+    SetMtime(source, 1000000);
+    WriteFile(source, "encoded bytes, edited");
+    SetMtime(source, 1000000);
+    ASSERT_TRUE(cache.MakeKey(source, params, &changed));
+    EXPECT_NE(changed, key);
+
+    WriteFile(source, "encoded bytes");
+    SetMtime(source, 1000000);
+    ASSERT_TRUE(cache.MakeKey(source, params, &again));
+    EXPECT_EQ(again, key);
+    params.gaplessTrim = true;
+    ASSERT_TRUE(cache.MakeKey(source, params, &changed));
+    EXPECT_NE(changed, key);
+
+    EXPECT_FALSE(cache.MakeKey(dir.File("missing.flac"), params, &key));
+    EXPECT_FALSE(cache.MakeKey(dir.Path(), params, &key));
+}
+
+TEST(PcmDiskCacheTest, AbandonedFillsLeaveNothing)
+{
+    test::TempDir dir;
+    PcmDiskCache cache(dir.Path(), 0);
+    std::mt19937 rng = test::Rng(2);
+    const std::vector<uint8_t> pcm = RandomPcm(rng, 40000);
+
+    {
+        std::unique_ptr<PcmDiskCache::Fill> fill = cache.BeginFill("dropped");
+        ASSERT_NE(fill, nullptr);
+        ASSERT_TRUE(fill->SetFormat(48000, 2, 1, 0));
+        ASSERT_TRUE(fill->Write(pcm.data(), pcm.size()));
+    }  // destroyed without Commit()
+    {
+        std::unique_ptr<PcmDiskCache::Fill> fill = cache.BeginFill("abandoned");
+        ASSERT_NE(fill, nullptr);
+        ASSERT_TRUE(fill->SetFormat(48000, 2, 1, 0));
+        ASSERT_TRUE(fill->Write(pcm.data(), pcm.size()));
+        fill->Abandon();
+        EXPECT_FALSE(fill->IsActive());
+        EXPECT_FALSE(fill->Write(pcm.data(), pcm.size()));
+        EXPECT_FALSE(fill->Commit());
+    }
+    {
+        std::unique_ptr<PcmDiskCache::Fill> fill = cache.BeginFill("bad format");
+        ASSERT_NE(fill, nullptr);
+        EXPECT_FALSE(fill->SetFormat(48000, 2, 7, 0));
+        EXPECT_FALSE(fill->IsActive());
+    }
+    {
+        std::unique_ptr<PcmDiskCache::Fill> fill = cache.BeginFill("empty");
+        ASSERT_NE(fill, nullptr);
+        ASSERT_TRUE(fill->SetFormat(48000, 2, 1, 0));
+        EXPECT_FALSE(fill->Commit());
+    }
+
+    for (const char* key : {"dropped", "abandoned", "bad format", "empty"}) {
+        EXPECT_EQ(cache.Open(key), nullptr) << key;
+    }
+    EXPECT_TRUE(ListDir(dir.Path()).empty());
+}
+
+// Each entry is 64 KB of PCM plus a small index; the budget holds two.
+TEST(PcmDiskCacheTest, EvictsLeastRecentlyUsed)
+{
+    test::TempDir dir;
+    const int64_t entryBytes = 64 * 1024;
+    PcmDiskCache cache(dir.Path(), 2 * entryBytes + 1024);
+    std::mt19937 rng = test::Rng(3);
+    const std::vector<uint8_t> pcm = RandomPcm(rng, entryBytes);
+
+    // The index file a Store() added.
+    auto storeIdx = [&](const std::string& key) {
+        const std::vector<std::string> before = WithSuffix(dir.Path(), ".idx");
+        EXPECT_TRUE(Store(cache, key, pcm)) << key;
+        for (const std::string& idx : WithSuffix(dir.Path(), ".idx")) {
+            if (std::find(before.begin(), before.end(), idx) == before.end()) {
+                return dir.File(idx);
+            }
+        }
+        return std::string();
+    };
+
+    const time_t now = time(nullptr);
+    const std::string a = storeIdx("a");
+    const std::string b = storeIdx("b");
+    ASSERT_FALSE(a.empty());
+    ASSERT_FALSE(b.empty());
+    SetMtime(a, now - 300);
+    SetMtime(b, now - 200);
+
+    // A hit refreshes the stamp, making "a" the most recent.
+    ASSERT_NE(cache.Open("a"), nullptr);
+    struct stat st;
+    ASSERT_EQ(stat(a.c_str(), &st), 0);
+    EXPECT_GE(st.st_mtime, now);
+
+    ASSERT_FALSE(storeIdx("c").empty());  // over budget: "b" goes
+    EXPECT_NE(cache.Open("a"), nullptr);
+    EXPECT_EQ(cache.Open("b"), nullptr);
+    EXPECT_NE(cache.Open("c"), nullptr);
+    EXPECT_EQ(WithSuffix(dir.Path(), ".pcm").size(), 2u);
+    EXPECT_EQ(WithSuffix(dir.Path(), ".idx").size(), 2u);
+
+    // An entry over the whole budget is not cached at all.
+    EXPECT_FALSE(Store(cache, "huge", RandomPcm(rng, 3 * entryBytes)));
+    EXPECT_EQ(cache.Open("huge"), nullptr);
+    EXPECT_NE(cache.Open("a"), nullptr);
+    EXPECT_NE(cache.Open("c"), nullptr);
+}
+
+// Temporaries and index-less data older than an hour belong to no live fill.
+TEST(PcmDiskCacheTest, TrimRemovesStaleLeftovers)
+{
+    test::TempDir dir;
+    PcmDiskCache cache(dir.Path(), 0);
+    const time_t old = time(nullptr) - 2 * 60 * 60;
+    WriteFile(dir.File("0123456789abcdef.42-0.tmp"), "old partial fill");
+    WriteFile(dir.File("0123456789abcdef.42-0.tmp.idx"), "old index");
+    WriteFile(dir.File("fedcba9876543210.pcm"), "old orphaned data");
+    WriteFile(dir.File("1111111111111111.43-1.tmp"), "live fill");
+    SetMtime(dir.File("0123456789abcdef.42-0.tmp"), old);
+    SetMtime(dir.File("0123456789abcdef.42-0.tmp.idx"), old);
+    SetMtime(dir.File("fedcba9876543210.pcm"), old);
+
+    cache.Trim();
+    EXPECT_EQ(ListDir(dir.Path()), std::vector<std::string>{"1111111111111111.43-1.tmp"});
+}
+
+} // namespace
@@ -0,0 +1,375 @@
+// PcmRingBuffer concurrency tests. The producer writes a known byte stream
+// (StreamByte(i) at stream offset i) in random chunks, the consumer reads in
+// random chunks and checks every byte it gets against the stream. The
+// watermark tests count producer sleeps and wakeups. Run them in the
+// FREE_PCM_SANITIZE=thread and =address builds as well.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/ring_buffer.h"
+#include "test_util.h"
+
+namespace {
+
+using audio::PcmRingBuffer;
+
+uint8_t StreamByte(uint64_t i)
+{
+    return static_cast<uint8_t>((i * 0x9E3779B97F4A7C15ull) >> 56);
+}
+
+bool MatchesStream(const uint8_t* data, size_t n, uint64_t at)
+{
+    for (size_t k = 0; k < n; k++) {
+        if (data[k] != StreamByte(at + k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FillStream(uint8_t* data, size_t n, uint64_t at)
+{
+    for (size_t k = 0; k < n; k++) {
+        data[k] = StreamByte(at + k);
+    }
+}
+
+// Total stream length for a capacity: small rings move fewer bytes so every
+// case takes about the same number of producer/consumer hand-offs.
+size_t StreamBytes(size_t capacity)
+{
+    return std::min<size_t>(8u << 20, capacity * 16384);
+}
+
+// Capacities: degenerate, odd (wrap inside a sample), page-sized and large.
+const size_t kCapacities[] = {1, 7, 4096, 4099, 65536};
+
+class RingStressTest : public ::testing::TestWithParam<size_t> {};
+
+// Plain SPSC: Push/Read/ReadBlocking in random chunk sizes deliver the stream
+// byte for byte.
+TEST_P(RingStressTest, PushReadPreservesByteOrder)
+{
+    const size_t capacity = GetParam();
+    const size_t total = StreamBytes(capacity);
+    PcmRingBuffer ring(capacity, 48000, 2, 2);
+    std::atomic<bool> cancel(false);
+
+    std::thread producer([&]() {
+        std::mt19937 rng = test::Rng(1);
+        std::uniform_int_distribution<size_t> chunk(1, std::min<size_t>(2 * capacity + 1, 8192));
+        std::vector<uint8_t> buf(8192);
+        for (uint64_t at = 0; at < total;) {
+            const size_t n = std::min<size_t>(chunk(rng), total - at);
+            FillStream(buf.data(), n, at);
+            if (!ring.Push(buf.data(), n, &cancel)) {
+                break;
+            }
+            at += n;
+        }
+        ring.MarkEos();
+    });
+
+    std::mt19937 rng = test::Rng(2);
+    std::uniform_int_distribution<size_t> chunk(1, 8192);
+    std::vector<uint8_t> buf(8192);
+    uint64_t at = 0;
+    while (!ring.IsEos()) {
+        // Alternate the lock-free and the blocking read path; a blocking read waits for
+        // the full amount, so it never asks for more than the ring holds.
+        const bool blocking = (rng() & 1) != 0;
+        const size_t want = blocking ? std::min(chunk(rng), capacity) : chunk(rng);
+        const size_t n = blocking ? ring.ReadBlocking(buf.data(), want, 5) : ring.Read(buf.data(), want);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (n > want || !MatchesStream(buf.data(), n, at)) {
+            ADD_FAILURE() << "read of " << n << " bytes at stream offset " << at << " out of order";
+            cancel.store(true);
+            ring.Cancel();
+            break;
+        }
+        at += n;
+    }
+    producer.join();
+    EXPECT_EQ(at, total);
+    EXPECT_EQ(ring.Available(), 0u);
+}
+
+// Commit boundaries of the producer, in stream offsets. Clear() moves the read
+// cursor to the published write cursor, which is always one of them.
+class BoundaryLog {
+public:
+    explicit BoundaryLog(size_t maxEntries) : entries_(maxEntries + 1), count_(1) { entries_[0] = 0; }
+
+    void Append(uint64_t end)
+    {
+        const size_t i = count_.load(std::memory_order_relaxed);
+        entries_[i] = end;
+        count_.store(i + 1, std::memory_order_release);
+    }
+
+    // Boundaries >= from among those logged so far.
+    template <typename Fn>
+    void ForEachFrom(uint64_t from, Fn fn) const
+    {
+        const size_t n = count_.load(std::memory_order_acquire);
+        auto it = std::lower_bound(entries_.begin(), entries_.begin() + static_cast<ptrdiff_t>(n), from);
+        for (; it != entries_.begin() + static_cast<ptrdiff_t>(n); ++it) {
+            fn(*it);
+        }
+    }
+
+private:
+    std::vector<uint64_t> entries_;
+    std::atomic<size_t> count_;
+};
+
+// Clear() from a third thread races the consumer's Peek/Commit CAS and the
+// producer. A read either lands where the previous one ended or, when a
+// Clear overlapped it, at a later commit boundary; it never returns stale or
+// overwritten bytes, nor bytes a Clear that finished before it had dropped.
+TEST_P(RingStressTest, ClearRacingReadNeverDeliversStaleBytes)
+{
+    const size_t capacity = GetParam();
+    const size_t total = StreamBytes(capacity);
+    PcmRingBuffer ring(capacity, 48000, 2, 2);
+    std::atomic<bool> cancel(false);
+    std::atomic<bool> producerDone(false);
+    std::atomic<uint64_t> clearsStarted(0);
+    std::atomic<uint64_t> clearsDone(0);
+    // Everything published before the last finished Clear was dropped by it.
+    std::atomic<uint64_t> publishedEnd(0);
+    std::atomic<uint64_t> clearFloor(0);
+    BoundaryLog boundaries(total);
+
+    std::thread producer([&]() {
+        std::mt19937 rng = test::Rng(3);
+        std::uniform_int_distribution<size_t> chunk(1, std::min<size_t>(2 * capacity + 1, 8192));
+        for (uint64_t at = 0; at < total;) {
+            const PcmRingBuffer::WriteRegions w = ring.ReserveWrite(std::min<size_t>(chunk(rng), total - at), &cancel);
+            if (w.Total() == 0) {
+                break;
+            }
+            // Commit only part of the reservation now and then.
+            const size_t n = (rng() % 4 == 0) ? 1 + rng() % w.Total() : w.Total();
+            const size_t first = std::min(n, w.len[0]);
+            FillStream(w.data[0], first, at);
+            FillStream(w.data[1], n - first, at + first);
+            boundaries.Append(at + n);
+            ring.CommitWrite(n);
+            at += n;
+            publishedEnd.store(at);
+        }
+        ring.MarkEos();
+        producerDone.store(true);
+    });
+
+    std::thread seeker([&]() {
+        std::mt19937 rng = test::Rng(4);
+        while (!producerDone.load()) {
+            clearsStarted.fetch_add(1, std::memory_order_seq_cst);
+            const uint64_t published = publishedEnd.load();
+            ring.Clear();
+            clearFloor.store(published);
+            clearsDone.fetch_add(1, std::memory_order_seq_cst);
+            std::this_thread::sleep_for(std::chrono::microseconds(rng() % 200));
+        }
+    });
+
+    std::mt19937 rng = test::Rng(5);
+    std::uniform_int_distribution<size_t> chunk(1, 8192);
+    std::vector<uint8_t> buf(8192);
+    // Stream offsets the read cursor may be at; more than one only while a short
+    // read matched several places.
+    std::vector<uint64_t> cursors = {0};
+    std::vector<uint64_t> next;
+    uint64_t doneBeforeLastRead = 0;
+    uint64_t delivered = 0;
+    while ((!ring.IsEos() || !producerDone.load()) && !cancel.load()) {
+        const uint64_t doneBefore = clearsDone.load(std::memory_order_seq_cst);
+        const uint64_t floor = clearFloor.load();
+        const size_t n = ring.Read(buf.data(), chunk(rng));
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Any Clear that moved the cursor since the last read finished after that
+        // read began, so it is not in doneBeforeLastRead but is counted as started.
+        const bool cleared = clearsStarted.load(std::memory_order_seq_cst) != doneBeforeLastRead;
+        next.clear();
+        for (uint64_t at : cursors) {
+            if (at >= floor && MatchesStream(buf.data(), n, at)) {
+                next.push_back(at + n);
+            }
+        }
+        if (cleared) {
+            const uint64_t from = std::max(*std::min_element(cursors.begin(), cursors.end()), floor);
+            boundaries.ForEachFrom(from, [&](uint64_t at) {
+                if (at + n <= total && MatchesStream(buf.data(), n, at)) {
+                    next.push_back(at + n);
+                }
+            });
+        }
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        if (next.empty()) {
+            ADD_FAILURE() << "read of " << n << " bytes after stream offset " << cursors.front()
+                          << " matches no reachable offset (cleared=" << cleared << ")";
+            cancel.store(true);
+            ring.Cancel();
+            break;
+        }
+        cursors.swap(next);
+        doneBeforeLastRead = doneBefore;
+        delivered += n;
+    }
+    producer.join();
+    seeker.join();
+    EXPECT_GT(delivered, 0u);
+    EXPECT_LE(delivered, total);
+}
+
+INSTANTIATE_TEST_SUITE_P(Capacities, RingStressTest, ::testing::ValuesIn(kCapacities));
+
+// Cancel() releases a producer blocked on a full ring and a reader blocked on an
+// empty one.
+TEST(RingBufferTest, CancelReleasesBlockedProducerAndReader)
+{
+    PcmRingBuffer full(16, 48000, 2, 2);
+    std::atomic<bool> cancel(false);
+    std::vector<uint8_t> data(64, 1);
+    std::thread producer([&]() { EXPECT_FALSE(full.Push(data.data(), data.size(), &cancel)); });
+
+    PcmRingBuffer empty(16, 48000, 2, 2);
+    std::thread reader([&]() {
+        uint8_t out[8];
+        EXPECT_EQ(empty.ReadBlocking(out, sizeof(out), -1), 0u);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    full.Cancel();
+    empty.Cancel();
+    producer.join();
+    reader.join();
+}
+
+// At EOS a blocking read returns the short remainder instead of waiting.
+TEST(RingBufferTest, ReadBlockingReturnsTailAtEos)
+{
+    PcmRingBuffer ring(64, 48000, 2, 2);
+    std::atomic<bool> cancel(false);
+    uint8_t in[10];
+    FillStream(in, sizeof(in), 0);
+    ASSERT_TRUE(ring.Push(in, sizeof(in), &cancel));
+    ring.MarkEos();
+
+    uint8_t out[32];
+    ASSERT_EQ(ring.ReadBlocking(out, sizeof(out), -1), sizeof(in));
+    EXPECT_TRUE(MatchesStream(out, sizeof(in), 0));
+    EXPECT_TRUE(ring.IsEos());
+}
+
+// A 1.5 s 48 kHz stereo S16 ring drained in 10 ms chunks at a steady pace, as
+// the renderer does. Returns the producer's sleep/wakeup counts; the fill level
+// never goes above the high watermark.
+PcmRingBuffer::WakeupStats DrainInChunks(uint32_t highPercent, uint32_t lowPercent)
+{
+    const size_t capacity = 48000 * 4 * 3 / 2;
+    const size_t chunk = 48000 * 4 / 100;
+    const size_t total = 3000 * chunk;
+    PcmRingBuffer ring(capacity, 48000, 2, 2);
+    ring.SetWatermarks(highPercent, lowPercent);
+    const size_t limit = (highPercent == 0) ? capacity : capacity * highPercent / 100;
+    std::atomic<bool> cancel(false);
+
+    std::thread producer([&]() {
+        std::vector<uint8_t> buf(chunk);
+        for (uint64_t at = 0; at < total; at += chunk) {
+            FillStream(buf.data(), chunk, at);
+            if (!ring.Push(buf.data(), chunk, &cancel)) {
+                break;
+            }
+        }
+        ring.MarkEos();
+    });
+
+    std::vector<uint8_t> buf(chunk);
+    uint64_t at = 0;
+    while (at < total) {
+        if (ring.Available() > limit) {
+            ADD_FAILURE() << ring.Available() << " bytes buffered, limit " << limit;
+            break;
+        }
+        const size_t n = ring.ReadBlocking(buf.data(), chunk, -1);
+        if (n != chunk || !MatchesStream(buf.data(), n, at)) {
+            ADD_FAILURE() << "read of " << n << " bytes at stream offset " << at;
+            break;
+        }
+        at += n;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    cancel.store(true);
+    ring.Cancel();
+    producer.join();
+    EXPECT_EQ(at, total);
+    return ring.GetWakeupStats();
+}
+
+// Without watermarks the producer tops the ring up after nearly every chunk;
+// with 95/25 it writes 70 % of the ring per batch, about 30 batches here.
+TEST(RingBufferTest, WatermarksBatchProducerWakeups)
+{
+    const PcmRingBuffer::WakeupStats off = DrainInChunks(0, 0);
+    const PcmRingBuffer::WakeupStats on = DrainInChunks(95, 25);
+    EXPECT_LE(on.producerSleeps, 31u);
+    EXPECT_LE(on.producerWakeups, on.producerSleeps + 2);
+    EXPECT_GT(off.producerSleeps, 10 * on.producerSleeps);
+    EXPECT_GE(off.producerWakeups, off.producerSleeps - 1);
+}
+
+// SetWatermarks wakes a sleeping producer so it re-evaluates; invalid levels
+// switch the mode off.
+TEST(RingBufferTest, SetWatermarksWakesSleepingProducer)
+{
+    const size_t capacity = 1000;
+    PcmRingBuffer ring(capacity, 48000, 2, 2);
+    ring.SetWatermarks(50, 10);
+    std::atomic<bool> cancel(false);
+    std::vector<uint8_t> data(capacity);
+    FillStream(data.data(), data.size(), 0);
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        EXPECT_TRUE(ring.Push(data.data(), data.size(), &cancel));
+        pushed.store(true);
+    });
+
+    // Stuck at the high watermark; draining to just above the low one is not enough.
+    while (ring.GetWakeupStats().producerSleeps == 0) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(ring.Available(), 500u);
+    std::vector<uint8_t> out(capacity);
+    ASSERT_EQ(ring.Read(out.data(), 399), 399u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(ring.Available(), 101u);
+    EXPECT_FALSE(pushed.load());
+
+    ring.SetWatermarks(60, 60);
+    producer.join();
+    EXPECT_EQ(ring.Available(), 601u);
+    ASSERT_EQ(ring.Read(out.data() + 399, 601), 601u);
+    EXPECT_TRUE(MatchesStream(out.data(), capacity, 0));
+}
+
+} // namespace
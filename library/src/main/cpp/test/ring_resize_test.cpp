@@ -0,0 +1,323 @@
+// PcmRingBuffer::Resize and RingResizePolicy. Resizes keep the buffered data,
+// the history and the position; a shrink below the unread amount holds the
+// producer to the new capacity at once and completes once the consumer has
+// drained enough. The stream is 1 kHz mono 32-bit with every frame holding its
+// own index, as in ring_seek_test. Run in the FREE_PCM_SANITIZE builds as well.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/ring_buffer.h"
+#include "buffer/ring_resize_policy.h"
+#include "test_util.h"
+
+namespace {
+
+using audio::PcmRingBuffer;
+using audio::RingResizePolicy;
+
+constexpr int kRate = 1000;
+constexpr size_t kFrame = sizeof(uint32_t);
+
+PcmRingBuffer MakeRing(size_t frames, size_t historyFrames = 0)
+{
+    return PcmRingBuffer(frames * kFrame, kRate, 1, kFrame, historyFrames * kFrame);
+}
+
+void PushFrames(PcmRingBuffer& ring, uint32_t from, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = from + i;
+    }
+    ASSERT_TRUE(ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), count * kFrame, nullptr));
+}
+
+// Index of the first frame of a read of count frames, which must be
+// contiguous; -1 for a short or torn read.
+int64_t ReadFrames(PcmRingBuffer& ring, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    if (ring.Read(reinterpret_cast<uint8_t*>(frames.data()), count * kFrame) != count * kFrame) {
+        return -1;
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        if (frames[i] != frames[0] + i) {
+            return -1;
+        }
+    }
+    return frames[0];
+}
+
+TEST(RingResizeTest, GrowKeepsDataHistoryAndPosition)
+{
+    PcmRingBuffer ring = MakeRing(100, 50);
+    PushFrames(ring, 0, 100);
+    ASSERT_EQ(ReadFrames(ring, 60), 0);
+
+    ASSERT_TRUE(ring.Resize(300 * kFrame));
+    EXPECT_EQ(ring.Capacity(), 300 * kFrame);
+    PcmRingBuffer::MemoryStats stats = ring.GetMemoryStats();
+    EXPECT_EQ(stats.capacityBytes, 300 * kFrame);
+    EXPECT_EQ(stats.allocatedBytes, (150 + 350) * kFrame);  // the old storage until the reader moves
+    EXPECT_EQ(stats.bufferedBytes, 40 * kFrame);
+    EXPECT_EQ(stats.historyBytes, 50 * kFrame);
+    EXPECT_EQ(ring.GetPositionMs(), 60u);
+
+    // The history came along.
+    EXPECT_FALSE(ring.SeekWithinBuffer(9));
+    EXPECT_TRUE(ring.SeekWithinBuffer(10));
+    EXPECT_EQ(ReadFrames(ring, 10), 10);
+    EXPECT_TRUE(ring.SeekWithinBuffer(60));
+
+    // The new room is usable without blocking.
+    PushFrames(ring, 100, 260);
+    EXPECT_EQ(ReadFrames(ring, 300), 60);
+    EXPECT_EQ(ring.GetMemoryStats().allocatedBytes, (150 + 350) * kFrame);
+    ASSERT_TRUE(ring.Resize(300 * kFrame));
+    EXPECT_EQ(ring.GetMemoryStats().allocatedBytes, 350 * kFrame);
+}
+
+// The previous storage is freed only after the reader has moved to the new one.
+TEST(RingResizeTest, WaitsForTheReaderToSwitch)
+{
+    PcmRingBuffer ring = MakeRing(100);
+    PushFrames(ring, 0, 50);
+    ASSERT_TRUE(ring.Resize(200 * kFrame));
+    EXPECT_FALSE(ring.Resize(400 * kFrame));
+    EXPECT_EQ(ring.Capacity(), 200 * kFrame);
+
+    // Even an empty read moves the reader over.
+    uint8_t none[kFrame];
+    PcmRingBuffer empty = MakeRing(100);
+    ASSERT_TRUE(empty.Resize(200 * kFrame));
+    EXPECT_EQ(empty.Read(none, sizeof(none)), 0u);
+    EXPECT_TRUE(empty.Resize(400 * kFrame));
+
+    ASSERT_EQ(ReadFrames(ring, 10), 0);
+    ASSERT_TRUE(ring.Resize(400 * kFrame));
+    EXPECT_EQ(ReadFrames(ring, 40), 10);
+    EXPECT_FALSE(ring.Resize(0));
+}
+
+// A shrink below the unread amount lowers the fill limit right away and swaps
+// the storage once the consumer is below the new capacity.
+TEST(RingResizeTest, SoftShrinkWithHistory)
+{
+    PcmRingBuffer ring = MakeRing(400, 100);
+    PushFrames(ring, 0, 400);
+    ASSERT_EQ(ReadFrames(ring, 200), 0);
+
+    EXPECT_FALSE(ring.Resize(100 * kFrame));
+    EXPECT_EQ(ring.Capacity(), 100 * kFrame);
+    EXPECT_EQ(ring.GetMemoryStats().allocatedBytes, 500 * kFrame);
+
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        PushFrames(ring, 400, 1);
+        pushed.store(true);
+    });
+    ASSERT_EQ(ReadFrames(ring, 100), 200);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+    ASSERT_EQ(ReadFrames(ring, 1), 300);
+    producer.join();
+
+    EXPECT_TRUE(ring.Resize(100 * kFrame));
+    ASSERT_EQ(ReadFrames(ring, 10), 301);
+    EXPECT_TRUE(ring.Resize(100 * kFrame));
+    PcmRingBuffer::MemoryStats stats = ring.GetMemoryStats();
+    EXPECT_EQ(stats.allocatedBytes, 200 * kFrame);
+    EXPECT_EQ(stats.historyBytes, 100 * kFrame);
+    EXPECT_TRUE(ring.SeekWithinBuffer(211));
+    EXPECT_EQ(ReadFrames(ring, 190), 211);
+
+    // Growing back while a shrink is pending just lifts the limit again.
+    PcmRingBuffer pending = MakeRing(400);
+    PushFrames(pending, 0, 300);
+    EXPECT_FALSE(pending.Resize(100 * kFrame));
+    EXPECT_TRUE(pending.Resize(400 * kFrame));
+    EXPECT_EQ(pending.Capacity(), 400 * kFrame);
+    PushFrames(pending, 300, 100);
+    EXPECT_EQ(ReadFrames(pending, 400), 0);
+}
+
+// The producer resizes at random between writes, retrying pending shrinks the
+// way the decode thread does, while a consumer reads and a seeker jumps both
+// ways. Reads stay contiguous runs of frames.
+TEST(RingResizeTest, ResizeRacingReadAndSeek)
+{
+    const uint32_t total = 2000000;
+    const uint32_t history = 1024;
+    PcmRingBuffer ring = MakeRing(4096, history);
+    std::atomic<bool> cancel(false);
+    std::atomic<bool> producerDone(false);
+    std::vector<std::atomic<bool>> tried(total + 1);
+    std::atomic<uint64_t> resizes(0);
+
+    std::thread producer([&]() {
+        std::mt19937 rng = test::Rng(1);
+        std::vector<uint32_t> frames(512);
+        size_t pending = 0;
+        for (uint32_t at = 0; at < total;) {
+            if (pending == 0 && rng() % 64 == 0) {
+                pending = (64 + rng() % 8192) * kFrame;
+            }
+            if (pending != 0 && ring.Resize(pending)) {
+                pending = 0;
+                resizes.fetch_add(1);
+            }
+            const uint32_t n = std::min<uint32_t>(1 + rng() % 512, total - at);
+            for (uint32_t i = 0; i < n; i++) {
+                frames[i] = at + i;
+            }
+            if (!ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), n * kFrame, &cancel)) {
+                break;
+            }
+            at += n;
+        }
+        ring.MarkEos();
+        producerDone.store(true);
+    });
+
+    std::thread seeker([&]() {
+        std::mt19937 rng = test::Rng(2);
+        while (!producerDone.load() && !cancel.load()) {
+            const uint64_t pos = ring.GetPositionMs();
+            const uint64_t back = rng() % (2 * history);
+            const uint64_t target = (rng() & 1) ? pos + rng() % 2000 : pos - std::min(pos, back);
+            if (target <= total) {
+                tried[target].store(true, std::memory_order_release);
+            }
+            ring.SeekWithinBuffer(target);
+            std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 rng = test::Rng(3);
+    std::vector<uint32_t> frames(512);
+    uint64_t cursor = 0;
+    while (!ring.IsEos() && !cancel.load()) {
+        const size_t n = ring.Read(reinterpret_cast<uint8_t*>(frames.data()), (1 + rng() % 512) * kFrame);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint32_t first = frames[0];
+        bool ok = n % kFrame == 0 && (first == cursor || tried[first].load(std::memory_order_acquire));
+        for (size_t i = 1; ok && i < n / kFrame; i++) {
+            ok = frames[i] == first + i;
+        }
+        if (!ok) {
+            ADD_FAILURE() << "read of " << n << " bytes starting at frame " << first << " after frame " << cursor;
+            cancel.store(true);
+            ring.Cancel();
+            break;
+        }
+        cursor = first + n / kFrame;
+    }
+    producer.join();
+    seeker.join();
+    EXPECT_LE(cursor, total);
+    EXPECT_EQ(ring.GetBytesRead(), total * kFrame);
+    EXPECT_GT(resizes.load(), 0u);
+}
+
+RingResizePolicy::Sample PolicySample(uint64_t nowMs, size_t capacity, size_t buffered)
+{
+    RingResizePolicy::Sample s;
+    s.nowMs = nowMs;
+    s.capacityBytes = capacity;
+    s.bufferedBytes = buffered;
+    s.bytesPerSecond = 192000;
+    return s;
+}
+
+TEST(RingResizePolicyTest, GrowsOnUnderrunOnceAnInterval)
+{
+    RingResizePolicy policy;
+    policy.Reset(64000, 1000000, 4096, 0);
+    RingResizePolicy::Sample s = PolicySample(500, 100000, 0);
+    s.underruns = 1;
+    EXPECT_EQ(policy.Update(s).reason, RingResizePolicy::Reason::None);
+
+    s.nowMs = 1000;
+    const RingResizePolicy::Decision d = policy.Update(s);
+    EXPECT_EQ(d.reason, RingResizePolicy::Reason::Underrun);
+    EXPECT_EQ(d.newBytes, 151552u);  // 1.5x rounded up to 4 KB
+    policy.Applied(1000);
+
+    // The same underrun count is not a new underrun; the top is the maximum.
+    s.nowMs = 2000;
+    s.capacityBytes = d.newBytes;
+    EXPECT_EQ(policy.Update(s).reason, RingResizePolicy::Reason::None);
+    s.nowMs = 3000;
+    s.capacityBytes = 900000;
+    s.underruns = 2;
+    EXPECT_EQ(policy.Update(s).newBytes, 1000000u);
+    s.nowMs = 4000;
+    s.capacityBytes = 1000000;
+    s.underruns = 3;
+    EXPECT_EQ(policy.Update(s).reason, RingResizePolicy::Reason::None);
+}
+
+TEST(RingResizePolicyTest, GrowsToCoverSlowReads)
+{
+    RingResizePolicy policy;
+    policy.Reset(64000, 4000000, 4, 0);
+    // A 0.5 s read at 192 KB/s needs 4 x 96000 bytes.
+    RingResizePolicy::Sample s = PolicySample(200, 100000, 50000);
+    s.readLatencyUs = 500000;
+    policy.Update(s);
+    s.nowMs = 1000;
+    s.readLatencyUs = 0;
+    const RingResizePolicy::Decision d = policy.Update(s);
+    EXPECT_EQ(d.reason, RingResizePolicy::Reason::Latency);
+    EXPECT_EQ(d.newBytes, 384000u);
+    policy.Applied(1000);
+
+    // The peak decays by 1/8 per interval, so a big enough ring stays put.
+    s.nowMs = 2000;
+    s.capacityBytes = 384000;
+    EXPECT_EQ(policy.Update(s).reason, RingResizePolicy::Reason::None);
+}
+
+TEST(RingResizePolicyTest, ShrinksAfterStableFullPeriod)
+{
+    RingResizePolicy policy;
+    policy.Reset(64000, 1000000, 1, 0);
+    const size_t cap = 400000;
+    uint64_t now = 0;
+    RingResizePolicy::Decision d;
+    // Near full the whole time, but one dip below 90 % in a window holds it off.
+    for (; now < RingResizePolicy::kShrinkStableMs; now += 250) {
+        d = policy.Update(PolicySample(now, cap, now == 9500 ? cap / 2 : cap));
+        ASSERT_EQ(d.reason, RingResizePolicy::Reason::None) << now;
+    }
+    d = policy.Update(PolicySample(now, cap, cap));
+    EXPECT_EQ(d.reason, RingResizePolicy::Reason::None);  // the window with the dip
+    for (now += 250; d.reason == RingResizePolicy::Reason::None && now < 20000; now += 250) {
+        d = policy.Update(PolicySample(now, cap, cap));
+    }
+    EXPECT_EQ(d.reason, RingResizePolicy::Reason::Idle);
+    EXPECT_EQ(now - 250, 11000u);
+    EXPECT_EQ(d.newBytes, 300000u);
+    policy.Applied(now);
+
+    // The stable period starts over after a change, and the minimum holds.
+    EXPECT_EQ(policy.Update(PolicySample(now + 1000, 300000, 300000)).reason, RingResizePolicy::Reason::None);
+    EXPECT_EQ(policy.Update(PolicySample(now + 10000, 300000, 300000)).newBytes, 225000u);
+    policy.Applied(now + 10000);
+    EXPECT_EQ(policy.Update(PolicySample(now + 20000, 70000, 70000)).newBytes, 64000u);
+    EXPECT_EQ(policy.Update(PolicySample(now + 40000, 64000, 64000)).reason, RingResizePolicy::Reason::None);
+    EXPECT_STREQ(RingResizePolicy::ReasonName(RingResizePolicy::Reason::Idle), "idle");
+}
+
+} // namespace
@@ -0,0 +1,392 @@
+// PcmRingBuffer::SeekWithinBuffer: the accepted window, the position after a
+// seek, the data served from the new read cursor, the history of played PCM
+// kept for backward seeks, and a seeker racing the producer and the consumer. The stream is 1 kHz mono 32-bit with every frame
+// holding its own index, so one millisecond is one frame and each read tells
+// where it was served from. Run in the FREE_PCM_SANITIZE builds as well.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/ring_buffer.h"
+#include "test_util.h"
+
+namespace {
+
+using audio::PcmRingBuffer;
+
+constexpr int kRate = 1000;
+constexpr size_t kFrame = sizeof(uint32_t);
+
+PcmRingBuffer MakeRing(size_t frames, size_t historyFrames = 0)
+{
+    return PcmRingBuffer(frames * kFrame, kRate, 1, kFrame, historyFrames * kFrame);
+}
+
+void PushFrames(PcmRingBuffer& ring, uint32_t from, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = from + i;
+    }
+    ASSERT_TRUE(ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), count * kFrame, nullptr));
+}
+
+// Index of the first frame of a read of count frames, which must be
+// contiguous; -1 for a short or torn read.
+int64_t ReadFrames(PcmRingBuffer& ring, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    if (ring.Read(reinterpret_cast<uint8_t*>(frames.data()), count * kFrame) != count * kFrame) {
+        return -1;
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        if (frames[i] != frames[0] + i) {
+            return -1;
+        }
+    }
+    return frames[0];
+}
+
+// Without history the window is [read cursor, buffered end].
+TEST(RingSeekTest, WindowIsReadCursorToBufferedEnd)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    PushFrames(ring, 0, 600);
+    ASSERT_EQ(ReadFrames(ring, 100), 0);
+    EXPECT_EQ(ring.GetPositionMs(), 100u);
+
+    EXPECT_FALSE(ring.SeekWithinBuffer(99));
+    EXPECT_FALSE(ring.SeekWithinBuffer(601));
+    EXPECT_EQ(ring.GetPositionMs(), 100u);
+    EXPECT_EQ(ring.Available(), 500 * kFrame);
+
+    EXPECT_TRUE(ring.SeekWithinBuffer(100));
+    EXPECT_TRUE(ring.SeekWithinBuffer(350));
+    EXPECT_EQ(ring.GetPositionMs(), 350u);
+    EXPECT_EQ(ring.GetBytesRead(), 350 * kFrame);
+    EXPECT_EQ(ring.Available(), 250 * kFrame);
+    EXPECT_EQ(ReadFrames(ring, 50), 350);
+    EXPECT_FALSE(ring.SeekWithinBuffer(399));
+
+    // The buffered end is a valid target; EOS stays marked.
+    ring.MarkEos();
+    EXPECT_TRUE(ring.SeekWithinBuffer(600));
+    EXPECT_EQ(ring.Available(), 0u);
+    EXPECT_TRUE(ring.IsEos());
+    EXPECT_EQ(ring.GetPositionMs(), 600u);
+
+    // Appending after a seek continues the stream.
+    ring.ResetEos();
+    PushFrames(ring, 600, 10);
+    EXPECT_EQ(ReadFrames(ring, 10), 600);
+}
+
+// Targets are timeline positions, so they follow SetPositionMs/ResetCounters.
+TEST(RingSeekTest, TargetsFollowTheTimeline)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    ring.SetPositionMs(60000);
+    PushFrames(ring, 0, 500);
+    EXPECT_FALSE(ring.SeekWithinBuffer(300));
+    EXPECT_TRUE(ring.SeekWithinBuffer(60300));
+    EXPECT_EQ(ring.GetPositionMs(), 60300u);
+    EXPECT_EQ(ReadFrames(ring, 10), 300);
+
+    ring.ResetCounters();
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+    EXPECT_FALSE(ring.SeekWithinBuffer(60400));
+    EXPECT_TRUE(ring.SeekWithinBuffer(100));
+    EXPECT_EQ(ReadFrames(ring, 10), 410);
+
+    // Without a format there is no timeline to seek on.
+    PcmRingBuffer raw(4000, 0, 1, kFrame);
+    EXPECT_FALSE(raw.SeekWithinBuffer(0));
+}
+
+// A seek stays inside the segment being played: its end is the limit, and once
+// the next segment plays, targets are positions in it.
+TEST(RingSeekTest, StopsAtPendingSegment)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    PushFrames(ring, 0, 300);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 300, 300);
+    ASSERT_EQ(ReadFrames(ring, 100), 0);
+
+    EXPECT_TRUE(ring.SeekWithinBuffer(250));
+    EXPECT_FALSE(ring.SeekWithinBuffer(301));
+    EXPECT_EQ(ring.GetSegmentCount(), 0u);
+    EXPECT_TRUE(ring.SeekWithinBuffer(300));
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+
+    EXPECT_TRUE(ring.SeekWithinBuffer(100));
+    EXPECT_EQ(ring.GetPositionMs(), 100u);
+    EXPECT_EQ(ReadFrames(ring, 10), 400);
+    EXPECT_FALSE(ring.SeekWithinBuffer(301));
+}
+
+// A producer, a consumer and a seeker jumping ahead of the read cursor. Every
+// read is a contiguous run of frames that starts where the previous one ended
+// or at a target the seeker tried; nothing stale or overwritten comes through.
+TEST(RingSeekTest, SeekRacingReadAndWrite)
+{
+    const uint32_t total = 2000000;
+    PcmRingBuffer ring = MakeRing(4096);
+    std::atomic<bool> cancel(false);
+    std::atomic<bool> producerDone(false);
+    std::vector<std::atomic<bool>> tried(total + 1);
+    std::atomic<uint64_t> seeks(0);
+
+    std::thread producer([&]() {
+        std::mt19937 rng = test::Rng(1);
+        std::vector<uint32_t> frames(512);
+        for (uint32_t at = 0; at < total;) {
+            const uint32_t n = std::min<uint32_t>(1 + rng() % 512, total - at);
+            for (uint32_t i = 0; i < n; i++) {
+                frames[i] = at + i;
+            }
+            if (!ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), n * kFrame, &cancel)) {
+                break;
+            }
+            at += n;
+        }
+        ring.MarkEos();
+        producerDone.store(true);
+    });
+
+    std::thread seeker([&]() {
+        std::mt19937 rng = test::Rng(2);
+        while (!producerDone.load() && !cancel.load()) {
+            // Some targets lie past the buffered end and must be refused.
+            const uint64_t target = ring.GetPositionMs() + rng() % 2000;
+            if (target <= total) {
+                tried[target].store(true, std::memory_order_release);
+            }
+            if (ring.SeekWithinBuffer(target)) {
+                seeks.fetch_add(1);
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 rng = test::Rng(3);
+    std::vector<uint32_t> frames(512);
+    uint64_t cursor = 0;
+    while (!ring.IsEos() && !cancel.load()) {
+        const size_t n = ring.Read(reinterpret_cast<uint8_t*>(frames.data()), (1 + rng() % 512) * kFrame);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint32_t first = frames[0];
+        bool ok = n % kFrame == 0 &&
+                  (first == cursor || (first > cursor && tried[first].load(std::memory_order_acquire)));
+        for (size_t i = 1; ok && i < n / kFrame; i++) {
+            ok = frames[i] == first + i;
+        }
+        if (!ok) {
+            ADD_FAILURE() << "read of " << n << " bytes starting at frame " << first << " after frame " << cursor;
+            cancel.store(true);
+            ring.Cancel();
+            break;
+        }
+        cursor = first + n / kFrame;
+    }
+    producer.join();
+    seeker.join();
+    // A last seek may have jumped straight to the end.
+    EXPECT_LE(cursor, total);
+    EXPECT_EQ(ring.GetBytesRead(), total * kFrame);
+    EXPECT_GT(seeks.load(), 0u);
+}
+
+// The history reaches historyBytes back from the highest read cursor, not from
+// wherever a backward seek left it.
+TEST(RingSeekTest, HistoryBounds)
+{
+    PcmRingBuffer ring = MakeRing(1000, 200);
+    PushFrames(ring, 0, 600);
+    ASSERT_EQ(ReadFrames(ring, 100), 0);
+    PcmRingBuffer::MemoryStats stats = ring.GetMemoryStats();
+    EXPECT_EQ(stats.capacityBytes, 1000 * kFrame);
+    EXPECT_EQ(stats.historyCapacityBytes, 200 * kFrame);
+    EXPECT_EQ(stats.allocatedBytes, 1200 * kFrame);
+    EXPECT_EQ(stats.bufferedBytes, 500 * kFrame);
+    EXPECT_EQ(stats.historyBytes, 100 * kFrame);
+    EXPECT_TRUE(ring.SeekWithinBuffer(0));
+    EXPECT_EQ(ReadFrames(ring, 10), 0);
+
+    ASSERT_EQ(ReadFrames(ring, 490), 10);
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 200 * kFrame);
+    EXPECT_FALSE(ring.SeekWithinBuffer(299));
+    EXPECT_TRUE(ring.SeekWithinBuffer(300));
+    EXPECT_EQ(ring.GetPositionMs(), 300u);
+    EXPECT_EQ(ring.Available(), 300 * kFrame);
+    EXPECT_EQ(ReadFrames(ring, 10), 300);
+    EXPECT_FALSE(ring.SeekWithinBuffer(299));
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 10 * kFrame);
+
+    // Forward again, past the old high mark.
+    EXPECT_TRUE(ring.SeekWithinBuffer(550));
+    EXPECT_EQ(ReadFrames(ring, 10), 550);
+    EXPECT_FALSE(ring.SeekWithinBuffer(359));
+    EXPECT_TRUE(ring.SeekWithinBuffer(360));
+    EXPECT_EQ(ReadFrames(ring, 240), 360);
+}
+
+// Clear(), SetPositionMs() and ResetCounters() start a new timeline: nothing
+// played before them is reachable. Passing a segment start raises the floor
+// to it.
+TEST(RingSeekTest, HistoryFloorAfterRebase)
+{
+    PcmRingBuffer ring = MakeRing(1000, 500);
+    PushFrames(ring, 0, 400);
+    ASSERT_EQ(ReadFrames(ring, 100), 0);
+    ring.Clear();
+    EXPECT_EQ(ring.GetPositionMs(), 100u);
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 0u);
+    EXPECT_FALSE(ring.SeekWithinBuffer(50));
+    PushFrames(ring, 400, 100);
+    ASSERT_EQ(ReadFrames(ring, 50), 400);
+    EXPECT_FALSE(ring.SeekWithinBuffer(99));
+    EXPECT_TRUE(ring.SeekWithinBuffer(100));
+    EXPECT_EQ(ReadFrames(ring, 100), 400);
+
+    ring.SetPositionMs(10000);
+    PushFrames(ring, 500, 100);
+    ASSERT_EQ(ReadFrames(ring, 50), 500);
+    EXPECT_FALSE(ring.SeekWithinBuffer(9999));
+    EXPECT_TRUE(ring.SeekWithinBuffer(10000));
+    EXPECT_EQ(ReadFrames(ring, 100), 500);
+
+    ring.ResetCounters();
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 0u);
+
+    // The previous segment is still in storage but no longer reachable.
+    PushFrames(ring, 600, 100);
+    ASSERT_EQ(ReadFrames(ring, 50), 600);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 700, 100);
+    ASSERT_EQ(ReadFrames(ring, 60), 650);
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.GetPositionMs(), 10u);
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 10 * kFrame);
+    EXPECT_TRUE(ring.SeekWithinBuffer(0));
+    EXPECT_EQ(ring.GetMemoryStats().historyBytes, 0u);
+    EXPECT_EQ(ReadFrames(ring, 10), 700);
+}
+
+// After a backward seek the producer is held to capacity unread bytes counted
+// from the new read cursor, so the bytes sought back to are not rewritten.
+TEST(RingSeekTest, ProducerLimitAfterBackwardSeek)
+{
+    PcmRingBuffer ring = MakeRing(100, 50);
+    PushFrames(ring, 0, 100);
+    ASSERT_EQ(ReadFrames(ring, 100), 0);
+    PushFrames(ring, 100, 100);
+    ASSERT_TRUE(ring.SeekWithinBuffer(50));
+    EXPECT_EQ(ring.Available(), 150 * kFrame);
+
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        PushFrames(ring, 200, 1);
+        pushed.store(true);
+    });
+    ASSERT_EQ(ReadFrames(ring, 50), 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+    ASSERT_EQ(ReadFrames(ring, 1), 100);
+    producer.join();
+    EXPECT_EQ(ReadFrames(ring, 100), 101);
+
+    // The full history is still there.
+    EXPECT_TRUE(ring.SeekWithinBuffer(151));
+    EXPECT_EQ(ReadFrames(ring, 50), 151);
+    EXPECT_FALSE(ring.SeekWithinBuffer(150));
+}
+
+// Like SeekRacingReadAndWrite, with seeks back into the history as well. A read
+// of bytes the producer already rewrote breaks the frame sequence.
+TEST(RingSeekTest, HistorySeekRacingReadAndWrite)
+{
+    const uint32_t total = 2000000;
+    const uint32_t history = 1024;
+    PcmRingBuffer ring = MakeRing(4096, history);
+    std::atomic<bool> cancel(false);
+    std::atomic<bool> producerDone(false);
+    std::vector<std::atomic<bool>> tried(total + 1);
+    std::atomic<uint64_t> backward(0);
+
+    std::thread producer([&]() {
+        std::mt19937 rng = test::Rng(4);
+        std::vector<uint32_t> frames(512);
+        for (uint32_t at = 0; at < total;) {
+            const uint32_t n = std::min<uint32_t>(1 + rng() % 512, total - at);
+            for (uint32_t i = 0; i < n; i++) {
+                frames[i] = at + i;
+            }
+            if (!ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), n * kFrame, &cancel)) {
+                break;
+            }
+            at += n;
+        }
+        ring.MarkEos();
+        producerDone.store(true);
+    });
+
+    std::thread seeker([&]() {
+        std::mt19937 rng = test::Rng(5);
+        while (!producerDone.load() && !cancel.load()) {
+            // Targets on both sides of the window.
+            const uint64_t pos = ring.GetPositionMs();
+            const uint64_t back = rng() % (2 * history);
+            const uint64_t target = (rng() & 1) ? pos + rng() % 2000 : pos - std::min(pos, back);
+            if (target <= total) {
+                tried[target].store(true, std::memory_order_release);
+            }
+            if (ring.SeekWithinBuffer(target) && target < pos) {
+                backward.fetch_add(1);
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 rng = test::Rng(6);
+    std::vector<uint32_t> frames(512);
+    uint64_t cursor = 0;
+    while (!ring.IsEos() && !cancel.load()) {
+        const size_t n = ring.Read(reinterpret_cast<uint8_t*>(frames.data()), (1 + rng() % 512) * kFrame);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint32_t first = frames[0];
+        bool ok = n % kFrame == 0 && (first == cursor || tried[first].load(std::memory_order_acquire));
+        for (size_t i = 1; ok && i < n / kFrame; i++) {
+            ok = frames[i] == first + i;
+        }
+        if (!ok) {
+            ADD_FAILURE() << "read of " << n << " bytes starting at frame " << first << " after frame " << cursor;
+            cancel.store(true);
+            ring.Cancel();
+            break;
+        }
+        cursor = first + n / kFrame;
+    }
+    producer.join();
+    seeker.join();
+    EXPECT_LE(cursor, total);
+    EXPECT_EQ(ring.GetBytesRead(), total * kFrame);
+    EXPECT_GT(backward.load(), 0u);
+}
+
+} // namespace
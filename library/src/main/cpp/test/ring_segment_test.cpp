@@ -0,0 +1,261 @@
+// PcmRingBuffer segments (MarkSegmentStart): the position restarts at 0 and the
+// segment count steps when the read cursor passes a start; Clear keeps the
+// position or lands on the last start it crosses; SetPositionMs/ResetCounters
+// drop pending starts; ClearPendingSegments withdraws them uncounted; and tracks spliced by a producer racing a reader and a
+// position poller always report the track and offset of the last frame read.
+// The stream is 1 kHz mono 32-bit, so one millisecond is one frame. Run in the
+// FREE_PCM_SANITIZE builds as well.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/ring_buffer.h"
+#include "test_util.h"
+
+namespace {
+
+using audio::PcmRingBuffer;
+
+constexpr int kRate = 1000;
+constexpr size_t kFrame = sizeof(uint32_t);
+
+PcmRingBuffer MakeRing(size_t frames)
+{
+    return PcmRingBuffer(frames * kFrame, kRate, 1, kFrame);
+}
+
+void PushFrames(PcmRingBuffer& ring, uint32_t from, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = from + i;
+    }
+    ASSERT_TRUE(ring.Push(reinterpret_cast<const uint8_t*>(frames.data()), count * kFrame, nullptr));
+}
+
+size_t ReadCount(PcmRingBuffer& ring, uint32_t count)
+{
+    std::vector<uint32_t> frames(count);
+    return ring.Read(reinterpret_cast<uint8_t*>(frames.data()), count * kFrame) / kFrame;
+}
+
+// Tracks of 300, 200 and 100 frames read in random chunks that cross the starts.
+TEST(RingSegmentTest, PositionRestartsAtEachSegment)
+{
+    std::mt19937 rng = test::Rng(1);
+    const uint64_t starts[] = {0, 300, 500};
+    for (int round = 0; round < 20; round++) {
+        PcmRingBuffer ring = MakeRing(1000);
+        PushFrames(ring, 0, 300);
+        ring.MarkSegmentStart();
+        PushFrames(ring, 300, 200);
+        ring.MarkSegmentStart();
+        PushFrames(ring, 500, 100);
+        EXPECT_TRUE(ring.HasPendingSegment());
+        EXPECT_EQ(ring.GetSegmentCount(), 0u);
+
+        uint64_t cursor = 0;
+        while (cursor < 600) {
+            const uint32_t n = std::min<uint32_t>(1 + rng() % 250, static_cast<uint32_t>(600 - cursor));
+            ASSERT_EQ(ReadCount(ring, n), n);
+            cursor += n;
+            const uint64_t passed = cursor >= 500 ? 2 : cursor >= 300 ? 1 : 0;
+            ASSERT_EQ(ring.GetSegmentCount(), passed) << cursor;
+            ASSERT_EQ(ring.GetPositionMs(), cursor - starts[passed]) << cursor;
+            ASSERT_EQ(ring.HasPendingSegment(), cursor < 500) << cursor;
+        }
+    }
+}
+
+TEST(RingSegmentTest, ClearKeepsPositionOrLandsOnLastStart)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    PushFrames(ring, 0, 200);
+    ASSERT_EQ(ReadCount(ring, 50), 50u);
+    ring.Clear();
+    EXPECT_EQ(ring.GetPositionMs(), 50u);
+    EXPECT_EQ(ring.GetSegmentCount(), 0u);
+
+    // Two starts inside the dropped data: the position is 0 at the second.
+    PushFrames(ring, 200, 100);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 300, 100);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 400, 100);
+    ring.Clear();
+    EXPECT_EQ(ring.GetSegmentCount(), 2u);
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+    EXPECT_FALSE(ring.HasPendingSegment());
+    PushFrames(ring, 500, 100);
+    ASSERT_EQ(ReadCount(ring, 30), 30u);
+    EXPECT_EQ(ring.GetPositionMs(), 30u);
+
+    // A start right at the write cursor is crossed by a clear as well.
+    ring.MarkSegmentStart();
+    PushFrames(ring, 600, 10);
+    ring.Clear();
+    EXPECT_EQ(ring.GetSegmentCount(), 3u);
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+}
+
+// Rebasing the timeline drops the pending starts; they still count as passed.
+TEST(RingSegmentTest, RebaseDropsPendingStarts)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    PushFrames(ring, 0, 100);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 100, 100);
+    ASSERT_EQ(ReadCount(ring, 40), 40u);
+    ring.SetPositionMs(5000);
+    EXPECT_FALSE(ring.HasPendingSegment());
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.GetPositionMs(), 5000u);
+    ASSERT_EQ(ReadCount(ring, 100), 100u);
+    EXPECT_EQ(ring.GetPositionMs(), 5100u);
+
+    ring.MarkSegmentStart();
+    PushFrames(ring, 200, 100);
+    ring.ResetCounters();
+    EXPECT_FALSE(ring.HasPendingSegment());
+    EXPECT_EQ(ring.GetSegmentCount(), 2u);
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+    ASSERT_EQ(ReadCount(ring, 60), 60u);
+    EXPECT_EQ(ring.GetPositionMs(), 60u);
+}
+
+// Withdrawn starts are never counted; a start the reader reached but did not
+// fold yet stays and is crossed as by Clear.
+TEST(RingSegmentTest, ClearPendingSegmentsWithdrawsUnreachedStarts)
+{
+    PcmRingBuffer ring = MakeRing(1000);
+    PushFrames(ring, 0, 100);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 100, 100);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 200, 100);
+    ASSERT_EQ(ReadCount(ring, 70), 70u);
+    EXPECT_EQ(ring.ClearPendingSegments(), 2u);
+    EXPECT_FALSE(ring.HasPendingSegment());
+    EXPECT_EQ(ring.GetSegmentCount(), 0u);
+    EXPECT_EQ(ring.GetPositionMs(), 70u);
+    PushFrames(ring, 300, 100);
+    ASSERT_EQ(ReadCount(ring, 100), 100u);
+    EXPECT_EQ(ring.GetSegmentCount(), 0u);
+    EXPECT_EQ(ring.GetPositionMs(), 170u);
+    EXPECT_EQ(ring.ClearPendingSegments(), 0u);
+
+    // The reader stops right on a start: that one is reached, the next is not.
+    ring.MarkSegmentStart();
+    PushFrames(ring, 400, 50);
+    ring.MarkSegmentStart();
+    PushFrames(ring, 450, 50);
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.ClearPendingSegments(), 1u);
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.GetPositionMs(), 0u);
+    PushFrames(ring, 500, 20);
+    ASSERT_EQ(ReadCount(ring, 20), 20u);
+    EXPECT_EQ(ring.GetSegmentCount(), 1u);
+    EXPECT_EQ(ring.GetPositionMs(), 20u);
+}
+
+// The producer splices tracks of random length (frame = track << 20 | index)
+// through a ring smaller than most of them. After every read the reader's
+// segment count and position name the track and offset just past its last
+// frame; a poller on a third thread only ever sees the count grow.
+TEST(RingSegmentTest, SplicingRacingReaderAndPoller)
+{
+    std::mt19937 rng = test::Rng(2);
+    constexpr uint32_t kTracks = 40;
+    std::vector<uint32_t> lengths(kTracks);
+    uint64_t total = 0;
+    for (uint32_t& len : lengths) {
+        len = 1 + rng() % 3000;
+        total += len;
+    }
+    PcmRingBuffer ring = MakeRing(1000);
+
+    std::thread producer([&ring, &lengths]() {
+        std::mt19937 chunks = test::Rng(3);
+        for (uint32_t t = 0; t < kTracks; t++) {
+            if (t > 0) {
+                ring.MarkSegmentStart();
+            }
+            for (uint32_t i = 0; i < lengths[t];) {
+                const uint32_t n = std::min<uint32_t>(1 + chunks() % 400, lengths[t] - i);
+                PushFrames(ring, (t << 20) | i, n);
+                i += n;
+            }
+        }
+    });
+    std::atomic<bool> done(false);
+    std::thread poller([&]() {
+        uint64_t lastCount = 0;
+        const uint32_t longest = *std::max_element(lengths.begin(), lengths.end());
+        while (!done.load()) {
+            const uint64_t count = ring.GetSegmentCount();
+            EXPECT_GE(count, lastCount);
+            EXPECT_LT(count, kTracks);
+            EXPECT_LE(ring.GetPositionMs(), longest);
+            lastCount = count;
+            std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 reads = test::Rng(4);
+    std::vector<uint32_t> frames(500);
+    uint32_t track = 0;
+    uint32_t next = 0;  // index in track of the next frame
+    uint64_t read = 0;
+    int failures = 0;
+    while (read < total && failures < 10) {
+        const size_t n = ring.Read(reinterpret_cast<uint8_t*>(frames.data()), (1 + reads() % 500) * kFrame) / kFrame;
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t k = 0; k < n; k++) {
+            if (next == lengths[track]) {
+                track++;
+                next = 0;
+            }
+            if (frames[k] != ((track << 20) | next)) {
+                ADD_FAILURE() << "frame " << std::hex << frames[k] << " where " << ((track << 20) | next)
+                              << " belongs";
+                failures++;
+                break;
+            }
+            next++;
+        }
+        read += n;
+        // At a track end the next start may or may not be marked yet.
+        const uint64_t count = ring.GetSegmentCount();
+        const uint64_t position = ring.GetPositionMs();
+        if (next < lengths[track]) {
+            EXPECT_EQ(count, track);
+            EXPECT_EQ(position, next);
+        } else {
+            EXPECT_TRUE((count == track && (position == next || position == 0)) ||
+                        (count == track + 1 && position == 0))
+                << "count " << count << " position " << position << " at end of track " << track;
+        }
+    }
+    if (read < total) {
+        ring.Cancel();  // releases a producer blocked on the full ring
+    }
+    producer.join();
+    done.store(true);
+    poller.join();
+    EXPECT_EQ(read, total);
+    EXPECT_EQ(ring.GetSegmentCount(), kTracks - 1);
+    EXPECT_EQ(ring.GetPositionMs(), lengths.back());
+    EXPECT_FALSE(ring.HasPendingSegment());
+}
+
+} // namespace
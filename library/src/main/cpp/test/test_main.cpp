@@ -0,0 +1,57 @@
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <stdlib.h>
+
+namespace test {
+
+namespace {
+
+uint32_t g_seed = 0;
+
+uint32_t SeedFromEnv()
+{
+    const char* env = std::getenv("FREE_PCM_TEST_SEED");
+    if (env != nullptr && *env != '\0') {
+        return static_cast<uint32_t>(std::strtoul(env, nullptr, 0));
+    }
+    return std::random_device{}();
+}
+
+} // namespace
+
+uint32_t Seed()
+{
+    return g_seed;
+}
+
+TempDir::TempDir()
+{
+    const char* base = std::getenv("TMPDIR");
+    std::string tmpl = std::string((base != nullptr && *base != '\0') ? base : "/tmp") + "/free_pcm_test.XXXXXX";
+    if (mkdtemp(&tmpl[0]) == nullptr) {
+        throw std::runtime_error("mkdtemp failed: " + tmpl);
+    }
+    path_ = tmpl;
+}
+
+TempDir::~TempDir()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+}
+
+} // namespace test
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    test::g_seed = test::SeedFromEnv();
+    std::printf("FREE_PCM_TEST_SEED=%u\n", test::g_seed);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,39 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace test {
+
+// Seed of this run's randomized cases: FREE_PCM_TEST_SEED if set, otherwise
+// random. test_main prints it so a failing run can be replayed.
+uint32_t Seed();
+
+// Per-test generator: the run seed mixed with a test-specific salt, so cases
+// stay independent of which other tests ran first.
+inline std::mt19937 Rng(uint32_t salt)
+{
+    std::seed_seq seq{Seed(), salt};
+    return std::mt19937(seq);
+}
+
+// A fresh directory under $TMPDIR (or /tmp), removed with its contents.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::string& Path() const { return path_; }
+    std::string File(const std::string& name) const { return path_ + "/" + name; }
+
+private:
+    std::string path_;
+};
+
+} // namespace test
+
+#endif
@@ -0,0 +1,159 @@
+// TruePeakLimiter golden checks: delayed bit-exact passthrough under the
+// ceiling, the settled gain reduction on a tone whose true peak lies between
+// samples, and block-split invariance.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "test_util.h"
+#include "true_peak_limiter.h"
+
+namespace {
+
+constexpr float kLookaheadMs = 5.0f;
+constexpr size_t kDetectorDelay = 3;
+
+void InitLimiter(TruePeakLimiter& limiter, int32_t rate, int32_t channels, float ceilingDbtp)
+{
+    limiter.Init(rate, channels);
+    limiter.SetParams(ceilingDbtp, kLookaheadMs, 1.0f, 80.0f);
+    limiter.SetEnabled(true);
+}
+
+std::vector<float> Noise(std::mt19937& rng, size_t samples, float amplitude)
+{
+    std::uniform_real_distribution<float> amp(-amplitude, amplitude);
+    std::vector<float> out(samples);
+    for (float& v : out) {
+        v = amp(rng);
+    }
+    return out;
+}
+
+// ProcessFloat in random block sizes around the limiter's 256-frame tile.
+void ProcessInBlocks(TruePeakLimiter& limiter, std::vector<float>& samples, size_t channels, std::mt19937& rng)
+{
+    std::uniform_int_distribution<size_t> block(0, 700);
+    const size_t frames = samples.size() / channels;
+    for (size_t at = 0; at < frames;) {
+        const size_t n = std::min(block(rng), frames - at);
+        limiter.ProcessFloat(samples.data() + at * channels, n);
+        at += n;
+    }
+}
+
+TEST(TruePeakLimiterTest, LatencyIsLookaheadPlusDetectorDelay)
+{
+    TruePeakLimiter limiter;
+    EXPECT_EQ(limiter.LatencyFrames(), 0u);
+    for (int32_t rate : {44100, 48000, 96000}) {
+        InitLimiter(limiter, rate, 2, -1.0f);
+        const size_t lookahead = static_cast<size_t>(std::lround(kLookaheadMs / 1000.0f * static_cast<float>(rate)));
+        EXPECT_EQ(limiter.LatencyFrames(), lookahead + kDetectorDelay) << "rate " << rate;
+    }
+}
+
+class TruePeakLimiterLayoutTest : public ::testing::TestWithParam<std::tuple<int32_t, int32_t>> {};
+
+// Under the ceiling the gain stays exactly 1: the output is the input delayed
+// by LatencyFrames(), bit for bit, with silence in front.
+TEST_P(TruePeakLimiterLayoutTest, BelowCeilingIsDelayedPassthrough)
+{
+    const int32_t rate = std::get<0>(GetParam());
+    const int32_t channels = std::get<1>(GetParam());
+    const size_t chs = static_cast<size_t>(channels);
+    std::mt19937 rng = test::Rng(static_cast<uint32_t>(rate + channels));
+
+    TruePeakLimiter limiter;
+    InitLimiter(limiter, rate, channels, -1.0f);
+    // +/-0.4 keeps even the interpolated peaks well under -1 dBTP (0.89).
+    const std::vector<float> in = Noise(rng, static_cast<size_t>(rate / 2) * chs, 0.4f);
+    std::vector<float> out = in;
+    ProcessInBlocks(limiter, out, chs, rng);
+
+    const size_t delay = limiter.LatencyFrames() * chs;
+    ASSERT_GT(delay, 0u);
+    for (size_t i = 0; i < out.size(); i++) {
+        const float expected = (i < delay) ? 0.0f : in[i - delay];
+        if (std::memcmp(&out[i], &expected, sizeof(float)) != 0) {
+            FAIL() << "sample " << i << ": " << out[i] << " != " << expected;
+        }
+    }
+    EXPECT_EQ(limiter.GetLastGrDb(), 0.0f);
+}
+
+// State carries across calls exactly: any block split of an over-ceiling
+// signal gives the same bits as one call.
+TEST_P(TruePeakLimiterLayoutTest, BlockSplitIsBitExact)
+{
+    const int32_t rate = std::get<0>(GetParam());
+    const int32_t channels = std::get<1>(GetParam());
+    const size_t chs = static_cast<size_t>(channels);
+    std::mt19937 rng = test::Rng(static_cast<uint32_t>(rate * 16 + channels));
+
+    // Loud bursts over quiet passages, so attack and release both run.
+    std::vector<float> in = Noise(rng, static_cast<size_t>(rate / 2) * chs, 0.3f);
+    for (size_t f = 0; f < in.size() / chs; f++) {
+        if ((f / 2000) % 3 == 1) {
+            for (size_t c = 0; c < chs; c++) {
+                in[f * chs + c] *= 5.0f;
+            }
+        }
+    }
+
+    TruePeakLimiter whole;
+    TruePeakLimiter split;
+    InitLimiter(whole, rate, channels, -1.0f);
+    InitLimiter(split, rate, channels, -1.0f);
+    std::vector<float> a = in;
+    whole.ProcessFloat(a.data(), a.size() / chs);
+    std::vector<float> b = in;
+    ProcessInBlocks(split, b, chs, rng);
+
+    EXPECT_EQ(std::memcmp(a.data(), b.data(), a.size() * sizeof(float)), 0);
+    EXPECT_EQ(whole.GetLastGrDb(), split.GetLastGrDb());
+    EXPECT_GT(whole.GetLastGrDb(), 0.0f);
+}
+
+INSTANTIATE_TEST_SUITE_P(RatesAndLayouts, TruePeakLimiterLayoutTest,
+                         ::testing::Combine(::testing::Values(44100, 48000, 96000), ::testing::Values(1, 2, 6)));
+
+// A full-scale fs/4 sine at 45 degrees has samples at +/-0.707 and its true
+// peak (1.0) halfway between them, where the 4x detector's phase 2 lands. With
+// a -6 dBTP ceiling the limiter settles at 6 dB of gain reduction plus the
+// interpolator's small overshoot on this tone: 6.09 dB.
+TEST(TruePeakLimiterTest, QuarterRateSineSettlesAtTruePeakGainReduction)
+{
+    const int32_t rate = 48000;
+    const size_t chs = 2;
+    TruePeakLimiter limiter;
+    InitLimiter(limiter, rate, static_cast<int32_t>(chs), -6.0f);
+
+    const double kPi = 3.14159265358979323846;
+    const size_t frames = static_cast<size_t>(rate);
+    std::vector<float> in(frames * chs);
+    for (size_t f = 0; f < frames; f++) {
+        const float x = static_cast<float>(std::sin(kPi / 2.0 * static_cast<double>(f) + kPi / 4.0));
+        for (size_t c = 0; c < chs; c++) {
+            in[f * chs + c] = x;
+        }
+    }
+    std::vector<float> out = in;
+    limiter.ProcessFloat(out.data(), frames);
+
+    EXPECT_NEAR(limiter.GetLastGrDb(), 6.09f, 0.01f);
+    // Settled output: the sample peak is the true peak scaled by the gain.
+    const float gain = std::pow(10.0f, -limiter.GetLastGrDb() / 20.0f);
+    for (size_t i = (frames - 1000) * chs; i < out.size(); i++) {
+        EXPECT_NEAR(std::fabs(out[i]), 0.70710678f * gain, 1e-5f) << "sample " << i;
+    }
+}
+
+} // namespace
@@ -0,0 +1,273 @@
+// WavFileWriter: header layout for every supported format, sizes that match the
+// file on disk after every block (a copy taken mid-decode is a valid WAV), and
+// the switch to RF64 past 4 GB.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "test_util.h"
+#include "wav_file_writer.h"
+
+namespace {
+
+std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+uint16_t Get16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t Get32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(Get16(p)) | (static_cast<uint32_t>(Get16(p + 2)) << 16);
+}
+
+uint64_t Get64(const uint8_t* p)
+{
+    return static_cast<uint64_t>(Get32(p)) | (static_cast<uint64_t>(Get32(p + 4)) << 32);
+}
+
+bool IsId(const uint8_t* p, const char* id)
+{
+    return std::memcmp(p, id, 4) == 0;
+}
+
+struct Chunk {
+    std::string id;
+    size_t offset;  // of the chunk body
+    uint32_t size;
+};
+
+// Chunks after the RIFF/RF64 "WAVE" preamble, up to and including "data".
+std::vector<Chunk> WalkChunks(const uint8_t* h, size_t size)
+{
+    std::vector<Chunk> chunks;
+    for (size_t at = 12; at + 8 <= size;) {
+        Chunk c{std::string(reinterpret_cast<const char*>(h + at), 4), at + 8, Get32(h + at + 4)};
+        chunks.push_back(c);
+        if (c.id == "data") {
+            break;
+        }
+        at = c.offset + c.size + (c.size & 1u);
+    }
+    return chunks;
+}
+
+const Chunk* FindChunk(const std::vector<Chunk>& chunks, const char* id)
+{
+    for (const Chunk& c : chunks) {
+        if (c.id == id) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+// Checks a RIFF file (header plus payload) written for format; returns the
+// data chunk size.
+uint32_t CheckRiffHeader(const std::vector<uint8_t>& file, const PcmFileFormat& format)
+{
+    EXPECT_GE(file.size(), WavFileWriter::kHeaderBytes);
+    if (file.size() < WavFileWriter::kHeaderBytes) {
+        return 0;
+    }
+    const uint8_t* h = file.data();
+    EXPECT_TRUE(IsId(h, "RIFF"));
+    EXPECT_EQ(Get32(h + 4), file.size() - 8);
+    EXPECT_TRUE(IsId(h + 8, "WAVE"));
+
+    const std::vector<Chunk> chunks = WalkChunks(h, WavFileWriter::kHeaderBytes);
+    EXPECT_EQ(chunks.front().id, "JUNK");  // reserved for ds64
+    EXPECT_EQ(chunks.front().size, 28u);
+    const Chunk* fmt = FindChunk(chunks, "fmt ");
+    const Chunk* data = FindChunk(chunks, "data");
+    EXPECT_NE(fmt, nullptr);
+    EXPECT_NE(data, nullptr);
+    if (fmt == nullptr || data == nullptr) {
+        return 0;
+    }
+
+    const uint8_t* f = h + fmt->offset;
+    const uint16_t blockAlign = static_cast<uint16_t>(format.channelCount * format.bitsPerSample / 8);
+    const bool extensible = format.channelCount > 2 || format.bitsPerSample > 16;
+    const uint16_t tag = format.isFloat ? 3 : 1;
+    EXPECT_EQ(fmt->size, extensible ? 40u : 16u);
+    EXPECT_EQ(Get16(f), extensible ? 0xFFFE : tag);
+    EXPECT_EQ(Get16(f + 2), format.channelCount);
+    EXPECT_EQ(Get32(f + 4), static_cast<uint32_t>(format.sampleRate));
+    EXPECT_EQ(Get32(f + 8), static_cast<uint32_t>(format.sampleRate) * blockAlign);
+    EXPECT_EQ(Get16(f + 12), blockAlign);
+    EXPECT_EQ(Get16(f + 14), format.bitsPerSample);
+    if (extensible) {
+        EXPECT_EQ(Get16(f + 16), 22);
+        EXPECT_EQ(Get16(f + 24), tag);  // sub-format GUID starts with the tag
+    }
+
+    // The payload starts on the page boundary and runs to the end of the file.
+    EXPECT_EQ(data->offset, WavFileWriter::kHeaderBytes);
+    EXPECT_EQ(data->size, file.size() - WavFileWriter::kHeaderBytes);
+    return data->size;
+}
+
+class WavFileWriterFormatTest : public ::testing::TestWithParam<std::tuple<int32_t, int32_t>> {};
+
+// Every channel count the decoder emits, at 16/24/32-bit integer and float.
+TEST_P(WavFileWriterFormatTest, HeaderAndPayload)
+{
+    const int32_t channels = std::get<0>(GetParam());
+    const int32_t bits = std::get<1>(GetParam());  // 0: 32-bit float
+    const PcmFileFormat format{44100, channels, bits == 0 ? 32 : bits, bits == 0};
+    const size_t frameBytes = static_cast<size_t>(channels * format.bitsPerSample / 8);
+
+    test::TempDir dir;
+    const std::string path = dir.File("out.wav");
+    std::mt19937 rng = test::Rng(static_cast<uint32_t>(channels * 64 + bits));
+    // Past one block, so the header is patched mid-file as well as on Close().
+    std::vector<uint8_t> payload(((PcmFileWriter::kDefaultBlockBytes * 3 / 2) / frameBytes) * frameBytes);
+    for (uint8_t& b : payload) {
+        b = static_cast<uint8_t>(rng());
+    }
+
+    WavFileWriter writer;
+    ASSERT_TRUE(writer.Open(path, PcmFileWriter::Options()));
+    ASSERT_TRUE(writer.SetFormat(format));
+    std::uniform_int_distribution<size_t> chunk(1, 8192);
+    for (size_t at = 0; at < payload.size();) {
+        const size_t n = std::min(chunk(rng), payload.size() - at);
+        ASSERT_TRUE(writer.Write(payload.data() + at, n));
+        at += n;
+    }
+    ASSERT_TRUE(writer.Close());
+
+    const std::vector<uint8_t> file = ReadFile(path);
+    EXPECT_EQ(CheckRiffHeader(file, format), payload.size());
+    EXPECT_TRUE(std::equal(payload.begin(), payload.end(), file.begin() + WavFileWriter::kHeaderBytes));
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, WavFileWriterFormatTest,
+                         ::testing::Combine(::testing::Values(1, 2, 6, 8), ::testing::Values(16, 24, 32, 0)));
+
+// Snapshots the file from the writer thread right after each header patch.
+class SnapshotWavWriter : public WavFileWriter {
+public:
+    explicit SnapshotWavWriter(std::string path) : path_(std::move(path)) {}
+    ~SnapshotWavWriter() override { Close(); }
+
+    std::vector<std::vector<uint8_t>> snapshots;
+    std::vector<int64_t> dataBytes;
+
+protected:
+    void OnBlockWritten(int64_t bytes) override
+    {
+        WavFileWriter::OnBlockWritten(bytes);
+        dataBytes.push_back(bytes);
+        snapshots.push_back(ReadFile(path_));
+    }
+
+private:
+    std::string path_;
+};
+
+TEST(WavFileWriterTest, EveryBlockLeavesAValidFile)
+{
+    test::TempDir dir;
+    const std::string path = dir.File("out.wav");
+    const PcmFileFormat format{48000, 2, 16, false};
+    std::vector<uint8_t> payload(PcmFileWriter::kDefaultBlockBytes * 3 + 4 * 100);
+    std::mt19937 rng = test::Rng(1);
+    for (uint8_t& b : payload) {
+        b = static_cast<uint8_t>(rng());
+    }
+
+    SnapshotWavWriter writer(path);
+    ASSERT_TRUE(writer.Open(path, PcmFileWriter::Options()));
+    ASSERT_TRUE(writer.SetFormat(format));
+    ASSERT_TRUE(writer.Write(payload.data(), payload.size()));
+    ASSERT_TRUE(writer.Close());
+
+    ASSERT_EQ(writer.snapshots.size(), 4u);
+    for (size_t i = 0; i < writer.snapshots.size(); i++) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(CheckRiffHeader(writer.snapshots[i], format), static_cast<uint32_t>(writer.dataBytes[i]));
+    }
+    EXPECT_EQ(writer.dataBytes.back(), static_cast<int64_t>(payload.size()));
+}
+
+// Patches the header for a given payload size without writing the payload.
+class PatchableWavWriter : public WavFileWriter {
+public:
+    ~PatchableWavWriter() override { Close(); }
+    void Patch(int64_t dataBytes) { OnBlockWritten(dataBytes); }
+};
+
+TEST(WavFileWriterTest, SwitchesToRf64PastFourGigabytes)
+{
+    test::TempDir dir;
+    const std::string path = dir.File("big.wav");
+    const PcmFileFormat format{48000, 6, 24, false};
+    const uint64_t blockAlign = 6 * 3;
+
+    PatchableWavWriter writer;
+    ASSERT_TRUE(writer.Open(path, PcmFileWriter::Options()));
+    ASSERT_TRUE(writer.SetFormat(format));
+
+    // Largest payload whose RIFF size still fits in 32 bits.
+    const uint64_t riffMax = 0xFFFFFFFFull - (WavFileWriter::kHeaderBytes - 8);
+    writer.Patch(static_cast<int64_t>(riffMax));
+    std::vector<uint8_t> h = ReadFile(path);
+    ASSERT_GE(h.size(), WavFileWriter::kHeaderBytes);
+    EXPECT_TRUE(IsId(h.data(), "RIFF"));
+    EXPECT_EQ(Get32(h.data() + 4), 0xFFFFFFFFu);
+    EXPECT_TRUE(IsId(h.data() + 12, "JUNK"));
+    EXPECT_EQ(Get32(h.data() + WavFileWriter::kHeaderBytes - 4), static_cast<uint32_t>(riffMax));
+
+    const uint64_t data = 5ull << 30;
+    writer.Patch(static_cast<int64_t>(data));
+    h = ReadFile(path);
+    ASSERT_GE(h.size(), WavFileWriter::kHeaderBytes);
+    EXPECT_TRUE(IsId(h.data(), "RF64"));
+    EXPECT_EQ(Get32(h.data() + 4), 0xFFFFFFFFu);
+    EXPECT_TRUE(IsId(h.data() + 8, "WAVE"));
+    ASSERT_TRUE(IsId(h.data() + 12, "ds64"));
+    EXPECT_EQ(Get32(h.data() + 16), 28u);
+    EXPECT_EQ(Get64(h.data() + 20), WavFileWriter::kHeaderBytes - 8 + data);
+    EXPECT_EQ(Get64(h.data() + 28), data);
+    EXPECT_EQ(Get64(h.data() + 36), data / blockAlign);
+    EXPECT_EQ(Get32(h.data() + 44), 0u);
+
+    const std::vector<Chunk> chunks = WalkChunks(h.data(), WavFileWriter::kHeaderBytes);
+    const Chunk* dataChunk = FindChunk(chunks, "data");
+    ASSERT_NE(dataChunk, nullptr);
+    EXPECT_EQ(dataChunk->offset, WavFileWriter::kHeaderBytes);
+    EXPECT_EQ(dataChunk->size, 0xFFFFFFFFu);
+    ASSERT_NE(FindChunk(chunks, "fmt "), nullptr);
+}
+
+TEST(WavFileWriterTest, RejectsUnsupportedFormats)
+{
+    test::TempDir dir;
+    WavFileWriter writer;
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{48000, 2, 16, false}));  // not open
+    ASSERT_TRUE(writer.Open(dir.File("x.wav"), PcmFileWriter::Options()));
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{48000, 9, 16, false}));
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{48000, 0, 16, false}));
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{48000, 2, 12, false}));
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{48000, 2, 16, true}));
+    EXPECT_FALSE(writer.SetFormat(PcmFileFormat{0, 2, 16, false}));
+    EXPECT_TRUE(writer.SetFormat(PcmFileFormat{48000, 2, 8, false}));
+}
+
+} // namespace
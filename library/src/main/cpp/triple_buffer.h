@@ -0,0 +1,80 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of a parameter block from one writer thread to one reader
+// thread.
+//
+// The writer fills its private slot and swaps it with the shared middle slot;
+// the reader swaps its slot with the middle one when the middle holds a value
+// it has not seen yet. Each side therefore only ever touches its own slot, the
+// reader always sees a whole published value (never a mix of two updates), and
+// intermediate values the reader did not get to are simply skipped.
+//
+// - Publish(): writer side, copies the value and makes it visible.
+// - Published(): writer side, the last value passed to Publish() (for updates
+//   that change only some fields).
+// - Acquire(): reader side, adopts the latest value if there is a new one; a
+//   relaxed load when nothing changed, one exchange otherwise. Returns true
+//   when Current() changed.
+// - Current(): reader side, the value adopted by the last Acquire().
+template <typename T>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(const T& initial = T()) : middle_(kMiddleInit), write_(kWriteInit), read_(kReadInit)
+    {
+        for (auto& slot : slots_) {
+            slot.value = initial;
+        }
+        published_ = initial;
+    }
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    void Publish(const T& value)
+    {
+        published_ = value;
+        slots_[write_].value = value;
+        const uint8_t prev = middle_.exchange(static_cast<uint8_t>(write_ | kFresh), std::memory_order_acq_rel);
+        write_ = prev & kIndexMask;
+    }
+
+    const T& Published() const { return published_; }
+
+    bool Acquire()
+    {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        const uint8_t prev = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = prev & kIndexMask;
+        return true;
+    }
+
+    const T& Current() const { return slots_[read_].value; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+    static constexpr uint8_t kReadInit = 0;
+    static constexpr uint8_t kMiddleInit = 1;
+    static constexpr uint8_t kWriteInit = 2;
+
+    // Slots on separate cache lines so writer and reader do not share one.
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    std::array<Slot, 3> slots_;
+    std::atomic<uint8_t> middle_;
+    // Writer-owned.
+    uint8_t write_;
+    T published_;
+    // Reader-owned.
+    uint8_t read_;
+};
+
+#endif
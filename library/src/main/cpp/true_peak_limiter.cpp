@@ -3,16 +3,79 @@
 #include <algorithm>
 #include <cmath>
 
+#if !defined(FREE_PCM_LIMITER_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define PCM_TPL_USE_NEON 1
+#elif !defined(FREE_PCM_LIMITER_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_TPL_USE_SSE 1
+#endif
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+// 4-frame float vector for the polyphase detector; loads are unaligned because
+// the FIR window slides one frame per tap.
+#if defined(PCM_TPL_USE_NEON)
+struct Frames4 {
+    float32x4_t v;
+    static Frames4 Load(const float* p) { return {vld1q_f32(p)}; }
+    static Frames4 Splat(float x) { return {vdupq_n_f32(x)}; }
+    void Store(float* p) const { vst1q_f32(p, v); }
+};
+inline Frames4 operator+(Frames4 a, Frames4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Frames4 operator*(Frames4 a, Frames4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Frames4 Abs(Frames4 a) { return {vabsq_f32(a.v)}; }
+inline Frames4 Max(Frames4 a, Frames4 b) { return {vmaxq_f32(a.v, b.v)}; }
+#elif defined(PCM_TPL_USE_SSE)
+struct Frames4 {
+    __m128 v;
+    static Frames4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static Frames4 Splat(float x) { return {_mm_set1_ps(x)}; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+};
+inline Frames4 operator+(Frames4 a, Frames4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Frames4 operator*(Frames4 a, Frames4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Frames4 Abs(Frames4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline Frames4 Max(Frames4 a, Frames4 b) { return {_mm_max_ps(a.v, b.v)}; }
+#else
+struct Frames4 {
+    float v[4];
+    static Frames4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static Frames4 Splat(float x) { return {{x, x, x, x}}; }
+    void Store(float* p) const
+    {
+        p[0] = v[0];
+        p[1] = v[1];
+        p[2] = v[2];
+        p[3] = v[3];
+    }
+};
+inline Frames4 operator+(Frames4 a, Frames4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+inline Frames4 operator*(Frames4 a, Frames4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+inline Frames4 Abs(Frames4 a) { return {{std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3])}}; }
+inline Frames4 Max(Frames4 a, Frames4 b)
+{
+    return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}};
+}
+#endif
+
+}
+
 TruePeakLimiter::TruePeakLimiter()
     : ready_(false), enabled_(true), sampleRate_(0), channelCount_(0), ceilingDbtp_(-1.0f), lookaheadMs_(5.0f),
       attackMs_(1.0f), releaseMs_(80.0f), ceilingLin_(DbToLin(-1.0f)), attackCoef_(0.0f), releaseCoef_(0.0f),
-      currentGain_(1.0f), lookaheadFrames_(0), lastGainDb_(0.0f), lastGrDb_(0.0f)
+      currentGain_(1.0f), lookaheadFrames_(0), firCoefs_(), firRun_(), peaks_(), delayFrames_(0), delayPos_(0), minQHead_(0),
+      minQSize_(0), reqIndex_(0), lastGainDb_(0.0f), lastGrDb_(0.0f)
 {
+    InitFir();
 }
 
 bool TruePeakLimiter::IsReady() const
 {
-    return ready_ && (channelCount_ >= 1) && (channelCount_ <= 8) && sampleRate_ > 0 && lookaheadFrames_ > 0;
+    return ready_ && (channelCount_ >= 1) && (static_cast<size_t>(channelCount_) <= kMaxChannels) &&
+           sampleRate_ > 0 && lookaheadFrames_ > 0 && !delay_.empty();
 }
 
 void TruePeakLimiter::Reset()
@@ -20,14 +83,19 @@ void TruePeakLimiter::Reset()
     currentGain_ = 1.0f;
     lastGainDb_ = 0.0f;
     lastGrDb_ = 0.0f;
-    std::fill(history_.begin(), history_.end(), 0.0f);
+    std::fill(firHist_.begin(), firHist_.end(), 0.0f);
+    std::fill(delay_.begin(), delay_.end(), 0.0f);
+    delayPos_ = 0;
+    minQHead_ = 0;
+    minQSize_ = 0;
+    reqIndex_ = 0;
 }
 
 void TruePeakLimiter::Init(int32_t sampleRate, int32_t channelCount)
 {
     sampleRate_ = sampleRate;
     channelCount_ = channelCount;
-    ready_ = (sampleRate_ > 0) && (channelCount_ >= 1) && (channelCount_ <= 8);
+    ready_ = (sampleRate_ > 0) && (channelCount_ >= 1) && (static_cast<size_t>(channelCount_) <= kMaxChannels);
     SetParams(ceilingDbtp_, lookaheadMs_, attackMs_, releaseMs_);
 }
 
@@ -55,14 +123,131 @@ void TruePeakLimiter::SetParams(float ceilingDbtp, float lookaheadMs, float atta
         lookaheadFrames_ = 0;
     }
 
-    if (ready_ && lookaheadFrames_ > 0) {
-        history_.assign(lookaheadFrames_ * static_cast<size_t>(channelCount_), 0.0f);
-        currentGain_ = 1.0f;
-    } else {
-        history_.clear();
+    AllocateBuffers();
+}
+
+void TruePeakLimiter::AllocateBuffers()
+{
+    if (!ready_ || lookaheadFrames_ == 0) {
+        firHist_.clear();
+        delay_.clear();
+        minQVal_.clear();
+        minQIdx_.clear();
+        delayFrames_ = 0;
+        Reset();
+        return;
+    }
+
+    const size_t ch = static_cast<size_t>(channelCount_);
+    // Requirements from the last lookaheadFrames_ + 1 detector outputs cover the delayed output frame.
+    const size_t window = lookaheadFrames_ + 1;
+    delayFrames_ = lookaheadFrames_ + kDetectorDelay;
+
+    firHist_.assign(ch * (kFirTaps - 1), 0.0f);
+    delay_.assign(delayFrames_ * ch, 0.0f);
+    minQVal_.assign(window, 1.0f);
+    minQIdx_.assign(window, 0);
+    Reset();
+}
+
+void TruePeakLimiter::InitFir()
+{
+    // Hann-windowed sinc over the kFirTaps neighbours, each phase normalized to unity DC gain.
+    const float half = static_cast<float>(kFirTaps) / 2.0f;
+    for (size_t k = 0; k < kFirTaps; k++) {
+        firCoefs_[0][k] = (k == kDetectorDelay) ? 1.0f : 0.0f;
+    }
+    for (size_t p = 1; p < kOversample; p++) {
+        const float frac = static_cast<float>(p) / static_cast<float>(kOversample);
+        float sum = 0.0f;
+        for (size_t k = 0; k < kFirTaps; k++) {
+            // Distance from tap k to the interpolated point at (kDetectorDelay + frac).
+            const float x = static_cast<float>(kDetectorDelay) + frac - static_cast<float>(k);
+            const float sinc = std::sin(kPi * x) / (kPi * x);
+            const float w = 0.5f + 0.5f * std::cos(kPi * x / half);
+            firCoefs_[p][k] = sinc * w;
+            sum += firCoefs_[p][k];
+        }
+        for (size_t k = 0; k < kFirTaps; k++) {
+            firCoefs_[p][k] /= sum;
+        }
     }
 }
 
+void TruePeakLimiter::DetectPeaks(const float* samples, size_t frameCount)
+{
+    const size_t ch = static_cast<size_t>(channelCount_);
+    constexpr size_t kHist = kFirTaps - 1;
+    float* run = firRun_.data();
+    float* peaks = peaks_.data();
+    std::fill(peaks, peaks + frameCount, 0.0f);
+
+    for (size_t c = 0; c < ch; c++) {
+        float* hist = firHist_.data() + c * kHist;
+        std::copy(hist, hist + kHist, run);
+        for (size_t i = 0; i < frameCount; i++) {
+            run[kHist + i] = samples[i * ch + c];
+        }
+        std::copy(run + frameCount, run + frameCount + kHist, hist);
+
+        // Frame i's window is run[i .. i + kFirTaps); four frames are evaluated per step.
+        size_t i = 0;
+        for (; i + 4 <= frameCount; i += 4) {
+            Frames4 win[kFirTaps];
+            for (size_t k = 0; k < kFirTaps; k++) {
+                win[k] = Frames4::Load(run + i + k);
+            }
+            Frames4 peak = Max(Frames4::Load(peaks + i), Abs(win[kDetectorDelay]));
+            for (size_t p = 1; p < kOversample; p++) {
+                Frames4 y = Frames4::Splat(firCoefs_[p][0]) * win[0];
+                for (size_t k = 1; k < kFirTaps; k++) {
+                    y = y + Frames4::Splat(firCoefs_[p][k]) * win[k];
+                }
+                peak = Max(peak, Abs(y));
+            }
+            peak.Store(peaks + i);
+        }
+        for (; i < frameCount; i++) {
+            const float* win = run + i;
+            float peak = std::max(peaks[i], std::fabs(win[kDetectorDelay]));
+            for (size_t p = 1; p < kOversample; p++) {
+                float y = firCoefs_[p][0] * win[0];
+                for (size_t k = 1; k < kFirTaps; k++) {
+                    y += firCoefs_[p][k] * win[k];
+                }
+                peak = std::max(peak, std::fabs(y));
+            }
+            peaks[i] = peak;
+        }
+    }
+}
+
+float TruePeakLimiter::PushRequirement(float gainReq)
+{
+    const size_t cap = minQVal_.size();
+    const uint64_t idx = reqIndex_++;
+
+    // Drop requirements that can never be the minimum again.
+    while (minQSize_ > 0) {
+        size_t back = minQHead_ + minQSize_ - 1;
+        if (back >= cap) back -= cap;
+        if (minQVal_[back] < gainReq) break;
+        minQSize_--;
+    }
+    // Expire the front once it leaves the window.
+    if (minQSize_ > 0 && minQIdx_[minQHead_] + cap <= idx) {
+        minQHead_ = (minQHead_ + 1 < cap) ? (minQHead_ + 1) : 0;
+        minQSize_--;
+    }
+    size_t tail = minQHead_ + minQSize_;
+    if (tail >= cap) tail -= cap;
+    minQVal_[tail] = gainReq;
+    minQIdx_[tail] = idx;
+    minQSize_++;
+
+    return minQVal_[minQHead_];
+}
+
 float TruePeakLimiter::ClampFloat(float v, float lo, float hi)
 {
     if (v < lo) return lo;
@@ -88,103 +273,44 @@ float TruePeakLimiter::TimeMsToCoef(float timeMs, float sampleRate)
     return std::exp(-1.0f / (t * sampleRate));
 }
 
-float TruePeakLimiter::CatmullRom(float p0, float p1, float p2, float p3, float t)
-{
-    const float t2 = t * t;
-    const float t3 = t2 * t;
-    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
-                   (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
-}
-
-float TruePeakLimiter::SegmentTruePeak4x(float p0, float p1, float p2, float p3) const
-{
-    float peak = std::max(std::fabs(p1), std::fabs(p2));
-    const float y1 = CatmullRom(p0, p1, p2, p3, 0.25f);
-    const float y2 = CatmullRom(p0, p1, p2, p3, 0.50f);
-    const float y3 = CatmullRom(p0, p1, p2, p3, 0.75f);
-    peak = std::max(peak, std::fabs(y1));
-    peak = std::max(peak, std::fabs(y2));
-    peak = std::max(peak, std::fabs(y3));
-    return peak;
-}
-
 void TruePeakLimiter::ProcessFloat(float* samples, size_t frameCount)
 {
     if (!enabled_ || !IsReady() || samples == nullptr || frameCount == 0) return;
 
     const size_t ch = static_cast<size_t>(channelCount_);
-    const size_t la = lookaheadFrames_;
-    const size_t histFrames = la;
-
-    if (history_.size() != histFrames * ch) {
-        history_.assign(histFrames * ch, 0.0f);
-    }
+    float gain = currentGain_;
 
-    const size_t totalFrames = histFrames + frameCount;
-    const size_t totalSamples = totalFrames * ch;
-    std::vector<float> buf(totalSamples);
-    std::copy(history_.begin(), history_.end(), buf.begin());
-    std::copy(samples, samples + frameCount * ch, buf.begin() + history_.size());
-
-    const size_t gainCount = totalFrames;
-    std::vector<float> gReq(gainCount, 1.0f);
-    std::vector<float> gTgt(gainCount, 1.0f);
-
-    for (size_t i = 0; i + 1 < totalFrames; i++) {
-        const size_t i0 = (i == 0) ? 0 : (i - 1);
-        const size_t i1 = i;
-        const size_t i2 = i + 1;
-        const size_t i3 = (i + 2 < totalFrames) ? (i + 2) : (i + 1);
-
-        float peak = 0.0f;
-        for (size_t c = 0; c < ch; c++) {
-            const float p0 = buf[i0 * ch + c];
-            const float p1 = buf[i1 * ch + c];
-            const float p2 = buf[i2 * ch + c];
-            const float p3 = buf[i3 * ch + c];
-            peak = std::max(peak, SegmentTruePeak4x(p0, p1, p2, p3));
-        }
+    for (size_t off = 0; off < frameCount; off += kBlockFrames) {
+        const size_t n = std::min(kBlockFrames, frameCount - off);
+        float* block = samples + off * ch;
+        DetectPeaks(block, n);
 
-        float g = 1.0f;
-        if (peak > ceilingLin_) {
-            g = ceilingLin_ / peak;
-        }
-        if (g < 0.0f) g = 0.0f;
-        if (g > 1.0f) g = 1.0f;
-        gReq[i] = g;
-    }
-    gReq[totalFrames - 1] = 1.0f;
+        for (size_t i = 0; i < n; i++) {
+            const float peak = peaks_[i];
+            float req = 1.0f;
+            if (peak > ceilingLin_) {
+                req = ceilingLin_ / peak;
+            }
+            const float target = PushRequirement(req);
 
-    for (size_t i = 0; i < totalFrames; i++) {
-        const size_t j = (i + la < totalFrames) ? (i + la) : (totalFrames - 1);
-        gTgt[i] = gReq[j];
-    }
+            const float coef = (target < gain) ? attackCoef_ : releaseCoef_;
+            gain = (coef * gain) + ((1.0f - coef) * target);
+            if (gain > 1.0f) gain = 1.0f;
+            if (gain < 0.0f) gain = 0.0f;
 
-    float gain = currentGain_;
-    float lastApplied = 1.0f;
-    for (size_t i = 0; i < totalFrames; i++) {
-        const float target = gTgt[i];
-        const float coef = (target < gain) ? attackCoef_ : releaseCoef_;
-        gain = (coef * gain) + ((1.0f - coef) * target);
-        if (gain > 1.0f) gain = 1.0f;
-        if (gain < 0.0f) gain = 0.0f;
-
-        const bool inOutput = (i < frameCount);
-        if (inOutput) {
-            const size_t outIdx = i * ch;
+            float* frame = block + i * ch;
+            float* delayed = delay_.data() + delayPos_ * ch;
             for (size_t c = 0; c < ch; c++) {
-                const float x = buf[outIdx + c];
-                samples[outIdx + c] = x * gain;
+                const float x = frame[c];
+                frame[c] = delayed[c] * gain;
+                delayed[c] = x;
             }
-            lastApplied = gain;
+            delayPos_ = (delayPos_ + 1 < delayFrames_) ? (delayPos_ + 1) : 0;
         }
     }
     currentGain_ = gain;
 
-    const size_t histStart = frameCount * ch;
-    std::copy(buf.begin() + histStart, buf.begin() + histStart + history_.size(), history_.begin());
-
-    lastGainDb_ = LinToDb(lastApplied);
+    lastGainDb_ = LinToDb(gain);
     const float gr = -lastGainDb_;
     lastGrDb_ = (gr > 0.0f) ? gr : 0.0f;
 }
@@ -1,10 +1,23 @@
 #ifndef TRUE_PEAK_LIMITER_H
 #define TRUE_PEAK_LIMITER_H
 
+#include <array>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
 
+// Streaming lookahead true-peak limiter for interleaved float PCM.
+//
+// - True peak: 4x polyphase FIR interpolation (windowed sinc, kFirTaps taps per
+//   phase). Input is processed in kBlockFrames tiles; each channel is deinterleaved
+//   into a contiguous run and the FIR is evaluated four frames per vector (NEON on
+//   arm64, SSE2 on x86_64, plain C++ otherwise; define FREE_PCM_LIMITER_NO_SIMD to
+//   force the scalar lanes).
+// - Lookahead: circular delay line; the gain target is the minimum required
+//   gain over the lookahead window, tracked with a monotonic deque in O(1).
+// - All storage is sized in Init/SetParams; ProcessFloat never allocates.
+//
+// Output is delayed by lookahead + kDetectorDelay frames.
 class TruePeakLimiter {
 public:
     TruePeakLimiter();
@@ -17,17 +30,30 @@ public:
     void SetParams(float ceilingDbtp, float lookaheadMs, float attackMs, float releaseMs);
     void ProcessFloat(float* samples, size_t frameCount);
 
+    // Frames by which ProcessFloat delays its input (lookahead + kDetectorDelay),
+    // 0 when not ready. Positions counted on the output lag the input by this.
+    size_t LatencyFrames() const { return IsReady() ? delayFrames_ : 0; }
+
     float GetLastGainDb() const { return lastGainDb_; }
     float GetLastGrDb() const { return lastGrDb_; }
 
 private:
+    static constexpr size_t kMaxChannels = 8;
+    static constexpr size_t kOversample = 4;
+    static constexpr size_t kFirTaps = 8;
+    static constexpr size_t kBlockFrames = 256;
+    // Interpolated points lie between window taps kFirTaps/2-1 and kFirTaps/2.
+    static constexpr size_t kDetectorDelay = kFirTaps / 2 - 1;
+
     static float DbToLin(float db);
     static float LinToDb(float lin);
     static float TimeMsToCoef(float timeMs, float sampleRate);
     static float ClampFloat(float v, float lo, float hi);
-    static float CatmullRom(float p0, float p1, float p2, float p3, float t);
 
-    float SegmentTruePeak4x(float p0, float p1, float p2, float p3) const;
+    void InitFir();
+    void AllocateBuffers();
+    void DetectPeaks(const float* samples, size_t frameCount);
+    float PushRequirement(float gainReq);
 
     bool ready_;
     bool enabled_;
@@ -45,7 +71,28 @@ private:
     float currentGain_;
 
     size_t lookaheadFrames_;
-    std::vector<float> history_;   // interleaved, size = lookaheadFrames_ * ch
+
+    // Polyphase coefficients, [phase][tap]; phase p interpolates at fractional position p/4
+    // (phase 0 is the sample itself and is not filtered).
+    std::array<std::array<float, kFirTaps>, kOversample> firCoefs_;
+    // Per channel: last kFirTaps - 1 input samples carried across tiles.
+    std::vector<float> firHist_;
+    // Tile scratch: one deinterleaved channel with its history, and per-frame peaks.
+    std::array<float, kFirTaps - 1 + kBlockFrames> firRun_;
+    std::array<float, kBlockFrames> peaks_;
+
+    // Circular lookahead delay line, interleaved, delayFrames_ * ch samples.
+    std::vector<float> delay_;
+    size_t delayFrames_;
+    size_t delayPos_;
+
+    // Monotonic deque (ring storage) of gain requirements for the sliding-window minimum.
+    std::vector<float> minQVal_;
+    std::vector<uint64_t> minQIdx_;
+    size_t minQHead_;
+    size_t minQSize_;
+    uint64_t reqIndex_;
+
     float lastGainDb_;
     float lastGrDb_;
 };
@@ -7,12 +7,22 @@
 #include <atomic>
 #include <array>
 #include <vector>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include "../pcm_equalizer.h"
 #include "../drc_processor.h"
 #include "../buffer/ring_buffer.h"
+#include "../buffer/ring_resize_policy.h"
 #include "../true_peak_limiter.h"
 #include "../pcm_pitch_shifter.h"
+#include "../dsp_chain.h"
+#include "../audio_decoder.h"
+#include "../preroll_decoder.h"
+#include "../pcm_crossfade.h"
+#include "../decode_scheduler.h"
+#include "../decode_stats.h"
+#include "../triple_buffer.h"
 
 // ============================================================================
 // 解码器事件类型和负载
@@ -27,6 +37,8 @@ enum class DecoderEventType {
     Error = 2,      ///< 错误发生
     Seek = 3,       ///< Seek 结果（用于 Promise resolve/reject）
     DrcMeter = 4,   ///< DRC meter (level/gain/GR)
+    RingResize = 5, ///< 环形缓冲区扩缩容
+    TrackChange = 6, ///< 播放到队列中的下一曲目
 };
 
 /**
@@ -59,6 +71,20 @@ struct DecoderEventPayload {
     double drcLevelDb = 0.0;
     double drcGainDb = 0.0;
     double drcGrDb = 0.0;
+
+    // Ring resize
+    uint64_t ringOldBytes = 0;
+    uint64_t ringNewBytes = 0;
+    const char* ringReason = "";
+    double ringFillPercent = 0.0;
+    uint64_t ringUnderruns = 0;
+    double ringReadLatencyMs = 0.0;
+
+    // Track change
+    uint64_t trackId = 0;
+    std::string trackUri;
+    int64_t trimStartFrames = 0;
+    int64_t trimEndFrames = 0;
 };
 
 // ============================================================================
@@ -79,7 +105,6 @@ struct DecodeAudioProgressPayload {
  */
 struct DecodeAudioAsyncContext {
     napi_env env;
-    napi_async_work work;
     napi_deferred deferred;
     napi_threadsafe_function tsfn;
 
@@ -92,17 +117,173 @@ struct DecodeAudioAsyncContext {
     bool success;
 };
 
+// ============================================================================
+// 批量解码上下文
+// ============================================================================
+
+/**
+ * @brief 批量解码中的单个任务
+ */
+struct BatchDecodeJob {
+    std::string inputPathOrUri;
+    std::string outputPath;
+    int32_t sampleRate = 0;
+    int32_t channelCount = 0;
+    int32_t bitrate = 0;
+
+    // 以下由工作线程写入，CompleteBatchDecode 中读取（工作线程均已 join）
+    bool success = false;
+    bool cancelled = false;
+    int64_t outputBytes = 0;
+    int64_t durationMs = 0;
+    int64_t elapsedMs = 0;
+};
+
+/**
+ * @brief 批量解码事件类型
+ */
+enum class BatchDecodeEventType {
+    Progress = 0,   ///< 单个任务的进度更新
+    JobDone = 1,    ///< 单个任务结束（成功/失败/取消）
+};
+
+/**
+ * @brief 批量解码事件负载
+ */
+struct BatchDecodeEventPayload {
+    BatchDecodeEventType type;
+    int32_t jobIndex = 0;
+
+    // Progress 事件数据
+    double progress = 0.0;
+    int64_t ptsMs = 0;
+    int64_t durationMs = 0;
+
+    // JobDone 事件数据
+    bool success = false;
+    bool cancelled = false;
+    int64_t outputBytes = 0;
+    int64_t elapsedMs = 0;
+};
+
+/**
+ * @brief 批量解码上下文
+ *
+ * 由 napi_wrap 的 finalizer 释放；解码期间 selfRef 保持任务对象存活。
+ */
+struct BatchDecodeContext {
+    napi_env env = nullptr;
+    napi_deferred deferred = nullptr;
+    napi_threadsafe_function eventTsfn = nullptr;
+
+    napi_ref selfRef = nullptr;
+    napi_ref onProgressRef = nullptr;
+    napi_ref onJobDoneRef = nullptr;
+
+    std::vector<BatchDecodeJob> jobs;
+    int32_t concurrency = 1;
+    AudioDecoder::FileOutputOptions fileOutput;
+
+    // 下一个待领取的任务下标（工作线程间共享）
+    std::atomic<size_t> nextJob{0};
+    std::atomic<bool> cancel{false};
+    // 每个工作线程一个等待原语（创建时按 concurrency 分配），取消时逐个唤醒
+    std::vector<std::unique_ptr<DecodeWakeup>> wakeups;
+
+    int64_t elapsedMs = 0;
+};
+
+// ============================================================================
+// 解码器实例池上下文
+// ============================================================================
+
+/**
+ * @brief prewarmCodecs 异步上下文
+ */
+struct CodecPrewarmContext {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+
+    std::vector<std::string> mimeTypes;
+    int32_t countPerMime = 1;
+
+    uint32_t created = 0;
+};
+
 // ============================================================================
 // 流式解码器上下文
 // ============================================================================
 
+/**
+ * @brief 播放队列中等待预解码的曲目
+ */
+struct QueuedTrack {
+    uint64_t id = 0;
+    std::string uri;
+    int64_t delayFrames = -1;    // < 0 = 从文件读取
+    int64_t paddingFrames = -1;  // < 0 = 从文件读取
+};
+
+/**
+ * @brief 已拼接进环形缓冲区、等待播放到的曲目起点
+ */
+struct TrackChangeInfo {
+    uint64_t id = 0;
+    std::string uri;
+    int64_t durationMs = 0;
+    int64_t trimStartFrames = 0;
+    int64_t trimEndFrames = 0;
+    int64_t delayFrames = -1;    // 入队时的 QueuedTrack 取值，撤回后重新入队用
+    int64_t paddingFrames = -1;
+};
+
+/**
+ * @brief EQ 参数快照
+ */
+struct EqParams {
+    bool enabled = false;
+    // Band gains per channel (0=left/mono, 1=right), dB.
+    std::array<std::array<float, PcmEqualizer::kBandCount>, 2> gainsDb{};
+    // Headroom for positive band gains, derived from gainsDb when published.
+    float preamp = 1.0f;
+};
+
+/**
+ * @brief 声道音量补偿系数快照（1.0 = 不变）
+ */
+struct ChannelVolumeParams {
+    float left = 1.0f;
+    float right = 1.0f;
+};
+
+/**
+ * @brief DRC 参数快照
+ */
+struct DrcParams {
+    bool enabled = false;
+    float thresholdDb = -20.0f;
+    float ratio = 4.0f;
+    float attackMs = 10.0f;
+    float releaseMs = 100.0f;
+    float makeupDb = 0.0f;
+};
+
+/**
+ * @brief 变调参数快照
+ */
+struct PitchParams {
+    bool enabled = false;
+    int32_t semitones = 0;
+};
+
 /**
  * @brief 流式解码器上下文
  */
 struct PcmStreamDecoderContext {
     napi_env env;
-    napi_async_work work;
     napi_threadsafe_function eventTsfn;
+    // 解码线程的调度优先级（流式解码调度器）
+    DecodeScheduler::Priority priority;
 
     napi_deferred readyDeferred;
     napi_deferred doneDeferred;
@@ -115,6 +296,8 @@ struct PcmStreamDecoderContext {
     napi_ref onProgressRef;
     napi_ref onErrorRef;
     napi_ref onDrcMeterRef;
+    napi_ref onRingResizeRef;
+    napi_ref onTrackChangeRef;
 
     std::string inputPathOrUri;
     int32_t sampleRate;
@@ -122,10 +305,20 @@ struct PcmStreamDecoderContext {
     int32_t bitrate;
     int32_t sampleFormat;
 
+    // Decoded-PCM disk cache; empty dir = disabled, maxBytes 0 = default budget.
+    std::string cacheDir;
+    int64_t cacheMaxBytes;
+
+    // Played PCM kept in the ring for backward in-buffer seeks; 0 = disabled.
+    int32_t historyMs;
+
     std::atomic<bool> cancel;
     bool success;
     bool readySettled;
 
+    // Wait primitive of the decode thread; notified on seek, resume and close.
+    DecodeWakeup wakeup;
+
     // Decoder pause control: when true, decode thread waits instead of reading network.
     // This prevents network timeout during long pauses.
     std::atomic<bool> decoderPaused;
@@ -141,51 +334,41 @@ struct PcmStreamDecoderContext {
 
     std::unique_ptr<audio::PcmRingBuffer> ring;
 
-    // EQ（10 段均衡器）配置，与 JS 线程共享
-    std::atomic<bool> eqEnabled;
-    std::atomic<uint32_t> eqVersion;
+    // DSP 参数：JS 线程整块发布，解码线程每个缓冲区取一次最新快照（见 triple_buffer.h）
+    TripleBuffer<EqParams> eqParams;
+    TripleBuffer<ChannelVolumeParams> channelVolumeParams;
+    TripleBuffer<DrcParams> drcParams;
+    TripleBuffer<PitchParams> pitchParams;
 
-    // EQ gains per channel (0=left/mono, 1=right). Unit: dB * 100.
-    std::array<std::array<std::atomic<int32_t>, PcmEqualizer::kBandCount>, 2> eqGainsDb100Stereo;
-
-    // Per-channel volume compensation coefficients.
-    // Unit: coefficient * 1000. 1000 = 1.0, 500 = 0.5, 1500 = 1.5.
-    std::array<std::atomic<int32_t>, 2> channelVol1000;
-
-    // 工作线程状态
-    uint32_t eqAppliedVersion;
+    // 工作线程状态：对应快照是否已写入处理器（新快照或处理器重新 Init 后置 false）
+    bool eqParamsApplied;
+    bool drcParamsApplied;
+    bool pitchParamsApplied;
     int32_t eqSampleRate;
     int32_t eqChannelCount;
     PcmEqualizer eq;
 
-    // DRC (dynamic range compression)
-    std::atomic<bool> drcEnabled;
-    std::atomic<uint32_t> drcVersion;
-    std::atomic<int32_t> drcThresholdDb100;   // dB * 100
-    std::atomic<int32_t> drcRatio1000;        // ratio * 1000
-    std::atomic<int32_t> drcAttackMs100;      // ms * 100
-    std::atomic<int32_t> drcReleaseMs100;     // ms * 100
-    std::atomic<int32_t> drcMakeupDb100;      // dB * 100
-
-    uint32_t drcAppliedVersion;
     DrcProcessor drc;
 
     uint64_t drcMeterLastEmitMs;
 
-    std::atomic<bool> pitchEnabled;
-    std::atomic<uint32_t> pitchVersion;
-    std::atomic<int32_t> pitchSemitones;
-
-    uint32_t pitchAppliedVersion;
     PcmPitchShifter pitchShifter;
 
-    std::vector<int16_t> eqScratch16;
-    std::vector<int32_t> eqScratch32;
+    TruePeakLimiter limiter;
+    // 限幅器输出延迟（帧，前视 + 检测延迟），解码线程初始化限幅器后写入，供 getBufferStats 读取
+    std::atomic<int64_t> limiterLatencyFrames;
 
-    // Float DSP scratch (normalized)
-    std::vector<float> dspScratchF;
+    // Float DSP chain over eq/pitchShifter/drc/limiter (owns the float scratch).
+    DspChain dspChain{eq, pitchShifter, drc, limiter};
 
-    TruePeakLimiter limiter;
+    // 交叉淡入淡出（仅环形缓冲区生产者访问 crossfade / crossfadeScratchF / crossfadeAppliedMs）
+    std::atomic<int32_t> crossfadeMs;  // 0 = 无缝衔接，不做交叉淡化
+    int32_t crossfadeAppliedMs;
+    PcmCrossfade crossfade;
+    std::vector<float> crossfadeScratchF;  // 下一曲目一侧的浮点缓冲
+    std::atomic<uint64_t> crossfadeCount;
+    std::atomic<int64_t> crossfadeLastAudioMs;
+    std::atomic<int64_t> crossfadeLastCpuUs;  // 重叠区间内解码线程 CPU 时间
 
     // Global S32LE max absolute value for stable normalization.
     // This persists across callbacks to prevent volume rollercoasters
@@ -194,6 +377,21 @@ struct PcmStreamDecoderContext {
 
     // 用于 PcmRingBuffer 重新初始化
     size_t ringBytes;
+
+    // 运行期扩缩容（仅解码线程访问 ringPolicy / ringPending*）
+    bool adaptiveRing;
+    size_t ringMinBytes;   // 0 = 自动
+    size_t ringMaxBytes;   // 0 = 自动
+    audio::RingResizePolicy ringPolicy;
+    size_t ringPendingBytes;  // 等待消费者读走数据后生效的缩容目标
+    audio::RingResizePolicy::Reason ringPendingReason;
+    // fillForWriteData 欠载（返回 0）次数，不含暂停/EOS/seek 期间
+    std::atomic<uint64_t> underrunCount;
+    std::atomic<uint64_t> ringResizeCount;
+
+    // 水位模式（百分比，0 = 关闭），JS 线程可随时修改
+    std::atomic<int32_t> watermarkHighPercent;
+    std::atomic<int32_t> watermarkLowPercent;
     int32_t actualSampleRate;
     int32_t actualChannelCount;
     int32_t sourceSampleFormat;
@@ -211,6 +409,36 @@ struct PcmStreamDecoderContext {
     // For seekToAsync: resolved when first post-seek PCM is produced.
     std::atomic<bool> seekAwaitOutput;
     std::atomic<uint64_t> seekAwaitSeq;
+
+    // Seeks served from the ring vs. handed to the decoder (JS thread only).
+    uint64_t localSeekCount;
+    uint64_t decoderSeekCount;
+
+    // 各阶段耗时直方图与缓冲计数（getStats），解码线程 / 送数据线程直接写入
+    DecodeStats stats;
+    // 尚未出首帧的 decoder seek 中最早一次的请求时刻（DecodeStats::NowNs），0 = 无
+    std::atomic<int64_t> seekRequestNs;
+
+    // 播放队列（gapless）。queue 为尚未开始预解码的曲目，preroll 为正在预解码的下一曲目；
+    // 当前曲目结束后解码线程把 preroll 拼接到同一环形缓冲区。
+    bool gaplessTrim;  // 按编码器延迟/填充裁剪首尾
+    std::mutex queueMutex;
+    std::deque<QueuedTrack> queue;
+    std::atomic<uint32_t> queuedCount;  // queue.size()，供解码线程免锁判断
+    bool queueClosed;                   // 解码线程已退出，不再接受新曲目
+    std::unique_ptr<PrerollDecoder> preroll;
+    // clearQueue 取消的预解码器，由解码线程 join 后释放
+    std::vector<std::unique_ptr<PrerollDecoder>> retiredPrerolls;
+    // 与环形缓冲区中的分段起点一一对应，读指针越过后由 JS 线程取出并发送 TrackChange 事件
+    std::deque<TrackChangeInfo> pendingTrackChanges;
+    uint64_t nextTrackId;           // queueMutex
+    uint64_t trackChangesReported;  // JS 线程
+    QueuedTrack playingTrack;       // queueMutex：读指针所在的曲目（最后一个已发送 TrackChange 的曲目）
+    // 定位回正在播放的曲目时撤回其后已拼接的曲目（RequestRewind），解码线程据此重新解码该曲目
+    // 并把撤回的曲目放回队首（TakeRewind）。均在 queueMutex 内写入。
+    std::atomic<bool> rewindRequested;
+    QueuedTrack rewindTrack;
+    std::deque<QueuedTrack> rewindRequeue;
 };
 
 #endif // DECODER_TYPES_H
@@ -112,6 +112,211 @@ export type PcmStreamDecoderOptions = {
   pitchEnabled?: boolean;
 
   pitchSemitones?: number;
+
+  /**
+   * 解码结果磁盘缓存目录（默认不启用）
+   * - 仅对本地文件生效；键由路径、文件大小、修改时间与解码参数组成
+   * - 完整解码到结尾（期间未 seek）后写入缓存；再次打开同一文件时直接从 mmap 读取 PCM，不再启动解码器
+   * - 命中时 fill / fillForWriteData / seekTo 行为不变，seek 为精确到帧的定位
+   */
+  cacheDir?: string;
+
+  /**
+   * 缓存目录容量上限（字节，默认 512MB），超出时按最近最少使用淘汰
+   */
+  cacheMaxBytes?: number;
+
+  /**
+   * 回看区时长（毫秒，默认 0 不启用，上限 60000）
+   * - 环形缓冲区额外保留最近播放过的这段 PCM，向后 seek 落在其中时直接移动读位置，
+   *   不需要 demuxer seek、解码器 flush 与重新解码（HTTP 源也不会发起新的 Range 请求）
+   * - 额外内存 = 采样率 × 声道数 × 每样本字节数 × historyMs / 1000，可通过 getBufferStats() 查看
+   */
+  historyMs?: number;
+
+  /**
+   * 运行期自适应调整环形缓冲区容量（默认 true；指定 ringBytes 且未指定 ringMinBytes/ringMaxBytes 时不调整）
+   * - 出现欠载（fillForWriteData 返回 0）时扩容
+   * - 容量不足以覆盖近期最慢一次源数据读取延迟的 4 倍时扩容
+   * - 10 秒内无欠载且水位持续接近满时缩容
+   * 每次调整通过 onRingResize 回调通知
+   */
+  adaptiveRing?: boolean;
+
+  /** 自适应容量下限（字节，默认按本地/HTTP 与码率估算） */
+  ringMinBytes?: number;
+
+  /** 自适应容量上限（字节，默认本地 16MB / HTTP 8MB） */
+  ringMaxBytes?: number;
+
+  /**
+   * 水位模式（默认关闭），也可运行期通过 setWatermarks 切换
+   * - 缓冲区未读数据达到 watermarkHighPercent 后解码暂停，降到 watermarkLowPercent 及以下才恢复
+   * - 解码成批进行，两批之间解码线程休眠，适合熄屏低功耗播放；唤醒次数见 getBufferStats()
+   * - 需满足 0 <= low < high <= 100，例如 high=95, low=25
+   */
+  watermarkHighPercent?: number;
+
+  watermarkLowPercent?: number;
+
+  /**
+   * 按编码器延迟/填充裁剪曲目首尾的静音帧（默认 true）
+   * - 本地 MP3 读取 LAME/Xing 头，MP4/M4A 读取 iTunSMPB 标签；也可在 enqueue 时显式指定
+   * - 队列中的曲目首尾相接，裁剪后衔接处没有空隙
+   */
+  gaplessTrim?: boolean;
+
+  /**
+   * 队列曲目之间的交叉淡入淡出时长（毫秒，默认 0 即无缝衔接，上限 12000），也可通过 setCrossfadeMs 调整
+   * - 有下一曲目时，当前曲目最后这段 PCM 暂不写入缓冲区，结束时与下一曲目开头按等功率曲线混合
+   * - 混合在同一条浮点 DSP 链中完成（EQ/DRC/限幅器之前），只需一个 AudioRenderer
+   * - 两曲目源采样格式不同时退化为无缝衔接
+   */
+  crossfadeMs?: number;
+  /**
+   * 解码线程优先级（默认 'normal'）
+   *
+   * @remarks
+   * - 流式解码运行在库自有的调度器线程上（有界，见 {@link configureDecodeScheduler}），不占用 napi 异步工作线程
+   * - 线程全忙时新解码排队等待（ready 随之推迟），'high' 先于 'normal' 先于 'low' 取得线程
+   * - 'low' 的解码线程额外降低系统调度优先级（nice +10），适合预览/试听
+   */
+  priority?: 'high' | 'normal' | 'low';
+};
+
+/**
+ * enqueue 选项：显式指定编码器延迟/填充（帧），不指定时从文件读取
+ */
+export type PcmEnqueueOptions = {
+  encoderDelayFrames?: number;
+  paddingFrames?: number;
+};
+
+/**
+ * 切换到队列中下一曲目（onTrackChange 回调参数），在该曲目第一帧被读出时触发
+ */
+export type PcmTrackChangeInfo = {
+  /** enqueue 返回的曲目 id */
+  trackId: number;
+  uri: string;
+  durationMs: number;
+  /** 实际裁剪的首尾帧数 */
+  trimStartFrames: number;
+  trimEndFrames: number;
+};
+
+/**
+ * 环形缓冲区扩缩容事件（onRingResize 回调参数）
+ */
+export type PcmRingResizeInfo = {
+  oldBytes: number;
+  newBytes: number;
+  /** 'underrun' | 'latency' | 'idle' */
+  reason: string;
+  /** 决策时的水位（0~100） */
+  fillPercent: number;
+  /** 累计欠载次数 */
+  underruns: number;
+  /** 近期最慢一次源数据读取耗时（毫秒） */
+  readLatencyMs: number;
+};
+
+/**
+ * 环形缓冲区统计（getBufferStats 返回值）
+ */
+export type PcmBufferStats = {
+  /** 未读数据容量（字节） */
+  ringBytes: number;
+  /** 回看区容量（字节） */
+  historyCapacityBytes: number;
+  /** 实际分配的内存（字节），含扩缩容后尚未释放的旧存储 */
+  allocatedBytes: number;
+  /** 当前已缓冲、尚未播放的数据 */
+  bufferedBytes: number;
+  bufferedMs: number;
+  /** 当前可回看的已播放数据 */
+  historyBytes: number;
+  historyMs: number;
+  /**
+   * DSP 链的输出延迟：真峰值限幅器的前视（5 ms）+ 过采样检测器的 3 帧
+   * @remarks getPosition 与缓冲区内的位置按输出 PCM 计算，此刻听到的是源音频中早 dspLatencyMs 的内容
+   */
+  dspLatencyFrames: number;
+  dspLatencyMs: number;
+  /** 在缓冲区内完成的 seek 次数 */
+  localSeeks: number;
+  /** 交给解码器（demuxer seek + flush）完成的 seek 次数 */
+  decoderSeeks: number;
+  /** fillForWriteData 欠载次数 */
+  underruns: number;
+  /** 运行期扩缩容次数 */
+  ringResizes: number;
+  /** 解码线程因缓冲区满进入休眠的次数（水位模式下即批次数） */
+  producerSleeps: number;
+  /** 解码线程在缓冲区满等待期间被唤醒的次数 */
+  producerWakeups: number;
+  /** 解码线程/送数据线程在等待编解码器、seek、暂停等事件时被唤醒的次数 */
+  decodeWakeups: number;
+  /** 当前水位（0 表示未启用） */
+  watermarkHighPercent: number;
+  watermarkLowPercent: number;
+  /** 已完成的交叉淡化次数 */
+  crossfades: number;
+  /** 最近一次交叉淡化的时长与解码线程 CPU 耗时（毫秒） */
+  lastCrossfadeMs: number;
+  lastCrossfadeCpuMs: number;
+};
+
+/**
+ * 单个处理阶段的耗时分布（微秒）
+ * @remarks 分位数按对数-线性分桶统计，相对误差不超过 6.25%
+ */
+export type PcmStageStats = {
+  /** 样本数（读取/等待为每次调用，转换与 DSP 各阶段为每个解码缓冲） */
+  count: number;
+  minUs: number;
+  meanUs: number;
+  p50Us: number;
+  p90Us: number;
+  p99Us: number;
+  p999Us: number;
+  maxUs: number;
+};
+
+/**
+ * 解码流水线统计（getStats 返回值），自创建或上次 resetStats() 起累计
+ */
+export type PcmDecoderStats = {
+  /** 统计是否编入（以 FREE_PCM_STATS=OFF 构建时为 false，其余字段均为 0） */
+  enabled: boolean;
+  /** 统计时长（毫秒） */
+  elapsedMs: number;
+  /** 解码器输出的 PCM 字节数 */
+  bytesDecoded: number;
+  /** fillForWriteData 欠载次数 */
+  underruns: number;
+  /** 解码线程写入后缓冲区数据量的最大值（字节） */
+  ringHighWaterBytes: number;
+  /** fill/fillForWriteData 开始时缓冲区数据量的最小值（字节），尚未读取时为 0 */
+  ringLowWaterBytes: number;
+  stages: {
+    /** 解封装读取（本地 I/O / 网络） */
+    read: PcmStageStats;
+    /** 解码线程等待 codec 输出 */
+    codecWait: PcmStageStats;
+    /** 解码数据转为浮点（含交叉淡化混音） */
+    convert: PcmStageStats;
+    eq: PcmStageStats;
+    pitch: PcmStageStats;
+    drc: PcmStageStats;
+    limiter: PcmStageStats;
+    /** 转换为输出格式并写入环形缓冲区（含等待空间） */
+    ringPush: PcmStageStats;
+    /** fill / fillForWriteData 调用耗时（含阻塞等待） */
+    fill: PcmStageStats;
+    /** 经解码器完成的 seek：从请求到目标位置首帧 PCM */
+    seek: PcmStageStats;
+  };
 };
 
 /**
@@ -156,6 +361,16 @@ export type PcmStreamDecoderCallbacks = {
    * DRC meter callback (throttled).
    */
   onDrcMeter?: (m: { levelDb: number; gainDb: number; grDb: number }) => void;
+
+  /**
+   * 环形缓冲区扩缩容回调（adaptiveRing 启用时）
+   */
+  onRingResize?: (info: PcmRingResizeInfo) => void;
+
+  /**
+   * 播放到队列中的下一曲目时回调，此后 getPosition / seekTo 以新曲目为准
+   */
+  onTrackChange?: (info: PcmTrackChangeInfo) => void;
 };
 
 /**
@@ -319,18 +534,65 @@ export type PcmStreamDecoder = {
 
   /**
    * 跳转到指定播放位置（毫秒）
+   * @returns 解码已结束、无法重新解码目标曲目时返回 false（缓冲区保持不变），否则 true
+   * @remarks 目标位于已缓冲的 PCM 内（尚未播放的部分，或 historyMs 保留的回看区）时直接移动读位置，不重启解码器
    */
-  seekTo: (positionMs: number) => void;
+  seekTo: (positionMs: number) => boolean;
 
   /**
    * Async seek that resolves when post-seek PCM is ready.
+   * Seeks served from already-buffered PCM resolve immediately.
+   * Rejects with code -3 where seekTo returns false, and with -2 when superseded by a newer seek.
    */
   seekToAsync?: (positionMs: number) => Promise<void>;
 
   /**
    * 获取当前播放位置（毫秒）
+   * @remarks 按解码输出的 PCM 计算，包含限幅器的处理延迟（见 PcmBufferStats.dspLatencyMs）
    */
   getPosition: () => number;
+
+  /**
+   * 获取环形缓冲区内存占用、缓冲/回看数据量与 seek 统计
+   */
+  getBufferStats?: () => PcmBufferStats;
+
+  /**
+   * 获取各处理阶段（读取、codec、转换、EQ、变调、DRC、限幅、写缓冲、fill、seek）的耗时分布与缓冲计数
+   * @remarks 用于定位卡顿与欠载发生在哪个阶段；统计开销为每阶段数次原子操作
+   */
+  getStats?: () => PcmDecoderStats;
+
+  /**
+   * 清零 getStats() 的统计（与正在进行的记录并发时个别样本可能落在清零前后）
+   */
+  resetStats?: () => void;
+
+  /**
+   * 设置缓冲区高/低水位（百分比），setWatermarks(0, 0) 关闭水位模式
+   * @remarks 例如熄屏时 setWatermarks(95, 25)，亮屏时恢复 setWatermarks(0, 0)
+   */
+  setWatermarks?: (highPercent: number, lowPercent: number) => void;
+
+  /**
+   * 将曲目加入播放队列，当前曲目结束后无缝衔接（同一 AudioRenderer 无需重建）
+   * @returns 曲目 id（首个曲目为 0），解码已结束时返回 -1
+   * @remarks
+   * - 下一曲目在当前曲目播放期间预先解码，输出格式（采样率/声道数/采样格式）须与当前流一致，否则通过 onError 报告（stage 'queue_format'）并跳过
+   * - 衔接处尚未播放到时（旧曲目仍在播放，解码器已切到新曲目），超出缓冲区的 seek 仍以旧曲目为准：
+   *   已拼接的曲目被撤回并放回队首，旧曲目从目标位置重新解码，之后照常衔接（不会重复触发 onTrackChange）
+   */
+  enqueue?: (uri: string, options?: PcmEnqueueOptions) => number;
+
+  /**
+   * 清空播放队列；已拼接进缓冲区的曲目继续播放
+   */
+  clearQueue?: () => void;
+
+  /**
+   * 设置队列曲目之间的交叉淡入淡出时长（毫秒），0 为无缝衔接
+   */
+  setCrossfadeMs?: (ms: number) => void;
 };
 
 /**
@@ -414,6 +676,280 @@ export const decodeAudioAsync: (
   bitrate?: number
 ) => Promise<boolean>;
 
+/**
+ * 批量解码中的单个任务
+ */
+export type BatchDecodeJob = {
+  /** 输入音频文件路径或 URL（支持 http(s)://...） */
+  inputPathOrUri: string;
+  /** 输出 PCM 文件路径 */
+  outputPath: string;
+  /** 可选：采样率（Hz），0 或不传表示自动 */
+  sampleRate?: number;
+  /** 可选：声道数，0 或不传表示自动 */
+  channelCount?: number;
+  /** 可选：比特率（bps），0 或不传表示不设置 */
+  bitrate?: number;
+};
+
+/**
+ * 批量解码选项
+ */
+export type BatchDecodeOptions = {
+  /**
+   * 并发解码数（每个并发对应一个后台解码线程及其独立解码器）
+   * - 不传或 <= 0 时默认为 CPU 核数 - 1（至少 1）
+   * - 实际并发数不超过任务数，且不超过 16
+   * - 各批次与 decodeAudioAsync 共用后台解码线程池，整个进程的并发不超过 backgroundThreads
+   *   （见 configureDecodeScheduler）；线程被占满时，本批次以已取得的线程继续
+   */
+  concurrency?: number;
+
+  /**
+   * 输出写入块大小（字节），默认 1MB，范围 1MB ~ 4MB
+   * - 解码线程只做内存拷贝，满块后由独立写线程一次写盘
+   */
+  writeBlockBytes?: number;
+
+  /**
+   * 输出容器
+   * - 'pcm'：无头 S16LE PCM（默认）
+   * - 'wav'：WAV 头 + S16LE，数据固定从 4096 字节处开始（可直接 mmap）；
+   *   解码过程中每写完一块即更新头部大小，超过 4GB 自动写为 RF64
+   */
+  container?: 'pcm' | 'wav';
+
+  /** 按媒体时长预分配输出文件磁盘空间（fallocate），默认 false */
+  preallocate?: boolean;
+
+  /** 以 O_DIRECT 打开输出文件（文件系统不支持时自动回退），默认 false */
+  directIo?: boolean;
+
+  /**
+   * 落盘策略
+   * - 'none'：交给系统回写（默认）
+   * - 'close'：完成时 fdatasync 一次
+   * - 'block'：每写完一块 fdatasync
+   */
+  syncPolicy?: 'none' | 'close' | 'block';
+};
+
+/**
+ * 单个批量任务的结果
+ */
+export type BatchDecodeJobResult = {
+  /** 是否解码成功 */
+  success: boolean;
+  /** 是否因 cancel() 而中止或未执行 */
+  cancelled: boolean;
+  /** 输出 PCM 字节数（仅成功时有效） */
+  outputBytes: number;
+  /** 解码出的媒体时长（毫秒） */
+  durationMs: number;
+  /** 该任务耗时（毫秒） */
+  elapsedMs: number;
+};
+
+/**
+ * 批量解码回调
+ */
+export type BatchDecodeCallbacks = {
+  /** 单个任务的进度（jobIndex 为 jobs 数组下标） */
+  onProgress?: (p: DecodeAudioProgress & { jobIndex: number }) => void;
+  /** 单个任务结束（成功、失败或取消） */
+  onJobDone?: (r: BatchDecodeJobResult & { jobIndex: number }) => void;
+};
+
+/**
+ * 批量解码汇总结果
+ */
+export type BatchDecodeResult = {
+  total: number;
+  succeeded: number;
+  failed: number;
+  cancelled: number;
+  /** 实际使用的并发数 */
+  concurrency: number;
+  /** 整批耗时（毫秒） */
+  elapsedMs: number;
+  /** 成功任务的输出总字节数 */
+  outputBytes: number;
+  /** 整批吞吐（输出字节 / 秒） */
+  bytesPerSecond: number;
+  /** 成功任务的媒体总时长 / 整批耗时（实时倍率） */
+  realtimeFactor: number;
+  /** 与 jobs 一一对应的结果 */
+  jobs: BatchDecodeJobResult[];
+};
+
+/**
+ * 批量解码任务句柄
+ */
+export type BatchDecodeTask = {
+  /** 所有任务结束后 resolve（单个任务失败不会 reject） */
+  done: Promise<BatchDecodeResult>;
+  /** 取消：正在解码的任务尽快停止（其输出文件不完整），未开始的任务不再执行 */
+  cancel: () => void;
+};
+
+/**
+ * 批量解码音频文件为 PCM 格式（离线转码）
+ *
+ * @param jobs - 任务列表
+ * @param options - 可选：并发等配置
+ * @param callbacks - 可选：每个任务的进度/完成回调
+ * @returns BatchDecodeTask
+ *
+ * @remarks
+ * - 由有界的原生工作线程池执行，每个工作线程持有独立的解码器实例
+ * - 输出格式与 {@link decodeAudioAsync} 相同
+ *
+ * @example
+ * ```typescript
+ * const task = decodeBatch(
+ *   files.map((f) => ({ inputPathOrUri: f, outputPath: f + '.pcm' })),
+ *   { concurrency: 2 },
+ *   { onJobDone: (r) => console.log(`#${r.jobIndex} ${r.success}`) }
+ * );
+ * const result = await task.done;
+ * console.log(`${result.succeeded}/${result.total}, ${result.realtimeFactor.toFixed(1)}x`);
+ * ```
+ */
+export const decodeBatch: (
+  jobs: BatchDecodeJob[],
+  options?: BatchDecodeOptions,
+  callbacks?: BatchDecodeCallbacks
+) => BatchDecodeTask;
+
+/**
+ * 解码器实例池统计（进程级，所有解码共享）
+ */
+export type CodecPoolStats = {
+  /** 取到同 MIME、同配置的空闲 codec，直接 Start */
+  warmHits: number;
+  /** 取到同 MIME 的空闲 codec，Reset 后重新 Configure */
+  resetHits: number;
+  /** 没有可用的空闲 codec，新建 */
+  misses: number;
+  /** 成功新建的 codec 数（含 prewarmCodecs） */
+  creates: number;
+  createFailures: number;
+  /** 超出 maxIdle 被销毁的空闲 codec 数 */
+  evictions: number;
+  /** 出错后未归还实例池的 codec 数 */
+  discards: number;
+  /** 新建 codec（CreateByMime + 注册回调）的平均/最近/最大耗时（毫秒） */
+  createMsAvg: number;
+  createMsLast: number;
+  createMsMax: number;
+  /** 当前空闲 codec 数 */
+  idle: number;
+  /** 空闲 codec 上限 */
+  maxIdle: number;
+};
+
+/**
+ * 预创建 codec 放入进程级实例池
+ *
+ * 解码结束后 codec 不再销毁，而是停止后归还实例池，下一次同 MIME 的解码
+ * （流式、文件、批量、播放队列预解码）直接取用，跳过创建与配置，缩短到 ready 的时间。
+ * 预创建把首次解码的创建开销也移到后台线程。
+ *
+ * @param mimeTypes - MIME 类型，如 'audio/mpeg'、'audio/mp4a-latm'、'audio/flac'
+ * @param countPerMime - 每个 MIME 创建的个数（默认 1，最大 8）
+ * @returns 成功创建的 codec 数
+ */
+export const prewarmCodecs: (mimeTypes: string[], countPerMime?: number) => Promise<number>;
+
+/**
+ * 设置实例池最多保留的空闲 codec 数（默认 4，最大 32；0 关闭复用）
+ *
+ * @remarks 超出上限时按最久未使用的顺序销毁
+ */
+export const setCodecPoolSize: (maxIdle: number) => void;
+
+/**
+ * 获取实例池命中/未命中次数与 codec 创建耗时
+ */
+export const getCodecPoolStats: () => CodecPoolStats;
+
+/**
+ * 单个解码调度器的统计
+ */
+export type DecodeSchedulerPoolStats = {
+  /** 线程上限 */
+  maxThreads: number;
+  /** 当前存活线程数（运行中 + 空闲） */
+  threads: number;
+  /** 正在执行的解码数 */
+  running: number;
+  /** 等待线程的解码数 */
+  queued: number;
+  submitted: number;
+  completed: number;
+  /** 解码等待线程的最长时间（毫秒） */
+  queueWaitMsMax: number;
+};
+
+/**
+ * 解码调度器统计
+ */
+export type DecodeSchedulerStats = {
+  /** 流式解码（createPcmStreamDecoder） */
+  streams: DecodeSchedulerPoolStats;
+  /** 后台文件解码（decodeAudioAsync / decodeBatch） */
+  background: DecodeSchedulerPoolStats;
+};
+
+/**
+ * 设置库自有解码线程的上限
+ *
+ * @param options.streamThreads - 流式解码线程上限（默认 4，最大 16）
+ * @param options.backgroundThreads - 后台文件解码线程上限，所有 decodeAudioAsync / decodeBatch 共用
+ *   （默认 CPU 核数 - 1，至少 2，最大 16）
+ *
+ * @remarks
+ * - 每路流式解码在整个播放期间占用一个线程；超出上限的解码按优先级排队
+ * - 调低上限时多余线程在空闲后退出，不会中断正在进行的解码
+ */
+export const configureDecodeScheduler: (options: { streamThreads?: number; backgroundThreads?: number }) => void;
+
+/**
+ * 获取解码调度器的线程与排队统计
+ */
+export const getDecodeSchedulerStats: () => DecodeSchedulerStats;
+
+/**
+ * 开始记录解码流水线时间线（丢弃上一次的记录）
+ *
+ * @param eventsPerThread - 每个线程保留的最近事件数（默认 8192，范围 256 ~ 1048576）
+ *
+ * @remarks
+ * - 记录解码线程、writeData 回调线程与 JS 线程上的事件：fillForWriteData / ReadBlocking 阻塞、欠载、
+ *   applySeek 中 codec 的停止/重启、解封装读取、等待 codec 输出、缓冲区满、暂停等待、seek 请求与首帧
+ * - 每线程一个定长无锁环形缓冲，写满后覆盖最旧事件；内存约为 eventsPerThread × 40 字节 × 线程数
+ * - 未开启时每个埋点只做一次原子读
+ */
+export const startTrace: (eventsPerThread?: number) => void;
+
+/**
+ * 停止记录；已记录的事件仍可通过 dumpTrace() 导出
+ */
+export const stopTrace: () => void;
+
+/**
+ * 导出本次记录为 Chrome trace-event JSON，可写入文件后用 chrome://tracing 或 ui.perfetto.dev 打开
+ *
+ * @example
+ * ```typescript
+ * startTrace();
+ * // ... 复现卡顿 ...
+ * stopTrace();
+ * fs.writeFileSync(context.filesDir + '/decode_trace.json', dumpTrace());
+ * ```
+ */
+export const dumpTrace: () => string;
+
 /**
  * 创建一个"流式 PCM 解码器"
  *
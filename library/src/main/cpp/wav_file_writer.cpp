@@ -0,0 +1,177 @@
+#include "wav_file_writer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <hilog/log.h>
+
+#undef LOG_TAG
+#undef LOG_DOMAIN
+#define LOG_TAG "WavFileWriter"
+#define LOG_DOMAIN 0x3200
+
+namespace {
+
+constexpr uint16_t kFormatPcm = 0x0001;
+constexpr uint16_t kFormatFloat = 0x0003;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+constexpr size_t kDs64Offset = 12;      // "JUNK"/"ds64" chunk, 28-byte body
+constexpr size_t kDs64BodyBytes = 28;
+constexpr size_t kFmtOffset = kDs64Offset + 8 + kDs64BodyBytes;
+constexpr size_t kDataHeaderOffset = WavFileWriter::kHeaderBytes - 8;
+constexpr uint32_t kSize32Max = 0xFFFFFFFFu;
+
+// KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT share this tail after the format tag.
+constexpr uint8_t kSubFormatTail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                        0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+void Put16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void Put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void Put64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void PutId(uint8_t* p, const char* id)
+{
+    memcpy(p, id, 4);
+}
+
+uint32_t DefaultChannelMask(int32_t channelCount)
+{
+    switch (channelCount) {
+        case 1: return 0x4;      // FC
+        case 2: return 0x3;      // FL FR
+        case 3: return 0x7;      // FL FR FC
+        case 4: return 0x33;     // FL FR BL BR
+        case 5: return 0x37;     // FL FR FC BL BR
+        case 6: return 0x3F;     // 5.1
+        case 7: return 0x13F;    // 6.1
+        case 8: return 0x63F;    // 7.1
+        default: return 0;
+    }
+}
+
+} // namespace
+
+WavFileWriter::WavFileWriter() : header_(nullptr), hasFormat_(false)
+{
+}
+
+WavFileWriter::~WavFileWriter()
+{
+    // Close here so the final OnBlockWritten still reaches this class.
+    Close();
+    free(header_);
+}
+
+bool WavFileWriter::Open(const std::string& path, const Options& options)
+{
+    if (header_ == nullptr) {
+        void* p = nullptr;
+        if (posix_memalign(&p, kIoAlign, kHeaderBytes) != 0) {
+            return false;
+        }
+        header_ = static_cast<uint8_t*>(p);
+    }
+    hasFormat_ = false;
+    return OpenAt(path, options, static_cast<int64_t>(kHeaderBytes));
+}
+
+bool WavFileWriter::SetFormat(const PcmFileFormat& format)
+{
+    const bool intOk = !format.isFloat && (format.bitsPerSample == 8 || format.bitsPerSample == 16 ||
+                                           format.bitsPerSample == 24 || format.bitsPerSample == 32);
+    const bool floatOk = format.isFloat && format.bitsPerSample == 32;
+    if (!IsOpen() || format.sampleRate <= 0 || format.channelCount < 1 || format.channelCount > 8 ||
+        !(intOk || floatOk)) {
+        OH_LOG_ERROR(LOG_APP, "Unsupported WAV format: %{public}d Hz, %{public}d ch, %{public}d bit",
+                     format.sampleRate, format.channelCount, format.bitsPerSample);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(headerMutex_);
+    format_ = format;
+    hasFormat_ = true;
+    return WriteHeader(0);
+}
+
+void WavFileWriter::OnBlockWritten(int64_t dataBytes)
+{
+    std::lock_guard<std::mutex> lock(headerMutex_);
+    if (hasFormat_ && !WriteHeader(dataBytes)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to patch WAV header");
+    }
+}
+
+bool WavFileWriter::WriteHeader(int64_t dataBytes)
+{
+    uint8_t* h = header_;
+    memset(h, 0, kHeaderBytes);
+
+    const uint64_t data = static_cast<uint64_t>(dataBytes);
+    const uint64_t riff = kHeaderBytes - 8 + data;
+    const bool rf64 = riff > kSize32Max;
+
+    const uint16_t blockAlign = static_cast<uint16_t>(format_.channelCount * format_.bitsPerSample / 8);
+
+    PutId(h, rf64 ? "RF64" : "RIFF");
+    Put32(h + 4, rf64 ? kSize32Max : static_cast<uint32_t>(riff));
+    PutId(h + 8, "WAVE");
+
+    // Reserved for ds64; stays a JUNK chunk while the file fits RIFF.
+    PutId(h + kDs64Offset, rf64 ? "ds64" : "JUNK");
+    Put32(h + kDs64Offset + 4, kDs64BodyBytes);
+    if (rf64) {
+        uint8_t* ds = h + kDs64Offset + 8;
+        Put64(ds, riff);
+        Put64(ds + 8, data);
+        Put64(ds + 16, blockAlign > 0 ? data / blockAlign : 0);
+        Put32(ds + 24, 0);  // no extra size table
+    }
+
+    // WAVE_FORMAT_EXTENSIBLE for > 2 channels or > 16 bit, as Windows expects.
+    const bool extensible = format_.channelCount > 2 || format_.bitsPerSample > 16;
+    const uint16_t tag = format_.isFloat ? kFormatFloat : kFormatPcm;
+    const uint32_t fmtBytes = extensible ? 40 : 16;
+
+    uint8_t* fmt = h + kFmtOffset;
+    PutId(fmt, "fmt ");
+    Put32(fmt + 4, fmtBytes);
+    Put16(fmt + 8, extensible ? kFormatExtensible : tag);
+    Put16(fmt + 10, static_cast<uint16_t>(format_.channelCount));
+    Put32(fmt + 12, static_cast<uint32_t>(format_.sampleRate));
+    Put32(fmt + 16, static_cast<uint32_t>(format_.sampleRate) * blockAlign);
+    Put16(fmt + 20, blockAlign);
+    Put16(fmt + 22, static_cast<uint16_t>(format_.bitsPerSample));
+    if (extensible) {
+        Put16(fmt + 24, 22);
+        Put16(fmt + 26, static_cast<uint16_t>(format_.bitsPerSample));
+        Put32(fmt + 28, DefaultChannelMask(format_.channelCount));
+        Put16(fmt + 32, tag);
+        memcpy(fmt + 34, kSubFormatTail, sizeof(kSubFormatTail));
+    }
+
+    // Pad so the data payload starts at kHeaderBytes.
+    const size_t padOffset = kFmtOffset + 8 + fmtBytes;
+    PutId(h + padOffset, "JUNK");
+    Put32(h + padOffset + 4, static_cast<uint32_t>(kDataHeaderOffset - padOffset - 8));
+
+    PutId(h + kDataHeaderOffset, "data");
+    Put32(h + kDataHeaderOffset + 4, rf64 ? kSize32Max : static_cast<uint32_t>(data));
+
+    return WriteAt(0, h, kHeaderBytes);
+}
@@ -0,0 +1,44 @@
+#ifndef WAV_FILE_WRITER_H
+#define WAV_FILE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "pcm_file_writer.h"
+
+// WAV writer on top of PcmFileWriter.
+//
+// The header occupies exactly kHeaderBytes, so the PCM payload starts on a page
+// boundary and can be mmap'ed directly:
+//   RIFF | JUNK(28) | fmt | JUNK padding | data -> payload at offset 4096
+// The sizes are patched after every block written, so a file that is still
+// being decoded is a valid WAV of the PCM already on disk. Once the file grows
+// past 4 GB the header is rewritten as RF64 (EBU Tech 3306): the first JUNK
+// chunk becomes ds64 and the 32-bit sizes are set to 0xFFFFFFFF.
+class WavFileWriter : public PcmFileWriter {
+public:
+    static constexpr size_t kHeaderBytes = kIoAlign;
+
+    WavFileWriter();
+    ~WavFileWriter() override;
+
+    bool Open(const std::string& path, const Options& options) override;
+
+    // Writes the initial header (data size 0). Supports integer PCM (8/16/24/32
+    // bit) and 32-bit float, 1..8 channels.
+    bool SetFormat(const PcmFileFormat& format) override;
+
+protected:
+    void OnBlockWritten(int64_t dataBytes) override;
+
+private:
+    bool WriteHeader(int64_t dataBytes);
+
+    uint8_t* header_;       // kIoAlign-aligned, kHeaderBytes
+    PcmFileFormat format_;
+    bool hasFormat_;
+    std::mutex headerMutex_;
+};
+
+#endif